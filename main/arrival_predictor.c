@@ -0,0 +1,423 @@
+#include "arrival_predictor.h"
+#include "presence_module.h"
+#include "time_module.h"
+#include "project_config.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <nvs.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <string.h>
+
+static const char *TAG = "ArrivalPredictor";
+
+#define SLOTS_PER_DAY           ((24 * 60) / CONFIG_ARRIVAL_SLOT_MINUTES)
+#define DAYS_PER_WEEK           7
+#define MAX_PREWARM_HOOKS       8
+#define NOTIFY_ARRIVAL          0x01
+#define NOTIFY_HOOK_READY(i)    (1UL << (8 + (i)))
+#define NOTIFY_HOOK_FAILED(i)   (1UL << (16 + (i)))
+
+#define NVS_NAMESPACE           "arrival"
+#define NVS_KEY_TABLE           "table"
+
+typedef struct {
+    const char *name;
+    arrival_prewarm_fn_t prewarm;
+    float warm_current_ma;
+    void *user_ctx;
+} prewarm_hook_t;
+
+// Learned P(arrival in slot | away at some point in slot), scaled to 0-255
+static uint8_t arrival_table[DAYS_PER_WEEK][SLOTS_PER_DAY];
+static bool table_dirty = false;
+
+// Module state
+static bool module_initialized = false;
+static TaskHandle_t predictor_task_handle = NULL;
+static prewarm_hook_t hooks[MAX_PREWARM_HOOKS];
+static int hook_count = 0;
+static arrival_predictor_stats_t stats = {0};
+static uint64_t latency_warm_sum_ms = 0;
+static uint64_t latency_cold_sum_ms = 0;
+
+// Slot tracking
+static int tracked_day = -1;
+static int tracked_slot = -1;
+static bool away_in_slot = false;
+static bool arrived_in_slot = false;
+
+// Pre-warm window
+static bool prewarm_active = false;
+static int64_t prewarm_start_us = 0;
+static int last_prewarm_key = -1;   // day * SLOTS_PER_DAY + slot of the last prediction
+
+// Arrival waiting for hooks that come up in the background
+static bool arrival_pending = false;
+static bool arrival_prewarmed = false;
+static int64_t arrival_us = 0;
+static uint32_t pending_hooks = 0;  // Bit per hook index
+
+/**
+ * @brief Day of week for a Gregorian date (0=Sunday)
+ *
+ * Computed instead of trusting the DS3231 day register, which is user-defined.
+ */
+static int day_of_week(int year, int month, int day)
+{
+    static const int offsets[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+    if (month < 3) {
+        year -= 1;
+    }
+    return (year + year / 4 - year / 100 + year / 400 + offsets[(month - 1) % 12] + day) % 7;
+}
+
+static void load_table(void)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        ESP_LOGI(TAG, "No arrival history stored yet");
+        return;
+    }
+
+    size_t size = sizeof(arrival_table);
+    esp_err_t ret = nvs_get_blob(nvs, NVS_KEY_TABLE, arrival_table, &size);
+    if (ret != ESP_OK || size != sizeof(arrival_table)) {
+        ESP_LOGW(TAG, "Discarding stored arrival history (%s)", esp_err_to_name(ret));
+        memset(arrival_table, 0, sizeof(arrival_table));
+    }
+    nvs_close(nvs);
+}
+
+static void save_table(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open NVS: %s", esp_err_to_name(ret));
+        return;
+    }
+
+    ret = nvs_set_blob(nvs, NVS_KEY_TABLE, arrival_table, sizeof(arrival_table));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+
+    if (ret == ESP_OK) {
+        table_dirty = false;
+    } else {
+        ESP_LOGW(TAG, "Failed to save arrival history: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * @brief Fold the outcome of a finished slot into the weekly average
+ */
+static void finalize_slot(int day, int slot, bool arrived)
+{
+    float p = arrival_table[day][slot] / 255.0f;
+    float observed = arrived ? 1.0f : 0.0f;
+    p += CONFIG_ARRIVAL_LEARNING_RATE * (observed - p);
+    arrival_table[day][slot] = (uint8_t)(p * 255.0f + 0.5f);
+    table_dirty = true;
+
+    ESP_LOGD(TAG, "Slot %d/%d: arrived=%d, p=%.2f", day, slot, arrived, p);
+}
+
+/**
+ * @brief Run every pre-warm hook and return how long they took in total
+ *
+ * @param reason Logged on failure
+ * @param pending Set to the hooks still coming up in the background (may be NULL)
+ */
+static uint32_t run_prewarm_hooks(const char *reason, uint32_t *pending)
+{
+    int64_t start = esp_timer_get_time();
+    uint32_t background = 0;
+
+    for (int i = 0; i < hook_count; i++) {
+        esp_err_t ret = hooks[i].prewarm(hooks[i].user_ctx);
+        if (ret == ESP_ERR_NOT_FINISHED) {
+            background |= 1UL << i;
+        } else if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Pre-warm '%s' failed (%s): %s", hooks[i].name, reason, esp_err_to_name(ret));
+        }
+    }
+    if (pending != NULL) {
+        *pending = background;
+    }
+
+    return (uint32_t)((esp_timer_get_time() - start) / 1000);
+}
+
+static float warm_current_ma(void)
+{
+    float total = 0.0f;
+    for (int i = 0; i < hook_count; i++) {
+        total += hooks[i].warm_current_ma;
+    }
+    return total;
+}
+
+static void finish_arrival(bool was_prewarmed, uint32_t latency_ms)
+{
+    if (was_prewarmed) {
+        latency_warm_sum_ms += latency_ms;
+        stats.latency_warm_avg_ms = (uint32_t)(latency_warm_sum_ms / stats.hits);
+    } else {
+        latency_cold_sum_ms += latency_ms;
+        stats.latency_cold_avg_ms = (uint32_t)(latency_cold_sum_ms / stats.unpredicted);
+    }
+
+    ESP_LOGI(TAG, "Arrival (%s): ready in %lu ms | hits %lu/%lu prewarms, unpredicted %lu, wasted %.2f mWh",
+             was_prewarmed ? "pre-warmed" : "cold", (unsigned long)latency_ms,
+             (unsigned long)stats.hits, (unsigned long)stats.prewarms,
+             (unsigned long)stats.unpredicted, stats.wasted_energy_mwh);
+}
+
+static void handle_arrival(void)
+{
+    stats.arrivals++;
+    arrived_in_slot = true;
+
+    bool was_prewarmed = prewarm_active;
+    if (was_prewarmed) {
+        stats.hits++;
+    } else {
+        stats.unpredicted++;
+    }
+    prewarm_active = false;
+
+    // Hooks are idempotent: on a hit this measures the residual wait only
+    arrival_us = esp_timer_get_time();
+    uint32_t latency_ms = run_prewarm_hooks("arrival", &pending_hooks);
+    if (pending_hooks != 0) {
+        // Finished by arrival_predictor_prewarm_done() once the last background hook is up
+        arrival_pending = true;
+        arrival_prewarmed = was_prewarmed;
+        return;
+    }
+    arrival_pending = false;
+    finish_arrival(was_prewarmed, latency_ms);
+}
+
+static void handle_hook_done(uint32_t events)
+{
+    for (int i = 0; i < hook_count; i++) {
+        bool ready = (events & NOTIFY_HOOK_READY(i)) != 0;
+        bool failed = (events & NOTIFY_HOOK_FAILED(i)) != 0;
+        if (!arrival_pending || !(pending_hooks & (1UL << i)) || (!ready && !failed)) {
+            continue;
+        }
+        pending_hooks &= ~(1UL << i);
+        if (failed) {
+            // Not ready at all: the arrival says nothing about the latency
+            ESP_LOGW(TAG, "Pre-warm '%s' failed in the background (arrival)", hooks[i].name);
+            arrival_pending = false;
+            return;
+        }
+    }
+
+    if (arrival_pending && pending_hooks == 0) {
+        arrival_pending = false;
+        finish_arrival(arrival_prewarmed, (uint32_t)((esp_timer_get_time() - arrival_us) / 1000));
+    }
+}
+
+static void check_prediction(const time_info_t *now_time)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    // Expire an unused pre-warm window
+    if (prewarm_active && now_us - prewarm_start_us >= (int64_t)CONFIG_ARRIVAL_PREWARM_WINDOW_MIN * 60 * 1000000) {
+        prewarm_active = false;
+        stats.misses++;
+        float warm_hours = CONFIG_ARRIVAL_PREWARM_WINDOW_MIN / 60.0f;
+        stats.wasted_energy_mwh += warm_current_ma() * CONFIG_ENERGY_SUPPLY_VOLTAGE_V * warm_hours;
+        ESP_LOGI(TAG, "Pre-warm window expired without arrival (%lu misses)", (unsigned long)stats.misses);
+    }
+
+    if (prewarm_active || presence_get_state() != PRESENCE_STATE_AWAY || hook_count == 0) {
+        return;
+    }
+
+    // Look at the slot the user would arrive in after the lead time
+    int minute_of_day = now_time->hour * 60 + now_time->minute + CONFIG_ARRIVAL_PREWARM_LEAD_MIN;
+    int day = day_of_week(now_time->year, now_time->month, now_time->day);
+    if (minute_of_day >= 24 * 60) {
+        minute_of_day -= 24 * 60;
+        day = (day + 1) % DAYS_PER_WEEK;
+    }
+    int slot = minute_of_day / CONFIG_ARRIVAL_SLOT_MINUTES;
+    int key = day * SLOTS_PER_DAY + slot;
+
+    float p = arrival_table[day][slot] / 255.0f;
+    if (p >= CONFIG_ARRIVAL_PREWARM_THRESHOLD && key != last_prewarm_key) {
+        last_prewarm_key = key;
+        prewarm_active = true;
+        prewarm_start_us = now_us;
+        stats.prewarms++;
+        ESP_LOGI(TAG, "Arrival likely (p=%.2f), pre-warming %d subsystems", p, hook_count);
+        uint32_t background = 0;
+        uint32_t elapsed = run_prewarm_hooks("prediction", &background);
+        ESP_LOGI(TAG, "Pre-warm started in %lu ms%s", (unsigned long)elapsed,
+                 background != 0 ? ", some subsystems still coming up" : "");
+    }
+}
+
+static void track_slot(const time_info_t *now_time)
+{
+    int day = day_of_week(now_time->year, now_time->month, now_time->day);
+    int slot = (now_time->hour * 60 + now_time->minute) / CONFIG_ARRIVAL_SLOT_MINUTES;
+
+    if (day != tracked_day || slot != tracked_slot) {
+        // Only slots that started (or became) AWAY say anything about arrivals
+        if (tracked_day >= 0 && away_in_slot) {
+            finalize_slot(tracked_day, tracked_slot, arrived_in_slot);
+        }
+        if (table_dirty) {
+            save_table();
+        }
+        tracked_day = day;
+        tracked_slot = slot;
+        away_in_slot = false;
+        arrived_in_slot = false;
+    }
+
+    if (presence_get_state() == PRESENCE_STATE_AWAY) {
+        away_in_slot = true;
+    }
+}
+
+static void presence_changed(presence_state_t new_state, presence_state_t old_state, void *user_ctx)
+{
+    if (new_state == PRESENCE_STATE_PRESENT && old_state == PRESENCE_STATE_AWAY && predictor_task_handle != NULL) {
+        xTaskNotify(predictor_task_handle, NOTIFY_ARRIVAL, eSetBits);
+    }
+}
+
+/**
+ * @brief Predictor task
+ */
+static void arrival_predictor_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Arrival predictor task started");
+
+    while (1) {
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, pdMS_TO_TICKS(CONFIG_ARRIVAL_CHECK_INTERVAL_MS));
+
+        time_info_t now_time;
+        bool time_valid = (time_module_get_time(&now_time) == ESP_OK);
+
+        if (time_valid) {
+            track_slot(&now_time);
+        }
+
+        if (events & NOTIFY_ARRIVAL) {
+            handle_arrival();
+        }
+        if (events & ~NOTIFY_ARRIVAL) {
+            handle_hook_done(events);
+        }
+
+        if (time_valid) {
+            check_prediction(&now_time);
+        }
+    }
+}
+
+esp_err_t arrival_predictor_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Arrival predictor already initialized");
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Initializing arrival predictor...");
+
+    memset(arrival_table, 0, sizeof(arrival_table));
+    load_table();
+
+    BaseType_t task_ret = xTaskCreate(
+        arrival_predictor_task,
+        "arrival_pred",
+        CONFIG_TASK_STACK_ARRIVAL,
+        NULL,
+        CONFIG_TASK_PRIORITY_ARRIVAL,
+        &predictor_task_handle
+    );
+
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create arrival predictor task");
+        return ESP_FAIL;
+    }
+
+    esp_err_t ret = presence_register_listener(presence_changed, NULL);
+    if (ret != ESP_OK) {
+        vTaskDelete(predictor_task_handle);
+        predictor_task_handle = NULL;
+        return ret;
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Arrival predictor initialized (%d slots/day, lead %d min)",
+             SLOTS_PER_DAY, CONFIG_ARRIVAL_PREWARM_LEAD_MIN);
+
+    return ESP_OK;
+}
+
+esp_err_t arrival_predictor_register_prewarm(const char *name, arrival_prewarm_fn_t prewarm,
+                                             float warm_current_ma, void *user_ctx)
+{
+    if (name == NULL || prewarm == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (hook_count >= MAX_PREWARM_HOOKS) {
+        ESP_LOGE(TAG, "No free pre-warm hook slot for '%s'", name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    hooks[hook_count].name = name;
+    hooks[hook_count].prewarm = prewarm;
+    hooks[hook_count].warm_current_ma = warm_current_ma;
+    hooks[hook_count].user_ctx = user_ctx;
+    hook_count++;
+
+    ESP_LOGI(TAG, "Registered pre-warm hook '%s' (%.1f mA warm)", name, warm_current_ma);
+    return ESP_OK;
+}
+
+void arrival_predictor_prewarm_done(const char *name, esp_err_t result)
+{
+    if (name == NULL || predictor_task_handle == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < hook_count; i++) {
+        if (strcmp(hooks[i].name, name) == 0) {
+            xTaskNotify(predictor_task_handle, result == ESP_OK ? NOTIFY_HOOK_READY(i) : NOTIFY_HOOK_FAILED(i),
+                        eSetBits);
+            return;
+        }
+    }
+}
+
+float arrival_predictor_get_probability(int weekday, int hour, int minute)
+{
+    if (weekday < 0 || weekday >= DAYS_PER_WEEK || hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        return 0.0f;
+    }
+    return arrival_table[weekday][(hour * 60 + minute) / CONFIG_ARRIVAL_SLOT_MINUTES] / 255.0f;
+}
+
+esp_err_t arrival_predictor_get_stats(arrival_predictor_stats_t *out)
+{
+    if (!module_initialized || out == NULL) {
+        return ESP_FAIL;
+    }
+
+    memcpy(out, &stats, sizeof(arrival_predictor_stats_t));
+    return ESP_OK;
+}
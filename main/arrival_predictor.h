@@ -0,0 +1,106 @@
+#ifndef ARRIVAL_PREDICTOR_H
+#define ARRIVAL_PREDICTOR_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file arrival_predictor.h
+ * @brief Learns when the user usually arrives and pre-warms slow subsystems
+ *
+ * Arrival probability is tracked per weekday and per time-of-day slot from
+ * AWAY -> PRESENT transitions of the presence module. Shortly before a likely
+ * arrival, all registered pre-warm hooks are run so the first interaction
+ * does not wait for the link, Wi-Fi or weather to come up.
+ */
+
+/**
+ * @brief Pre-warm hook
+ *
+ * Brings a subsystem to the ready state and returns once it is ready, or
+ * starts bringing it up in the background and returns ESP_ERR_NOT_FINISHED;
+ * the subsystem then reports through arrival_predictor_prewarm_done().
+ * Must be idempotent: it is called again on arrival to measure how long the
+ * first interaction would have waited.
+ *
+ * @param user_ctx Context passed at registration
+ * @return ESP_OK when the subsystem is ready, ESP_ERR_NOT_FINISHED while it
+ *         comes up in the background
+ */
+typedef esp_err_t (*arrival_prewarm_fn_t)(void *user_ctx);
+
+/**
+ * @brief Predictor statistics
+ */
+typedef struct {
+    uint32_t arrivals;              // AWAY -> PRESENT transitions observed
+    uint32_t prewarms;              // Pre-warm cycles started by a prediction
+    uint32_t hits;                  // Arrivals inside a pre-warm window
+    uint32_t misses;                // Pre-warm windows that expired without arrival
+    uint32_t unpredicted;           // Arrivals with no pre-warm active
+    float wasted_energy_mwh;        // Estimated energy spent keeping subsystems warm on misses
+    uint32_t latency_warm_avg_ms;   // Arrival -> ready when pre-warmed
+    uint32_t latency_cold_avg_ms;   // Arrival -> ready without pre-warm
+} arrival_predictor_stats_t;
+
+/**
+ * @brief Initialize the predictor
+ *
+ * Loads the learned arrival table from NVS and starts the predictor task.
+ * Requires presence_module_init() and time_module_init().
+ *
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t arrival_predictor_init(void);
+
+/**
+ * @brief Register a subsystem pre-warm hook
+ *
+ * @param name Short name used in logs
+ * @param prewarm Hook bringing the subsystem up
+ * @param warm_current_ma Extra supply current while the subsystem is kept warm
+ * @param user_ctx Context passed to the hook
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if all hook slots are used
+ */
+esp_err_t arrival_predictor_register_prewarm(const char *name, arrival_prewarm_fn_t prewarm,
+                                             float warm_current_ma, void *user_ctx);
+
+/**
+ * @brief Report that a background pre-warm finished
+ *
+ * For hooks that returned ESP_ERR_NOT_FINISHED. The arrival latency then
+ * runs until the last background hook is ready.
+ *
+ * @param name Name the hook was registered with
+ * @param result ESP_OK when ready, an error if the subsystem did not come up
+ */
+void arrival_predictor_prewarm_done(const char *name, esp_err_t result);
+
+/**
+ * @brief Get the learned arrival probability of a weekday/time slot
+ *
+ * @param weekday Day of week (0=Sunday, 6=Saturday)
+ * @param hour Hour (0-23)
+ * @param minute Minute (0-59)
+ * @return Probability (0.0-1.0) that the user arrives in that slot
+ */
+float arrival_predictor_get_probability(int weekday, int hour, int minute);
+
+/**
+ * @brief Get predictor statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if not initialized or stats is NULL
+ */
+esp_err_t arrival_predictor_get_stats(arrival_predictor_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARRIVAL_PREDICTOR_H
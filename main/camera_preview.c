@@ -0,0 +1,482 @@
+#include "camera_preview.h"
+#include "coproc_link.h"
+#include "display_module.h"
+#include "ring_buffer.h"
+#include "ui_strings.h"
+#include "project_config.h"
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "CameraPreview";
+
+#define RATE_WINDOW_US          1000000
+#define STOP_TIMEOUT_MS         500
+#define FRAME_NONE              -1
+
+#if CONFIG_PREVIEW_STRIPE_ROWS % CONFIG_PREVIEW_SCALE != 0
+#error "CONFIG_PREVIEW_STRIPE_ROWS must be a multiple of CONFIG_PREVIEW_SCALE"
+#endif
+
+/**
+ * @brief One received stripe message, queued by the link RX task
+ */
+typedef struct {
+    uint16_t len;
+    uint8_t data[COPROC_LINK_MAX_PAYLOAD];
+} preview_slot_t;
+
+// Module state
+static bool module_initialized = false;
+static volatile bool preview_running = false;
+static TaskHandle_t preview_task_handle = NULL;
+
+// Stripe queue: link RX task -> preview task. Storage is kept once allocated so a
+// handler still running after a stop never writes freed memory.
+static ring_spsc_t stripe_ring;
+static preview_slot_t *ring_storage = NULL;
+static volatile int32_t newest_complete_frame = FRAME_NONE;
+static int32_t overflow_frame = FRAME_NONE;      // RX task only
+
+// Decoder output, only touched by the preview task
+static lv_color_t *stripe_buf = NULL;            // DMA-capable, CONFIG_PREVIEW_STRIPE_ROWS panel rows
+static uint16_t source_row[CONFIG_PREVIEW_WIDTH];
+static int stripe_rows = 0;
+static int stripe_y = 0;                         // First panel row of stripe_buf inside the region
+static uint32_t frame_draw_us = 0;
+
+// Statistics
+static camera_preview_stats_t stats = {0};
+static uint64_t decode_sum_us = 0;
+static uint64_t draw_sum_us = 0;
+static volatile uint64_t link_bytes = 0;         // Written by the RX task
+static int64_t window_start_us = 0;
+static uint32_t window_frames = 0;
+static uint64_t window_bytes = 0;
+static int64_t last_report_us = 0;
+
+static void send_ack(uint16_t frame_id)
+{
+    coproc_link_send(COPROC_MSG_PREVIEW_ACK, &frame_id, sizeof(frame_id));
+}
+
+static bool frame_older(int32_t frame_id, int32_t than)
+{
+    return than != FRAME_NONE && (int16_t)((uint16_t)frame_id - (uint16_t)than) < 0;
+}
+
+/**
+ * @brief Stripe handler, runs in the link RX task
+ */
+static void on_preview_stripe(uint8_t type, const uint8_t *payload, size_t len, void *user_ctx)
+{
+    if (!preview_running || len < sizeof(coproc_preview_stripe_t)) {
+        return;
+    }
+
+    coproc_preview_stripe_t header;
+    memcpy(&header, payload, sizeof(header));
+    link_bytes += len + COPROC_LINK_FRAME_OVERHEAD;
+    bool last = (header.flags & COPROC_PREVIEW_LAST_STRIPE) != 0;
+
+    // Once a stripe of a frame is lost the rest of it is useless too
+    if (header.frame_id != overflow_frame) {
+        uint32_t count = 1;
+        preview_slot_t *slot = ring_spsc_reserve(&stripe_ring, &count);
+        if (slot != NULL) {
+            slot->len = (uint16_t)len;
+            memcpy(slot->data, payload, len);
+            ring_spsc_commit(&stripe_ring, 1);
+        } else {
+            overflow_frame = header.frame_id;
+            stats.stripes_overflow++;
+        }
+    }
+
+    if (last) {
+        if (header.frame_id == overflow_frame) {
+            // The preview task never sees this frame end, so return its credit here
+            send_ack(header.frame_id);
+        } else {
+            newest_complete_frame = header.frame_id;
+        }
+    }
+
+    TaskHandle_t task = preview_task_handle;
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+static void swap_pixel_bytes(uint16_t *pixel)
+{
+#if LV_COLOR_16_SWAP
+    *pixel = (uint16_t)((*pixel << 8) | (*pixel >> 8));
+#endif
+}
+
+/**
+ * @brief Send the filled part of the stripe buffer to the panel
+ */
+static void draw_stripe(void)
+{
+    if (stripe_rows == 0) {
+        return;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = display_preview_draw(stripe_y, stripe_rows, stripe_buf);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "Stripe at row %d not drawn: %s", stripe_y, esp_err_to_name(ret));
+    }
+    frame_draw_us += (uint32_t)(esp_timer_get_time() - start_us);
+
+    stripe_y += stripe_rows;
+    stripe_rows = 0;
+}
+
+/**
+ * @brief Replicate one decoded source row into the stripe buffer
+ */
+static void emit_source_row(int source_y)
+{
+    if (stripe_rows == 0) {
+        stripe_y = source_y * CONFIG_PREVIEW_SCALE;
+    }
+
+    uint16_t *out = (uint16_t *)&stripe_buf[stripe_rows * CONFIG_PREVIEW_REGION_WIDTH];
+    for (int x = 0; x < CONFIG_PREVIEW_WIDTH; x++) {
+        for (int s = 0; s < CONFIG_PREVIEW_SCALE; s++) {
+            *out++ = source_row[x];
+        }
+    }
+    for (int s = 1; s < CONFIG_PREVIEW_SCALE; s++) {
+        memcpy(&stripe_buf[(stripe_rows + s) * CONFIG_PREVIEW_REGION_WIDTH],
+               &stripe_buf[stripe_rows * CONFIG_PREVIEW_REGION_WIDTH],
+               CONFIG_PREVIEW_REGION_WIDTH * sizeof(lv_color_t));
+    }
+    stripe_rows += CONFIG_PREVIEW_SCALE;
+
+    if (stripe_rows == CONFIG_PREVIEW_STRIPE_ROWS) {
+        draw_stripe();
+    }
+}
+
+/**
+ * @brief Decode the RLE pixels of one stripe message and draw them
+ *
+ * @return false if the data is malformed
+ */
+static bool decode_stripe(const coproc_preview_stripe_t *header, const uint8_t *data, size_t len)
+{
+    if (header->rows == 0 || header->y + header->rows > CONFIG_PREVIEW_HEIGHT) {
+        return false;
+    }
+
+    const uint32_t total = (uint32_t)header->rows * CONFIG_PREVIEW_WIDTH;
+    uint32_t pixel = 0;
+    size_t pos = 0;
+    int x = 0;
+    int y = header->y;
+
+    while (pixel < total) {
+        if (pos >= len) {
+            return false;
+        }
+        uint8_t control = data[pos++];
+        bool run = (control & 0x80) != 0;
+        uint32_t count = run ? (uint32_t)(control - 0x7F) : (uint32_t)control + 1;
+        if (pixel + count > total || pos + (run ? 2 : 2 * count) > len) {
+            return false;
+        }
+
+        uint16_t value = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (!run || i == 0) {
+                value = (uint16_t)(data[pos] | (data[pos + 1] << 8));
+                swap_pixel_bytes(&value);
+                pos += 2;
+            }
+            source_row[x++] = value;
+            if (x == CONFIG_PREVIEW_WIDTH) {
+                emit_source_row(y++);
+                x = 0;
+            }
+        }
+        pixel += count;
+    }
+
+    // Rows of the next stripe message continue in the same buffer
+    if (y == CONFIG_PREVIEW_HEIGHT) {
+        draw_stripe();
+    }
+    return pos == len;
+}
+
+/**
+ * @brief Share of the UART used by the stream; 8N1 puts ten bits on the wire per byte
+ */
+static uint32_t link_percent(uint32_t kbps)
+{
+    return (uint32_t)((uint64_t)kbps * 1000 / 8 * 10 * 100 / CONFIG_COPROC_UART_BAUD);
+}
+
+static void update_rates(int64_t now)
+{
+    if (now - window_start_us < RATE_WINDOW_US) {
+        return;
+    }
+
+    uint64_t bytes = link_bytes;
+    int64_t elapsed_us = now - window_start_us;
+    stats.fps_x10 = (uint32_t)((uint64_t)window_frames * 10000000ULL / elapsed_us);
+    stats.link_kbps = (uint32_t)((bytes - window_bytes) * 8000ULL / elapsed_us);
+    window_frames = 0;
+    window_bytes = bytes;
+    window_start_us = now;
+
+    if (now - last_report_us >= (int64_t)CONFIG_PREVIEW_REPORT_INTERVAL_MS * 1000) {
+        last_report_us = now;
+        camera_preview_stats_t snapshot;
+        camera_preview_get_stats(&snapshot);
+        ESP_LOGI(TAG, "Preview: %lu frames, %lu.%lu fps, %lu kbit/s (%lu%% of link), decode mean %lu us max %lu us, "
+                 "draw mean %lu us, %lu stale, %lu overflowed stripes, %lu bad",
+                 (unsigned long)snapshot.frames_drawn, (unsigned long)(snapshot.fps_x10 / 10),
+                 (unsigned long)(snapshot.fps_x10 % 10), (unsigned long)snapshot.link_kbps,
+                 (unsigned long)link_percent(snapshot.link_kbps),
+                 (unsigned long)snapshot.decode_mean_us, (unsigned long)snapshot.decode_max_us,
+                 (unsigned long)snapshot.draw_mean_us, (unsigned long)snapshot.frames_stale,
+                 (unsigned long)snapshot.stripes_overflow, (unsigned long)snapshot.stripes_bad);
+    }
+}
+
+/**
+ * @brief Preview task: decode and draw queued stripes
+ */
+static void preview_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Preview task started");
+
+    int32_t current_frame = FRAME_NONE;
+    bool current_stale = false;
+    uint32_t frame_decode_us = 0;
+
+    while (preview_running) {
+        uint32_t count = 0;
+        const preview_slot_t *slot = ring_spsc_peek(&stripe_ring, &count);
+        if (slot == NULL) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RATE_WINDOW_US / 1000));
+            update_rates(esp_timer_get_time());
+            continue;
+        }
+
+        coproc_preview_stripe_t header;
+        memcpy(&header, slot->data, sizeof(header));
+        bool last = (header.flags & COPROC_PREVIEW_LAST_STRIPE) != 0;
+
+        if (header.frame_id != current_frame) {
+            current_frame = header.frame_id;
+            current_stale = false;
+            frame_decode_us = 0;
+            frame_draw_us = 0;
+            stripe_rows = 0;
+        }
+
+        // Behind: a newer frame is complete, skip straight to it
+        if (!current_stale && frame_older(header.frame_id, newest_complete_frame)) {
+            current_stale = true;
+            stats.frames_stale++;
+        }
+
+        if (!current_stale) {
+            int64_t start_us = esp_timer_get_time();
+            uint32_t draw_before_us = frame_draw_us;
+            if (!decode_stripe(&header, slot->data + sizeof(header), slot->len - sizeof(header))) {
+                stats.stripes_bad++;
+            }
+            frame_decode_us += (uint32_t)(esp_timer_get_time() - start_us) - (frame_draw_us - draw_before_us);
+        }
+        ring_spsc_release(&stripe_ring, 1);
+
+        if (last) {
+            if (!current_stale) {
+                stats.frames_drawn++;
+                window_frames++;
+                decode_sum_us += frame_decode_us;
+                draw_sum_us += frame_draw_us;
+                if (frame_decode_us > stats.decode_max_us) {
+                    stats.decode_max_us = frame_decode_us;
+                }
+            }
+            send_ack(header.frame_id);
+        }
+        update_rates(esp_timer_get_time());
+    }
+
+    heap_caps_free(stripe_buf);
+    stripe_buf = NULL;
+    ESP_LOGI(TAG, "Preview task ending");
+    preview_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t camera_preview_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Camera preview already initialized");
+        return ESP_OK;
+    }
+
+    esp_err_t ret = coproc_link_register_handler(COPROC_MSG_PREVIEW_STRIPE, on_preview_stripe, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register preview handler: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Camera preview initialized (%dx%d, x%d on the panel)",
+             CONFIG_PREVIEW_WIDTH, CONFIG_PREVIEW_HEIGHT, CONFIG_PREVIEW_SCALE);
+
+    return ESP_OK;
+}
+
+esp_err_t camera_preview_start(void)
+{
+    if (!module_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (preview_task_handle != NULL) {
+        ESP_LOGW(TAG, "Preview already running");
+        return ESP_OK;
+    }
+
+    if (ring_storage == NULL) {
+        ring_storage = heap_caps_malloc(CONFIG_PREVIEW_RING_SLOTS * sizeof(preview_slot_t), MALLOC_CAP_INTERNAL);
+    }
+    stripe_buf = heap_caps_malloc(CONFIG_PREVIEW_REGION_WIDTH * CONFIG_PREVIEW_STRIPE_ROWS * sizeof(lv_color_t),
+                                  MALLOC_CAP_DMA);
+    if (ring_storage == NULL || stripe_buf == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate preview buffers");
+        heap_caps_free(stripe_buf);
+        stripe_buf = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ring_spsc_init(&stripe_ring, ring_storage, sizeof(preview_slot_t), CONFIG_PREVIEW_RING_SLOTS);
+    newest_complete_frame = FRAME_NONE;
+    overflow_frame = FRAME_NONE;
+    memset(&stats, 0, sizeof(stats));
+    decode_sum_us = 0;
+    draw_sum_us = 0;
+    link_bytes = 0;
+    window_bytes = 0;
+    window_frames = 0;
+    window_start_us = esp_timer_get_time();
+    last_report_us = window_start_us;
+
+    display_show_preview(true);
+
+    preview_running = true;
+    BaseType_t task_ret = xTaskCreate(
+        preview_task,
+        "cam_preview",
+        CONFIG_TASK_STACK_PREVIEW,
+        NULL,
+        CONFIG_TASK_PRIORITY_PREVIEW,
+        &preview_task_handle
+    );
+
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create preview task");
+        preview_running = false;
+        heap_caps_free(stripe_buf);
+        stripe_buf = NULL;
+        display_show_preview(false);
+        return ESP_FAIL;
+    }
+
+    const coproc_preview_request_t request = {
+        .width = CONFIG_PREVIEW_WIDTH,
+        .height = CONFIG_PREVIEW_HEIGHT,
+        .max_fps = CONFIG_PREVIEW_MAX_FPS,
+        .frames_in_flight = CONFIG_PREVIEW_FRAMES_IN_FLIGHT,
+    };
+    if (coproc_link_send(COPROC_MSG_PREVIEW_START, &request, sizeof(request)) != ESP_OK) {
+        ESP_LOGW(TAG, "Preview request not sent, co-processor link down");
+    }
+
+    ESP_LOGI(TAG, "Preview started");
+    return ESP_OK;
+}
+
+esp_err_t camera_preview_stop(void)
+{
+    if (preview_task_handle == NULL) {
+        return ESP_OK;
+    }
+
+    coproc_link_send(COPROC_MSG_PREVIEW_STOP, NULL, 0);
+    preview_running = false;
+    xTaskNotifyGive(preview_task_handle);
+
+    // Wait for the task to finish its stripe
+    int timeout = STOP_TIMEOUT_MS / 10;
+    while (preview_task_handle != NULL && timeout > 0) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        timeout--;
+    }
+    if (preview_task_handle != NULL) {
+        ESP_LOGW(TAG, "Preview task did not stop in time");
+    }
+
+    display_show_preview(false);
+    ESP_LOGI(TAG, "Preview stopped after %lu frames", (unsigned long)stats.frames_drawn);
+
+    return ESP_OK;
+}
+
+bool camera_preview_is_running(void)
+{
+    return preview_running;
+}
+
+esp_err_t camera_preview_get_stats(camera_preview_stats_t *out)
+{
+    if (out == NULL) {
+        return ESP_FAIL;
+    }
+
+    *out = stats;
+    out->running = preview_running;
+    out->link_bytes = link_bytes;
+    out->decode_mean_us = stats.frames_drawn > 0 ? (uint32_t)(decode_sum_us / stats.frames_drawn) : 0;
+    out->draw_mean_us = stats.frames_drawn > 0 ? (uint32_t)(draw_sum_us / stats.frames_drawn) : 0;
+
+    return ESP_OK;
+}
+
+esp_err_t camera_preview_get_status_string(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size < 64) {
+        return ESP_FAIL;
+    }
+
+    camera_preview_stats_t snapshot;
+    camera_preview_get_stats(&snapshot);
+    if (snapshot.frames_drawn == 0) {
+        snprintf(buffer, buffer_size, "%s", ui_string(UI_STR_PREVIEW_WAITING));
+        return ESP_OK;
+    }
+
+    snprintf(buffer, buffer_size, ui_string(UI_STR_PREVIEW_STATS),
+             (unsigned long)(snapshot.fps_x10 / 10), (unsigned long)(snapshot.fps_x10 % 10),
+             (unsigned long)snapshot.link_kbps, (unsigned long)link_percent(snapshot.link_kbps),
+             (unsigned long)(snapshot.decode_mean_us / 1000), (unsigned long)(snapshot.decode_mean_us % 1000 / 100),
+             (unsigned long)snapshot.frames_stale);
+
+    return ESP_OK;
+}
@@ -0,0 +1,102 @@
+#ifndef CAMERA_PREVIEW_H
+#define CAMERA_PREVIEW_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file camera_preview.h
+ * @brief Camera thumbnails from the co-processor, drawn straight to the panel
+ *
+ * While the preview runs, the co-processor sends CONFIG_PREVIEW_WIDTH x
+ * CONFIG_PREVIEW_HEIGHT RGB565 frames as RLE-coded stripes
+ * (COPROC_MSG_PREVIEW_STRIPE). The link RX task queues each stripe in a
+ * lock-free ring; the preview task decodes it, scaled by
+ * CONFIG_PREVIEW_SCALE, into a DMA-capable stripe buffer and draws that into
+ * the preview screen region without going through LVGL.
+ *
+ * Every frame is acknowledged, and the co-processor keeps at most
+ * CONFIG_PREVIEW_FRAMES_IN_FLIGHT frames unacknowledged, so the frame rate
+ * follows what the ESP can draw. When the preview task still holds stripes
+ * of a frame older than the newest complete one, it drops them.
+ */
+
+/**
+ * @brief Preview statistics since the preview started
+ */
+typedef struct {
+    bool running;
+    uint32_t frames_drawn;
+    uint32_t frames_stale;          // Dropped because a newer frame was complete
+    uint32_t stripes_overflow;      // Dropped because the ring was full
+    uint32_t stripes_bad;           // Malformed header or RLE data
+    uint64_t link_bytes;            // Stripe frames including link framing
+    uint32_t decode_mean_us;        // Per drawn frame, without the panel transfers
+    uint32_t decode_max_us;
+    uint32_t draw_mean_us;          // Panel transfers per drawn frame
+    uint32_t fps_x10;               // Last second
+    uint32_t link_kbps;             // Last second
+} camera_preview_stats_t;
+
+/**
+ * @brief Register the stripe handler on the co-processor link
+ *
+ * Call after coproc_module_init().
+ *
+ * @return ESP_OK on success, error code from the link otherwise
+ */
+esp_err_t camera_preview_init(void);
+
+/**
+ * @brief Show the preview screen and request the stream
+ *
+ * The screen says it is waiting until the first frame arrives, e.g. while
+ * the co-processor is still booting.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM, ESP_ERR_INVALID_STATE if not
+ *         initialized, ESP_FAIL if the task cannot be created
+ */
+esp_err_t camera_preview_start(void);
+
+/**
+ * @brief Stop the stream and return to the main screen
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t camera_preview_stop(void);
+
+/**
+ * @brief Check whether the preview is running
+ *
+ * @return true between camera_preview_start() and camera_preview_stop()
+ */
+bool camera_preview_is_running(void);
+
+/**
+ * @brief Get preview statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t camera_preview_get_stats(camera_preview_stats_t *stats);
+
+/**
+ * @brief Get the statistics line shown above the preview
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 64 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t camera_preview_get_status_string(char *buffer, size_t buffer_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAMERA_PREVIEW_H
@@ -0,0 +1,1096 @@
+#include "conn_manager.h"
+#include "service_task.h"
+#include "wifi_module.h"
+#include "project_config.h"
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#ifndef CONFIG_NET_CA_PEM
+#include <esp_crt_bundle.h>
+#endif
+
+static const char *TAG = "ConnManager";
+
+#define HOST_MAX_LEN            64
+
+/**
+ * @brief One connection, pooled or made for a single request
+ */
+typedef struct {
+    bool open;                  // Socket (and TLS session) established
+    bool busy;                  // Lent to a request or being opened or closed
+    bool expired;               // Marked by the idle job, waiting for the closer task
+    bool pooled;                // Slot of the pool, otherwise heap-allocated
+    bool tls;
+    char host[HOST_MAX_LEN];
+    uint16_t port;
+    mbedtls_net_context net;
+    mbedtls_ssl_context ssl;
+    int64_t idle_since_us;
+} conn_t;
+
+typedef struct {
+    bool tls;
+    char host[HOST_MAX_LEN];
+    uint16_t port;
+    const char *path;           // From the URL, may start with '?' or be empty
+} url_parts_t;
+
+/**
+ * @brief Serialized TLS session of the last handshake with one host
+ */
+typedef struct {
+    char host[HOST_MAX_LEN];
+    uint16_t port;
+    uint16_t len;               // 0 when empty
+    int64_t saved_s;            // Wall clock at the handshake
+    uint8_t data[CONFIG_NET_SESSION_MAX_BYTES];
+} session_entry_t;
+
+/**
+ * @brief Buffered reader over a connection
+ */
+typedef struct {
+    conn_t *conn;
+    uint8_t *buf;
+    size_t size;
+    size_t pos;
+    size_t len;
+    size_t received;            // Total bytes read from the connection
+    uint32_t timeout_ms;
+    int64_t last_io_us;
+} reader_t;
+
+// Module state
+static bool module_initialized = false;
+static volatile bool reuse_enabled = true;
+static volatile bool prefetch_running = false;
+static bool closer_running = false;             // Under pool_lock
+static conn_t pool[CONFIG_NET_CONN_POOL_SIZE];
+static SemaphoreHandle_t pool_lock = NULL;     // Pool slots and the session cache
+static service_job_handle_t idle_job = NULL;
+static mbedtls_ssl_config tls_conf;
+#ifdef CONFIG_NET_CA_PEM
+static mbedtls_x509_crt ca_chain;
+#endif
+
+// Session tickets survive deep sleep; RTC memory is zeroed on a reset, leaving every entry empty
+static RTC_DATA_ATTR session_entry_t session_cache[CONFIG_NET_SESSION_CACHE_HOSTS];
+
+// Statistics
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static conn_manager_stats_t stats = {0};
+
+static int tls_random(void *ctx, unsigned char *buf, size_t len)
+{
+    esp_fill_random(buf, len);
+    return 0;
+}
+
+static esp_err_t parse_url(const char *url, url_parts_t *parts)
+{
+    const char *p;
+    if (strncmp(url, "https://", 8) == 0) {
+        parts->tls = true;
+        parts->port = 443;
+        p = url + 8;
+    } else if (strncmp(url, "http://", 7) == 0) {
+        parts->tls = false;
+        parts->port = 80;
+        p = url + 7;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t host_len = strcspn(p, ":/?");
+    if (host_len == 0 || host_len >= sizeof(parts->host)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(parts->host, p, host_len);
+    parts->host[host_len] = '\0';
+    p += host_len;
+
+    if (*p == ':') {
+        char *end;
+        long port = strtol(p + 1, &end, 10);
+        if (port <= 0 || port > 65535) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        parts->port = (uint16_t)port;
+        p = end;
+    }
+    parts->path = p;
+    return ESP_OK;
+}
+
+static bool host_kept_alive(const char *host)
+{
+    const char *list = CONFIG_NET_KEEPALIVE_HOSTS;
+    size_t host_len = strlen(host);
+    while (*list != '\0') {
+        size_t n = strcspn(list, ",");
+        if (n == host_len && strncasecmp(list, host, host_len) == 0) {
+            return true;
+        }
+        list += n;
+        if (*list == ',') {
+            list++;
+        }
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Session cache
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Offer the cached session for the connection's host, if still fresh
+ *
+ * @return true when a session was set on the TLS context
+ */
+static bool session_offer(conn_t *conn)
+{
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    uint8_t *data = heap_caps_malloc(CONFIG_NET_SESSION_MAX_BYTES, MALLOC_CAP_INTERNAL);
+    if (data == NULL) {
+        return false;
+    }
+
+    size_t len = 0;
+    int64_t now_s = (int64_t)time(NULL);
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_NET_SESSION_CACHE_HOSTS; i++) {
+        session_entry_t *entry = &session_cache[i];
+        if (entry->len == 0 || entry->port != conn->port || strcmp(entry->host, conn->host) != 0) {
+            continue;
+        }
+        // A clock set after the handshake makes the age meaningless, drop it too
+        if (now_s < entry->saved_s || now_s - entry->saved_s > CONFIG_NET_SESSION_MAX_AGE_S) {
+            entry->len = 0;
+        } else {
+            len = entry->len;
+            memcpy(data, entry->data, len);
+        }
+        break;
+    }
+    xSemaphoreGive(pool_lock);
+
+    bool offered = false;
+    if (len > 0) {
+        mbedtls_ssl_session session;
+        mbedtls_ssl_session_init(&session);
+        offered = mbedtls_ssl_session_load(&session, data, len) == 0 &&
+                  mbedtls_ssl_set_session(&conn->ssl, &session) == 0;
+        mbedtls_ssl_session_free(&session);
+    }
+    heap_caps_free(data);
+    return offered;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Store the session of a completed handshake, replacing the oldest entry
+ */
+static void session_store(conn_t *conn)
+{
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    uint8_t *data = heap_caps_malloc(CONFIG_NET_SESSION_MAX_BYTES, MALLOC_CAP_INTERNAL);
+    if (data == NULL) {
+        return;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    size_t len = 0;
+    int ret = mbedtls_ssl_get_session(&conn->ssl, &session);
+    if (ret == 0) {
+        ret = mbedtls_ssl_session_save(&session, data, CONFIG_NET_SESSION_MAX_BYTES, &len);
+    }
+    mbedtls_ssl_session_free(&session);
+    if (ret != 0) {
+        // Too large usually means the peer certificate is kept, see sdkconfig.defaults
+        ESP_LOGW(TAG, "Session for %s not cached (-0x%04x)", conn->host, (unsigned)-ret);
+        heap_caps_free(data);
+        return;
+    }
+
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    // Same host, else an empty entry, else the oldest
+    session_entry_t *target = &session_cache[0];
+    for (int i = 0; i < CONFIG_NET_SESSION_CACHE_HOSTS; i++) {
+        session_entry_t *entry = &session_cache[i];
+        if (entry->len > 0 && entry->port == conn->port && strcmp(entry->host, conn->host) == 0) {
+            target = entry;
+            break;
+        }
+        if (target->len > 0 && (entry->len == 0 || entry->saved_s < target->saved_s)) {
+            target = entry;
+        }
+    }
+    strncpy(target->host, conn->host, sizeof(target->host) - 1);
+    target->host[sizeof(target->host) - 1] = '\0';
+    target->port = conn->port;
+    target->saved_s = (int64_t)time(NULL);
+    memcpy(target->data, data, len);
+    target->len = (uint16_t)len;
+    xSemaphoreGive(pool_lock);
+
+    heap_caps_free(data);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Connections
+// -----------------------------------------------------------------------------
+
+static void conn_set_timeout(conn_t *conn, uint32_t timeout_ms)
+{
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    setsockopt(conn->net.fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(conn->net.fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+/**
+ * @brief Check an idle connection for data or a close from the server
+ *
+ * Nothing is expected between responses, so readable means closed (FIN or
+ * TLS alert).
+ */
+static bool conn_peer_closed(const conn_t *conn)
+{
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(conn->net.fd, &readable);
+    struct timeval zero = {0};
+    return select(conn->net.fd + 1, &readable, NULL, NULL, &zero) != 0;
+}
+
+static void conn_close(conn_t *conn)
+{
+    if (!conn->open) {
+        return;
+    }
+    if (conn->tls) {
+        mbedtls_ssl_close_notify(&conn->ssl);
+        mbedtls_ssl_free(&conn->ssl);
+    }
+    mbedtls_net_free(&conn->net);
+    conn->open = false;
+}
+
+static esp_err_t conn_open(conn_t *conn, uint32_t timeout_ms, conn_exchange_t *exchange)
+{
+    char port[6];
+    snprintf(port, sizeof(port), "%u", conn->port);
+    int64_t start_us = esp_timer_get_time();
+
+    mbedtls_net_init(&conn->net);
+    int ret = mbedtls_net_connect(&conn->net, conn->host, port, MBEDTLS_NET_PROTO_TCP);
+    if (ret != 0) {
+        ESP_LOGW(TAG, "Connect to %s:%s failed (-0x%04x)", conn->host, port, (unsigned)-ret);
+        mbedtls_net_free(&conn->net);
+        return ESP_FAIL;
+    }
+    conn_set_timeout(conn, timeout_ms);
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.connects++;
+    taskEXIT_CRITICAL(&stats_lock);
+
+    if (conn->tls) {
+        mbedtls_ssl_init(&conn->ssl);
+        ret = mbedtls_ssl_setup(&conn->ssl, &tls_conf);
+        if (ret == 0) {
+            ret = mbedtls_ssl_set_hostname(&conn->ssl, conn->host);
+        }
+        if (ret != 0) {
+            ESP_LOGE(TAG, "TLS setup failed (-0x%04x)", (unsigned)-ret);
+            mbedtls_ssl_free(&conn->ssl);
+            mbedtls_net_free(&conn->net);
+            return ESP_ERR_NO_MEM;
+        }
+        mbedtls_ssl_set_bio(&conn->ssl, &conn->net, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+        bool ticket = reuse_enabled && session_offer(conn);
+        int64_t handshake_start_us = esp_timer_get_time();
+        while ((ret = mbedtls_ssl_handshake(&conn->ssl)) != 0) {
+            if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+                break;
+            }
+        }
+        if (ret != 0) {
+            ESP_LOGW(TAG, "TLS handshake with %s failed (-0x%04x)", conn->host, (unsigned)-ret);
+            mbedtls_ssl_free(&conn->ssl);
+            mbedtls_net_free(&conn->net);
+            return ESP_FAIL;
+        }
+        uint32_t handshake_ms = (uint32_t)((esp_timer_get_time() - handshake_start_us) / 1000);
+
+        taskENTER_CRITICAL(&stats_lock);
+        if (ticket) {
+            stats.handshakes_ticket++;
+            stats.handshake_ms_ticket += handshake_ms;
+        } else {
+            stats.handshakes_full++;
+            stats.handshake_ms_full += handshake_ms;
+        }
+        taskEXIT_CRITICAL(&stats_lock);
+
+        exchange->handshake = true;
+        exchange->ticket_offered = ticket;
+        if (reuse_enabled) {
+            session_store(conn);
+        }
+        ESP_LOGD(TAG, "TLS to %s in %lu ms (%s)", conn->host, (unsigned long)handshake_ms,
+                 ticket ? "ticket offered" : "full");
+    }
+
+    conn->open = true;
+    exchange->connect_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    return ESP_OK;
+}
+
+/**
+ * @brief Take an idle pooled connection to the host, or a slot for a new one
+ *
+ * A slot for a new connection is a free one, else the longest idle one
+ * (closed here), else a heap connection that is not pooled.
+ *
+ * @param reused Set when the returned connection is open already
+ * @return NULL on allocation failure
+ */
+static conn_t *conn_acquire(const url_parts_t *url, bool poolable, bool *reused)
+{
+    conn_t *found = NULL;
+    conn_t *spare = NULL;
+    conn_t *evict = NULL;
+    *reused = false;
+
+    if (poolable) {
+        xSemaphoreTake(pool_lock, portMAX_DELAY);
+        for (int i = 0; i < CONFIG_NET_CONN_POOL_SIZE; i++) {
+            conn_t *conn = &pool[i];
+            if (conn->busy) {
+                continue;
+            }
+            if (conn->open && conn->tls == url->tls && conn->port == url->port &&
+                strcmp(conn->host, url->host) == 0) {
+                found = conn;
+                break;
+            }
+            if (!conn->open && spare == NULL) {
+                spare = conn;
+            } else if (conn->open && (evict == NULL || conn->idle_since_us < evict->idle_since_us)) {
+                evict = conn;
+            }
+        }
+        if (found != NULL) {
+            spare = found;
+            evict = NULL;
+        } else if (spare != NULL) {
+            evict = NULL;
+        } else {
+            spare = evict;
+        }
+        if (spare != NULL) {
+            spare->busy = true;
+        }
+        xSemaphoreGive(pool_lock);
+    }
+
+    if (evict != NULL) {
+        conn_close(evict);
+    }
+    if (found != NULL) {
+        if (!conn_peer_closed(found)) {
+            *reused = true;
+            return found;
+        }
+        conn_close(found);
+    }
+
+    conn_t *conn = spare;
+    if (conn == NULL) {
+        conn = heap_caps_calloc(1, sizeof(conn_t), MALLOC_CAP_INTERNAL);
+        if (conn == NULL) {
+            return NULL;
+        }
+    }
+    conn->tls = url->tls;
+    conn->port = url->port;
+    strncpy(conn->host, url->host, sizeof(conn->host) - 1);
+    conn->host[sizeof(conn->host) - 1] = '\0';
+    return conn;
+}
+
+/**
+ * @brief Give a connection back, keeping it open in the pool if keep is set
+ */
+static void conn_release(conn_t *conn, bool keep)
+{
+    if (!keep || !conn->pooled || !reuse_enabled) {
+        conn_close(conn);
+    }
+    if (!conn->pooled) {
+        heap_caps_free(conn);
+        return;
+    }
+
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    conn->idle_since_us = esp_timer_get_time();
+    conn->busy = false;
+    bool open = conn->open;
+    xSemaphoreGive(pool_lock);
+
+    if (open) {
+        service_job_wake(idle_job);
+    }
+}
+
+static int conn_write(conn_t *conn, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        int n = conn->tls ? mbedtls_ssl_write(&conn->ssl, data, len)
+                          : mbedtls_net_send(&conn->net, data, len);
+        if (n == MBEDTLS_ERR_SSL_WANT_READ || n == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read from the connection
+ *
+ * @return Bytes read, 0 when the server closed, negative on error or timeout
+ */
+static int conn_read(conn_t *conn, uint8_t *buf, size_t len)
+{
+    for (;;) {
+        int n = conn->tls ? mbedtls_ssl_read(&conn->ssl, buf, len) : mbedtls_net_recv(&conn->net, buf, len);
+        if (n == MBEDTLS_ERR_SSL_WANT_READ || n == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (n == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+            return 0;
+        }
+        return n;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// HTTP/1.1
+// -----------------------------------------------------------------------------
+
+static esp_err_t reader_error(const reader_t *r, int n)
+{
+    if (n == 0) {
+        return ESP_FAIL;
+    }
+    // Socket timeouts surface as plain receive errors
+    int64_t silent_ms = (esp_timer_get_time() - r->last_io_us) / 1000;
+    return silent_ms >= r->timeout_ms ? ESP_ERR_TIMEOUT : ESP_FAIL;
+}
+
+/**
+ * @brief Read more data into the buffer, after moving unread data to the front
+ */
+static int reader_fill(reader_t *r)
+{
+    if (r->pos > 0) {
+        memmove(r->buf, r->buf + r->pos, r->len - r->pos);
+        r->len -= r->pos;
+        r->pos = 0;
+    }
+    if (r->len == r->size) {
+        return -1;      // Header line longer than the buffer
+    }
+    int n = conn_read(r->conn, r->buf + r->len, r->size - r->len);
+    if (n > 0) {
+        r->len += (size_t)n;
+        r->received += (size_t)n;
+        r->last_io_us = esp_timer_get_time();
+    }
+    return n;
+}
+
+/**
+ * @brief Next line without its CRLF, NUL-terminated in the buffer
+ *
+ * @return The line (valid until the next read), NULL on error with err set
+ */
+static char *reader_line(reader_t *r, esp_err_t *err)
+{
+    for (;;) {
+        uint8_t *start = r->buf + r->pos;
+        uint8_t *lf = memchr(start, '\n', r->len - r->pos);
+        if (lf != NULL) {
+            *lf = '\0';
+            if (lf > start && lf[-1] == '\r') {
+                lf[-1] = '\0';
+            }
+            r->pos = (size_t)(lf - r->buf) + 1;
+            return (char *)start;
+        }
+        int n = reader_fill(r);
+        if (n <= 0) {
+            *err = reader_error(r, n);
+            return NULL;
+        }
+    }
+}
+
+/**
+ * @brief Pass length body bytes to the callback, or everything up to the close if length is negative
+ */
+static esp_err_t read_body(reader_t *r, int64_t length, net_data_cb_t on_body, void *user_ctx)
+{
+    while (length != 0) {
+        if (r->pos == r->len) {
+            int n = reader_fill(r);
+            if (n == 0 && length < 0) {
+                return ESP_OK;
+            }
+            if (n <= 0) {
+                return reader_error(r, n);
+            }
+        }
+        size_t n = r->len - r->pos;
+        if (length > 0 && (int64_t)n > length) {
+            n = (size_t)length;
+        }
+        esp_err_t ret = on_body(r->buf + r->pos, n, user_ctx);
+        r->pos += n;
+        if (length > 0) {
+            length -= (int64_t)n;
+        }
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t read_chunked_body(reader_t *r, net_data_cb_t on_body, void *user_ctx)
+{
+    esp_err_t err = ESP_FAIL;
+    for (;;) {
+        char *line = reader_line(r, &err);
+        if (line == NULL) {
+            return err;
+        }
+        char *end;
+        unsigned long size = strtoul(line, &end, 16);
+        if (end == line) {
+            return ESP_FAIL;
+        }
+        if (size == 0) {
+            // Trailers up to the empty line
+            do {
+                line = reader_line(r, &err);
+                if (line == NULL) {
+                    return err;
+                }
+            } while (line[0] != '\0');
+            return ESP_OK;
+        }
+
+        esp_err_t ret = read_body(r, (int64_t)size, on_body, user_ctx);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        if (reader_line(r, &err) == NULL) {
+            return err;
+        }
+    }
+}
+
+static bool header_is(const char *line, const char *name, const char **value)
+{
+    size_t len = strlen(name);
+    if (strncasecmp(line, name, len) != 0 || line[len] != ':') {
+        return false;
+    }
+    *value = line + len + 1;
+    while (**value == ' ' || **value == '\t') {
+        (*value)++;
+    }
+    return true;
+}
+
+static bool value_has_token(const char *value, const char *token)
+{
+    size_t len = strlen(token);
+    for (const char *p = value; *p != '\0'; p++) {
+        if (strncasecmp(p, token, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Send the request and read the whole response
+ *
+ * @param keep Set when the connection can carry another request
+ */
+static esp_err_t http_exchange(reader_t *r, const url_parts_t *url, const net_request_t *request,
+                               bool keep_alive, net_data_cb_t on_body, void *user_ctx,
+                               conn_exchange_t *exchange, bool *keep)
+{
+    *keep = false;
+
+    bool default_port = url->port == (url->tls ? 443 : 80);
+    char port[8] = "";
+    if (!default_port) {
+        snprintf(port, sizeof(port), ":%u", url->port);
+    }
+    int len = snprintf((char *)r->buf, r->size,
+                       "%s %s%s HTTP/1.1\r\nHost: %s%s\r\nUser-Agent: smart-assistant\r\nConnection: %s\r\n",
+                       request->method == NET_METHOD_POST ? "POST" : "GET",
+                       url->path[0] == '/' ? "" : "/", url->path, url->host, port,
+                       keep_alive ? "keep-alive" : "close");
+    if (request->content_type != NULL && len < (int)r->size) {
+        len += snprintf((char *)r->buf + len, r->size - len, "Content-Type: %s\r\n", request->content_type);
+    }
+    if ((request->method == NET_METHOD_POST || request->body_len > 0) && len < (int)r->size) {
+        len += snprintf((char *)r->buf + len, r->size - len, "Content-Length: %u\r\n",
+                        (unsigned)request->body_len);
+    }
+    if (len + 2 >= (int)r->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(r->buf + len, "\r\n", 2);
+    len += 2;
+
+    if (conn_write(r->conn, r->buf, (size_t)len) != 0 ||
+        (request->body_len > 0 && conn_write(r->conn, request->body, request->body_len) != 0)) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = ESP_FAIL;
+    char *line = reader_line(r, &err);
+    if (line == NULL) {
+        return err;
+    }
+    if (strncmp(line, "HTTP/1.", 7) != 0 || strlen(line) < 12) {
+        return ESP_FAIL;
+    }
+    exchange->status = atoi(line + 9);
+    bool reusable = line[7] != '0';
+
+    int64_t length = -1;
+    bool chunked = false;
+    while ((line = reader_line(r, &err)) != NULL && line[0] != '\0') {
+        const char *value;
+        if (header_is(line, "Content-Length", &value)) {
+            length = strtoll(value, NULL, 10);
+        } else if (header_is(line, "Transfer-Encoding", &value)) {
+            chunked = value_has_token(value, "chunked");
+        } else if (header_is(line, "Connection", &value)) {
+            if (value_has_token(value, "close")) {
+                reusable = false;
+            } else if (value_has_token(value, "keep-alive")) {
+                reusable = true;
+            }
+        }
+    }
+    if (line == NULL) {
+        return err;
+    }
+    exchange->headers_us = esp_timer_get_time();
+
+    if (exchange->status == 204 || exchange->status == 304 || exchange->status < 200) {
+        length = 0;
+    }
+    esp_err_t ret;
+    if (chunked) {
+        ret = read_chunked_body(r, on_body, user_ctx);
+    } else {
+        ret = read_body(r, length, on_body, user_ctx);
+        if (length < 0) {
+            reusable = false;   // Body ended by the close
+        }
+    }
+    *keep = ret == ESP_OK && reusable && r->pos == r->len;
+    return ret;
+}
+
+// -----------------------------------------------------------------------------
+// Idle connections and prefetch
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Close the connections the idle job marked, then exit
+ *
+ * The TLS close_notify is a socket write, so it runs here with the
+ * connection stack instead of on the service task.
+ */
+static void closer_task(void *arg)
+{
+    for (;;) {
+        conn_t *conn = NULL;
+        xSemaphoreTake(pool_lock, portMAX_DELAY);
+        for (int i = 0; i < CONFIG_NET_CONN_POOL_SIZE; i++) {
+            if (pool[i].expired) {
+                conn = &pool[i];
+                break;
+            }
+        }
+        if (conn == NULL) {
+            closer_running = false;
+        }
+        xSemaphoreGive(pool_lock);
+        if (conn == NULL) {
+            break;
+        }
+
+        ESP_LOGD(TAG, "Closing idle connection to %s", conn->host);
+        // A dead link must not hold the close for the request timeout
+        conn_set_timeout(conn, CONFIG_NET_CONN_CLOSE_TIMEOUT_MS);
+        conn_close(conn);
+
+        xSemaphoreTake(pool_lock, portMAX_DELAY);
+        conn->expired = false;
+        conn->busy = false;
+        xSemaphoreGive(pool_lock);
+
+        taskENTER_CRITICAL(&stats_lock);
+        stats.idle_closes++;
+        taskEXIT_CRITICAL(&stats_lock);
+    }
+
+    vTaskDelete(NULL);
+}
+
+static uint32_t idle_check_job(void *user_ctx)
+{
+    int64_t now_us = esp_timer_get_time();
+    bool any_open = false;
+    bool any_expired = false;
+    bool start_closer = false;
+
+    // Only marks expired connections: closing them writes to the socket
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_NET_CONN_POOL_SIZE; i++) {
+        conn_t *conn = &pool[i];
+        any_expired |= conn->expired;
+        if (!conn->open || conn->busy) {
+            any_open |= conn->open;
+            continue;
+        }
+        if (now_us - conn->idle_since_us >= (int64_t)CONFIG_NET_CONN_IDLE_TIMEOUT_MS * 1000 ||
+            !wifi_is_connected() || conn_peer_closed(conn)) {
+            conn->busy = true;
+            conn->expired = true;
+            any_expired = true;
+        } else {
+            any_open = true;
+        }
+    }
+    if (any_expired && !closer_running) {
+        closer_running = true;
+        start_closer = true;
+    }
+    xSemaphoreGive(pool_lock);
+
+    if (start_closer &&
+        xTaskCreate(closer_task, "conn_close", CONFIG_TASK_STACK_CONN, NULL,
+                    CONFIG_TASK_PRIORITY_CONN, NULL) != pdPASS) {
+        // Marked connections stay out of the pool; try again at the next check
+        ESP_LOGW(TAG, "Failed to create closer task");
+        xSemaphoreTake(pool_lock, portMAX_DELAY);
+        closer_running = false;
+        xSemaphoreGive(pool_lock);
+        return CONFIG_NET_CONN_IDLE_CHECK_MS;
+    }
+
+    return any_open ? CONFIG_NET_CONN_IDLE_CHECK_MS : SERVICE_JOB_IDLE;
+}
+
+static void prefetch_task(void *arg)
+{
+    url_parts_t *url = (url_parts_t *)arg;
+    bool reused = false;
+    conn_t *conn = conn_acquire(url, true, &reused);
+    if (conn != NULL) {
+        bool keep = reused;
+        if (!reused) {
+            conn_exchange_t exchange = {0};
+            keep = conn_open(conn, CONFIG_NET_TIMEOUT_MS, &exchange) == ESP_OK;
+            if (keep) {
+                ESP_LOGI(TAG, "Prefetched connection to %s in %lu ms", url->host,
+                         (unsigned long)exchange.connect_ms);
+            }
+        }
+        conn_release(conn, keep);
+    }
+
+    heap_caps_free(url);
+    prefetch_running = false;
+    vTaskDelete(NULL);
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+esp_err_t conn_manager_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Connection manager already initialized");
+        return ESP_OK;
+    }
+
+    pool_lock = xSemaphoreCreateMutex();
+    if (pool_lock == NULL) {
+        ESP_LOGE(TAG, "Failed to create pool lock");
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < CONFIG_NET_CONN_POOL_SIZE; i++) {
+        pool[i].pooled = true;
+    }
+
+    mbedtls_ssl_config_init(&tls_conf);
+    int ret = mbedtls_ssl_config_defaults(&tls_conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                          MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "TLS configuration failed (-0x%04x)", (unsigned)-ret);
+        return ESP_FAIL;
+    }
+    mbedtls_ssl_conf_authmode(&tls_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_rng(&tls_conf, tls_random, NULL);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&tls_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+#ifdef CONFIG_NET_CA_PEM
+    mbedtls_x509_crt_init(&ca_chain);
+    ret = mbedtls_x509_crt_parse(&ca_chain, (const unsigned char *)CONFIG_NET_CA_PEM, sizeof(CONFIG_NET_CA_PEM));
+    if (ret != 0) {
+        ESP_LOGE(TAG, "CONFIG_NET_CA_PEM does not parse (-0x%04x)", (unsigned)-ret);
+        return ESP_FAIL;
+    }
+    mbedtls_ssl_conf_ca_chain(&tls_conf, &ca_chain, NULL);
+#else
+    if (esp_crt_bundle_attach(&tls_conf) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to attach the certificate bundle");
+        return ESP_FAIL;
+    }
+#endif
+
+    const service_job_config_t job_config = {
+        .name = "conn_idle",
+        .run = idle_check_job,
+        .user_ctx = NULL,
+        .first_delay_ms = SERVICE_JOB_IDLE,
+        .dedicated_stack = CONFIG_TASK_STACK_CONN_IDLE,
+        .dedicated_priority = CONFIG_TASK_PRIORITY_CONN,
+    };
+    if (service_job_add(&job_config, &idle_job) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add idle connection job");
+        return ESP_FAIL;
+    }
+
+    int cached = 0;
+    for (int i = 0; i < CONFIG_NET_SESSION_CACHE_HOSTS; i++) {
+        cached += session_cache[i].len > 0;
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Connection manager initialized (pool %d, keep-alive hosts \"%s\", %d cached sessions)",
+             CONFIG_NET_CONN_POOL_SIZE, CONFIG_NET_KEEPALIVE_HOSTS, cached);
+
+    return ESP_OK;
+}
+
+esp_err_t conn_manager_perform(const net_request_t *request, uint32_t timeout_ms,
+                               net_data_cb_t on_body, void *user_ctx, conn_exchange_t *exchange)
+{
+    memset(exchange, 0, sizeof(*exchange));
+    if (!module_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    url_parts_t url;
+    if (parse_url(request->url, &url) != ESP_OK) {
+        ESP_LOGW(TAG, "Unsupported URL %s", request->url);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t *buf = heap_caps_malloc(CONFIG_NET_DIRECT_BUFFER_SIZE, MALLOC_CAP_INTERNAL);
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    bool poolable = reuse_enabled && host_kept_alive(url.host);
+    esp_err_t ret = ESP_FAIL;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = false;
+        conn_t *conn = conn_acquire(&url, poolable, &reused);
+        if (conn == NULL) {
+            ret = ESP_ERR_NO_MEM;
+            break;
+        }
+        memset(exchange, 0, sizeof(*exchange));
+        exchange->reused = reused;
+        if (reused) {
+            conn_set_timeout(conn, timeout_ms);
+        } else {
+            ret = conn_open(conn, timeout_ms, exchange);
+            if (ret != ESP_OK) {
+                conn_release(conn, false);
+                break;
+            }
+        }
+
+        reader_t reader = {
+            .conn = conn,
+            .buf = buf,
+            .size = CONFIG_NET_DIRECT_BUFFER_SIZE,
+            .timeout_ms = timeout_ms,
+            .last_io_us = esp_timer_get_time(),
+        };
+        bool keep = false;
+        ret = http_exchange(&reader, &url, request, poolable, on_body, user_ctx, exchange, &keep);
+        conn_release(conn, keep);
+
+        // A pooled connection the server closed in the meantime fails before any response;
+        // a GET is safe to repeat on a new one
+        if (!reused || ret == ESP_OK || reader.received > 0 || request->method != NET_METHOD_GET) {
+            if (reused && ret == ESP_OK) {
+                taskENTER_CRITICAL(&stats_lock);
+                stats.reuses++;
+                taskEXIT_CRITICAL(&stats_lock);
+            }
+            break;
+        }
+        ESP_LOGD(TAG, "Pooled connection to %s was closed, retrying", url.host);
+        taskENTER_CRITICAL(&stats_lock);
+        stats.stale_retries++;
+        taskEXIT_CRITICAL(&stats_lock);
+    }
+
+    heap_caps_free(buf);
+    return ret;
+}
+
+esp_err_t conn_manager_prefetch(const char *url)
+{
+    if (!module_initialized || !wifi_is_connected()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    url_parts_t *parts = heap_caps_malloc(sizeof(url_parts_t), MALLOC_CAP_INTERNAL);
+    if (parts == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (parse_url(url, parts) != ESP_OK || !reuse_enabled || !host_kept_alive(parts->host)) {
+        heap_caps_free(parts);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    bool pooled = false;
+    xSemaphoreTake(pool_lock, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_NET_CONN_POOL_SIZE; i++) {
+        if (pool[i].open && !pool[i].busy && pool[i].port == parts->port && strcmp(pool[i].host, parts->host) == 0) {
+            pooled = true;
+            break;
+        }
+    }
+    bool start = !pooled && !prefetch_running;
+    if (start) {
+        prefetch_running = true;
+    }
+    xSemaphoreGive(pool_lock);
+
+    if (pooled) {
+        heap_caps_free(parts);
+        return ESP_OK;
+    }
+    if (!start) {
+        heap_caps_free(parts);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (xTaskCreate(prefetch_task, "conn_prefetch", CONFIG_TASK_STACK_CONN, parts,
+                    CONFIG_TASK_PRIORITY_CONN, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create prefetch task");
+        heap_caps_free(parts);
+        prefetch_running = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.prefetches++;
+    taskEXIT_CRITICAL(&stats_lock);
+    return ESP_OK;
+}
+
+void conn_manager_set_reuse(bool enable)
+{
+    reuse_enabled = enable;
+    if (!enable && module_initialized) {
+        for (int i = 0; i < CONFIG_NET_CONN_POOL_SIZE; i++) {
+            xSemaphoreTake(pool_lock, portMAX_DELAY);
+            bool idle = pool[i].open && !pool[i].busy;
+            if (idle) {
+                pool[i].busy = true;
+            }
+            xSemaphoreGive(pool_lock);
+            if (idle) {
+                conn_close(&pool[i]);
+                xSemaphoreTake(pool_lock, portMAX_DELAY);
+                pool[i].busy = false;
+                xSemaphoreGive(pool_lock);
+            }
+        }
+    }
+}
+
+esp_err_t conn_manager_get_stats(conn_manager_stats_t *out)
+{
+    if (out == NULL) {
+        return ESP_FAIL;
+    }
+
+    uint32_t open = 0;
+    if (module_initialized) {
+        xSemaphoreTake(pool_lock, portMAX_DELAY);
+        for (int i = 0; i < CONFIG_NET_CONN_POOL_SIZE; i++) {
+            open += pool[i].open;
+        }
+        xSemaphoreGive(pool_lock);
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    taskEXIT_CRITICAL(&stats_lock);
+    out->open_connections = open;
+    return ESP_OK;
+}
@@ -0,0 +1,116 @@
+#ifndef CONN_MANAGER_H
+#define CONN_MANAGER_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "net_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file conn_manager.h
+ * @brief Kept-alive HTTP(S) connections and TLS session tickets for direct requests
+ *
+ * Requests to the hosts in CONFIG_NET_KEEPALIVE_HOSTS leave their connection
+ * open in a pool of CONFIG_NET_CONN_POOL_SIZE, so the next request to the
+ * same host skips TCP connect and TLS handshake. Connections idle longer than
+ * CONFIG_NET_CONN_IDLE_TIMEOUT_MS, or closed by the server, are dropped by a
+ * service job.
+ *
+ * When a new TLS connection is needed, the session ticket of the last
+ * handshake with that host is offered, so the server can resume instead of
+ * doing a full handshake. Tickets are kept in RTC memory and survive deep
+ * sleep.
+ *
+ * All TLS connections share one mbedtls configuration and CA chain.
+ */
+
+/**
+ * @brief How one request was served
+ */
+typedef struct {
+    int status;                 // HTTP status, 0 if no response
+    bool reused;                // Kept-alive connection from the pool
+    bool handshake;             // New TLS handshake made
+    bool ticket_offered;        // Handshake offered a cached session ticket
+    uint32_t connect_ms;        // TCP connect and handshake, 0 when reused
+    int64_t headers_us;         // esp_timer time the response headers were complete
+} conn_exchange_t;
+
+/**
+ * @brief Connection statistics
+ */
+typedef struct {
+    uint32_t connects;              // New TCP connections
+    uint32_t handshakes_full;       // TLS handshakes without a ticket
+    uint32_t handshakes_ticket;     // TLS handshakes offering a ticket
+    uint64_t handshake_ms_full;     // Summed handshake time
+    uint64_t handshake_ms_ticket;
+    uint32_t reuses;                // Requests served on a pooled connection
+    uint32_t stale_retries;         // Pooled connection found closed, request retried
+    uint32_t idle_closes;           // Expired idle and closed by the closer task
+    uint32_t prefetches;
+    uint32_t open_connections;
+} conn_manager_stats_t;
+
+/**
+ * @brief Set up the shared TLS configuration and the idle job
+ *
+ * @return ESP_OK on success, ESP_FAIL if the CA chain cannot be loaded
+ */
+esp_err_t conn_manager_init(void);
+
+/**
+ * @brief Make one HTTP/1.1 request on a pooled or new connection
+ *
+ * @param request Request (URL, method, body); on_data and user_ctx are ignored
+ * @param timeout_ms Connect and inactivity timeout
+ * @param on_body Called for every piece of the response body
+ * @param user_ctx Passed to on_body
+ * @param exchange Filled in also on failure
+ * @return ESP_OK when the complete response was read, ESP_ERR_TIMEOUT,
+ *         the callback's error if it aborted, ESP_FAIL on other errors
+ */
+esp_err_t conn_manager_perform(const net_request_t *request, uint32_t timeout_ms,
+                               net_data_cb_t on_body, void *user_ctx, conn_exchange_t *exchange);
+
+/**
+ * @brief Open a connection to the host of url in the background
+ *
+ * For a request that is about to be made (e.g. when a long press that opens
+ * the dialogue begins). Does nothing when an idle connection to the host is
+ * pooled already.
+ *
+ * @param url Any URL on the host
+ * @return ESP_OK if a connection is being opened or pooled,
+ *         ESP_ERR_NOT_SUPPORTED if the host is not kept alive,
+ *         ESP_ERR_INVALID_STATE without Wi-Fi or while another prefetch runs
+ */
+esp_err_t conn_manager_prefetch(const char *url);
+
+/**
+ * @brief Enable or disable connection reuse and session tickets
+ *
+ * Disabling closes all pooled connections. For comparison runs.
+ *
+ * @param enable true to reuse (default)
+ */
+void conn_manager_set_reuse(bool enable);
+
+/**
+ * @brief Get connection statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t conn_manager_get_stats(conn_manager_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONN_MANAGER_H
@@ -0,0 +1,318 @@
+#include "coproc_link.h"
+#include "project_config.h"
+#include <driver/uart.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <string.h>
+
+static const char *TAG = "CoprocLink";
+
+#define LINK_HEADER_LEN         5       // sync, type, seq, len_lo, len_hi
+#define LINK_CRC_LEN            2
+#define LINK_MAX_HANDLERS       16
+#define LINK_UART_RX_BUFFER     4096
+#define LINK_UART_TX_BUFFER     2048
+
+typedef struct {
+    uint8_t type;
+    coproc_link_handler_t handler;
+    void *user_ctx;
+} link_handler_entry_t;
+
+typedef enum {
+    RX_WAIT_SYNC,
+    RX_HEADER,
+    RX_PAYLOAD,
+    RX_CRC
+} rx_state_t;
+
+// Module state
+static bool module_initialized = false;
+static TaskHandle_t rx_task_handle = NULL;
+static SemaphoreHandle_t tx_mutex = NULL;
+static uint8_t tx_seq = 0;
+static link_handler_entry_t handlers[LINK_MAX_HANDLERS];
+static int handler_count = 0;
+static coproc_link_stats_t stats = {0};
+
+// RX parser state (only touched by the RX task)
+static rx_state_t rx_state = RX_WAIT_SYNC;
+static uint8_t rx_header[LINK_HEADER_LEN];
+static uint8_t rx_payload[COPROC_LINK_MAX_PAYLOAD];
+static uint8_t rx_crc[LINK_CRC_LEN];
+static size_t rx_pos = 0;
+static size_t rx_len = 0;
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+ */
+static uint16_t crc16_update(uint16_t crc, const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void dispatch_frame(uint8_t type, const uint8_t *payload, size_t len)
+{
+    for (int i = 0; i < handler_count; i++) {
+        if (handlers[i].type == type && handlers[i].handler != NULL) {
+            handlers[i].handler(type, payload, len, handlers[i].user_ctx);
+            return;
+        }
+    }
+    ESP_LOGD(TAG, "No handler for message 0x%02x (%u bytes)", type, (unsigned)len);
+}
+
+static void rx_byte(uint8_t byte)
+{
+    switch (rx_state) {
+        case RX_WAIT_SYNC:
+            if (byte == COPROC_LINK_SYNC_BYTE) {
+                rx_header[0] = byte;
+                rx_pos = 1;
+                rx_state = RX_HEADER;
+            } else {
+                stats.framing_errors++;
+            }
+            break;
+
+        case RX_HEADER:
+            rx_header[rx_pos++] = byte;
+            if (rx_pos == LINK_HEADER_LEN) {
+                rx_len = rx_header[3] | ((size_t)rx_header[4] << 8);
+                if (rx_len > COPROC_LINK_MAX_PAYLOAD) {
+                    stats.framing_errors++;
+                    rx_state = RX_WAIT_SYNC;
+                } else {
+                    rx_pos = 0;
+                    rx_state = (rx_len > 0) ? RX_PAYLOAD : RX_CRC;
+                }
+            }
+            break;
+
+        case RX_PAYLOAD:
+            rx_payload[rx_pos++] = byte;
+            if (rx_pos == rx_len) {
+                rx_pos = 0;
+                rx_state = RX_CRC;
+            }
+            break;
+
+        case RX_CRC:
+            rx_crc[rx_pos++] = byte;
+            if (rx_pos == LINK_CRC_LEN) {
+                uint16_t crc = crc16_update(0xFFFF, &rx_header[1], LINK_HEADER_LEN - 1);
+                crc = crc16_update(crc, rx_payload, rx_len);
+                uint16_t received = rx_crc[0] | ((uint16_t)rx_crc[1] << 8);
+                if (crc == received) {
+                    stats.frames_rx++;
+                    dispatch_frame(rx_header[1], rx_payload, rx_len);
+                } else {
+                    stats.crc_errors++;
+                    ESP_LOGW(TAG, "CRC mismatch on message 0x%02x", rx_header[1]);
+                }
+                rx_state = RX_WAIT_SYNC;
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Link receive task
+ */
+static void coproc_link_rx_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Link RX task started");
+
+    uint8_t buf[128];
+    while (1) {
+        int n = uart_read_bytes(CONFIG_COPROC_UART_PORT, buf, sizeof(buf), pdMS_TO_TICKS(100));
+        if (n <= 0) {
+            continue;
+        }
+        stats.bytes_rx += n;
+        for (int i = 0; i < n; i++) {
+            rx_byte(buf[i]);
+        }
+    }
+}
+
+esp_err_t coproc_link_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Co-processor link already initialized");
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Initializing co-processor link on UART%d (TX:%d, RX:%d)",
+             CONFIG_COPROC_UART_PORT, CONFIG_COPROC_UART_TX_GPIO, CONFIG_COPROC_UART_RX_GPIO);
+
+    const uart_config_t uart_config = {
+        .baud_rate = CONFIG_COPROC_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    esp_err_t ret = uart_driver_install(CONFIG_COPROC_UART_PORT, LINK_UART_RX_BUFFER, LINK_UART_TX_BUFFER, 0, NULL, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install UART driver: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = uart_param_config(CONFIG_COPROC_UART_PORT, &uart_config);
+    if (ret == ESP_OK) {
+        ret = uart_set_pin(CONFIG_COPROC_UART_PORT, CONFIG_COPROC_UART_TX_GPIO, CONFIG_COPROC_UART_RX_GPIO,
+                           UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure UART: %s", esp_err_to_name(ret));
+        uart_driver_delete(CONFIG_COPROC_UART_PORT);
+        return ret;
+    }
+
+    tx_mutex = xSemaphoreCreateMutex();
+    if (tx_mutex == NULL) {
+        uart_driver_delete(CONFIG_COPROC_UART_PORT);
+        return ESP_ERR_NO_MEM;
+    }
+
+    BaseType_t task_ret = xTaskCreate(
+        coproc_link_rx_task,
+        "coproc_rx",
+        CONFIG_TASK_STACK_COPROC_LINK,
+        NULL,
+        CONFIG_TASK_PRIORITY_COPROC_LINK,
+        &rx_task_handle
+    );
+
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create link RX task");
+        vSemaphoreDelete(tx_mutex);
+        tx_mutex = NULL;
+        uart_driver_delete(CONFIG_COPROC_UART_PORT);
+        return ESP_FAIL;
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Co-processor link initialized at %d baud", CONFIG_COPROC_UART_BAUD);
+
+    return ESP_OK;
+}
+
+// Writes one frame; tx_mutex must be held
+static esp_err_t write_frame(uint8_t type, const void *payload, size_t len)
+{
+    uint8_t header[LINK_HEADER_LEN] = {
+        COPROC_LINK_SYNC_BYTE, type, tx_seq++, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8)
+    };
+    uint16_t crc = crc16_update(0xFFFF, &header[1], LINK_HEADER_LEN - 1);
+    crc = crc16_update(crc, payload, len);
+    uint8_t trailer[LINK_CRC_LEN] = { (uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8) };
+
+    int written = uart_write_bytes(CONFIG_COPROC_UART_PORT, header, sizeof(header));
+    if (len > 0) {
+        written += uart_write_bytes(CONFIG_COPROC_UART_PORT, payload, len);
+    }
+    written += uart_write_bytes(CONFIG_COPROC_UART_PORT, trailer, sizeof(trailer));
+
+    stats.frames_tx++;
+    stats.bytes_tx += written;
+
+    return (written == (int)(LINK_HEADER_LEN + len + LINK_CRC_LEN)) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t coproc_link_send(uint8_t type, const void *payload, size_t len)
+{
+    if (!module_initialized) {
+        return ESP_FAIL;
+    }
+    if (len > COPROC_LINK_MAX_PAYLOAD || (len > 0 && payload == NULL)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(tx_mutex, portMAX_DELAY);
+    esp_err_t ret = write_frame(type, payload, len);
+    xSemaphoreGive(tx_mutex);
+
+    return ret;
+}
+
+esp_err_t coproc_link_try_send(uint8_t type, const void *payload, size_t len)
+{
+    if (!module_initialized) {
+        return ESP_FAIL;
+    }
+    if (len > COPROC_LINK_MAX_PAYLOAD || (len > 0 && payload == NULL)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if (xSemaphoreTake(tx_mutex, 0) != pdTRUE) {
+        stats.tx_busy++;
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // uart_write_bytes() only returns at once when the whole frame fits the TX ring buffer
+    size_t free_bytes = 0;
+    esp_err_t ret = uart_get_tx_buffer_free_size(CONFIG_COPROC_UART_PORT, &free_bytes);
+    if (ret == ESP_OK && free_bytes < LINK_HEADER_LEN + len + LINK_CRC_LEN) {
+        ret = ESP_ERR_TIMEOUT;
+    }
+    if (ret == ESP_OK) {
+        ret = write_frame(type, payload, len);
+    } else {
+        stats.tx_busy++;
+    }
+    xSemaphoreGive(tx_mutex);
+
+    return ret;
+}
+
+esp_err_t coproc_link_register_handler(uint8_t type, coproc_link_handler_t handler, void *user_ctx)
+{
+    for (int i = 0; i < handler_count; i++) {
+        if (handlers[i].type == type) {
+            handlers[i].handler = handler;
+            handlers[i].user_ctx = user_ctx;
+            return ESP_OK;
+        }
+    }
+
+    if (handler_count >= LINK_MAX_HANDLERS) {
+        ESP_LOGE(TAG, "No free handler slot for message 0x%02x", type);
+        return ESP_ERR_NO_MEM;
+    }
+
+    handlers[handler_count].type = type;
+    handlers[handler_count].handler = handler;
+    handlers[handler_count].user_ctx = user_ctx;
+    handler_count++;
+    return ESP_OK;
+}
+
+esp_err_t coproc_link_get_stats(coproc_link_stats_t *out)
+{
+    if (!module_initialized || out == NULL) {
+        return ESP_FAIL;
+    }
+
+    memcpy(out, &stats, sizeof(coproc_link_stats_t));
+    return ESP_OK;
+}
+
+const char* coproc_action_to_string(uint8_t action)
+{
+    static const char *names[COPROC_ACTION_COUNT] = {
+        "EMPTY", "BED", "PC", "STUDY", "PHONE", "TABLET", "DRINK"
+    };
+    return (action < COPROC_ACTION_COUNT) ? names[action] : "UNKNOWN";
+}
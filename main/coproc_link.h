@@ -0,0 +1,283 @@
+#ifndef COPROC_LINK_H
+#define COPROC_LINK_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file coproc_link.h
+ * @brief Framed UART link between the ESP32-S3 and the Orange Pi co-processor
+ *
+ * Frame layout (little endian):
+ *   0xA5 | type | seq | len (2 bytes) | payload (len bytes) | crc16 (2 bytes)
+ * The CRC covers type, seq, len and payload.
+ */
+
+#define COPROC_LINK_SYNC_BYTE       0xA5
+#define COPROC_LINK_MAX_PAYLOAD     512
+#define COPROC_LINK_FRAME_OVERHEAD  7       // Sync, type, seq, len and CRC around the payload
+
+/**
+ * @brief Link message types
+ */
+typedef enum {
+    COPROC_MSG_PING             = 0x01,     // ESP -> OPi, liveness probe
+    COPROC_MSG_PONG             = 0x02,     // OPi -> ESP
+    COPROC_MSG_SUSPEND          = 0x10,     // ESP -> OPi, stop pipeline and suspend (payload: u8 power_off)
+    COPROC_MSG_SUSPEND_ACK      = 0x11,     // OPi -> ESP, safe to suspend / cut power
+    COPROC_MSG_RESUME           = 0x12,     // ESP -> OPi, restart pipeline
+    COPROC_MSG_READY            = 0x13,     // OPi -> ESP, pipeline running (after boot or resume)
+    COPROC_MSG_ACTION_RESULT    = 0x20,     // OPi -> ESP, payload: coproc_action_result_t
+    COPROC_MSG_PREVIEW_START    = 0x30,     // ESP -> OPi, payload: coproc_preview_request_t
+    COPROC_MSG_PREVIEW_STOP     = 0x31,     // ESP -> OPi
+    COPROC_MSG_PREVIEW_STRIPE   = 0x32,     // OPi -> ESP, payload: coproc_preview_stripe_t + RLE data
+    COPROC_MSG_PREVIEW_ACK      = 0x33,     // ESP -> OPi, frame drawn or dropped (payload: u16 frame_id)
+    COPROC_MSG_NET_REQUEST      = 0x40,     // ESP -> OPi, payload: coproc_net_request_t + URL + content type
+    COPROC_MSG_NET_REQUEST_BODY = 0x41,     // ESP -> OPi, payload: coproc_net_chunk_t + body bytes
+    COPROC_MSG_NET_ACCEPT       = 0x42,     // OPi -> ESP, proxy took the request (payload: coproc_net_accept_t)
+    COPROC_MSG_NET_RESPONSE     = 0x43,     // OPi -> ESP, payload: coproc_net_response_t
+    COPROC_MSG_NET_RESPONSE_BODY = 0x44,    // OPi -> ESP, payload: coproc_net_chunk_t + body bytes
+    COPROC_MSG_NET_CREDIT       = 0x45,     // ESP -> OPi, body chunks consumed (payload: u8 id, u8 chunks)
+    COPROC_MSG_NET_CANCEL       = 0x46,     // ESP -> OPi, abandon the request (payload: u8 id)
+    COPROC_MSG_SFX_PLAY         = 0x50,     // ESP -> OPi, payload: coproc_sfx_play_t
+    COPROC_MSG_SFX_STARTED      = 0x51,     // OPi -> ESP, payload: coproc_sfx_started_t
+} coproc_msg_type_t;
+
+/**
+ * @brief Action recognition result payload
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t action;             // coproc_action_t
+    uint8_t confidence;         // 0-100
+    uint32_t frame_id;          // Camera frame the result belongs to
+} coproc_action_result_t;
+
+/**
+ * @brief Preview stream request
+ *
+ * The co-processor scales the camera image to width x height and sends it
+ * as RGB565 stripes, with at most frames_in_flight frames not yet
+ * acknowledged by PREVIEW_ACK.
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t width;
+    uint16_t height;
+    uint8_t max_fps;
+    uint8_t frames_in_flight;
+} coproc_preview_request_t;
+
+/**
+ * @brief Preview stripe header, followed by the RLE-coded pixels of its rows
+ *
+ * Pixels are RGB565, little endian, left to right and top to bottom. The
+ * data is a sequence of packets, none crossing the end of the stripe:
+ *   0x00-0x7F  literal: (byte + 1) pixels follow
+ *   0x80-0xFF  run: the following pixel repeats (byte - 0x7F) times
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t frame_id;
+    uint16_t y;                 // First row
+    uint8_t rows;
+    uint8_t flags;              // COPROC_PREVIEW_LAST_STRIPE
+} coproc_preview_stripe_t;
+
+#define COPROC_PREVIEW_LAST_STRIPE  0x01
+
+/**
+ * @brief HTTP(S) request for the proxy on the co-processor
+ *
+ * Followed by the URL and the content type, each NUL-terminated (empty
+ * content type for none), then by body_len bytes of NET_REQUEST_BODY
+ * chunks. The proxy answers NET_ACCEPT at once, NET_RESPONSE when the
+ * upstream headers arrive and then NET_RESPONSE_BODY chunks, never more
+ * than window chunks ahead of the NET_CREDIT messages.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t id;                 // Non-zero, unique among open requests
+    uint8_t method;             // COPROC_NET_METHOD_*
+    uint8_t window;             // Response chunks the ESP can buffer
+    uint8_t flags;              // Reserved, 0
+    uint32_t body_len;
+    uint32_t timeout_ms;        // Upstream timeout
+} coproc_net_request_t;
+
+#define COPROC_NET_METHOD_GET       0
+#define COPROC_NET_METHOD_POST      1
+
+typedef struct __attribute__((packed)) {
+    uint8_t id;
+    uint8_t error;              // COPROC_NET_ERR_*
+} coproc_net_accept_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t id;
+    uint8_t error;              // COPROC_NET_ERR_*, upstream failed before the headers
+    uint16_t status;            // HTTP status
+    uint32_t content_length;    // COPROC_NET_LENGTH_UNKNOWN for chunked upstream responses
+} coproc_net_response_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t id;
+    uint8_t flags;              // COPROC_NET_CHUNK_*
+} coproc_net_chunk_t;
+
+#define COPROC_NET_ERR_NONE         0
+#define COPROC_NET_ERR_BUSY         1   // No free request slot
+#define COPROC_NET_ERR_NO_UPLINK    2   // Proxy has no network
+#define COPROC_NET_ERR_UPSTREAM     3   // Connect, TLS or read failure
+#define COPROC_NET_ERR_TIMEOUT      4
+#define COPROC_NET_ERR_BAD_REQUEST  5
+
+#define COPROC_NET_CHUNK_LAST       0x01
+#define COPROC_NET_CHUNK_ERROR      0x02    // Upstream failed mid-body; also LAST
+#define COPROC_NET_LENGTH_UNKNOWN   UINT32_MAX
+#define COPROC_NET_CHUNK_MAX        (COPROC_LINK_MAX_PAYLOAD - sizeof(coproc_net_chunk_t))
+
+/**
+ * @brief Start a UI sound effect on the co-processor's speaker
+ *
+ * The effect is mixed over any speech playing, which is ducked while it
+ * lasts. The co-processor answers SFX_STARTED once the effect is queued to
+ * the DAC, or with COPROC_SFX_FLAG_DROPPED when it could not play it.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t seq;                // Echoed in SFX_STARTED
+    uint8_t effect;             // coproc_sfx_t
+    uint8_t gain;               // 255 = as recorded
+    uint8_t flags;              // Reserved, 0
+    uint32_t event_age_us;      // Triggering event -> this message sent
+} coproc_sfx_play_t;
+
+/**
+ * @brief Sound effect start report
+ *
+ * held_us lets the ESP take the co-processor's time out of the round trip
+ * and so estimate the one-way link delay.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t seq;
+    uint8_t flags;              // COPROC_SFX_FLAG_*
+    uint8_t voices;             // Effects playing, this one included
+    uint8_t mixer_load;         // Mixer CPU over the last second, 0.1% units (saturates)
+    uint32_t held_us;           // SFX_PLAY received -> this message sent
+    uint32_t until_sound_us;    // SFX_PLAY received -> first sample at the DAC
+} coproc_sfx_started_t;
+
+#define COPROC_SFX_FLAG_STOLEN      0x01    // All voices were busy, the oldest was cut
+#define COPROC_SFX_FLAG_DROPPED     0x02    // Unknown effect or audio not running
+
+/**
+ * @brief UI sound effects, preloaded on the co-processor (tools/sfx_mixer.py)
+ */
+typedef enum {
+    COPROC_SFX_TAP,
+    COPROC_SFX_SHAKE,
+    COPROC_SFX_PRESS,
+    COPROC_SFX_COUNT
+} coproc_sfx_t;
+
+/**
+ * @brief Recognized actions (README.yaml action_recognition examples)
+ */
+typedef enum {
+    COPROC_ACTION_EMPTY,
+    COPROC_ACTION_BED,
+    COPROC_ACTION_PC,
+    COPROC_ACTION_STUDY,
+    COPROC_ACTION_PHONE,
+    COPROC_ACTION_TABLET,
+    COPROC_ACTION_DRINK,
+    COPROC_ACTION_COUNT
+} coproc_action_t;
+
+/**
+ * @brief Received message handler, called from the link RX task
+ *
+ * @param type Message type
+ * @param payload Payload bytes (valid only during the call)
+ * @param len Payload length
+ * @param user_ctx Context passed at registration
+ */
+typedef void (*coproc_link_handler_t)(uint8_t type, const uint8_t *payload, size_t len, void *user_ctx);
+
+/**
+ * @brief Link statistics
+ */
+typedef struct {
+    uint32_t frames_tx;
+    uint32_t frames_rx;
+    uint32_t bytes_tx;
+    uint32_t bytes_rx;
+    uint32_t crc_errors;
+    uint32_t framing_errors;
+    uint32_t tx_busy;               // coproc_link_try_send() calls that found the link busy
+} coproc_link_stats_t;
+
+/**
+ * @brief Initialize the UART link and start the RX task
+ *
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t coproc_link_init(void);
+
+/**
+ * @brief Send one frame
+ *
+ * @param type Message type
+ * @param payload Payload bytes (may be NULL when len is 0)
+ * @param len Payload length (at most COPROC_LINK_MAX_PAYLOAD)
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if payload too long, ESP_FAIL on error
+ */
+esp_err_t coproc_link_send(uint8_t type, const void *payload, size_t len);
+
+/**
+ * @brief Send one frame only if that does not wait
+ *
+ * For callers that must not block, such as service jobs: fails when another
+ * task is sending or the UART TX buffer has no room for the whole frame.
+ *
+ * @param type Message type
+ * @param payload Payload bytes (may be NULL when len is 0)
+ * @param len Payload length (at most COPROC_LINK_MAX_PAYLOAD)
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the link is busy, ESP_ERR_INVALID_SIZE if
+ *         payload too long, ESP_FAIL on error
+ */
+esp_err_t coproc_link_try_send(uint8_t type, const void *payload, size_t len);
+
+/**
+ * @brief Register the handler of one message type
+ *
+ * @param type Message type
+ * @param handler Handler callback (NULL to remove)
+ * @param user_ctx Context passed to the handler
+ * @return ESP_OK on success
+ */
+esp_err_t coproc_link_register_handler(uint8_t type, coproc_link_handler_t handler, void *user_ctx);
+
+/**
+ * @brief Get link statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if not initialized or stats is NULL
+ */
+esp_err_t coproc_link_get_stats(coproc_link_stats_t *stats);
+
+/**
+ * @brief Get printable name of an action
+ *
+ * @param action Action id
+ * @return Constant string (e.g. "PC", "STUDY")
+ */
+const char* coproc_action_to_string(uint8_t action);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COPROC_LINK_H
@@ -0,0 +1,478 @@
+#include "coproc_module.h"
+#include "presence_module.h"
+#include "arrival_predictor.h"
+#include "project_config.h"
+#include "ui_strings.h"
+#include <driver/gpio.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+#include <string.h>
+#include <stdio.h>
+
+static const char *TAG = "CoprocModule";
+
+// Link events
+#define EVENT_READY             BIT0
+#define EVENT_SUSPEND_ACK       BIT1
+
+// Task commands
+#define CMD_RESUME              0x01
+
+// Module state
+static bool module_initialized = false;
+static TaskHandle_t coproc_task_handle = NULL;
+static EventGroupHandle_t link_events = NULL;
+static volatile coproc_state_t current_state = COPROC_STATE_OFF;
+static coproc_power_stats_t stats = {0};
+static uint64_t resume_result_sum_ms = 0;
+static uint32_t resume_result_count = 0;
+
+// Latest result
+static coproc_action_result_t last_result = {0};
+static bool have_result = false;
+
+// Resume latency measurement
+static int64_t resume_start_us = 0;
+static volatile bool awaiting_first_result = false;
+static int64_t suspended_since_us = 0;
+static int64_t boot_retry_after_us = 0;     // No power-on before this after a failed boot
+
+// Arrival pre-warm waiting for READY, reported to the predictor from the task
+static volatile bool prewarm_pending = false;
+
+// Co-processor state across an ESP deep sleep (power and wake lines are held meanwhile)
+static RTC_DATA_ATTR coproc_state_t deep_sleep_state = COPROC_STATE_OFF;
+static RTC_DATA_ATTR bool deep_sleep_state_valid = false;
+
+static void set_state(coproc_state_t new_state)
+{
+    if (new_state == current_state) {
+        return;
+    }
+
+    bool was_down = (current_state == COPROC_STATE_SUSPENDED || current_state == COPROC_STATE_OFF);
+    bool is_down = (new_state == COPROC_STATE_SUSPENDED || new_state == COPROC_STATE_OFF);
+    if (!was_down && is_down) {
+        suspended_since_us = esp_timer_get_time();
+    } else if (was_down && !is_down && suspended_since_us > 0) {
+        stats.seconds_suspended += (uint32_t)((esp_timer_get_time() - suspended_since_us) / 1000000);
+        suspended_since_us = 0;
+    }
+
+    ESP_LOGI(TAG, "Co-processor: %s -> %s", coproc_state_to_string(current_state), coproc_state_to_string(new_state));
+    current_state = new_state;
+
+    if (new_state == COPROC_STATE_RUNNING && prewarm_pending) {
+        prewarm_pending = false;
+        arrival_predictor_prewarm_done("coproc", ESP_OK);
+    }
+}
+
+static void set_power(bool on)
+{
+    gpio_set_level(CONFIG_COPROC_POWER_GPIO, on ? 1 : 0);
+}
+
+/**
+ * @brief Cut power after a boot that never reported READY
+ *
+ * A peer that did not boot must not keep drawing current while the state
+ * says off; the next power-on waits CONFIG_COPROC_BOOT_RETRY_MS.
+ */
+static void boot_failed(void)
+{
+    ESP_LOGW(TAG, "Co-processor did not boot within %d ms, powering it off", CONFIG_COPROC_BOOT_TIMEOUT_MS);
+    stats.resume_failures++;
+    awaiting_first_result = false;
+    set_power(false);
+    set_state(COPROC_STATE_OFF);
+    boot_retry_after_us = esp_timer_get_time() + (int64_t)CONFIG_COPROC_BOOT_RETRY_MS * 1000;
+    if (prewarm_pending) {
+        prewarm_pending = false;
+        arrival_predictor_prewarm_done("coproc", ESP_ERR_TIMEOUT);
+    }
+}
+
+static void pulse_wake_line(void)
+{
+    gpio_set_level(CONFIG_COPROC_WAKE_GPIO, 1);
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_COPROC_WAKE_PULSE_MS));
+    gpio_set_level(CONFIG_COPROC_WAKE_GPIO, 0);
+}
+
+static void on_link_message(uint8_t type, const uint8_t *payload, size_t len, void *user_ctx)
+{
+    switch (type) {
+        case COPROC_MSG_READY:
+            xEventGroupSetBits(link_events, EVENT_READY);
+            break;
+
+        case COPROC_MSG_SUSPEND_ACK:
+            xEventGroupSetBits(link_events, EVENT_SUSPEND_ACK);
+            break;
+
+        case COPROC_MSG_ACTION_RESULT:
+            if (len < sizeof(coproc_action_result_t)) {
+                ESP_LOGW(TAG, "Short action result (%u bytes)", (unsigned)len);
+                break;
+            }
+            memcpy(&last_result, payload, sizeof(coproc_action_result_t));
+            have_result = true;
+
+            if (awaiting_first_result) {
+                awaiting_first_result = false;
+                uint32_t latency_ms = (uint32_t)((esp_timer_get_time() - resume_start_us) / 1000);
+                stats.last_resume_result_ms = latency_ms;
+                if (latency_ms > stats.max_resume_result_ms) {
+                    stats.max_resume_result_ms = latency_ms;
+                }
+                resume_result_sum_ms += latency_ms;
+                resume_result_count++;
+                stats.avg_resume_result_ms = (uint32_t)(resume_result_sum_ms / resume_result_count);
+                ESP_LOGI(TAG, "First result %lu ms after resume (avg %lu ms, max %lu ms)",
+                         (unsigned long)latency_ms, (unsigned long)stats.avg_resume_result_ms,
+                         (unsigned long)stats.max_resume_result_ms);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void do_suspend(void)
+{
+    bool power_off = (CONFIG_COPROC_AWAY_ACTION == COPROC_AWAY_ACTION_POWER_OFF);
+    uint8_t payload = power_off ? 1 : 0;
+
+    set_state(COPROC_STATE_SUSPENDING);
+    xEventGroupClearBits(link_events, EVENT_SUSPEND_ACK | EVENT_READY);
+    coproc_link_send(COPROC_MSG_SUSPEND, &payload, sizeof(payload));
+
+    EventBits_t bits = xEventGroupWaitBits(link_events, EVENT_SUSPEND_ACK, pdTRUE, pdFALSE,
+                                           pdMS_TO_TICKS(CONFIG_COPROC_SUSPEND_ACK_TIMEOUT_MS));
+    if (!(bits & EVENT_SUSPEND_ACK)) {
+        // Never cut power on a peer that may still be writing its SD card
+        ESP_LOGW(TAG, "No suspend acknowledgement, keeping co-processor running");
+        set_state(COPROC_STATE_RUNNING);
+        return;
+    }
+
+    if (power_off) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_COPROC_SHUTDOWN_GRACE_MS));
+        set_power(false);
+        set_state(COPROC_STATE_OFF);
+    } else {
+        set_state(COPROC_STATE_SUSPENDED);
+    }
+    stats.suspends++;
+}
+
+static void do_resume(void)
+{
+    coproc_state_t from = current_state;
+    resume_start_us = esp_timer_get_time();
+    awaiting_first_result = true;
+    xEventGroupClearBits(link_events, EVENT_READY);
+
+    if (from == COPROC_STATE_OFF) {
+        set_power(true);
+        set_state(COPROC_STATE_BOOTING);
+    } else {
+        pulse_wake_line();
+        coproc_link_send(COPROC_MSG_RESUME, NULL, 0);
+        set_state(COPROC_STATE_RESUMING);
+    }
+
+    uint32_t timeout_ms = (from == COPROC_STATE_OFF) ? CONFIG_COPROC_BOOT_TIMEOUT_MS : CONFIG_COPROC_RESUME_TIMEOUT_MS;
+    EventBits_t bits = xEventGroupWaitBits(link_events, EVENT_READY, pdFALSE, pdFALSE, pdMS_TO_TICKS(timeout_ms));
+    if (!(bits & EVENT_READY)) {
+        if (from == COPROC_STATE_OFF) {
+            boot_failed();
+            return;
+        }
+        ESP_LOGW(TAG, "Co-processor did not report READY within %lu ms", (unsigned long)timeout_ms);
+        stats.resume_failures++;
+        awaiting_first_result = false;
+        set_state(from);
+        if (prewarm_pending) {
+            prewarm_pending = false;
+            arrival_predictor_prewarm_done("coproc", ESP_ERR_TIMEOUT);
+        }
+        return;
+    }
+
+    stats.resumes++;
+    stats.last_resume_ready_ms = (uint32_t)((esp_timer_get_time() - resume_start_us) / 1000);
+    ESP_LOGI(TAG, "Co-processor ready %lu ms after resume request", (unsigned long)stats.last_resume_ready_ms);
+    set_state(COPROC_STATE_RUNNING);
+}
+
+static void presence_changed(presence_state_t new_state, presence_state_t old_state, void *user_ctx)
+{
+    if (new_state == PRESENCE_STATE_PRESENT && coproc_task_handle != NULL) {
+        xTaskNotify(coproc_task_handle, CMD_RESUME, eSetBits);
+    }
+}
+
+static esp_err_t prewarm_coproc(void *user_ctx)
+{
+    // A boot takes up to a minute: only start it here, READY is reported from the task
+    if (current_state == COPROC_STATE_RUNNING) {
+        return ESP_OK;
+    }
+    prewarm_pending = true;
+    xTaskNotify(coproc_task_handle, CMD_RESUME, eSetBits);
+    return ESP_ERR_NOT_FINISHED;
+}
+
+/**
+ * @brief Co-processor power orchestration task
+ */
+static void coproc_power_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Co-processor power task started");
+
+    while (1) {
+        uint32_t commands = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &commands, pdMS_TO_TICKS(CONFIG_COPROC_POLL_INTERVAL_MS));
+
+        coproc_state_t state = current_state;
+
+        // A READY can also arrive unsolicited (peer rebooted, boot finished)
+        if ((state == COPROC_STATE_BOOTING || state == COPROC_STATE_RESUMING) &&
+            (xEventGroupGetBits(link_events) & EVENT_READY)) {
+            set_state(COPROC_STATE_RUNNING);
+            state = COPROC_STATE_RUNNING;
+        }
+
+        // The cold boot started by init is waited for here rather than in do_resume()
+        if (state == COPROC_STATE_BOOTING &&
+            esp_timer_get_time() - resume_start_us >= (int64_t)CONFIG_COPROC_BOOT_TIMEOUT_MS * 1000) {
+            boot_failed();
+            state = COPROC_STATE_OFF;
+        }
+
+        bool is_down = (state == COPROC_STATE_SUSPENDED || state == COPROC_STATE_OFF);
+        bool retry_held = (state == COPROC_STATE_OFF && esp_timer_get_time() < boot_retry_after_us);
+        if (is_down && retry_held && (commands & CMD_RESUME) && prewarm_pending) {
+            prewarm_pending = false;
+            arrival_predictor_prewarm_done("coproc", ESP_ERR_INVALID_STATE);
+        }
+        if (is_down && !retry_held && ((commands & CMD_RESUME) || presence_get_state() == PRESENCE_STATE_PRESENT)) {
+            do_resume();
+        } else if (state == COPROC_STATE_RUNNING &&
+                   presence_get_state() == PRESENCE_STATE_AWAY &&
+                   presence_get_seconds_in_state() >= CONFIG_COPROC_SUSPEND_AFTER_AWAY_S) {
+            do_suspend();
+        }
+    }
+}
+
+esp_err_t coproc_module_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Co-processor module already initialized");
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Initializing co-processor power orchestration...");
+
+    gpio_config_t out_config = {
+        .pin_bit_mask = (1ULL << CONFIG_COPROC_POWER_GPIO) | (1ULL << CONFIG_COPROC_WAKE_GPIO),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE
+    };
+    esp_err_t ret = gpio_config(&out_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure co-processor GPIOs: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // After a deep sleep the co-processor kept the state it had when the ESP went down;
+    // drive the same levels before releasing the pad holds so power does not glitch
+    bool from_deep_sleep = deep_sleep_state_valid && esp_reset_reason() == ESP_RST_DEEPSLEEP;
+    deep_sleep_state_valid = false;
+    set_power(from_deep_sleep ? (deep_sleep_state != COPROC_STATE_OFF) : false);
+    gpio_set_level(CONFIG_COPROC_WAKE_GPIO, 0);
+    gpio_hold_dis(CONFIG_COPROC_POWER_GPIO);
+    gpio_hold_dis(CONFIG_COPROC_WAKE_GPIO);
+
+    link_events = xEventGroupCreate();
+    if (link_events == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ret = coproc_link_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    coproc_link_register_handler(COPROC_MSG_READY, on_link_message, NULL);
+    coproc_link_register_handler(COPROC_MSG_SUSPEND_ACK, on_link_message, NULL);
+    coproc_link_register_handler(COPROC_MSG_ACTION_RESULT, on_link_message, NULL);
+
+    if (from_deep_sleep) {
+        // Still suspended or off; the task resumes it as soon as presence is reported
+        current_state = deep_sleep_state;
+        suspended_since_us = esp_timer_get_time();
+        ESP_LOGI(TAG, "Co-processor %s across deep sleep", coproc_state_to_string(current_state));
+    } else {
+        // Cold boot the co-processor; READY arrives once Linux and the pipeline are up
+        resume_start_us = esp_timer_get_time();
+        set_power(true);
+        set_state(COPROC_STATE_BOOTING);
+    }
+
+    BaseType_t task_ret = xTaskCreate(
+        coproc_power_task,
+        "coproc_power",
+        CONFIG_TASK_STACK_COPROC_POWER,
+        NULL,
+        CONFIG_TASK_PRIORITY_COPROC_POWER,
+        &coproc_task_handle
+    );
+
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create co-processor power task");
+        return ESP_FAIL;
+    }
+
+    presence_register_listener(presence_changed, NULL);
+    arrival_predictor_register_prewarm("coproc", prewarm_coproc, CONFIG_COPROC_RUNNING_CURRENT_MA, NULL);
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Co-processor orchestration initialized (%s after %ds away)",
+             CONFIG_COPROC_AWAY_ACTION == COPROC_AWAY_ACTION_POWER_OFF ? "power off" : "suspend",
+             CONFIG_COPROC_SUSPEND_AFTER_AWAY_S);
+
+    return ESP_OK;
+}
+
+esp_err_t coproc_prepare_deep_sleep(void)
+{
+    if (!module_initialized) {
+        return ESP_OK;
+    }
+
+    coproc_state_t state = current_state;
+    if (state != COPROC_STATE_SUSPENDED && state != COPROC_STATE_OFF) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    deep_sleep_state = state;
+    deep_sleep_state_valid = true;
+    gpio_hold_en(CONFIG_COPROC_POWER_GPIO);
+    gpio_hold_en(CONFIG_COPROC_WAKE_GPIO);
+    gpio_deep_sleep_hold_en();
+
+    ESP_LOGI(TAG, "Holding co-processor %s through deep sleep", coproc_state_to_string(state));
+    return ESP_OK;
+}
+
+void coproc_cancel_deep_sleep(void)
+{
+    if (!module_initialized || !deep_sleep_state_valid) {
+        return;
+    }
+
+    deep_sleep_state_valid = false;
+    gpio_deep_sleep_hold_dis();
+    gpio_hold_dis(CONFIG_COPROC_POWER_GPIO);
+    gpio_hold_dis(CONFIG_COPROC_WAKE_GPIO);
+}
+
+coproc_state_t coproc_get_state(void)
+{
+    return current_state;
+}
+
+esp_err_t coproc_request_resume(uint32_t timeout_ms)
+{
+    if (!module_initialized) {
+        return ESP_FAIL;
+    }
+    if (current_state == COPROC_STATE_RUNNING) {
+        return ESP_OK;
+    }
+
+    xTaskNotify(coproc_task_handle, CMD_RESUME, eSetBits);
+
+    // Poll the state so callers also return once the task saw an unsolicited READY
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (current_state != COPROC_STATE_RUNNING) {
+        if (esp_timer_get_time() >= deadline) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    return ESP_OK;
+}
+
+esp_err_t coproc_get_last_action(coproc_action_result_t *result)
+{
+    if (!module_initialized || result == NULL) {
+        return ESP_FAIL;
+    }
+    if (!have_result) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    memcpy(result, &last_result, sizeof(coproc_action_result_t));
+    return ESP_OK;
+}
+
+esp_err_t coproc_get_status_string(char *buffer, size_t buffer_size)
+{
+    if (!module_initialized || buffer == NULL || buffer_size < 32) {
+        return ESP_FAIL;
+    }
+
+    if (current_state != COPROC_STATE_RUNNING) {
+        snprintf(buffer, buffer_size, ui_string(UI_STR_ACTION_FORMAT), coproc_state_to_string(current_state));
+    } else if (!have_result) {
+        snprintf(buffer, buffer_size, "%s", ui_string(UI_STR_ACTION_NONE));
+    } else {
+        snprintf(buffer, buffer_size, ui_string(UI_STR_ACTION_FORMAT), coproc_action_to_string(last_result.action));
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t coproc_get_power_stats(coproc_power_stats_t *out)
+{
+    if (!module_initialized || out == NULL) {
+        return ESP_FAIL;
+    }
+
+    memcpy(out, &stats, sizeof(coproc_power_stats_t));
+    if (suspended_since_us > 0) {
+        out->seconds_suspended += (uint32_t)((esp_timer_get_time() - suspended_since_us) / 1000000);
+    }
+    return ESP_OK;
+}
+
+const char* coproc_state_to_string(coproc_state_t state)
+{
+    switch (state) {
+        case COPROC_STATE_OFF:
+            return "Off";
+        case COPROC_STATE_BOOTING:
+            return "Booting";
+        case COPROC_STATE_RUNNING:
+            return "Running";
+        case COPROC_STATE_SUSPENDING:
+            return "Suspending";
+        case COPROC_STATE_SUSPENDED:
+            return "Suspended";
+        case COPROC_STATE_RESUMING:
+            return "Resuming";
+        default:
+            return "Unknown";
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef COPROC_MODULE_H
+#define COPROC_MODULE_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "coproc_link.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Co-processor (Orange Pi) power state as seen from the ESP side
+ */
+typedef enum {
+    COPROC_STATE_OFF,           // Power switch open
+    COPROC_STATE_BOOTING,       // Powered, waiting for READY after a cold boot
+    COPROC_STATE_RUNNING,       // Pipeline running, results expected
+    COPROC_STATE_SUSPENDING,    // SUSPEND sent, waiting for acknowledgement
+    COPROC_STATE_SUSPENDED,     // Suspended to RAM
+    COPROC_STATE_RESUMING       // RESUME sent, waiting for READY
+} coproc_state_t;
+
+/**
+ * @brief What to do with the co-processor after the AWAY period
+ */
+typedef enum {
+    COPROC_AWAY_ACTION_SUSPEND,     // Suspend to RAM, resume over the link
+    COPROC_AWAY_ACTION_POWER_OFF    // Cut power through the GPIO switch, cold boot on return
+} coproc_away_action_t;
+
+/**
+ * @brief Power orchestration statistics
+ */
+typedef struct {
+    uint32_t suspends;                  // Completed suspend/power-off cycles
+    uint32_t resumes;                   // Completed resume/boot cycles
+    uint32_t resume_failures;           // Resumes that timed out waiting for READY
+    uint32_t last_resume_ready_ms;      // Resume request -> READY
+    uint32_t last_resume_result_ms;     // Resume request -> first action result
+    uint32_t avg_resume_result_ms;      // Average resume -> first result
+    uint32_t max_resume_result_ms;      // Worst resume -> first result
+    uint32_t seconds_suspended;         // Total time suspended or powered off
+} coproc_power_stats_t;
+
+/**
+ * @brief Initialize co-processor power orchestration
+ *
+ * Powers the co-processor on, starts the link and the orchestration task, and
+ * hooks into presence changes. Call after presence_module_init().
+ *
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t coproc_module_init(void);
+
+/**
+ * @brief Get current co-processor state
+ *
+ * @return Current state
+ */
+coproc_state_t coproc_get_state(void);
+
+/**
+ * @brief Resume the co-processor and wait until it is running
+ *
+ * Safe to call in any state; returns immediately when already running.
+ *
+ * @param timeout_ms Maximum time to wait for READY
+ * @return ESP_OK when running, ESP_ERR_TIMEOUT if READY did not arrive
+ */
+esp_err_t coproc_request_resume(uint32_t timeout_ms);
+
+/**
+ * @brief Latch the co-processor power and wake lines before ESP deep sleep
+ *
+ * Only allowed while the co-processor is suspended or off, so it never runs
+ * unsupervised. The state is restored by coproc_module_init() after wakeup.
+ *
+ * @return ESP_OK when it is safe to sleep, ESP_ERR_INVALID_STATE while the co-processor is up
+ */
+esp_err_t coproc_prepare_deep_sleep(void);
+
+/**
+ * @brief Release the lines latched by coproc_prepare_deep_sleep() when the ESP stays awake
+ */
+void coproc_cancel_deep_sleep(void);
+
+/**
+ * @brief Get the latest action recognition result
+ *
+ * @param result Pointer to store the result
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no result received yet
+ */
+esp_err_t coproc_get_last_action(coproc_action_result_t *result);
+
+/**
+ * @brief Get formatted action status string for display
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 32 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t coproc_get_status_string(char *buffer, size_t buffer_size);
+
+/**
+ * @brief Get power orchestration statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if not initialized or stats is NULL
+ */
+esp_err_t coproc_get_power_stats(coproc_power_stats_t *stats);
+
+/**
+ * @brief Get printable name of a co-processor state
+ *
+ * @param state Co-processor state
+ * @return Constant string
+ */
+const char* coproc_state_to_string(coproc_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COPROC_MODULE_H
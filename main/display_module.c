@@ -12,10 +12,20 @@
 #include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
 #include <lvgl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "sdkconfig.h"
 #include "fonts/chinese_font_16.h"
+#include "energy_module.h"
+#include "render_watchdog.h"
+#include "draw_accel.h"
+#include "status_bar.h"
+#include "hot_profile.h"
+#include "ui_strings.h"
+#include "project_config.h"
 
 
 static const char *TAG = "DisplayModule";
@@ -42,6 +52,13 @@ static const gpio_num_t TFT_BACKLIGHT = GPIO_NUM_12;
 static const lcd_rgb_element_order_t TFT_COLOR_MODE = COLOR_RGB_ELEMENT_ORDER_BGR;
 static const size_t LV_BUFFER_SIZE = DISPLAY_HORIZONTAL_PIXELS * 25;
 static const int LVGL_UPDATE_PERIOD_MS = 5;
+static const int DISPLAY_WIRE_BYTES_PER_PIXEL = 3;     // 18-bit color goes out as RGB666
+static const int DISPLAY_WINDOW_CMD_BYTES = 11;        // CASET + RASET + RAMWR per bitmap
+
+// ILI9488 scrolling commands
+static const int ILI9488_CMD_NORON = 0x13;
+static const int ILI9488_CMD_VSCRDEF = 0x33;
+static const int ILI9488_CMD_VSCRSADD = 0x37;
 
 // Backlight configuration
 static const ledc_mode_t BACKLIGHT_LEDC_MODE = LEDC_LOW_SPEED_MODE;
@@ -64,18 +81,60 @@ static lv_obj_t *boot_status_label = NULL;
 static lv_obj_t *boot_progress_bar = NULL;
 static lv_obj_t *boot_screen = NULL;
 static lv_obj_t *main_screen = NULL;
+static lv_obj_t *diagnostics_screen = NULL;
+static lv_obj_t *diagnostics_label = NULL;
 static esp_timer_handle_t lvgl_tick_timer = NULL;
+static int64_t flush_start_us = 0;
+static SemaphoreHandle_t ui_lock = NULL;   // Guards every LVGL call; recursive so public calls can nest
 static lv_style_t style_chinese_font;
 
 // Time-related UI components for clock module integration
 static lv_obj_t *time_label = NULL;
 static lv_obj_t *date_label = NULL;
 static char current_time_str[16] = "12:34:56";
+static bool clock_show_seconds = true;
+static int clock_hours = 12;
+static int clock_minutes = 34;
+static int clock_seconds = 56;
 static char current_date_str[32] = "Jul 20, 2025";
+static char current_weather_str[32] = "21C Rainy";
+static int current_brightness = 0;
+
+// Hardware scroll region: screen columns [scroll_start, scroll_start + scroll_size)
+static bool scroll_active = false;
+static lv_coord_t scroll_start = 0;
+static lv_coord_t scroll_size = 0;
+static lv_coord_t scroll_offset = 0;       // Content shift inside the region, 0..scroll_size-1
+static lv_obj_t *scroll_container = NULL;
+static lv_color_t *scroll_scratch = NULL;  // Flush parts that straddle the wrap point
+static uint32_t scroll_lines = 0;
+static uint64_t scroll_band_bytes = 0;
+static uint32_t scroll_split_flushes = 0;
+
+// Camera preview screen: a region LVGL leaves black and preview stripes are drawn into directly
+static lv_obj_t *preview_screen = NULL;
+static lv_obj_t *preview_stats_label = NULL;
+static SemaphoreHandle_t preview_draw_done = NULL;
+static volatile bool preview_draw_pending = false;
+static int64_t preview_draw_start_us = 0;
+
+// Flush accounting, written by the render path
+static SemaphoreHandle_t flush_part_done = NULL;
+static volatile int flush_parts_pending = 0;
+static uint64_t flush_wire_bytes = 0;
+static volatile uint32_t flush_count = 0;
+
+/**
+ * @brief Part of a flush area that maps to contiguous panel columns
+ */
+typedef struct {
+    lv_coord_t x;           // First screen column
+    lv_coord_t len;
+    lv_coord_t panel_x;     // Where the column is stored in frame memory
+} flush_segment_t;
 
-// PIR sensor status UI component
-static lv_obj_t *pir_status_label = NULL;
-static lv_obj_t *motion_status_label = NULL;
+// Action, sensor, weather, assistant and Wi-Fi status, drawn by one widget
+static lv_obj_t *status_bar = NULL;
 
 // Forward declarations
 static bool notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io,
@@ -86,26 +145,131 @@ static esp_err_t display_brightness_init(void);
 static esp_err_t initialize_spi(void);
 static esp_err_t initialize_display(void);
 static esp_err_t initialize_lvgl(void);
+static esp_err_t initialize_display_system(void);
 static void create_boot_screen(void);
 static void create_main_screen(void);
+static void create_diagnostics_screen(void);
+static void create_preview_screen(void);
 static void update_boot_progress(int progress);
 
 static bool notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io,
     esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
     lv_disp_drv_t *disp_driver = (lv_disp_drv_t *)user_ctx;
+    
+    // Preview stripes bypass LVGL and must not complete its flush
+    if (preview_draw_pending) {
+        preview_draw_pending = false;
+        energy_add_active_us(ENERGY_CONSUMER_DISPLAY_SPI, (uint32_t)(esp_timer_get_time() - preview_draw_start_us));
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(preview_draw_done, &woken);
+        return woken == pdTRUE;
+    }
+    
+    // A flush split at the scroll wrap point goes out in parts; only the last one completes it
+    if (flush_parts_pending > 1) {
+        flush_parts_pending--;
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(flush_part_done, &woken);
+        return woken == pdTRUE;
+    }
+    flush_parts_pending = 0;
+    
+    energy_add_active_us(ENERGY_CONSUMER_DISPLAY_SPI, (uint32_t)(esp_timer_get_time() - flush_start_us));
+    render_watchdog_flush_ready();
     lv_disp_flush_ready(disp_driver);
     return false;
 }
 
+/**
+ * @brief Split a flush area at the scroll region edges and wrap point
+ *
+ * Inside the region, screen column x is stored in frame memory at
+ * scroll_start + ((x - scroll_start + scroll_offset) mod scroll_size).
+ *
+ * @return Number of segments (at most 4)
+ */
+static int split_flush_area(const lv_area_t *area, flush_segment_t *segments)
+{
+    if (!scroll_active || scroll_offset == 0) {
+        segments[0] = (flush_segment_t){ area->x1, lv_area_get_width(area), area->x1 };
+        return 1;
+    }
+
+    lv_coord_t region_end = scroll_start + scroll_size;
+    lv_coord_t wrap_x = region_end - scroll_offset;    // Stored at scroll_start
+    int count = 0;
+    lv_coord_t x = area->x1;
+    while (x <= area->x2) {
+        lv_coord_t next;
+        lv_coord_t panel_x;
+        if (x < scroll_start) {
+            next = scroll_start;
+            panel_x = x;
+        } else if (x >= region_end) {
+            next = area->x2 + 1;
+            panel_x = x;
+        } else if (x < wrap_x) {
+            next = wrap_x;
+            panel_x = x + scroll_offset;
+        } else {
+            next = region_end;
+            panel_x = x + scroll_offset - scroll_size;
+        }
+        if (next > area->x2 + 1) {
+            next = area->x2 + 1;
+        }
+        segments[count++] = (flush_segment_t){ x, next - x, panel_x };
+        x = next;
+    }
+    return count;
+}
+
+static void flush_segments(esp_lcd_panel_handle_t panel_handle, const lv_area_t *area,
+                           const lv_color_t *color_map, const flush_segment_t *segments, int count)
+{
+    lv_coord_t width = lv_area_get_width(area);
+    lv_coord_t height = lv_area_get_height(area);
+
+    scroll_split_flushes++;
+    flush_parts_pending = count;
+    for (int i = 0; i < count; i++) {
+        // The panel driver converts into one RGB666 buffer, so wait until the previous part is out
+        if (i > 0 && xSemaphoreTake(flush_part_done, pdMS_TO_TICKS(CONFIG_RENDER_FLUSH_DEADLINE_MS)) != pdTRUE) {
+            ESP_LOGW(TAG, "Flush part %d of %d timed out", i, count);
+        }
+
+        const flush_segment_t *seg = &segments[i];
+        for (lv_coord_t y = 0; y < height; y++) {
+            memcpy(&scroll_scratch[y * seg->len], &color_map[y * width + (seg->x - area->x1)],
+                   seg->len * sizeof(lv_color_t));
+        }
+        flush_wire_bytes += (uint64_t)seg->len * height * DISPLAY_WIRE_BYTES_PER_PIXEL + DISPLAY_WINDOW_CMD_BYTES;
+        esp_lcd_panel_draw_bitmap(panel_handle, seg->panel_x, area->y1,
+                                  seg->panel_x + seg->len, area->y2 + 1, scroll_scratch);
+    }
+}
+
 static void lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
 {
     esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t) drv->user_data;
 
-    int offsetx1 = area->x1;
-    int offsetx2 = area->x2;
+    flush_start_us = esp_timer_get_time();
+    render_watchdog_flush_start();
+    flush_count++;
+
+    flush_segment_t segments[4];
+    int count = split_flush_area(area, segments);
+    if (count > 1) {
+        flush_segments(panel_handle, area, color_map, segments, count);
+        return;
+    }
+
+    int offsetx1 = segments[0].panel_x;
+    int offsetx2 = segments[0].panel_x + segments[0].len - 1;
     int offsety1 = area->y1;
     int offsety2 = area->y2;
+    flush_wire_bytes += (uint64_t)lv_area_get_size(area) * DISPLAY_WIRE_BYTES_PER_PIXEL + DISPLAY_WINDOW_CMD_BYTES;
     esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, color_map);
 }
 
@@ -166,10 +330,12 @@ void display_set_brightness(int brightness_percentage)
         brightness_percentage = 0;
     }
     ESP_LOGI(TAG, "Setting backlight to %d%%", brightness_percentage);
+    current_brightness = brightness_percentage;
 
     uint32_t duty_cycle = (1023 * brightness_percentage) / 100;
     ESP_ERROR_CHECK(ledc_set_duty(BACKLIGHT_LEDC_MODE, BACKLIGHT_LEDC_CHANNEL, duty_cycle));
     ESP_ERROR_CHECK(ledc_update_duty(BACKLIGHT_LEDC_MODE, BACKLIGHT_LEDC_CHANNEL));
+    energy_set_duty(ENERGY_CONSUMER_BACKLIGHT, duty_cycle / 1023.0f);
 }
 
 static esp_err_t initialize_spi(void)
@@ -332,11 +498,15 @@ static esp_err_t initialize_lvgl(void)
     lv_disp_drv.flush_cb = lvgl_flush_cb;
     lv_disp_drv.draw_buf = &lv_disp_buf;
     lv_disp_drv.user_data = lcd_handle;
+    if (draw_accel_install(&lv_disp_drv) != ESP_OK) {
+        ESP_LOGW(TAG, "Accelerated blend backend not installed, using the stock renderer");
+    }
     lv_display = lv_disp_drv_register(&lv_disp_drv);
 
     ESP_LOGI(TAG, "Initializing Chinese font style");
     lv_style_init(&style_chinese_font);
-    lv_style_set_text_font(&style_chinese_font, &lv_font_montserrat_14);
+    // Subset to the texts the UI draws (tools/font_subset.py), sub-pixel rendered
+    lv_style_set_text_font(&style_chinese_font, &chinese_font_16);
 
     ESP_LOGI(TAG, "Creating LVGL tick timer");
     const esp_timer_create_args_t lvgl_tick_timer_args =
@@ -382,7 +552,7 @@ static void create_boot_screen(void)
     lv_obj_set_style_bg_color(boot_screen, lv_color_black(), LV_STATE_DEFAULT);
 
     lv_obj_t *system_title = lv_label_create(boot_screen);
-    lv_label_set_text(system_title, "Smart Assistant");
+    lv_label_set_text(system_title, ui_string(UI_STR_APP_TITLE));
     lv_obj_set_style_text_color(system_title, lv_color_white(), LV_STATE_DEFAULT);
     lv_obj_set_style_text_font(system_title, LV_FONT_DEFAULT, LV_STATE_DEFAULT);
     lv_obj_align(system_title, LV_ALIGN_CENTER, 0, -30);
@@ -396,7 +566,7 @@ static void create_boot_screen(void)
     lv_bar_set_value(boot_progress_bar, 0, LV_ANIM_OFF);
 
     boot_status_label = lv_label_create(boot_screen);
-    lv_label_set_text(boot_status_label, "Starting...");
+    lv_label_set_text(boot_status_label, ui_string(UI_STR_BOOT_STARTING));
     lv_obj_set_style_text_color(boot_status_label, lv_color_white(), LV_STATE_DEFAULT);
     lv_obj_add_style(boot_status_label, &style_chinese_font, 0);
     lv_obj_align(boot_status_label, LV_ALIGN_CENTER, 0, 30);
@@ -412,33 +582,18 @@ static void create_main_screen(void)
     lv_obj_clear_flag(main_screen, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_set_style_bg_color(main_screen, lv_color_black(), LV_STATE_DEFAULT);
 
-    // Action recognition status (top-left)
-    lv_obj_t *motion_text = lv_label_create(main_screen);
-    lv_label_set_text(motion_text, "Action: PC");
-    lv_obj_set_style_text_color(motion_text, lv_color_white(), LV_STATE_DEFAULT);
-    lv_obj_add_style(motion_text, &style_chinese_font, 0);
-    lv_obj_align(motion_text, LV_ALIGN_TOP_LEFT, 10, 10);
-
-    // PIR sensor status (top-left, below action)
-    pir_status_label = lv_label_create(main_screen);
-    lv_label_set_text(pir_status_label, "PIR: No");
-    lv_obj_set_style_text_color(pir_status_label, lv_color_white(), LV_STATE_DEFAULT);
-    lv_obj_add_style(pir_status_label, &style_chinese_font, 0);
-    lv_obj_align(pir_status_label, LV_ALIGN_TOP_LEFT, 10, 30);
-
-    // MPU6050 motion sensor status (below PIR status)
-    motion_status_label = lv_label_create(main_screen);
-    lv_label_set_text(motion_status_label, "MPU: None");
-    lv_obj_set_style_text_color(motion_status_label, lv_color_white(), LV_STATE_DEFAULT);
-    lv_obj_add_style(motion_status_label, &style_chinese_font, 0);
-    lv_obj_align(motion_status_label, LV_ALIGN_TOP_LEFT, 10, 50);
-
-    // Weather info (top-right)
-    lv_obj_t *weather_text = lv_label_create(main_screen);
-    lv_label_set_text(weather_text, "21C Rainy");
-    lv_obj_set_style_text_color(weather_text, lv_color_white(), LV_STATE_DEFAULT);
-    lv_obj_add_style(weather_text, &style_chinese_font, 0);
-    lv_obj_align(weather_text, LV_ALIGN_TOP_RIGHT, -10, 10);
+    // Status fields around the screen edges
+    status_bar = status_bar_create(main_screen);
+    if (status_bar != NULL) {
+        lv_obj_set_style_text_color(status_bar, lv_color_white(), LV_STATE_DEFAULT);
+        lv_obj_add_style(status_bar, &style_chinese_font, 0);
+        status_bar_set_text(status_bar, STATUS_SLOT_ACTION, ui_string(UI_STR_ACTION_NONE));
+        status_bar_set_text(status_bar, STATUS_SLOT_PIR, ui_string(UI_STR_PIR_NONE));
+        status_bar_set_text(status_bar, STATUS_SLOT_MOTION, ui_string(UI_STR_MOTION_NONE));
+        status_bar_set_text(status_bar, STATUS_SLOT_WEATHER, current_weather_str);
+        status_bar_set_text(status_bar, STATUS_SLOT_ASSISTANT, ui_string(UI_STR_ASSISTANT));
+        status_bar_set_text(status_bar, STATUS_SLOT_WIFI, ui_string(UI_STR_WIFI_NONE));
+    }
 
     // Large time display (center) - USE SAME FONT AS OTHER LABELS
     time_label = lv_label_create(main_screen);
@@ -462,35 +617,70 @@ static void create_main_screen(void)
     lv_obj_add_style(date_label, &style_chinese_font, 0);
     lv_obj_align(date_label, LV_ALIGN_CENTER, 0, 40);
 
-    // Assistant status (bottom-left)
-    lv_obj_t *assistant_text = lv_label_create(main_screen);
-    lv_label_set_text(assistant_text, "Assistant");
-    lv_obj_set_style_text_color(assistant_text, lv_color_white(), LV_STATE_DEFAULT);
-    lv_obj_add_style(assistant_text, &style_chinese_font, 0);
-    lv_obj_align(assistant_text, LV_ALIGN_BOTTOM_LEFT, 10, -10);
+    ESP_LOGI(TAG, "Simple main screen created");
+}
 
-    // WiFi status (bottom-right)
-    lv_obj_t *wifi_text = lv_label_create(main_screen);
-    lv_label_set_text(wifi_text, "WiFi: OK");
-    lv_obj_set_style_text_color(wifi_text, lv_color_white(), LV_STATE_DEFAULT);
-    lv_obj_add_style(wifi_text, &style_chinese_font, 0);
-    lv_obj_align(wifi_text, LV_ALIGN_BOTTOM_RIGHT, -10, -10);
+static void create_diagnostics_screen(void)
+{
+    diagnostics_screen = lv_obj_create(NULL);
+    lv_obj_clear_flag(diagnostics_screen, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_color(diagnostics_screen, lv_color_black(), LV_STATE_DEFAULT);
 
-    ESP_LOGI(TAG, "Simple main screen created");
+    lv_obj_t *title = lv_label_create(diagnostics_screen);
+    lv_label_set_text(title, ui_string(UI_STR_DIAG_TITLE));
+    lv_obj_set_style_text_color(title, lv_color_white(), LV_STATE_DEFAULT);
+    lv_obj_add_style(title, &style_chinese_font, 0);
+    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 10);
+
+    diagnostics_label = lv_label_create(diagnostics_screen);
+    lv_label_set_text(diagnostics_label, ui_string(UI_STR_DIAG_COLLECTING));
+    lv_obj_set_style_text_color(diagnostics_label, lv_color_white(), LV_STATE_DEFAULT);
+    lv_obj_add_style(diagnostics_label, &style_chinese_font, 0);
+    lv_obj_align(diagnostics_label, LV_ALIGN_TOP_LEFT, 10, 40);
+
+    ESP_LOGI(TAG, "Diagnostics screen created");
+}
+
+static void create_preview_screen(void)
+{
+    preview_screen = lv_obj_create(NULL);
+    lv_obj_clear_flag(preview_screen, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_color(preview_screen, lv_color_black(), LV_STATE_DEFAULT);
+
+    // Nothing is placed over the preview region, so LVGL only draws it when the screen loads
+    preview_stats_label = lv_label_create(preview_screen);
+    lv_label_set_text(preview_stats_label, ui_string(UI_STR_PREVIEW_WAITING));
+    lv_obj_set_style_text_color(preview_stats_label, lv_color_white(), LV_STATE_DEFAULT);
+    lv_obj_add_style(preview_stats_label, &style_chinese_font, 0);
+    lv_obj_align(preview_stats_label, LV_ALIGN_TOP_MID, 0, 10);
+
+    ESP_LOGI(TAG, "Preview screen created");
 }
 
 void display_update_boot_status(const char* status_text, int progress)
 {
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
     if (boot_status_label != NULL) {
         lv_label_set_text(boot_status_label, status_text);
     }
     
     update_boot_progress(progress);
     ESP_LOGI(TAG, "Boot status updated: %s (%d%%)", status_text, progress);
+
+    display_unlock();
 }
 
 void display_complete_boot_animation(void)
 {
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
     if (main_screen == NULL) {
         create_main_screen();
     }
@@ -506,11 +696,35 @@ void display_complete_boot_animation(void)
     boot_spinner = NULL;
     boot_status_label = NULL;
     boot_progress_bar = NULL;
+
+    display_unlock();
 }
 
-esp_err_t display_init_and_show_boot_animation(void)
+static esp_err_t initialize_display_system(void)
 {
-    ESP_LOGI(TAG, "Initializing display system...");
+    if (ui_lock == NULL) {
+        ui_lock = xSemaphoreCreateRecursiveMutex();
+        if (ui_lock == NULL) {
+            ESP_LOGE(TAG, "Failed to create UI lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    if (flush_part_done == NULL) {
+        flush_part_done = xSemaphoreCreateBinary();
+        if (flush_part_done == NULL) {
+            ESP_LOGE(TAG, "Failed to create flush semaphore");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    if (preview_draw_done == NULL) {
+        preview_draw_done = xSemaphoreCreateBinary();
+        if (preview_draw_done == NULL) {
+            ESP_LOGE(TAG, "Failed to create preview draw semaphore");
+            return ESP_ERR_NO_MEM;
+        }
+    }
     
     // Initialize backlight (initially off)
     esp_err_t ret = display_brightness_init();
@@ -543,6 +757,18 @@ esp_err_t display_init_and_show_boot_animation(void)
         return ret;
     }
     
+    return ESP_OK;
+}
+
+esp_err_t display_init_and_show_boot_animation(void)
+{
+    ESP_LOGI(TAG, "Initializing display system...");
+    
+    esp_err_t ret = initialize_display_system();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
     create_boot_screen();
     
     // Give LVGL time to render the boot screen
@@ -556,69 +782,645 @@ esp_err_t display_init_and_show_boot_animation(void)
     return ESP_OK;
 }
 
+esp_err_t display_init_for_resume(void)
+{
+    ESP_LOGI(TAG, "Initializing display system for resume...");
+    
+    esp_err_t ret = initialize_display_system();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // Straight to the main screen; the backlight stays off until it is rendered
+    create_main_screen();
+    lv_scr_load(main_screen);
+    
+    return ESP_OK;
+}
+
+esp_err_t display_render_now(uint32_t timeout_ms)
+{
+    if (!display_lock(timeout_ms)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    lv_refr_now(lv_display);
+    
+    // The last area may still be on its way to the panel
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (lv_disp_buf.flushing && esp_timer_get_time() < deadline_us) {
+        vTaskDelay(1);
+    }
+    bool flushed = !lv_disp_buf.flushing;
+    
+    display_unlock();
+    return flushed ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t display_run_draw_benchmark(void)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    esp_err_t ret = draw_accel_run_benchmark(lv_display);
+    
+    display_unlock();
+    return ret;
+}
+
+static esp_err_t send_scroll_address(void)
+{
+    // Frame memory row shown on the first panel line of the scroll area
+    lv_coord_t first_x = CONFIG_DISPLAY_HW_SCROLL_REVERSED ? scroll_start + scroll_size - 1 : scroll_start;
+    lv_coord_t panel_x = scroll_start + (first_x - scroll_start + scroll_offset) % scroll_size;
+    uint16_t vsp = CONFIG_DISPLAY_HW_SCROLL_REVERSED ? (DISPLAY_HORIZONTAL_PIXELS - 1 - panel_x) : panel_x;
+    
+    uint8_t params[2] = { vsp >> 8, vsp & 0xFF };
+    return esp_lcd_panel_io_tx_param(lcd_io_handle, ILI9488_CMD_VSCRSADD, params, sizeof(params));
+}
+
+static void scroll_container_delete_cb(lv_event_t *e)
+{
+    scroll_container = NULL;
+}
+
+esp_err_t display_scroll_region_create(lv_obj_t *parent, lv_coord_t x, lv_coord_t width, lv_obj_t **container)
+{
+    if (parent == NULL || container == NULL || x < 0 || width <= 0 || x + width > DISPLAY_HORIZONTAL_PIXELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (scroll_active) {
+        display_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    scroll_scratch = heap_caps_malloc(LV_BUFFER_SIZE * sizeof(lv_color_t), MALLOC_CAP_8BIT);
+    if (scroll_scratch == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate scroll flush buffer");
+        display_unlock();
+        return ESP_ERR_NO_MEM;
+    }
+    
+    // Fixed areas before and after the scroll area, in frame memory rows
+    uint16_t tfa = CONFIG_DISPLAY_HW_SCROLL_REVERSED ? DISPLAY_HORIZONTAL_PIXELS - (x + width) : x;
+    uint16_t vsa = width;
+    uint16_t bfa = DISPLAY_HORIZONTAL_PIXELS - tfa - vsa;
+    uint8_t params[6] = { tfa >> 8, tfa & 0xFF, vsa >> 8, vsa & 0xFF, bfa >> 8, bfa & 0xFF };
+    
+    scroll_start = x;
+    scroll_size = width;
+    scroll_offset = 0;
+    esp_err_t ret = esp_lcd_panel_io_tx_param(lcd_io_handle, ILI9488_CMD_VSCRDEF, params, sizeof(params));
+    if (ret == ESP_OK) {
+        ret = send_scroll_address();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to define scroll area: %s", esp_err_to_name(ret));
+        heap_caps_free(scroll_scratch);
+        scroll_scratch = NULL;
+        display_unlock();
+        return ret;
+    }
+    
+    scroll_container = lv_obj_create(parent);
+    lv_obj_set_pos(scroll_container, x, 0);
+    lv_obj_set_size(scroll_container, width, DISPLAY_VERTICAL_PIXELS);
+    lv_obj_set_scrollbar_mode(scroll_container, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_set_style_bg_color(scroll_container, lv_color_black(), LV_STATE_DEFAULT);
+    lv_obj_set_style_border_width(scroll_container, 0, LV_STATE_DEFAULT);
+    lv_obj_set_style_pad_all(scroll_container, 0, LV_STATE_DEFAULT);
+    lv_obj_set_style_radius(scroll_container, 0, LV_STATE_DEFAULT);
+    lv_obj_add_event_cb(scroll_container, scroll_container_delete_cb, LV_EVENT_DELETE, NULL);
+    *container = scroll_container;
+    
+    scroll_active = true;
+    ESP_LOGI(TAG, "Hardware scroll region: columns %d-%d", x, x + width - 1);
+    
+    display_unlock();
+    return ESP_OK;
+}
+
+esp_err_t display_scroll_region_scroll(lv_coord_t pixels)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (!scroll_active || scroll_container == NULL || pixels == 0 || abs(pixels) >= scroll_size) {
+        display_unlock();
+        return (!scroll_active || scroll_container == NULL) ? ESP_ERR_INVALID_STATE : ESP_ERR_INVALID_ARG;
+    }
+    
+    scroll_offset = ((scroll_offset + pixels) % scroll_size + scroll_size) % scroll_size;
+    esp_err_t ret = send_scroll_address();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set scroll address: %s", esp_err_to_name(ret));
+    }
+    
+    // The panel already shows the shifted content; LVGL only has to follow the move
+    lv_disp_enable_invalidation(lv_display, false);
+    lv_obj_scroll_by(scroll_container, -pixels, 0, LV_ANIM_OFF);
+    lv_disp_enable_invalidation(lv_display, true);
+    
+    // Exposed band: the columns the wrapped-around content now occupies
+    lv_area_t band;
+    lv_coord_t region_end = scroll_start + scroll_size;
+    if (pixels > 0) {
+        lv_area_set(&band, region_end - pixels, 0, region_end - 1, DISPLAY_VERTICAL_PIXELS - 1);
+    } else {
+        lv_area_set(&band, scroll_start, 0, scroll_start - pixels - 1, DISPLAY_VERTICAL_PIXELS - 1);
+    }
+    lv_obj_invalidate_area(scroll_container, &band);
+    
+    uint64_t bytes_before = flush_wire_bytes;
+    lv_refr_now(lv_display);
+    scroll_band_bytes += flush_wire_bytes - bytes_before;
+    scroll_lines += abs(pixels);
+    
+    display_unlock();
+    return ret;
+}
+
+esp_err_t display_scroll_region_delete(void)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (!scroll_active) {
+        display_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    scroll_offset = 0;
+    esp_err_t ret = send_scroll_address();
+    if (ret == ESP_OK) {
+        ret = esp_lcd_panel_io_tx_param(lcd_io_handle, ILI9488_CMD_NORON, NULL, 0);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to leave scroll mode: %s", esp_err_to_name(ret));
+    }
+    
+    if (scroll_container != NULL) {
+        lv_obj_del(scroll_container);
+    }
+    scroll_active = false;
+    
+    // Frame memory of the region no longer matches what LVGL drew there
+    lv_area_t region;
+    lv_area_set(&region, scroll_start, 0, scroll_start + scroll_size - 1, DISPLAY_VERTICAL_PIXELS - 1);
+    lv_obj_invalidate_area(lv_scr_act(), &region);
+    
+    // The flush path only reads the scratch buffer while the UI lock is held
+    heap_caps_free(scroll_scratch);
+    scroll_scratch = NULL;
+    
+    display_unlock();
+    return ret;
+}
+
+esp_err_t display_scroll_region_get_stats(display_scroll_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_FAIL;
+    }
+    
+    memset(stats, 0, sizeof(display_scroll_stats_t));
+    stats->active = scroll_active;
+    stats->x = scroll_start;
+    stats->width = scroll_size;
+    stats->offset = scroll_offset;
+    stats->scrolled_lines = scroll_lines;
+    stats->band_bytes = scroll_band_bytes;
+    stats->split_flushes = scroll_split_flushes;
+    
+    return ESP_OK;
+}
+
+esp_err_t display_run_scroll_benchmark(void)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    lv_obj_t *prev_screen = lv_scr_act();
+    lv_obj_t *bench_screen = lv_obj_create(NULL);
+    lv_obj_clear_flag(bench_screen, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_color(bench_screen, lv_color_black(), LV_STATE_DEFAULT);
+    lv_scr_load(bench_screen);
+    
+    lv_obj_t *container = NULL;
+    esp_err_t ret = display_scroll_region_create(bench_screen, 0, DISPLAY_HORIZONTAL_PIXELS, &container);
+    if (ret != ESP_OK) {
+        lv_scr_load(prev_screen);
+        lv_obj_del(bench_screen);
+        display_unlock();
+        return ret;
+    }
+    
+    lv_obj_t *subtitle = lv_label_create(container);
+    lv_label_set_text(subtitle, "The quick brown fox jumps over the lazy dog. "
+                                "The quick brown fox jumps over the lazy dog.");
+    lv_obj_set_style_text_color(subtitle, lv_color_white(), LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(subtitle, &lv_font_montserrat_48, LV_STATE_DEFAULT);
+    lv_obj_align(subtitle, LV_ALIGN_LEFT_MID, 0, 0);
+    lv_refr_now(lv_display);
+    
+    uint32_t lines = CONFIG_DISPLAY_SCROLL_BENCH_STEPS * CONFIG_DISPLAY_SCROLL_BENCH_STEP_PX;
+    
+    // LVGL scroll first, while the hardware offset is still zero
+    uint64_t start_bytes = flush_wire_bytes;
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < CONFIG_DISPLAY_SCROLL_BENCH_STEPS; i++) {
+        lv_obj_scroll_by(container, -CONFIG_DISPLAY_SCROLL_BENCH_STEP_PX, 0, LV_ANIM_OFF);
+        lv_refr_now(lv_display);
+    }
+    uint64_t lvgl_bytes = flush_wire_bytes - start_bytes;
+    int64_t lvgl_us = esp_timer_get_time() - start_us;
+    
+    start_bytes = flush_wire_bytes;
+    start_us = esp_timer_get_time();
+    for (int i = 0; i < CONFIG_DISPLAY_SCROLL_BENCH_STEPS; i++) {
+        display_scroll_region_scroll(CONFIG_DISPLAY_SCROLL_BENCH_STEP_PX);
+    }
+    uint64_t hw_bytes = flush_wire_bytes - start_bytes;
+    int64_t hw_us = esp_timer_get_time() - start_us;
+    
+    display_scroll_region_delete();
+    lv_scr_load(prev_screen);
+    lv_obj_del(bench_screen);
+    lv_refr_now(lv_display);
+    
+    ESP_LOGI(TAG, "Scroll %lu lines in %d px steps: LVGL %llu B/line (%ld us/step), "
+             "hardware %llu B/line (%ld us/step)",
+             (unsigned long)lines, CONFIG_DISPLAY_SCROLL_BENCH_STEP_PX,
+             (unsigned long long)(lvgl_bytes / lines), (long)(lvgl_us / CONFIG_DISPLAY_SCROLL_BENCH_STEPS),
+             (unsigned long long)(hw_bytes / lines), (long)(hw_us / CONFIG_DISPLAY_SCROLL_BENCH_STEPS));
+    
+    display_unlock();
+    return ESP_OK;
+}
+
+esp_err_t display_run_status_bar_benchmark(void)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    esp_err_t ret = status_bar_run_benchmark(lv_display);
+    
+    display_unlock();
+    return ret;
+}
+
+int display_get_brightness(void)
+{
+    return current_brightness;
+}
+
+bool display_lock(uint32_t timeout_ms)
+{
+    if (ui_lock == NULL) {
+        return false;
+    }
+    return xSemaphoreTakeRecursive(ui_lock, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+void display_unlock(void)
+{
+    if (ui_lock != NULL) {
+        xSemaphoreGiveRecursive(ui_lock);
+    }
+}
+
+esp_err_t display_start_render_watchdog(void)
+{
+    return render_watchdog_init(ui_lock);
+}
+
 void display_task_handler(void)
 {
-    lv_timer_handler();
+    // Entry is marked before taking the lock so time spent waiting for it counts as a stall
+    render_watchdog_handler_enter();
+    if (display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        uint32_t flushes_before = flush_count;
+        int64_t start_us = esp_timer_get_time();
+        lv_timer_handler();
+        // Only runs that rendered count as frames
+        if (flush_count != flushes_before) {
+            hot_profile_record_frame((uint32_t)(esp_timer_get_time() - start_us));
+        }
+        display_unlock();
+    }
+    render_watchdog_handler_exit();
 }
 
 void display_update_time(int hours, int minutes, int seconds)
 {
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
+    clock_hours = hours;
+    clock_minutes = minutes;
+    clock_seconds = seconds;
     if (time_label != NULL) {
-        snprintf(current_time_str, sizeof(current_time_str), "%02d:%02d:%02d", hours, minutes, seconds);
-        lv_label_set_text(time_label, current_time_str);
-        ESP_LOGI(TAG, "Time updated: %s (label ptr: %p)", current_time_str, time_label);
+        char time_str[sizeof(current_time_str)];
+        if (clock_show_seconds) {
+            snprintf(time_str, sizeof(time_str), ui_string(UI_STR_TIME_FORMAT_HMS), hours, minutes, seconds);
+        } else {
+            snprintf(time_str, sizeof(time_str), ui_string(UI_STR_TIME_FORMAT_HM), hours, minutes);
+        }
+        // Same text at minute resolution: nothing to redraw
+        if (strcmp(time_str, current_time_str) != 0) {
+            snprintf(current_time_str, sizeof(current_time_str), "%s", time_str);
+            lv_label_set_text(time_label, current_time_str);
+            ESP_LOGI(TAG, "Time updated: %s (label ptr: %p)", current_time_str, time_label);
+        }
     } else {
         ESP_LOGE(TAG, "Time label is NULL - display may not be properly initialized or main screen not created");
     }
+
+    display_unlock();
+}
+
+void display_set_clock_seconds(bool show_seconds)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+    
+    if (show_seconds != clock_show_seconds) {
+        clock_show_seconds = show_seconds;
+        display_update_time(clock_hours, clock_minutes, clock_seconds);
+    }
+    
+    display_unlock();
+}
+
+uint32_t display_get_flush_count(void)
+{
+    return flush_count;
 }
 
 void display_update_date(int year, int month, int day)
 {
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
     if (date_label != NULL) {
-        const char* month_names[] = {
-            "Jan", "Feb", "Mar", "Apr", "May", "Jun",
-            "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
-        };
-        
         if (month >= 1 && month <= 12) {
-            snprintf(current_date_str, sizeof(current_date_str), "%s %d, %d", 
-                     month_names[month-1], day, year);
-            lv_label_set_text(date_label, current_date_str);
-            ESP_LOGI(TAG, "Date updated: %s", current_date_str);
+            char date_str[sizeof(current_date_str)];
+            snprintf(date_str, sizeof(date_str), ui_string(UI_STR_DATE_FORMAT), ui_month_name(month), day, year);
+            if (strcmp(date_str, current_date_str) != 0) {
+                snprintf(current_date_str, sizeof(current_date_str), "%s", date_str);
+                lv_label_set_text(date_label, current_date_str);
+                ESP_LOGI(TAG, "Date updated: %s", current_date_str);
+            }
         }
     }
+
+    display_unlock();
 }
 
 void display_show_time_error(const char* error_message)
 {
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
     if (time_label != NULL) {
         lv_label_set_text(time_label, error_message);
         ESP_LOGI(TAG, "Time error displayed: %s", error_message);
     }
     if (date_label != NULL) {
-        lv_label_set_text(date_label, "RTC Error");
+        lv_label_set_text(date_label, ui_string(UI_STR_RTC_ERROR));
         ESP_LOGI(TAG, "Date error displayed");
     }
+
+    display_unlock();
 }
 
 void display_update_pir_status(const char* pir_status_text)
 {
-    if (pir_status_label != NULL && pir_status_text != NULL) {
-        lv_label_set_text(pir_status_label, pir_status_text);
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
+    if (status_bar != NULL && pir_status_text != NULL) {
+        status_bar_set_text(status_bar, STATUS_SLOT_PIR, pir_status_text);
         ESP_LOGD(TAG, "PIR status updated: %s", pir_status_text);
     } else {
-        ESP_LOGW(TAG, "PIR status label is NULL or invalid text provided - main screen may not be initialized");
+        ESP_LOGW(TAG, "Status bar is NULL or invalid text provided - main screen may not be initialized");
     }
+
+    display_unlock();
 }
 
 void display_update_motion_status(const char* motion_status_text)
 {
-    if (motion_status_label != NULL && motion_status_text != NULL) {
-        lv_label_set_text(motion_status_label, motion_status_text);
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
+    if (status_bar != NULL && motion_status_text != NULL) {
+        status_bar_set_text(status_bar, STATUS_SLOT_MOTION, motion_status_text);
         ESP_LOGD(TAG, "Motion status updated: %s", motion_status_text);
     } else {
-        ESP_LOGW(TAG, "Motion status label is NULL or invalid text provided - main screen may not be initialized");
+        ESP_LOGW(TAG, "Status bar is NULL or invalid text provided - main screen may not be initialized");
+    }
+
+    display_unlock();
+}
+
+void display_update_wifi_status(const char* wifi_status_text)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
+    if (status_bar != NULL && wifi_status_text != NULL) {
+        status_bar_set_text(status_bar, STATUS_SLOT_WIFI, wifi_status_text);
+        ESP_LOGD(TAG, "Wi-Fi status updated: %s", wifi_status_text);
+    } else {
+        ESP_LOGW(TAG, "Status bar is NULL or invalid text provided - main screen may not be initialized");
+    }
+
+    display_unlock();
+}
+
+void display_update_action_status(const char* action_status_text)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
+    if (status_bar != NULL && action_status_text != NULL) {
+        status_bar_set_text(status_bar, STATUS_SLOT_ACTION, action_status_text);
+        ESP_LOGD(TAG, "Action status updated: %s", action_status_text);
+    } else {
+        ESP_LOGW(TAG, "Status bar is NULL or invalid text provided - main screen may not be initialized");
+    }
+
+    display_unlock();
+}
+
+void display_update_weather(const char* weather_text)
+{
+    if (weather_text == NULL) {
+        return;
+    }
+
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
+    snprintf(current_weather_str, sizeof(current_weather_str), "%s", weather_text);
+    if (status_bar != NULL) {
+        status_bar_set_text(status_bar, STATUS_SLOT_WEATHER, current_weather_str);
+        ESP_LOGD(TAG, "Weather updated: %s", current_weather_str);
+    }
+
+    display_unlock();
+}
+
+esp_err_t display_get_weather(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_FAIL;
+    }
+
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    snprintf(buffer, buffer_size, "%s", current_weather_str);
+    display_unlock();
+
+    return ESP_OK;
+}
+
+void display_show_diagnostics(bool show)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
+    if (show) {
+        if (diagnostics_screen == NULL) {
+            create_diagnostics_screen();
+        }
+        lv_scr_load(diagnostics_screen);
+    } else if (main_screen != NULL) {
+        lv_scr_load(main_screen);
     }
+    ESP_LOGI(TAG, "%s diagnostics screen", show ? "Showing" : "Leaving");
+
+    display_unlock();
+}
+
+esp_err_t display_show_preview(bool show)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    if (show) {
+        if (preview_screen == NULL) {
+            create_preview_screen();
+        }
+        lv_scr_load(preview_screen);
+    } else if (main_screen != NULL) {
+        lv_scr_load(main_screen);
+    }
+    ESP_LOGI(TAG, "%s preview screen", show ? "Showing" : "Leaving");
+
+    display_unlock();
+
+    // The region has to be black on the panel before the first stripe arrives
+    return show ? display_render_now(CONFIG_DISPLAY_LOCK_TIMEOUT_MS) : ESP_OK;
+}
+
+esp_err_t display_preview_draw(lv_coord_t y, lv_coord_t rows, const lv_color_t *pixels)
+{
+    if (pixels == NULL || y < 0 || rows <= 0 || y + rows > CONFIG_PREVIEW_REGION_HEIGHT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    // Frame memory columns are remapped inside a scroll region
+    if (lv_scr_act() != preview_screen || scroll_active) {
+        display_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    lv_coord_t x1 = (DISPLAY_HORIZONTAL_PIXELS - CONFIG_PREVIEW_REGION_WIDTH) / 2;
+    lv_coord_t y1 = CONFIG_PREVIEW_REGION_Y + y;
+
+    // The last LVGL area may still be on its way; its completion must not be taken for ours
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)CONFIG_RENDER_FLUSH_DEADLINE_MS * 1000;
+    while (lv_disp_buf.flushing && esp_timer_get_time() < deadline_us) {
+        vTaskDelay(1);
+    }
+    if (lv_disp_buf.flushing) {
+        display_unlock();
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // Holding the UI lock keeps LVGL flushes off the bus until this stripe is out
+    preview_draw_start_us = esp_timer_get_time();
+    preview_draw_pending = true;
+    flush_wire_bytes += (uint64_t)CONFIG_PREVIEW_REGION_WIDTH * rows * DISPLAY_WIRE_BYTES_PER_PIXEL + DISPLAY_WINDOW_CMD_BYTES;
+    esp_err_t ret = esp_lcd_panel_draw_bitmap(lcd_handle, x1, y1, x1 + CONFIG_PREVIEW_REGION_WIDTH, y1 + rows, pixels);
+    if (ret == ESP_OK && xSemaphoreTake(preview_draw_done, pdMS_TO_TICKS(CONFIG_RENDER_FLUSH_DEADLINE_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Preview stripe timed out");
+        ret = ESP_ERR_TIMEOUT;
+    }
+    preview_draw_pending = false;
+
+    display_unlock();
+    return ret;
+}
+
+void display_update_preview_stats(const char* stats_text)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
+    if (preview_stats_label != NULL && stats_text != NULL) {
+        lv_label_set_text(preview_stats_label, stats_text);
+    }
+
+    display_unlock();
+}
+
+void display_update_diagnostics(const char* diagnostics_text)
+{
+    if (!display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        ESP_LOGW(TAG, "UI lock timeout, %s skipped", __func__);
+        return;
+    }
+
+    if (diagnostics_label != NULL && diagnostics_text != NULL) {
+        lv_label_set_text(diagnostics_label, diagnostics_text);
+    }
+
+    display_unlock();
 }
 
 esp_err_t display_deinit(void)
@@ -670,8 +1472,13 @@ esp_err_t display_deinit(void)
     boot_progress_bar = NULL;
     boot_screen = NULL;
     main_screen = NULL;
+    diagnostics_screen = NULL;
+    diagnostics_label = NULL;
+    preview_screen = NULL;
+    preview_stats_label = NULL;
     time_label = NULL;
     date_label = NULL;
+    status_bar = NULL;
     
     ESP_LOGI(TAG, "Display system deinitialized successfully");
     return ESP_OK;
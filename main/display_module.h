@@ -2,6 +2,10 @@
 #define DISPLAY_MODULE_H
 
 #include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <lvgl.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,6 +24,110 @@ extern "C" {
  */
 esp_err_t display_init_and_show_boot_animation(void);
 
+/**
+ * @brief Initialize the display system straight into the main screen
+ * 
+ * Resume path after deep sleep: no boot animation, backlight left off.
+ * Set the labels, call display_render_now(), then turn the backlight on.
+ * 
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t display_init_for_resume(void);
+
+/**
+ * @brief Render the active screen and wait until it has reached the panel
+ * 
+ * @param timeout_ms Maximum time to wait for the lock and the last flush
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the flush did not complete
+ */
+esp_err_t display_render_now(uint32_t timeout_ms);
+
+/**
+ * @brief Compare the accelerated blend backend against the stock renderer
+ * 
+ * Logs per-operation throughput and full-screen fade times. Blocks the UI
+ * for a few seconds; the active screen is redrawn afterwards.
+ * 
+ * @return ESP_OK on success, error code from draw_accel_run_benchmark() otherwise
+ */
+esp_err_t display_run_draw_benchmark(void);
+
+/**
+ * @brief Hardware scroll region statistics
+ */
+typedef struct {
+    bool active;
+    lv_coord_t x;                   // First column of the region
+    lv_coord_t width;
+    lv_coord_t offset;              // Current content shift inside the region
+    uint32_t scrolled_lines;        // Columns scrolled since boot
+    uint64_t band_bytes;            // SPI bytes sent to draw the exposed bands
+    uint32_t split_flushes;         // Flushes sent in parts around the wrap point
+} display_scroll_stats_t;
+
+/**
+ * @brief Create a hardware scroll region and the LVGL container that fills it
+ * 
+ * Uses the ILI9488 vertical scrolling area (0x33/0x37). The panel is mounted
+ * in landscape, so its scroll axis is the screen's x axis: the region is a
+ * band of columns over the full height and its content scrolls horizontally.
+ * Put the scrolled content in the returned container; it is deleted with
+ * the region. Only one region can exist at a time.
+ * 
+ * @param parent Parent object, normally a screen
+ * @param x First column of the region
+ * @param width Number of columns
+ * @param container Pointer to store the container
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a region exists, other errors on failure
+ */
+esp_err_t display_scroll_region_create(lv_obj_t *parent, lv_coord_t x, lv_coord_t width, lv_obj_t **container);
+
+/**
+ * @brief Scroll the region content and render only the exposed band
+ * 
+ * Moves the panel scroll start address, shifts the container content to
+ * match without invalidating it, then renders and sends the band of
+ * columns that came into view.
+ * 
+ * @param pixels Columns to scroll; positive moves the content left
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if |pixels| is not smaller than the region
+ */
+esp_err_t display_scroll_region_scroll(lv_coord_t pixels);
+
+/**
+ * @brief Delete the scroll region and its container, and leave scrolling mode
+ * 
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no region exists
+ */
+esp_err_t display_scroll_region_delete(void);
+
+/**
+ * @brief Get hardware scroll region statistics
+ * 
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t display_scroll_region_get_stats(display_scroll_stats_t *stats);
+
+/**
+ * @brief Compare SPI bytes per scrolled line against a normal LVGL scroll
+ * 
+ * Scrolls a subtitle on a temporary screen, first with lv_obj_scroll_by()
+ * and then with the hardware region, and logs bytes per line for both.
+ * 
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t display_run_scroll_benchmark(void);
+
+/**
+ * @brief Compare the composite status widget against one label per field
+ * 
+ * Logs object count, LVGL heap use and render time per field update.
+ * 
+ * @return ESP_OK on success, error code from status_bar_run_benchmark() otherwise
+ */
+esp_err_t display_run_status_bar_benchmark(void);
+
 /**
  * @brief Set display brightness
  * 
@@ -27,6 +135,13 @@ esp_err_t display_init_and_show_boot_animation(void);
  */
 void display_set_brightness(int brightness_percentage);
 
+/**
+ * @brief Get the last brightness set with display_set_brightness()
+ * 
+ * @return Brightness level (0-100)
+ */
+int display_get_brightness(void);
+
 /**
  * @brief Update boot animation status text
  * 
@@ -50,6 +165,33 @@ void display_complete_boot_animation(void);
  */
 void display_task_handler(void);
 
+/**
+ * @brief Take the UI lock
+ * 
+ * Every LVGL call must be made with this lock held. The display_update_*
+ * functions take it themselves; hold it explicitly only when calling LVGL
+ * directly from another task. The lock is recursive.
+ * 
+ * @param timeout_ms Maximum time to wait for the lock
+ * @return true if the lock was taken
+ */
+bool display_lock(uint32_t timeout_ms);
+
+/**
+ * @brief Release the UI lock taken with display_lock()
+ */
+void display_unlock(void);
+
+/**
+ * @brief Start enforcing render loop deadlines
+ * 
+ * Call once the main screen loop runs; the boot sequence blocks between
+ * display_task_handler() calls on purpose.
+ * 
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t display_start_render_watchdog(void);
+
 /**
  * @brief Update the time display on the main screen
  * 
@@ -68,6 +210,22 @@ void display_update_time(int hours, int minutes, int seconds);
  */
 void display_update_date(int year, int month, int day);
 
+/**
+ * @brief Choose between HH:MM:SS and HH:MM on the main screen clock
+ * 
+ * The clock is reformatted right away from the last time shown.
+ * 
+ * @param show_seconds true for HH:MM:SS
+ */
+void display_set_clock_seconds(bool show_seconds);
+
+/**
+ * @brief Get the number of panel flushes since boot
+ * 
+ * @return Flush count (wraps around)
+ */
+uint32_t display_get_flush_count(void);
+
 /**
  * @brief Show error message in time display area
  * 
@@ -89,6 +247,83 @@ void display_update_pir_status(const char* pir_status_text);
  */
 void display_update_motion_status(const char* motion_status_text);
 
+/**
+ * @brief Update action recognition status display
+ * 
+ * @param action_status_text Action status text to display (e.g., "Action: PC" or "Action: Suspended")
+ */
+void display_update_action_status(const char* action_status_text);
+
+/**
+ * @brief Update Wi-Fi status display
+ * 
+ * @param wifi_status_text Wi-Fi status text to display (e.g., "WiFi: OK" or "WiFi: --")
+ */
+void display_update_wifi_status(const char* wifi_status_text);
+
+/**
+ * @brief Update weather display
+ * 
+ * @param weather_text Weather text to display (e.g., "21C Rainy")
+ */
+void display_update_weather(const char* weather_text);
+
+/**
+ * @brief Get the weather text currently shown
+ * 
+ * @param buffer Buffer to store the text (should be at least 32 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t display_get_weather(char *buffer, size_t buffer_size);
+
+/**
+ * @brief Switch between the main screen and the diagnostics screen
+ * 
+ * @param show true to show diagnostics, false to return to the main screen
+ */
+void display_show_diagnostics(bool show);
+
+/**
+ * @brief Switch between the main screen and the camera preview screen
+ * 
+ * The preview screen keeps a CONFIG_PREVIEW_REGION_WIDTH x
+ * CONFIG_PREVIEW_REGION_HEIGHT region free of LVGL objects; showing it
+ * renders the screen right away so the region is black before stripes arrive.
+ * 
+ * @param show true to show the preview, false to return to the main screen
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT if the UI lock or the render timed out
+ */
+esp_err_t display_show_preview(bool show);
+
+/**
+ * @brief Draw decoded preview rows straight to the panel, bypassing LVGL
+ * 
+ * Blocks until the transfer is complete, so the stripe can be reused on
+ * return. LVGL flushes wait on the UI lock meanwhile.
+ * 
+ * @param y First row inside the preview region
+ * @param rows Number of rows
+ * @param pixels rows x CONFIG_PREVIEW_REGION_WIDTH pixels in a DMA-capable buffer
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the preview screen is not shown,
+ *         ESP_ERR_INVALID_ARG if the rows fall outside the region, ESP_ERR_TIMEOUT
+ */
+esp_err_t display_preview_draw(lv_coord_t y, lv_coord_t rows, const lv_color_t *pixels);
+
+/**
+ * @brief Update the statistics line above the preview region
+ * 
+ * @param stats_text Text to display
+ */
+void display_update_preview_stats(const char* stats_text);
+
+/**
+ * @brief Update the diagnostics screen text
+ * 
+ * @param diagnostics_text Multi-line text to display (e.g., energy estimates)
+ */
+void display_update_diagnostics(const char* diagnostics_text);
+
 /**
  * @brief Deinitialize the display system and free resources
  * 
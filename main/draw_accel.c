@@ -0,0 +1,695 @@
+#include "draw_accel.h"
+#include "project_config.h"
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+#include <string.h>
+
+static const char *TAG = "DrawAccel";
+
+// The blend routines below work on unswapped RGB565 only
+#if LV_COLOR_DEPTH == 16 && !LV_COLOR_16_SWAP
+#define DRAW_ACCEL_SUPPORTED        1
+#else
+#define DRAW_ACCEL_SUPPORTED        0
+#endif
+
+#if CONFIG_IDF_TARGET_ESP32S3
+#define DRAW_ACCEL_USE_PIE          1
+#else
+#define DRAW_ACCEL_USE_PIE          0
+#endif
+
+/*
+ * Opacity and mask blends reproduce lv_color_mix() at 8-bit alpha. With a
+ * zero rounding offset LVGL mixes RGB565 at 5-bit alpha instead; those
+ * builds, and targets without PIE, keep the stock blends.
+ */
+#if DRAW_ACCEL_USE_PIE && LV_COLOR_MIX_ROUND_OFS != 0
+#define DRAW_ACCEL_PIE_BLEND        1
+#else
+#define DRAW_ACCEL_PIE_BLEND        0
+#endif
+
+#define PIE_BLOCK_PIXELS            32              // Four 128-bit stores
+#define PIE_LANES                   8               // RGB565 pixels per 128-bit register
+
+// Benchmark buffer, same shape as one LVGL render stripe
+#define BENCH_WIDTH                 CONFIG_DISPLAY_WIDTH
+#define BENCH_HEIGHT                CONFIG_DISPLAY_BUFFER_LINES
+
+static bool module_installed = false;
+static volatile bool accel_enabled = CONFIG_DRAW_ACCEL_ENABLE;
+static lv_disp_drv_t *installed_drv = NULL;
+
+// Statistics, only written from the render path (UI lock held)
+static uint32_t op_calls[DRAW_ACCEL_OP_COUNT];
+static uint64_t op_pixels[DRAW_ACCEL_OP_COUNT];
+static uint32_t fallback_calls = 0;
+static uint64_t fallback_pixels = 0;
+
+// Blend time accounting, only while the benchmark runs
+static bool timing_enabled = false;
+static int64_t timing_blend_us = 0;
+
+static const char *op_names[DRAW_ACCEL_OP_COUNT] = {
+    [DRAW_ACCEL_OP_FILL]      = "fill",
+    [DRAW_ACCEL_OP_FILL_OPA]  = "fill+opa",
+    [DRAW_ACCEL_OP_FILL_MASK] = "fill+mask",
+    [DRAW_ACCEL_OP_MAP]       = "map",
+    [DRAW_ACCEL_OP_MAP_OPA]   = "map+opa",
+    [DRAW_ACCEL_OP_MAP_MASK]  = "map+mask",
+};
+
+#if DRAW_ACCEL_SUPPORTED
+
+#if DRAW_ACCEL_USE_PIE
+static inline void pie_fill_blocks(uint16_t *dst, uint16_t color, int32_t blocks)
+{
+    // No other task or ISR uses the vector registers, so q0 needs no saving
+    const uint16_t color_mem = color;
+    while (blocks-- > 0) {
+        __asm__ volatile (
+            "ee.vldbc.16    q0, %[src]          \n"
+            "ee.vst.128.ip  q0, %[dst], 16      \n"
+            "ee.vst.128.ip  q0, %[dst], 16      \n"
+            "ee.vst.128.ip  q0, %[dst], 16      \n"
+            "ee.vst.128.ip  q0, %[dst], 16      \n"
+            : [dst] "+r" (dst)
+            : [src] "r" (&color_mem)
+            : "memory");
+    }
+}
+#endif
+
+static void fill_row(uint16_t *dst, int32_t len, uint16_t color)
+{
+#if DRAW_ACCEL_USE_PIE
+    // 128-bit stores need a 16-byte aligned destination
+    while (len > 0 && ((uintptr_t)dst & 15)) {
+        *dst++ = color;
+        len--;
+    }
+    int32_t blocks = len / PIE_BLOCK_PIXELS;
+    if (blocks > 0) {
+        pie_fill_blocks(dst, color, blocks);
+        dst += blocks * PIE_BLOCK_PIXELS;
+        len -= blocks * PIE_BLOCK_PIXELS;
+    }
+#else
+    if (len > 0 && ((uintptr_t)dst & 3)) {
+        *dst++ = color;
+        len--;
+    }
+    uint32_t pair = color | ((uint32_t)color << 16);
+    uint32_t *dst32 = (uint32_t *)dst;
+    for (int32_t i = 0; i < len / 2; i++) {
+        dst32[i] = pair;
+    }
+    dst += len & ~1;
+    len &= 1;
+#endif
+    while (len-- > 0) {
+        *dst++ = color;
+    }
+}
+
+static void blend_fill(uint16_t *dst, int32_t dst_stride, int32_t w, int32_t h, uint16_t color)
+{
+    for (int32_t y = 0; y < h; y++) {
+        fill_row(dst, w, color);
+        dst += dst_stride;
+    }
+}
+
+static void blend_map(uint16_t *dst, int32_t dst_stride, int32_t w, int32_t h,
+                      const uint16_t *src, int32_t src_stride)
+{
+    for (int32_t y = 0; y < h; y++) {
+        memcpy(dst, src, (size_t)w * sizeof(uint16_t));
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
+#if DRAW_ACCEL_PIE_BLEND
+
+#define PIE_VEC(v)                  { v, v, v, v, v, v, v, v }
+
+/*
+ * Broadcast constants, in the order pie_blend_blocks() loads them. Each
+ * channel is computed as lv_color_mix() does it:
+ * LV_UDIV255(fg * mix + bg * (255 - mix) + LV_COLOR_MIX_ROUND_OFS), where
+ * LV_UDIV255(x) is (x * 0x8081) >> 23. The largest sum, 63 * 255 + 255,
+ * fits a signed 16-bit lane.
+ */
+static const uint16_t pie_blend_consts[][PIE_LANES] __attribute__((aligned(16))) = {
+    PIE_VEC(255),
+    PIE_VEC(0x001F), PIE_VEC(LV_COLOR_MIX_ROUND_OFS), PIE_VEC(0x8081),
+    PIE_VEC(0x07E0), PIE_VEC(1), PIE_VEC(LV_COLOR_MIX_ROUND_OFS), PIE_VEC(0x8081), PIE_VEC(32),
+    PIE_VEC(1), PIE_VEC(LV_COLOR_MIX_ROUND_OFS), PIE_VEC(0x8081), PIE_VEC(2048),
+};
+
+/*
+ * Foreground and per-pixel mix rows for one blend, only used from the render
+ * path. A row is written at the 16-byte phase of its destination row so all
+ * three streams are aligned for 128-bit loads at the same pixel.
+ */
+static uint16_t row_fg[CONFIG_DISPLAY_WIDTH + PIE_LANES] __attribute__((aligned(16)));
+static uint16_t row_mix[CONFIG_DISPLAY_WIDTH + PIE_LANES] __attribute__((aligned(16)));
+
+static inline int32_t row_phase(const uint16_t *dst)
+{
+    return (int32_t)(((uintptr_t)dst & 15) >> 1);
+}
+
+static inline uint16_t mix_px(uint16_t fg, uint16_t bg, uint16_t mix)
+{
+    lv_color_t c1 = { .full = fg };
+    lv_color_t c2 = { .full = bg };
+    return lv_color_mix(c1, c2, (uint8_t)mix).full;
+}
+
+// Mix of one mask pixel, as lv_draw_sw_blend_basic() derives it
+static inline uint16_t mask_mix(lv_opa_t mask, lv_opa_t opa)
+{
+    if (opa >= LV_OPA_MAX || mask == LV_OPA_TRANSP) {
+        return mask;
+    }
+    return mask == LV_OPA_COVER ? opa : (uint16_t)(((uint32_t)mask * opa) >> 8);
+}
+
+static inline void pie_blend_blocks(uint16_t *dst, const uint16_t *fg, const uint16_t *mix, int32_t blocks)
+{
+    // SAR is set before every use, the compiler keeps nothing in it across statements
+    while (blocks-- > 0) {
+        const uint16_t *k = pie_blend_consts[0];
+        uint16_t *out = dst;
+        __asm__ volatile (
+            "ee.vld.128.ip  q0, %[fg], 16       \n"     // q0: foreground
+            "ee.vld.128.ip  q1, %[dst], 16      \n"     // q1: background
+            "ee.vld.128.ip  q2, %[mix], 16      \n"     // q2: mix
+            "ee.vld.128.ip  q3, %[k], 16        \n"
+            "ee.vsubs.s16   q3, q3, q2          \n"     // q3: 255 - mix
+            // Blue
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ee.andq        q4, q0, q6          \n"
+            "ee.andq        q5, q1, q6          \n"
+            "ssai           0                   \n"
+            "ee.vmul.u16    q4, q4, q2          \n"
+            "ee.vmul.u16    q5, q5, q3          \n"
+            "ee.vadds.s16   q4, q4, q5          \n"
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ee.vadds.s16   q4, q4, q6          \n"
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ssai           23                  \n"
+            "ee.vmul.u16    q7, q4, q6          \n"     // q7: result, blue in bits 0-4
+            // Green
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ee.andq        q4, q0, q6          \n"
+            "ee.andq        q5, q1, q6          \n"
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ssai           5                   \n"
+            "ee.vmul.u16    q4, q4, q6          \n"
+            "ee.vmul.u16    q5, q5, q6          \n"
+            "ssai           0                   \n"
+            "ee.vmul.u16    q4, q4, q2          \n"
+            "ee.vmul.u16    q5, q5, q3          \n"
+            "ee.vadds.s16   q4, q4, q5          \n"
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ee.vadds.s16   q4, q4, q6          \n"
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ssai           23                  \n"
+            "ee.vmul.u16    q4, q4, q6          \n"
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ssai           0                   \n"
+            "ee.vmul.u16    q4, q4, q6          \n"
+            "ee.orq         q7, q7, q4          \n"
+            // Red
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ssai           11                  \n"
+            "ee.vmul.u16    q4, q0, q6          \n"
+            "ee.vmul.u16    q5, q1, q6          \n"
+            "ssai           0                   \n"
+            "ee.vmul.u16    q4, q4, q2          \n"
+            "ee.vmul.u16    q5, q5, q3          \n"
+            "ee.vadds.s16   q4, q4, q5          \n"
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ee.vadds.s16   q4, q4, q6          \n"
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ssai           23                  \n"
+            "ee.vmul.u16    q4, q4, q6          \n"
+            "ee.vld.128.ip  q6, %[k], 16        \n"
+            "ssai           0                   \n"
+            "ee.vmul.u16    q4, q4, q6          \n"
+            "ee.orq         q7, q7, q4          \n"
+            "ee.vst.128.ip  q7, %[out], 16      \n"
+            : [fg] "+r" (fg), [dst] "+r" (dst), [mix] "+r" (mix), [k] "+r" (k), [out] "+r" (out)
+            :
+            : "memory");
+    }
+}
+
+// fg and mix must be at the phase of dst, see row_phase()
+static void blend_row(uint16_t *dst, const uint16_t *fg, const uint16_t *mix, int32_t len)
+{
+    while (len > 0 && ((uintptr_t)dst & 15)) {
+        *dst = mix_px(*fg++, *dst, *mix++);
+        dst++;
+        len--;
+    }
+    int32_t blocks = len / PIE_LANES;
+    if (blocks > 0) {
+        pie_blend_blocks(dst, fg, mix, blocks);
+        dst += blocks * PIE_LANES;
+        fg += blocks * PIE_LANES;
+        mix += blocks * PIE_LANES;
+        len -= blocks * PIE_LANES;
+    }
+    while (len-- > 0) {
+        *dst = mix_px(*fg++, *dst, *mix++);
+        dst++;
+    }
+}
+
+static void mask_row(uint16_t *mix, const lv_opa_t *mask, int32_t len, lv_opa_t opa)
+{
+    for (int32_t x = 0; x < len; x++) {
+        mix[x] = mask_mix(mask[x], opa);
+    }
+}
+
+static void blend_fill_opa(uint16_t *dst, int32_t dst_stride, int32_t w, int32_t h,
+                           uint16_t color, lv_opa_t opa)
+{
+    fill_row(row_fg, w + PIE_LANES, color);
+    fill_row(row_mix, w + PIE_LANES, opa);
+    for (int32_t y = 0; y < h; y++) {
+        int32_t phase = row_phase(dst);
+        blend_row(dst, row_fg + phase, row_mix + phase, w);
+        dst += dst_stride;
+    }
+}
+
+static void blend_fill_mask(uint16_t *dst, int32_t dst_stride, int32_t w, int32_t h,
+                            uint16_t color, lv_opa_t opa, const lv_opa_t *mask, int32_t mask_stride)
+{
+    fill_row(row_fg, w + PIE_LANES, color);
+    for (int32_t y = 0; y < h; y++) {
+        int32_t phase = row_phase(dst);
+        mask_row(row_mix + phase, mask, w, opa);
+        blend_row(dst, row_fg + phase, row_mix + phase, w);
+        dst += dst_stride;
+        mask += mask_stride;
+    }
+}
+
+// Source rows at the phase of their destination are read in place
+static const uint16_t *src_row(const uint16_t *src, const uint16_t *dst, int32_t w)
+{
+    int32_t phase = row_phase(dst);
+    if (row_phase(src) == phase) {
+        return src;
+    }
+    memcpy(row_fg + phase, src, (size_t)w * sizeof(uint16_t));
+    return row_fg + phase;
+}
+
+static void blend_map_opa(uint16_t *dst, int32_t dst_stride, int32_t w, int32_t h,
+                          const uint16_t *src, int32_t src_stride, lv_opa_t opa)
+{
+    fill_row(row_mix, w + PIE_LANES, opa);
+    for (int32_t y = 0; y < h; y++) {
+        blend_row(dst, src_row(src, dst, w), row_mix + row_phase(dst), w);
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
+
+static void blend_map_mask(uint16_t *dst, int32_t dst_stride, int32_t w, int32_t h,
+                           const uint16_t *src, int32_t src_stride, lv_opa_t opa,
+                           const lv_opa_t *mask, int32_t mask_stride)
+{
+    for (int32_t y = 0; y < h; y++) {
+        int32_t phase = row_phase(dst);
+        mask_row(row_mix + phase, mask, w, opa);
+        blend_row(dst, src_row(src, dst, w), row_mix + phase, w);
+        dst += dst_stride;
+        src += src_stride;
+        mask += mask_stride;
+    }
+}
+
+#endif // DRAW_ACCEL_PIE_BLEND
+
+/**
+ * @brief Check whether the backend handles an operation of the given width
+ *
+ * Without PIE blends only the opaque operations are lossless copies of the
+ * stock results; everything else stays with the stock renderer.
+ */
+static bool op_accelerated(draw_accel_op_t op, int32_t w)
+{
+    if (op == DRAW_ACCEL_OP_FILL || op == DRAW_ACCEL_OP_MAP) {
+        return true;
+    }
+#if DRAW_ACCEL_PIE_BLEND
+    return w <= CONFIG_DISPLAY_WIDTH;
+#else
+    return false;
+#endif
+}
+
+static draw_accel_op_t classify_op(const lv_draw_sw_blend_dsc_t *dsc, const lv_opa_t *mask)
+{
+    if (dsc->src_buf == NULL) {
+        if (mask != NULL) {
+            return DRAW_ACCEL_OP_FILL_MASK;
+        }
+        return dsc->opa >= LV_OPA_MAX ? DRAW_ACCEL_OP_FILL : DRAW_ACCEL_OP_FILL_OPA;
+    }
+    if (mask != NULL) {
+        return DRAW_ACCEL_OP_MAP_MASK;
+    }
+    return dsc->opa >= LV_OPA_MAX ? DRAW_ACCEL_OP_MAP : DRAW_ACCEL_OP_MAP_OPA;
+}
+
+/**
+ * @brief Blend one descriptor, with the clipping and strides of lv_draw_sw_blend_basic()
+ *
+ * @return false if the descriptor needs the stock renderer
+ */
+static bool accel_blend(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc,
+                        draw_accel_op_t *op, uint32_t *pixels)
+{
+    if (dsc->blend_mode != LV_BLEND_MODE_NORMAL) {
+        return false;
+    }
+
+    const lv_opa_t *mask = (dsc->mask_res == LV_DRAW_MASK_RES_FULL_COVER) ? NULL : dsc->mask_buf;
+    *op = classify_op(dsc, mask);
+    *pixels = 0;
+
+    if (dsc->opa <= LV_OPA_MIN || (dsc->mask_buf != NULL && dsc->mask_res == LV_DRAW_MASK_RES_TRANSP)) {
+        return true;
+    }
+
+    lv_area_t blend_area;
+    if (!_lv_area_intersect(&blend_area, dsc->blend_area, draw_ctx->clip_area)) {
+        return true;
+    }
+
+    int32_t w = lv_area_get_width(&blend_area);
+    int32_t h = lv_area_get_height(&blend_area);
+    if (!op_accelerated(*op, w)) {
+        return false;
+    }
+
+    if (draw_ctx->wait_for_finish) {
+        draw_ctx->wait_for_finish(draw_ctx);
+    }
+
+    int32_t dst_stride = lv_area_get_width(draw_ctx->buf_area);
+    uint16_t *dst = (uint16_t *)draw_ctx->buf;
+    dst += dst_stride * (blend_area.y1 - draw_ctx->buf_area->y1) + (blend_area.x1 - draw_ctx->buf_area->x1);
+
+    const uint16_t *src = NULL;
+    int32_t src_stride = 0;
+    if (dsc->src_buf != NULL) {
+        src_stride = lv_area_get_width(dsc->blend_area);
+        src = (const uint16_t *)dsc->src_buf;
+        src += src_stride * (blend_area.y1 - dsc->blend_area->y1) + (blend_area.x1 - dsc->blend_area->x1);
+    }
+
+    int32_t mask_stride = 0;
+    if (mask != NULL) {
+        mask_stride = lv_area_get_width(dsc->mask_area);
+        mask += mask_stride * (blend_area.y1 - dsc->mask_area->y1) + (blend_area.x1 - dsc->mask_area->x1);
+    }
+
+    switch (*op) {
+        case DRAW_ACCEL_OP_FILL:
+            blend_fill(dst, dst_stride, w, h, dsc->color.full);
+            break;
+        case DRAW_ACCEL_OP_MAP:
+            blend_map(dst, dst_stride, w, h, src, src_stride);
+            break;
+#if DRAW_ACCEL_PIE_BLEND
+        case DRAW_ACCEL_OP_FILL_OPA:
+            blend_fill_opa(dst, dst_stride, w, h, dsc->color.full, dsc->opa);
+            break;
+        case DRAW_ACCEL_OP_FILL_MASK:
+            blend_fill_mask(dst, dst_stride, w, h, dsc->color.full, dsc->opa, mask, mask_stride);
+            break;
+        case DRAW_ACCEL_OP_MAP_OPA:
+            blend_map_opa(dst, dst_stride, w, h, src, src_stride, dsc->opa);
+            break;
+        case DRAW_ACCEL_OP_MAP_MASK:
+            blend_map_mask(dst, dst_stride, w, h, src, src_stride, dsc->opa, mask, mask_stride);
+            break;
+#endif
+        default:
+            return false;
+    }
+
+    *pixels = (uint32_t)(w * h);
+    return true;
+}
+
+static void draw_accel_blend_cb(lv_draw_ctx_t *draw_ctx, const lv_draw_sw_blend_dsc_t *dsc)
+{
+    int64_t start_us = timing_enabled ? esp_timer_get_time() : 0;
+
+    draw_accel_op_t op;
+    uint32_t pixels;
+    if (accel_enabled && accel_blend(draw_ctx, dsc, &op, &pixels)) {
+        op_calls[op]++;
+        op_pixels[op] += pixels;
+    } else {
+        lv_draw_sw_blend_basic(draw_ctx, dsc);
+        lv_area_t blend_area;
+        fallback_calls++;
+        if (_lv_area_intersect(&blend_area, dsc->blend_area, draw_ctx->clip_area)) {
+            fallback_pixels += (uint32_t)(lv_area_get_width(&blend_area) * lv_area_get_height(&blend_area));
+        }
+    }
+
+    if (timing_enabled) {
+        timing_blend_us += esp_timer_get_time() - start_us;
+    }
+}
+
+static void draw_accel_ctx_init(lv_disp_drv_t *drv, lv_draw_ctx_t *draw_ctx)
+{
+    lv_draw_sw_init_ctx(drv, draw_ctx);
+    ((lv_draw_sw_ctx_t *)draw_ctx)->blend = draw_accel_blend_cb;
+}
+
+#endif // DRAW_ACCEL_SUPPORTED
+
+esp_err_t draw_accel_install(lv_disp_drv_t *drv)
+{
+    if (drv == NULL) {
+        return ESP_FAIL;
+    }
+
+#if DRAW_ACCEL_SUPPORTED
+    // set_px_cb and transparent screens have their own pixel formats
+    if (drv->set_px_cb != NULL || drv->screen_transp) {
+        ESP_LOGW(TAG, "Driver uses set_px_cb or a transparent screen, keeping the stock renderer");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    drv->draw_ctx_init = draw_accel_ctx_init;
+    drv->draw_ctx_deinit = lv_draw_sw_deinit_ctx;
+    drv->draw_ctx_size = sizeof(lv_draw_sw_ctx_t);
+    installed_drv = drv;
+    module_installed = true;
+
+    ESP_LOGI(TAG, "Blend backend installed (%s, %s)",
+             DRAW_ACCEL_PIE_BLEND ? "PIE fills and blends" :
+             (DRAW_ACCEL_USE_PIE ? "PIE fills, stock blends" : "32-bit fills, stock blends"),
+             accel_enabled ? "enabled" : "disabled");
+    return ESP_OK;
+#else
+    ESP_LOGW(TAG, "Color format not supported (needs unswapped RGB565), keeping the stock renderer");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void draw_accel_set_enabled(bool enabled)
+{
+    accel_enabled = enabled;
+}
+
+esp_err_t draw_accel_get_stats(draw_accel_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_FAIL;
+    }
+
+    memset(stats, 0, sizeof(draw_accel_stats_t));
+    stats->installed = module_installed;
+    stats->enabled = module_installed && accel_enabled;
+    memcpy(stats->calls, op_calls, sizeof(op_calls));
+    memcpy(stats->pixels, op_pixels, sizeof(op_pixels));
+    stats->fallback_calls = fallback_calls;
+    stats->fallback_pixels = fallback_pixels;
+
+    return ESP_OK;
+}
+
+const char* draw_accel_op_to_string(draw_accel_op_t op)
+{
+    if (op >= DRAW_ACCEL_OP_COUNT) {
+        return "unknown";
+    }
+    return op_names[op];
+}
+
+#if DRAW_ACCEL_SUPPORTED
+
+static void bench_prepare_dsc(draw_accel_op_t op, lv_draw_sw_blend_dsc_t *dsc, const lv_area_t *area,
+                              const lv_color_t *src, const lv_opa_t *mask)
+{
+    memset(dsc, 0, sizeof(lv_draw_sw_blend_dsc_t));
+    dsc->blend_area = area;
+    dsc->mask_area = area;
+    dsc->color = lv_color_hex(0x3080C0);
+    dsc->opa = LV_OPA_COVER;
+    dsc->mask_res = LV_DRAW_MASK_RES_FULL_COVER;
+    dsc->blend_mode = LV_BLEND_MODE_NORMAL;
+
+    if (op == DRAW_ACCEL_OP_FILL_OPA || op == DRAW_ACCEL_OP_MAP_OPA) {
+        dsc->opa = 128;
+    }
+    if (op >= DRAW_ACCEL_OP_MAP) {
+        dsc->src_buf = src;
+    }
+    if (op == DRAW_ACCEL_OP_FILL_MASK || op == DRAW_ACCEL_OP_MAP_MASK) {
+        dsc->mask_buf = mask;
+        dsc->mask_res = LV_DRAW_MASK_RES_CHANGED;
+    }
+}
+
+static uint32_t bench_op_us(lv_draw_ctx_t *ctx, const lv_draw_sw_blend_dsc_t *dsc, bool accelerated)
+{
+    draw_accel_op_t op;
+    uint32_t pixels;
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < CONFIG_DRAW_ACCEL_ITERATIONS; i++) {
+        if (!accelerated || !accel_blend(ctx, dsc, &op, &pixels)) {
+            lv_draw_sw_blend_basic(ctx, dsc);
+        }
+    }
+    return (uint32_t)(esp_timer_get_time() - start_us);
+}
+
+static void bench_operations(lv_disp_t *disp, lv_color_t *buf, const lv_color_t *src, const lv_opa_t *mask)
+{
+    lv_draw_sw_ctx_t ctx;
+    lv_area_t area = { 0, 0, BENCH_WIDTH - 1, BENCH_HEIGHT - 1 };
+    lv_draw_sw_init_ctx(installed_drv, &ctx.base_draw);
+    ctx.base_draw.buf = buf;
+    ctx.base_draw.buf_area = &area;
+    ctx.base_draw.clip_area = &area;
+
+    // The stock routine looks up the driver of the display being refreshed
+    lv_disp_t *prev_refreshing = _lv_refr_get_disp_refreshing();
+    _lv_refr_set_disp_refreshing(disp);
+
+    uint64_t total_px = (uint64_t)BENCH_WIDTH * BENCH_HEIGHT * CONFIG_DRAW_ACCEL_ITERATIONS;
+    for (int op = 0; op < DRAW_ACCEL_OP_COUNT; op++) {
+        lv_draw_sw_blend_dsc_t dsc;
+        bench_prepare_dsc((draw_accel_op_t)op, &dsc, &area, src, mask);
+
+        uint32_t stock_us = bench_op_us(&ctx.base_draw, &dsc, false);
+        uint32_t accel_us = bench_op_us(&ctx.base_draw, &dsc, true);
+
+        ESP_LOGI(TAG, "%-9s stock %6.2f Mpix/s, accelerated %6.2f Mpix/s (%.2fx)",
+                 op_names[op],
+                 stock_us ? (double)total_px / stock_us : 0.0,
+                 accel_us ? (double)total_px / accel_us : 0.0,
+                 accel_us ? (double)stock_us / accel_us : 0.0);
+    }
+
+    _lv_refr_set_disp_refreshing(prev_refreshing);
+    lv_draw_sw_deinit_ctx(installed_drv, &ctx.base_draw);
+}
+
+static void bench_fade(lv_disp_t *disp, bool accelerated, uint32_t *frame_us, uint32_t *blend_us)
+{
+    lv_obj_t *scr = lv_scr_act();
+    draw_accel_set_enabled(accelerated);
+
+    timing_blend_us = 0;
+    timing_enabled = true;
+    int64_t start_us = esp_timer_get_time();
+    for (int step = 1; step <= CONFIG_DRAW_ACCEL_FADE_STEPS; step++) {
+        lv_obj_set_style_opa(scr, (lv_opa_t)(LV_OPA_COVER * step / CONFIG_DRAW_ACCEL_FADE_STEPS), LV_PART_MAIN);
+        lv_refr_now(disp);
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    timing_enabled = false;
+
+    *frame_us = (uint32_t)(elapsed_us / CONFIG_DRAW_ACCEL_FADE_STEPS);
+    *blend_us = (uint32_t)(timing_blend_us / CONFIG_DRAW_ACCEL_FADE_STEPS);
+}
+
+#endif // DRAW_ACCEL_SUPPORTED
+
+esp_err_t draw_accel_run_benchmark(lv_disp_t *disp)
+{
+#if DRAW_ACCEL_SUPPORTED
+    if (!module_installed || disp == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t buf_pixels = (size_t)BENCH_WIDTH * BENCH_HEIGHT;
+    lv_color_t *buf = heap_caps_malloc(buf_pixels * sizeof(lv_color_t), MALLOC_CAP_DMA);
+    lv_color_t *src = heap_caps_malloc(buf_pixels * sizeof(lv_color_t), MALLOC_CAP_8BIT);
+    lv_opa_t *mask = heap_caps_malloc(buf_pixels, MALLOC_CAP_8BIT);
+    if (buf == NULL || src == NULL || mask == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate benchmark buffers");
+        heap_caps_free(buf);
+        heap_caps_free(src);
+        heap_caps_free(mask);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Glyph-like mask: mostly transparent or opaque with antialiased edges
+    for (size_t i = 0; i < buf_pixels; i++) {
+        src[i].full = (uint16_t)(i * 2654435761U >> 16);
+        mask[i] = (lv_opa_t)((i % 8) < 3 ? 0 : ((i % 8) > 5 ? 255 : (i * 37) & 0xFF));
+    }
+    memset(buf, 0, buf_pixels * sizeof(lv_color_t));
+
+    ESP_LOGI(TAG, "Blend throughput, %dx%d area, %d iterations",
+             BENCH_WIDTH, BENCH_HEIGHT, CONFIG_DRAW_ACCEL_ITERATIONS);
+    bench_operations(disp, buf, src, mask);
+
+    heap_caps_free(buf);
+    heap_caps_free(src);
+    heap_caps_free(mask);
+
+    bool was_enabled = accel_enabled;
+    uint32_t stock_frame_us, stock_blend_us, accel_frame_us, accel_blend_us;
+    bench_fade(disp, false, &stock_frame_us, &stock_blend_us);
+    bench_fade(disp, true, &accel_frame_us, &accel_blend_us);
+
+    lv_obj_set_style_opa(lv_scr_act(), LV_OPA_COVER, LV_PART_MAIN);
+    draw_accel_set_enabled(was_enabled);
+    lv_refr_now(disp);
+
+    ESP_LOGI(TAG, "Full-screen fade, %d frames: stock %lu us/frame (blend %lu us), "
+             "accelerated %lu us/frame (blend %lu us)",
+             CONFIG_DRAW_ACCEL_FADE_STEPS,
+             (unsigned long)stock_frame_us, (unsigned long)stock_blend_us,
+             (unsigned long)accel_frame_us, (unsigned long)accel_blend_us);
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
@@ -0,0 +1,101 @@
+#ifndef DRAW_ACCEL_H
+#define DRAW_ACCEL_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file draw_accel.h
+ * @brief Accelerated LVGL blend backend for the RGB565 render buffer
+ *
+ * Replaces the blend hook of LVGL's software draw context, which every
+ * rectangle fill, opacity blend and glyph alpha mask goes through. Opaque
+ * fills use 128-bit PIE stores on the ESP32-S3. Opacity and mask blends mix
+ * eight pixels per PIE multiply at 8-bit alpha, with the same results as
+ * lv_color_mix(). Other targets, and blend modes other than normal, fall
+ * back to the stock renderer.
+ */
+
+/**
+ * @brief Blend operations handled by the backend
+ */
+typedef enum {
+    DRAW_ACCEL_OP_FILL,         // Solid color, opaque
+    DRAW_ACCEL_OP_FILL_OPA,     // Solid color with opacity
+    DRAW_ACCEL_OP_FILL_MASK,    // Solid color through an alpha mask (glyphs, rounded corners)
+    DRAW_ACCEL_OP_MAP,          // Image copy, opaque
+    DRAW_ACCEL_OP_MAP_OPA,      // Image with opacity
+    DRAW_ACCEL_OP_MAP_MASK,     // Image through an alpha mask
+    DRAW_ACCEL_OP_COUNT
+} draw_accel_op_t;
+
+/**
+ * @brief Blend call statistics since boot
+ */
+typedef struct {
+    bool installed;
+    bool enabled;
+    uint32_t calls[DRAW_ACCEL_OP_COUNT];
+    uint64_t pixels[DRAW_ACCEL_OP_COUNT];
+    uint32_t fallback_calls;            // Passed on to the stock renderer
+    uint64_t fallback_pixels;
+} draw_accel_stats_t;
+
+/**
+ * @brief Install the backend on a display driver
+ *
+ * Call after lv_disp_drv_init() and before lv_disp_drv_register(). Leaves the
+ * driver untouched if the color format or driver options are not supported.
+ *
+ * @param drv Display driver
+ * @return ESP_OK if installed, ESP_ERR_NOT_SUPPORTED if the stock renderer stays in place
+ */
+esp_err_t draw_accel_install(lv_disp_drv_t *drv);
+
+/**
+ * @brief Switch between the accelerated and the stock blend routines at runtime
+ *
+ * @param enabled true to use the accelerated routines
+ */
+void draw_accel_set_enabled(bool enabled);
+
+/**
+ * @brief Get blend call statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t draw_accel_get_stats(draw_accel_stats_t *stats);
+
+/**
+ * @brief Get printable name of a blend operation
+ *
+ * @param op Operation
+ * @return Constant string
+ */
+const char* draw_accel_op_to_string(draw_accel_op_t op);
+
+/**
+ * @brief Compare the accelerated and stock renderers and log the results
+ *
+ * Measures per-operation throughput on an off-screen buffer, then a
+ * full-screen fade (CONFIG_DRAW_ACCEL_FADE_STEPS frames) with each renderer.
+ * Blocks for a few seconds; call with the UI lock held.
+ *
+ * @param disp Registered display
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the test buffers cannot be allocated
+ */
+esp_err_t draw_accel_run_benchmark(lv_disp_t *disp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DRAW_ACCEL_H
@@ -0,0 +1,324 @@
+#include "energy_module.h"
+#include "project_config.h"
+#include <esp_log.h>
+#include <esp_rom_sys.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+#include <stdio.h>
+#include <string.h>
+#if CONFIG_PM_ENABLE && CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+#include <esp_pm.h>
+#define ENERGY_TRACK_LIGHT_SLEEP    1
+#else
+#define ENERGY_TRACK_LIGHT_SLEEP    0
+#endif
+
+static const char *TAG = "EnergyModule";
+
+#define US_PER_HOUR     3600000000.0
+
+// Current drawn by each consumer while fully active; CPU is looked up per frequency
+static const float consumer_current_ma[ENERGY_CONSUMER_COUNT] = {
+    [ENERGY_CONSUMER_CPU]         = 0.0f,
+    [ENERGY_CONSUMER_BACKLIGHT]   = CONFIG_ENERGY_BACKLIGHT_MA,
+    [ENERGY_CONSUMER_DISPLAY_SPI] = CONFIG_ENERGY_DISPLAY_SPI_MA,
+    [ENERGY_CONSUMER_I2C]         = CONFIG_ENERGY_I2C_MA,
+    [ENERGY_CONSUMER_WIFI_TX]     = CONFIG_ENERGY_WIFI_TX_MA,
+    [ENERGY_CONSUMER_WIFI_RX]     = CONFIG_ENERGY_WIFI_RX_MA,
+    [ENERGY_CONSUMER_AUDIO_I2S]   = CONFIG_ENERGY_AUDIO_I2S_MA,
+};
+
+// Accounting state, written by any task or ISR
+static portMUX_TYPE energy_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t burst_us[ENERGY_CONSUMER_COUNT];
+static float duty_level[ENERGY_CONSUMER_COUNT];
+static int64_t duty_since_us[ENERGY_CONSUMER_COUNT];
+static double duty_active_us[ENERGY_CONSUMER_COUNT];
+static uint64_t light_sleep_us = 0;
+
+// Integration state (only touched by the energy task)
+static bool module_initialized = false;
+static TaskHandle_t energy_task_handle = NULL;
+static double total_mwh[ENERGY_CONSUMER_COUNT];
+static double window_mwh[ENERGY_CONSUMER_COUNT];
+static double window_active_us[ENERGY_CONSUMER_COUNT];
+static int64_t window_start_us = 0;
+
+// Published report
+static portMUX_TYPE report_lock = portMUX_INITIALIZER_UNLOCKED;
+static energy_report_t report = {0};
+
+/**
+ * @brief Fold the current duty level into the active time up to now
+ *
+ * Must be called with energy_lock held.
+ */
+static void integrate_duty(energy_consumer_t consumer, int64_t now)
+{
+    if (duty_since_us[consumer] != 0 && duty_level[consumer] > 0.0f) {
+        duty_active_us[consumer] += (double)duty_level[consumer] * (double)(now - duty_since_us[consumer]);
+    }
+    duty_since_us[consumer] = now;
+}
+
+#if ENERGY_TRACK_LIGHT_SLEEP
+/**
+ * @brief Count the time slept in one automatic light sleep
+ *
+ * Runs in the idle task on the way out of light sleep, with the scheduler
+ * stopped.
+ */
+static esp_err_t IRAM_ATTR on_light_sleep_exit(int64_t sleep_time_us, void *arg)
+{
+    if (sleep_time_us > 0) {
+        portENTER_CRITICAL_SAFE(&energy_lock);
+        light_sleep_us += (uint64_t)sleep_time_us;
+        portEXIT_CRITICAL_SAFE(&energy_lock);
+    }
+    return ESP_OK;
+}
+#endif
+
+static float cpu_current_ma(uint32_t freq_mhz)
+{
+    if (freq_mhz <= 80) {
+        return CONFIG_ENERGY_CPU_80MHZ_MA;
+    }
+    if (freq_mhz <= 160) {
+        return CONFIG_ENERGY_CPU_160MHZ_MA;
+    }
+    return CONFIG_ENERGY_CPU_240MHZ_MA;
+}
+
+static double active_us_to_mwh(float current_ma, double active_us)
+{
+    return (double)current_ma * CONFIG_ENERGY_SUPPLY_VOLTAGE_V * active_us / US_PER_HOUR;
+}
+
+static void publish_report(int64_t now, uint32_t cpu_freq_mhz)
+{
+    double window_us = (double)(now - window_start_us);
+    if (window_us <= 0) {
+        return;
+    }
+
+    energy_report_t next = {0};
+    for (int i = 0; i < ENERGY_CONSUMER_COUNT; i++) {
+        next.rate_mwh_per_h[i] = (float)(window_mwh[i] * US_PER_HOUR / window_us);
+        next.total_mwh[i] = (float)total_mwh[i];
+        next.duty[i] = (float)(window_active_us[i] / window_us);
+        if (next.duty[i] > 1.0f) {
+            next.duty[i] = 1.0f;    // Overlapping bursts on separate buses
+        }
+        next.rate_total_mwh_per_h += next.rate_mwh_per_h[i];
+        next.total_all_mwh += next.total_mwh[i];
+
+        window_mwh[i] = 0.0;
+        window_active_us[i] = 0.0;
+    }
+    next.cpu_freq_mhz = cpu_freq_mhz;
+    next.window_s = (uint32_t)(window_us / 1000000.0);
+    window_start_us = now;
+
+    portENTER_CRITICAL(&report_lock);
+    report = next;
+    portEXIT_CRITICAL(&report_lock);
+
+    ESP_LOGI(TAG, "Energy (last %lus): %.1f mWh/h total, %.2f mWh since boot",
+             (unsigned long)next.window_s, next.rate_total_mwh_per_h, next.total_all_mwh);
+    for (int i = 0; i < ENERGY_CONSUMER_COUNT; i++) {
+        ESP_LOGI(TAG, "  %-10s %7.1f mWh/h  duty %5.1f%%  total %8.2f mWh",
+                 energy_consumer_to_string((energy_consumer_t)i), next.rate_mwh_per_h[i],
+                 next.duty[i] * 100.0f, next.total_mwh[i]);
+    }
+}
+
+/**
+ * @brief Energy integration task
+ */
+static void energy_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Energy task started");
+
+    int64_t last_sample_us = esp_timer_get_time();
+    int64_t last_report_us = last_sample_us;
+    window_start_us = last_sample_us;
+    uint32_t cpu_freq_mhz = esp_rom_get_cpu_ticks_per_us();
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_ENERGY_SAMPLE_INTERVAL_MS));
+
+        int64_t now = esp_timer_get_time();
+        double active_us[ENERGY_CONSUMER_COUNT];
+        double slept_us;
+
+        portENTER_CRITICAL(&energy_lock);
+        for (int i = 0; i < ENERGY_CONSUMER_COUNT; i++) {
+            integrate_duty((energy_consumer_t)i, now);
+            active_us[i] = (double)burst_us[i] + duty_active_us[i];
+            burst_us[i] = 0;
+            duty_active_us[i] = 0.0;
+        }
+        slept_us = (double)light_sleep_us;
+        light_sleep_us = 0;
+        portEXIT_CRITICAL(&energy_lock);
+
+        // The CPU is awake except in automatic light sleep (wifi_power.c, when away). Charge the
+        // awake time at the frequency in effect when the interval started so frequency changes
+        // are attributed to the right state, and the time slept at the light sleep current.
+        double interval_us = (double)(now - last_sample_us);
+        if (slept_us > interval_us) {
+            slept_us = interval_us;
+        }
+        active_us[ENERGY_CONSUMER_CPU] = interval_us - slept_us;
+        float cpu_ma = cpu_current_ma(cpu_freq_mhz);
+        cpu_freq_mhz = esp_rom_get_cpu_ticks_per_us();
+        last_sample_us = now;
+
+        for (int i = 0; i < ENERGY_CONSUMER_COUNT; i++) {
+            float current_ma = (i == ENERGY_CONSUMER_CPU) ? cpu_ma : consumer_current_ma[i];
+            double mwh = active_us_to_mwh(current_ma, active_us[i]);
+            if (i == ENERGY_CONSUMER_CPU) {
+                mwh += active_us_to_mwh(CONFIG_ENERGY_CPU_LIGHT_SLEEP_MA, slept_us);
+            }
+            total_mwh[i] += mwh;
+            window_mwh[i] += mwh;
+            window_active_us[i] += active_us[i];
+        }
+
+        if (now - last_report_us >= (int64_t)CONFIG_ENERGY_REPORT_INTERVAL_MS * 1000) {
+            publish_report(now, cpu_freq_mhz);
+            last_report_us = now;
+        }
+    }
+}
+
+esp_err_t energy_module_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Energy module already initialized");
+        return ESP_OK;
+    }
+
+    BaseType_t task_ret = xTaskCreate(
+        energy_task,
+        "energy_task",
+        CONFIG_TASK_STACK_ENERGY,
+        NULL,
+        CONFIG_TASK_PRIORITY_ENERGY,
+        &energy_task_handle
+    );
+
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create energy task");
+        return ESP_FAIL;
+    }
+
+#if ENERGY_TRACK_LIGHT_SLEEP
+    esp_pm_sleep_cbs_register_config_t sleep_cbs = {
+        .exit_cb = on_light_sleep_exit,
+        .exit_cb_prior = 0,
+    };
+    esp_err_t ret = esp_pm_light_sleep_register_cbs(&sleep_cbs);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Light sleep not tracked, CPU charged as awake: %s", esp_err_to_name(ret));
+    }
+#elif CONFIG_PM_ENABLE
+    ESP_LOGW(TAG, "CONFIG_PM_LIGHT_SLEEP_CALLBACKS is off, light sleep charged as awake");
+#endif
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Energy module initialized (%.1f V supply, report every %d ms)",
+             CONFIG_ENERGY_SUPPLY_VOLTAGE_V, CONFIG_ENERGY_REPORT_INTERVAL_MS);
+
+    return ESP_OK;
+}
+
+void energy_set_duty(energy_consumer_t consumer, float duty)
+{
+    if (consumer >= ENERGY_CONSUMER_COUNT) {
+        return;
+    }
+    if (duty < 0.0f) {
+        duty = 0.0f;
+    } else if (duty > 1.0f) {
+        duty = 1.0f;
+    }
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_SAFE(&energy_lock);
+    integrate_duty(consumer, now);
+    duty_level[consumer] = duty;
+    portEXIT_CRITICAL_SAFE(&energy_lock);
+}
+
+void IRAM_ATTR energy_add_active_us(energy_consumer_t consumer, uint32_t active_us)
+{
+    if (consumer >= ENERGY_CONSUMER_COUNT) {
+        return;
+    }
+
+    portENTER_CRITICAL_SAFE(&energy_lock);
+    burst_us[consumer] += active_us;
+    portEXIT_CRITICAL_SAFE(&energy_lock);
+}
+
+esp_err_t energy_get_report(energy_report_t *out)
+{
+    if (!module_initialized || out == NULL) {
+        return ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&report_lock);
+    memcpy(out, &report, sizeof(energy_report_t));
+    portEXIT_CRITICAL(&report_lock);
+    return ESP_OK;
+}
+
+esp_err_t energy_get_summary_string(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_FAIL;
+    }
+
+    energy_report_t r;
+    if (energy_get_report(&r) != ESP_OK) {
+        snprintf(buffer, buffer_size, "Energy: not running");
+        return ESP_OK;
+    }
+    if (r.window_s == 0) {
+        snprintf(buffer, buffer_size, "Energy: collecting...");
+        return ESP_OK;
+    }
+
+    int len = snprintf(buffer, buffer_size, "Energy (last %lus): %.0f mWh/h, %.1f mWh total\n",
+                       (unsigned long)r.window_s, r.rate_total_mwh_per_h, r.total_all_mwh);
+    for (int i = 0; i < ENERGY_CONSUMER_COUNT && len > 0 && (size_t)len < buffer_size; i++) {
+        if (i == ENERGY_CONSUMER_CPU) {
+            len += snprintf(buffer + len, buffer_size - len, "CPU %luMHz: %.1f mWh/h (%.1f%% awake)\n",
+                            (unsigned long)r.cpu_freq_mhz, r.rate_mwh_per_h[i], r.duty[i] * 100.0f);
+        } else {
+            len += snprintf(buffer + len, buffer_size - len, "%s: %.1f mWh/h (%.1f%%)\n",
+                            energy_consumer_to_string((energy_consumer_t)i), r.rate_mwh_per_h[i],
+                            r.duty[i] * 100.0f);
+        }
+    }
+
+    return ESP_OK;
+}
+
+const char* energy_consumer_to_string(energy_consumer_t consumer)
+{
+    switch (consumer) {
+        case ENERGY_CONSUMER_CPU:           return "CPU";
+        case ENERGY_CONSUMER_BACKLIGHT:     return "Backlight";
+        case ENERGY_CONSUMER_DISPLAY_SPI:   return "LCD SPI";
+        case ENERGY_CONSUMER_I2C:           return "I2C";
+        case ENERGY_CONSUMER_WIFI_TX:       return "WiFi TX";
+        case ENERGY_CONSUMER_WIFI_RX:       return "WiFi RX";
+        case ENERGY_CONSUMER_AUDIO_I2S:     return "Audio I2S";
+        default:                            return "Unknown";
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef ENERGY_MODULE_H
+#define ENERGY_MODULE_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file energy_module.h
+ * @brief Energy estimate from per-subsystem active time
+ *
+ * There is no current meter in the loop, so each consumer reports how long it
+ * was active (or its duty level) and the model multiplies that by the current
+ * coefficients in project_config.h. Accounting calls may be made before
+ * energy_module_init() and from ISR context.
+ */
+
+/**
+ * @brief Tracked power consumers
+ */
+typedef enum {
+    ENERGY_CONSUMER_CPU,            // Sampled CPU frequency state, light sleep at its own current
+    ENERGY_CONSUMER_BACKLIGHT,      // Backlight PWM duty
+    ENERGY_CONSUMER_DISPLAY_SPI,    // Panel flush transfers
+    ENERGY_CONSUMER_I2C,            // I2C transactions (RTC, MPU6050)
+    ENERGY_CONSUMER_WIFI_TX,        // Wi-Fi transmit airtime
+    ENERGY_CONSUMER_WIFI_RX,        // Wi-Fi receive/listen time
+    ENERGY_CONSUMER_AUDIO_I2S,      // I2S audio stream running
+    ENERGY_CONSUMER_COUNT
+} energy_consumer_t;
+
+/**
+ * @brief Energy estimate snapshot
+ */
+typedef struct {
+    float rate_mwh_per_h[ENERGY_CONSUMER_COUNT];    // Last report window, i.e. average mW
+    float total_mwh[ENERGY_CONSUMER_COUNT];         // Since boot
+    float duty[ENERGY_CONSUMER_COUNT];              // Active fraction over the last window
+    float rate_total_mwh_per_h;                     // Sum over all consumers, last window
+    float total_all_mwh;                            // Sum over all consumers, since boot
+    uint32_t cpu_freq_mhz;                          // Last sampled CPU frequency
+    uint32_t window_s;                              // Length of the last report window
+} energy_report_t;
+
+/**
+ * @brief Initialize energy accounting and start the integration task
+ *
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t energy_module_init(void);
+
+/**
+ * @brief Set the continuous duty level of a consumer
+ *
+ * Used for consumers that stay on at a level, e.g. the backlight PWM duty or
+ * an I2S stream (1.0 while running, 0.0 when stopped).
+ *
+ * @param consumer Consumer
+ * @param duty Active fraction (0.0-1.0)
+ */
+void energy_set_duty(energy_consumer_t consumer, float duty);
+
+/**
+ * @brief Account one burst of activity
+ *
+ * Used for consumers that are active in short transactions, e.g. a panel
+ * flush or an I2C transfer. Safe to call from ISR context.
+ *
+ * @param consumer Consumer
+ * @param active_us Active time in microseconds
+ */
+void energy_add_active_us(energy_consumer_t consumer, uint32_t active_us);
+
+/**
+ * @brief Get the latest energy estimate
+ *
+ * @param report Pointer to store the report
+ * @return ESP_OK on success, ESP_FAIL if not initialized or report is NULL
+ */
+esp_err_t energy_get_report(energy_report_t *report);
+
+/**
+ * @brief Get formatted multi-line estimate for the diagnostics screen
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 256 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t energy_get_summary_string(char *buffer, size_t buffer_size);
+
+/**
+ * @brief Get printable name of a consumer
+ *
+ * @param consumer Consumer
+ * @return Constant string
+ */
+const char* energy_consumer_to_string(energy_consumer_t consumer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ENERGY_MODULE_H
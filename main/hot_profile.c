@@ -0,0 +1,408 @@
+#include "hot_profile.h"
+#include "display_module.h"
+#include "project_config.h"
+#include <driver/gptimer.h>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <math.h>
+#include <sdkconfig.h>
+#include <soc/soc.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lvgl.h"
+
+#if CONFIG_IDF_TARGET_ESP32S3
+#include <soc/assist_debug_reg.h>
+#include <soc/system_reg.h>
+#endif
+
+static const char *TAG = "HotProfile";
+
+// Each core samples the other one, so both cores must be running
+#if CONFIG_IDF_TARGET_ESP32S3 && !CONFIG_FREERTOS_UNICORE
+#define HOT_PROFILE_SUPPORTED       1
+#else
+#define HOT_PROFILE_SUPPORTED       0
+#endif
+
+#define BLOCK_SHIFT                 4               // 16-byte code blocks
+#define MAX_PROBES                  8               // Linear probing limit before a sample is dropped
+#define MAX_FONTS                   8
+#define SAMPLER_CORES               2
+#define TIMER_RESOLUTION_HZ         1000000
+#define REPORT_GRACE_MS             5000            // Extra wait for the samplers to shut down
+
+_Static_assert((CONFIG_HOT_PROFILE_BUCKETS & (CONFIG_HOT_PROFILE_BUCKETS - 1)) == 0,
+               "CONFIG_HOT_PROFILE_BUCKETS must be a power of two");
+
+typedef struct {
+    uint32_t block;             // PC >> BLOCK_SHIFT, 0 = empty
+    uint32_t count;
+} pc_bucket_t;
+
+typedef struct {
+    const lv_font_t *font;
+    uint32_t objects;
+} font_use_t;
+
+static volatile bool profile_active = false;
+static uint32_t profile_duration_ms = 0;
+static TaskHandle_t report_task_handle = NULL;
+
+// Sample table, written by the timer interrupts of both cores
+static portMUX_TYPE table_lock = portMUX_INITIALIZER_UNLOCKED;
+static pc_bucket_t *buckets = NULL;
+static uint32_t total_samples = 0;
+static uint32_t flash_samples = 0;
+static uint32_t dropped_samples = 0;
+
+// Render time accounting, written by the render task
+static portMUX_TYPE frame_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t frame_count = 0;
+static uint64_t frame_sum_us = 0;
+static uint64_t frame_sum_sq_us = 0;
+static uint32_t frame_max_us = 0;
+
+#if HOT_PROFILE_SUPPORTED
+
+static inline bool IRAM_ATTR pc_in_flash(uint32_t pc)
+{
+    return pc >= SOC_IROM_LOW && pc < SOC_IROM_HIGH;
+}
+
+static bool IRAM_ATTR sample_alarm_cb(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *user_ctx)
+{
+    // The sampler runs on one core and records the PC of the other
+    int sampled_core = (int)(intptr_t)user_ctx;
+    uint32_t pc = REG_READ(sampled_core == 0 ? ASSIST_DEBUG_CORE_0_RCD_PDEBUGPC_REG
+                                             : ASSIST_DEBUG_CORE_1_RCD_PDEBUGPC_REG);
+    uint32_t block = pc >> BLOCK_SHIFT;
+    uint32_t index = (block * 2654435761U) & (CONFIG_HOT_PROFILE_BUCKETS - 1);
+
+    portENTER_CRITICAL_ISR(&table_lock);
+    total_samples++;
+    if (pc_in_flash(pc)) {
+        flash_samples++;
+    }
+    bool stored = false;
+    for (int probe = 0; probe < MAX_PROBES && block != 0; probe++) {
+        pc_bucket_t *bucket = &buckets[(index + probe) & (CONFIG_HOT_PROFILE_BUCKETS - 1)];
+        if (bucket->block == block || bucket->block == 0) {
+            bucket->block = block;
+            bucket->count++;
+            stored = true;
+            break;
+        }
+    }
+    if (!stored) {
+        dropped_samples++;
+    }
+    portEXIT_CRITICAL_ISR(&table_lock);
+
+    return false;
+}
+
+static void enable_pc_recorder(void)
+{
+    REG_SET_BIT(SYSTEM_CPU_PERI_CLK_EN_REG, SYSTEM_CLK_EN_ASSIST_DEBUG);
+    REG_CLR_BIT(SYSTEM_CPU_PERI_RST_EN_REG, SYSTEM_RST_EN_ASSIST_DEBUG);
+    REG_WRITE(ASSIST_DEBUG_CORE_0_RCD_EN_REG, ASSIST_DEBUG_CORE_0_RCD_PDEBUGEN | ASSIST_DEBUG_CORE_0_RCD_RECORDEN);
+    REG_WRITE(ASSIST_DEBUG_CORE_1_RCD_EN_REG, ASSIST_DEBUG_CORE_1_RCD_PDEBUGEN | ASSIST_DEBUG_CORE_1_RCD_RECORDEN);
+}
+
+/*
+ * The timer interrupt is allocated on the core that registers the callbacks,
+ * and must be freed there too, so each sampler owns its timer for the whole
+ * window in a task pinned to its core.
+ */
+static void sampler_task(void *arg)
+{
+    int core = (int)(intptr_t)arg;
+    gptimer_handle_t timer = NULL;
+
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMER_RESOLUTION_HZ,
+    };
+    gptimer_alarm_config_t alarm_config = {
+        .alarm_count = TIMER_RESOLUTION_HZ / CONFIG_HOT_PROFILE_SAMPLE_HZ,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_event_callbacks_t callbacks = {
+        .on_alarm = sample_alarm_cb,
+    };
+
+    esp_err_t ret = gptimer_new_timer(&timer_config, &timer);
+    if (ret == ESP_OK) {
+        ret = gptimer_set_alarm_action(timer, &alarm_config);
+    }
+    if (ret == ESP_OK) {
+        ret = gptimer_register_event_callbacks(timer, &callbacks, (void *)(intptr_t)(1 - core));
+    }
+    if (ret == ESP_OK) {
+        ret = gptimer_enable(timer);
+    }
+    if (ret == ESP_OK) {
+        ret = gptimer_start(timer);
+        if (ret == ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(profile_duration_ms));
+            gptimer_stop(timer);
+        }
+        gptimer_disable(timer);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Sampler on core %d failed: %s", core, esp_err_to_name(ret));
+    }
+    if (timer != NULL) {
+        gptimer_del_timer(timer);
+    }
+
+    xTaskNotifyGive(report_task_handle);
+    vTaskDelete(NULL);
+}
+
+static int compare_bucket_count_desc(const void *a, const void *b)
+{
+    const pc_bucket_t *ba = (const pc_bucket_t *)a;
+    const pc_bucket_t *bb = (const pc_bucket_t *)b;
+    if (ba->count != bb->count) {
+        return ba->count < bb->count ? 1 : -1;
+    }
+    return ba->block < bb->block ? -1 : (ba->block > bb->block ? 1 : 0);
+}
+
+static void collect_fonts(lv_obj_t *obj, font_use_t *fonts, size_t *font_count)
+{
+    const lv_font_t *font = lv_obj_get_style_text_font(obj, LV_PART_MAIN);
+    size_t i;
+    for (i = 0; i < *font_count; i++) {
+        if (fonts[i].font == font) {
+            fonts[i].objects++;
+            break;
+        }
+    }
+    if (i == *font_count && *font_count < MAX_FONTS) {
+        fonts[*font_count].font = font;
+        fonts[*font_count].objects = 1;
+        (*font_count)++;
+    }
+
+    uint32_t child_count = lv_obj_get_child_cnt(obj);
+    for (uint32_t c = 0; c < child_count; c++) {
+        collect_fonts(lv_obj_get_child(obj, c), fonts, font_count);
+    }
+}
+
+static void log_report(bool samplers_done)
+{
+    hot_profile_frame_stats_t frames;
+    hot_profile_get_frame_stats(&frames);
+
+    // Stopped samplers leave the table stable, so it is sorted in place. A sampler that
+    // did not finish may still be hashing into it, so then the report works on a copy
+    pc_bucket_t *table = buckets;
+    if (!samplers_done) {
+        table = heap_caps_malloc(CONFIG_HOT_PROFILE_BUCKETS * sizeof(pc_bucket_t), MALLOC_CAP_DEFAULT);
+    }
+    portENTER_CRITICAL(&table_lock);
+    if (table != NULL && table != buckets) {
+        memcpy(table, buckets, CONFIG_HOT_PROFILE_BUCKETS * sizeof(pc_bucket_t));
+    }
+    uint32_t samples = total_samples;
+    uint32_t flash = flash_samples;
+    uint32_t dropped = dropped_samples;
+    portEXIT_CRITICAL(&table_lock);
+
+    size_t used = 0;
+    if (table != NULL) {
+        for (size_t i = 0; i < CONFIG_HOT_PROFILE_BUCKETS; i++) {
+            if (table[i].block != 0 && pc_in_flash(table[i].block << BLOCK_SHIFT)) {
+                table[used++] = table[i];
+            }
+        }
+        qsort(table, used, sizeof(pc_bucket_t), compare_bucket_count_desc);
+    } else {
+        ESP_LOGW(TAG, "No memory to copy the sample table, PCs not reported");
+    }
+
+    ESP_LOGI(TAG, "HOTPROF begin duration_ms=%lu sample_hz=%d block=%d samples=%lu flash=%lu dropped=%lu",
+             (unsigned long)profile_duration_ms, CONFIG_HOT_PROFILE_SAMPLE_HZ, 1 << BLOCK_SHIFT,
+             (unsigned long)samples, (unsigned long)flash, (unsigned long)dropped);
+
+    size_t reported = used < CONFIG_HOT_PROFILE_REPORT_TOP ? used : CONFIG_HOT_PROFILE_REPORT_TOP;
+    for (size_t i = 0; i < reported; i++) {
+        ESP_LOGI(TAG, "HOTPC 0x%08lx %lu",
+                 (unsigned long)(table[i].block << BLOCK_SHIFT), (unsigned long)table[i].count);
+    }
+    if (table != buckets) {
+        heap_caps_free(table);
+    }
+
+    font_use_t fonts[MAX_FONTS];
+    size_t font_count = 0;
+    if (display_lock(CONFIG_DISPLAY_LOCK_TIMEOUT_MS)) {
+        collect_fonts(lv_scr_act(), fonts, &font_count);
+        display_unlock();
+    } else {
+        ESP_LOGW(TAG, "UI lock timeout, fonts not reported");
+    }
+    for (size_t i = 0; i < font_count; i++) {
+        ESP_LOGI(TAG, "HOTFONT 0x%08lx %lu",
+                 (unsigned long)(uintptr_t)fonts[i].font, (unsigned long)fonts[i].objects);
+    }
+
+    ESP_LOGI(TAG, "HOTFRAME frames=%lu mean_us=%lu stddev_us=%lu max_us=%lu",
+             (unsigned long)frames.frames, (unsigned long)frames.mean_us,
+             (unsigned long)frames.stddev_us, (unsigned long)frames.max_us);
+    ESP_LOGI(TAG, "HOTPROF end flash_share=%lu%%",
+             (unsigned long)(samples > 0 ? (uint64_t)flash * 100 / samples : 0));
+}
+
+static void report_task(void *arg)
+{
+    for (int core = 0; core < SAMPLER_CORES; core++) {
+        BaseType_t task_ret = xTaskCreatePinnedToCore(
+            sampler_task,
+            "hot_sampler",
+            CONFIG_TASK_STACK_HOT_PROFILE,
+            (void *)(intptr_t)core,
+            CONFIG_TASK_PRIORITY_HOT_PROFILE,
+            NULL,
+            core
+        );
+        if (task_ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create sampler task on core %d", core);
+            xTaskNotifyGive(xTaskGetCurrentTaskHandle());
+        }
+    }
+
+    int done = 0;
+    while (done < SAMPLER_CORES) {
+        if (ulTaskNotifyTake(pdFALSE, pdMS_TO_TICKS(profile_duration_ms + REPORT_GRACE_MS)) == 0) {
+            ESP_LOGW(TAG, "Sampler did not finish, reporting what was collected");
+            break;
+        }
+        done++;
+    }
+
+    profile_active = false;
+    log_report(done == SAMPLER_CORES);
+
+    // A sampler that did not finish may still write to the table, keep it then
+    if (done == SAMPLER_CORES) {
+        heap_caps_free(buckets);
+        buckets = NULL;
+    }
+    report_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+#endif // HOT_PROFILE_SUPPORTED
+
+esp_err_t hot_profile_start(uint32_t duration_ms)
+{
+#if !HOT_PROFILE_SUPPORTED
+    ESP_LOGW(TAG, "PC sampling needs both ESP32-S3 cores");
+    return ESP_ERR_NOT_SUPPORTED;
+#else
+    if (profile_active || report_task_handle != NULL) {
+        ESP_LOGW(TAG, "Profile already running");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (buckets == NULL) {
+        buckets = heap_caps_calloc(CONFIG_HOT_PROFILE_BUCKETS, sizeof(pc_bucket_t), MALLOC_CAP_INTERNAL);
+        if (buckets == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate sample table");
+            return ESP_ERR_NO_MEM;
+        }
+    } else {
+        memset(buckets, 0, CONFIG_HOT_PROFILE_BUCKETS * sizeof(pc_bucket_t));
+    }
+    total_samples = 0;
+    flash_samples = 0;
+    dropped_samples = 0;
+
+    portENTER_CRITICAL(&frame_lock);
+    frame_count = 0;
+    frame_sum_us = 0;
+    frame_sum_sq_us = 0;
+    frame_max_us = 0;
+    portEXIT_CRITICAL(&frame_lock);
+
+    enable_pc_recorder();
+    profile_duration_ms = duration_ms;
+    profile_active = true;
+
+    BaseType_t task_ret = xTaskCreate(
+        report_task,
+        "hot_profile",
+        CONFIG_TASK_STACK_HOT_PROFILE,
+        NULL,
+        CONFIG_TASK_PRIORITY_HOT_PROFILE,
+        &report_task_handle
+    );
+
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create profile task");
+        profile_active = false;
+        report_task_handle = NULL;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Profiling for %lu ms at %d Hz per core", (unsigned long)duration_ms, CONFIG_HOT_PROFILE_SAMPLE_HZ);
+    return ESP_OK;
+#endif
+}
+
+bool hot_profile_is_active(void)
+{
+    return profile_active;
+}
+
+void hot_profile_record_frame(uint32_t render_us)
+{
+    if (!profile_active) {
+        return;
+    }
+
+    portENTER_CRITICAL(&frame_lock);
+    frame_count++;
+    frame_sum_us += render_us;
+    frame_sum_sq_us += (uint64_t)render_us * render_us;
+    if (render_us > frame_max_us) {
+        frame_max_us = render_us;
+    }
+    portEXIT_CRITICAL(&frame_lock);
+}
+
+esp_err_t hot_profile_get_frame_stats(hot_profile_frame_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&frame_lock);
+    uint32_t count = frame_count;
+    uint64_t sum = frame_sum_us;
+    uint64_t sum_sq = frame_sum_sq_us;
+    uint32_t max_us = frame_max_us;
+    portEXIT_CRITICAL(&frame_lock);
+
+    memset(stats, 0, sizeof(hot_profile_frame_stats_t));
+    stats->frames = count;
+    stats->max_us = max_us;
+    if (count > 0) {
+        double mean = (double)sum / count;
+        double variance = (double)sum_sq / count - mean * mean;
+        stats->mean_us = (uint32_t)mean;
+        stats->stddev_us = variance > 0.0 ? (uint32_t)sqrt(variance) : 0;
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,75 @@
+#ifndef HOT_PROFILE_H
+#define HOT_PROFILE_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file hot_profile.h
+ * @brief PC sampling profile for placing hot code in IRAM and hot tables in DRAM
+ *
+ * A timer interrupt on each core samples the program counter of the other
+ * core through the assist-debug PC recorder, so the sampler itself never
+ * shows up in the profile. Samples are counted per 16-byte code block. At the
+ * end of the window the hottest flash-resident blocks, the fonts on the
+ * active screen and the render time statistics are logged as HOTPC, HOTFONT
+ * and HOTFRAME lines, which tools/hot_placement.py turns into
+ * main/hot_placement.lf and uses to compare frame-time variance between builds.
+ */
+
+/**
+ * @brief Render time statistics of the profiling window
+ */
+typedef struct {
+    uint32_t frames;            // lv_timer_handler() runs that flushed
+    uint32_t mean_us;
+    uint32_t stddev_us;
+    uint32_t max_us;
+} hot_profile_frame_stats_t;
+
+/**
+ * @brief Start sampling and log the profile after duration_ms
+ *
+ * Run it while the device does representative work; the report is logged
+ * by a background task once the window closes.
+ *
+ * @param duration_ms Profiling window
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if already running,
+ *         ESP_ERR_NOT_SUPPORTED on single-core builds, ESP_ERR_NO_MEM or ESP_FAIL otherwise
+ */
+esp_err_t hot_profile_start(uint32_t duration_ms);
+
+/**
+ * @brief Check whether a profiling window is open
+ *
+ * @return true while sampling
+ */
+bool hot_profile_is_active(void);
+
+/**
+ * @brief Record the duration of one rendered frame, called from the render task
+ *
+ * Does nothing outside a profiling window.
+ *
+ * @param render_us Time spent in lv_timer_handler() for a run that flushed
+ */
+void hot_profile_record_frame(uint32_t render_us);
+
+/**
+ * @brief Get the render time statistics of the current or last window
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t hot_profile_get_frame_stats(hot_profile_frame_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOT_PROFILE_H
@@ -0,0 +1,547 @@
+#include "i2c_bus.h"
+#include "energy_module.h"
+#include "project_config.h"
+#include <driver/gpio.h>
+#include <esp_log.h>
+#include <esp_rom_sys.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "I2CBus";
+
+#define TICK_US                 (portTICK_PERIOD_MS * 1000)
+#define RECOVERY_HALF_PERIOD_US 5       // ~100 kHz while clocking out
+
+/**
+ * @brief Bus driver state, one per I2C port
+ */
+typedef struct {
+    bool installed;
+    int users;
+    gpio_num_t sda_gpio;
+    gpio_num_t scl_gpio;
+    uint32_t freq_hz;
+    SemaphoreHandle_t lock;         // Serializes transactions against recovery
+    volatile bool recovery_pending;
+    uint32_t recoveries;
+} i2c_port_state_t;
+
+/**
+ * @brief Device state and statistics
+ */
+typedef struct {
+    bool registered;
+    i2c_device_config_t config;
+    bool offline;
+    uint32_t consecutive_errors;
+    int64_t last_error_us;
+    uint32_t reprobe_delay_ms;
+    int64_t next_probe_us;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t deadline_misses;
+    uint32_t max_blocking_us;
+    uint32_t probes;
+} i2c_device_state_t;
+
+static i2c_port_state_t ports[I2C_NUM_MAX];
+static i2c_device_state_t devices[I2C_DEVICE_COUNT];
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t health_task_handle = NULL;
+
+/**
+ * @brief Deadline of a register transaction, from its length on the wire
+ *
+ * Address, register, repeated-start address and payload at 9 clocks per byte,
+ * plus start and stop, scaled by a margin for clock stretching and driver overhead.
+ */
+static uint32_t transaction_deadline_us(const i2c_device_state_t *dev, size_t len, bool read)
+{
+    uint32_t bytes = 2 + (read ? 1 : 0) + (uint32_t)len;
+    uint32_t wire_us = (uint32_t)(((uint64_t)(bytes * 9 + 2) * 1000000) / dev->config.freq_hz);
+    uint32_t deadline_us = wire_us * CONFIG_I2C_DEADLINE_MARGIN;
+    return (deadline_us < CONFIG_I2C_DEADLINE_MIN_US) ? CONFIG_I2C_DEADLINE_MIN_US : deadline_us;
+}
+
+static TickType_t deadline_to_ticks(uint32_t deadline_us)
+{
+    // One extra tick because the current one is already partly over
+    return (TickType_t)((deadline_us + TICK_US - 1) / TICK_US) + 1;
+}
+
+/**
+ * @brief Take a device offline and schedule its first re-probe
+ *
+ * Must be called with stats_lock held.
+ */
+static void mark_offline(i2c_device_state_t *dev, int64_t now)
+{
+    dev->offline = true;
+    dev->reprobe_delay_ms = CONFIG_I2C_REPROBE_MIN_MS;
+    dev->next_probe_us = now + (int64_t)dev->reprobe_delay_ms * 1000;
+}
+
+static void record_transaction(i2c_device_id_t id, esp_err_t ret, uint32_t blocked_us, uint32_t deadline_us)
+{
+    i2c_device_state_t *dev = &devices[id];
+    int64_t now = esp_timer_get_time();
+    bool went_offline = false;
+
+    portENTER_CRITICAL(&stats_lock);
+    dev->transactions++;
+    if (blocked_us > dev->max_blocking_us) {
+        dev->max_blocking_us = blocked_us;
+    }
+    if (blocked_us > deadline_us) {
+        dev->deadline_misses++;
+    }
+    if (ret == ESP_OK) {
+        dev->consecutive_errors = 0;
+    } else {
+        dev->errors++;
+        dev->consecutive_errors++;
+        dev->last_error_us = now;
+        if (ret == ESP_ERR_TIMEOUT) {
+            dev->timeouts++;
+        }
+        if (!dev->offline && dev->consecutive_errors >= CONFIG_I2C_OFFLINE_AFTER_ERRORS) {
+            mark_offline(dev, now);
+            went_offline = true;
+        }
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    // A timeout or a confused controller usually means a slave holds SDA low
+    if (ret == ESP_ERR_TIMEOUT || ret == ESP_ERR_INVALID_STATE) {
+        ports[dev->config.port].recovery_pending = true;
+    }
+
+    if (went_offline) {
+        ESP_LOGW(TAG, "%s offline after %d errors (%s), re-probing in background",
+                 dev->config.name, CONFIG_I2C_OFFLINE_AFTER_ERRORS, esp_err_to_name(ret));
+    }
+}
+
+static esp_err_t transaction(i2c_device_id_t id, uint8_t reg, uint8_t *data, size_t len, bool read)
+{
+    if (id >= I2C_DEVICE_COUNT || !devices[id].registered || data == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!read && len > CONFIG_I2C_MAX_WRITE_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    i2c_device_state_t *dev = &devices[id];
+    i2c_port_state_t *port = &ports[dev->config.port];
+
+    // Fail fast instead of queueing behind a dead device; the health task's probes get through
+    bool from_health_task = (xTaskGetCurrentTaskHandle() == health_task_handle);
+    if (!from_health_task && (dev->offline || port->recovery_pending)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t deadline_us = transaction_deadline_us(dev, len, read);
+    TickType_t deadline_ticks = deadline_to_ticks(deadline_us);
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret;
+
+    if (xSemaphoreTake(port->lock, deadline_ticks) != pdTRUE) {
+        ret = ESP_ERR_TIMEOUT;
+    } else {
+        // The lock wait counts against the same deadline
+        TickType_t waited = (TickType_t)((esp_timer_get_time() - start) / TICK_US);
+        TickType_t remaining = (waited < deadline_ticks) ? deadline_ticks - waited : 1;
+
+        int64_t bus_start = esp_timer_get_time();
+        if (read) {
+            ret = i2c_master_write_read_device(dev->config.port, dev->config.addr, &reg, 1, data, len, remaining);
+        } else {
+            uint8_t buf[CONFIG_I2C_MAX_WRITE_LEN + 1];
+            buf[0] = reg;
+            memcpy(&buf[1], data, len);
+            ret = i2c_master_write_to_device(dev->config.port, dev->config.addr, buf, len + 1, remaining);
+        }
+        energy_add_active_us(ENERGY_CONSUMER_I2C, (uint32_t)(esp_timer_get_time() - bus_start));
+        xSemaphoreGive(port->lock);
+    }
+
+    record_transaction(id, ret, (uint32_t)(esp_timer_get_time() - start), deadline_us);
+    return ret;
+}
+
+esp_err_t i2c_bus_read(i2c_device_id_t id, uint8_t reg, uint8_t *data, size_t len)
+{
+    return transaction(id, reg, data, len, true);
+}
+
+esp_err_t i2c_bus_write(i2c_device_id_t id, uint8_t reg, const uint8_t *data, size_t len)
+{
+    return transaction(id, reg, (uint8_t *)data, len, false);
+}
+
+static esp_err_t port_driver_install(i2c_port_t port_num)
+{
+    i2c_port_state_t *port = &ports[port_num];
+    i2c_config_t conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = port->sda_gpio,
+        .scl_io_num = port->scl_gpio,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = port->freq_hz,
+    };
+
+    esp_err_t ret = i2c_param_config(port_num, &conf);
+    if (ret == ESP_OK) {
+        ret = i2c_driver_install(port_num, conf.mode, 0, 0, 0);
+    }
+    return ret;
+}
+
+/**
+ * @brief Free a slave stuck mid-byte by clocking SCL until it releases SDA, then send STOP
+ *
+ * @return true if SDA is high afterwards
+ */
+static bool bus_clock_out(gpio_num_t sda, gpio_num_t scl)
+{
+    gpio_set_direction(sda, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(sda, GPIO_PULLUP_ONLY);
+    gpio_set_level(sda, 1);
+    gpio_set_direction(scl, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_pull_mode(scl, GPIO_PULLUP_ONLY);
+    gpio_set_level(scl, 1);
+    esp_rom_delay_us(RECOVERY_HALF_PERIOD_US);
+
+    for (int i = 0; i < CONFIG_I2C_RECOVERY_CLOCKS && gpio_get_level(sda) == 0; i++) {
+        gpio_set_level(scl, 0);
+        esp_rom_delay_us(RECOVERY_HALF_PERIOD_US);
+        gpio_set_level(scl, 1);
+        esp_rom_delay_us(RECOVERY_HALF_PERIOD_US);
+    }
+
+    // STOP: SDA rises while SCL is high
+    gpio_set_level(scl, 0);
+    esp_rom_delay_us(RECOVERY_HALF_PERIOD_US);
+    gpio_set_level(sda, 0);
+    esp_rom_delay_us(RECOVERY_HALF_PERIOD_US);
+    gpio_set_level(scl, 1);
+    esp_rom_delay_us(RECOVERY_HALF_PERIOD_US);
+    gpio_set_level(sda, 1);
+    esp_rom_delay_us(RECOVERY_HALF_PERIOD_US);
+
+    return gpio_get_level(sda) == 1;
+}
+
+static void recover_port(i2c_port_t port_num)
+{
+    i2c_port_state_t *port = &ports[port_num];
+
+    // A transaction still holding the lock finishes within its own deadline
+    if (xSemaphoreTake(port->lock, pdMS_TO_TICKS(CONFIG_I2C_HEALTH_POLL_MS)) != pdTRUE) {
+        return;
+    }
+
+    if (port->installed) {
+        i2c_driver_delete(port_num);
+        bool released = bus_clock_out(port->sda_gpio, port->scl_gpio);
+        esp_err_t ret = port_driver_install(port_num);
+        port->installed = (ret == ESP_OK);
+        port->recoveries++;
+
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Port %d driver reinstall failed: %s", port_num, esp_err_to_name(ret));
+        } else if (!released) {
+            ESP_LOGW(TAG, "Port %d recovered, but SDA is still held low", port_num);
+        } else {
+            ESP_LOGI(TAG, "Port %d bus recovered (%lu recoveries)", port_num, (unsigned long)port->recoveries);
+        }
+    }
+    port->recovery_pending = false;
+
+    xSemaphoreGive(port->lock);
+}
+
+static void probe_device(i2c_device_id_t id)
+{
+    i2c_device_state_t *dev = &devices[id];
+    uint8_t value;
+
+    esp_err_t ret = i2c_bus_read(id, dev->config.probe_reg, &value, 1);
+    if (ret == ESP_OK && dev->config.on_online != NULL) {
+        ret = dev->config.on_online(dev->config.user_ctx);
+    }
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&stats_lock);
+    dev->probes++;
+    if (ret == ESP_OK) {
+        dev->offline = false;
+        dev->consecutive_errors = 0;
+    } else {
+        dev->reprobe_delay_ms *= 2;
+        if (dev->reprobe_delay_ms > CONFIG_I2C_REPROBE_MAX_MS) {
+            dev->reprobe_delay_ms = CONFIG_I2C_REPROBE_MAX_MS;
+        }
+        dev->next_probe_us = now + (int64_t)dev->reprobe_delay_ms * 1000;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%s back online after %lu probes", dev->config.name, (unsigned long)dev->probes);
+    } else {
+        ESP_LOGD(TAG, "%s still offline (%s), next probe in %lu ms",
+                 dev->config.name, esp_err_to_name(ret), (unsigned long)dev->reprobe_delay_ms);
+    }
+}
+
+static void log_health_report(void)
+{
+    for (int id = 0; id < I2C_DEVICE_COUNT; id++) {
+        i2c_device_health_t h;
+        if (!devices[id].registered || i2c_bus_get_health((i2c_device_id_t)id, &h) != ESP_OK) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%s: %s, %lu transactions, %lu errors (%lu timeouts), worst block %lu us, %lu over deadline, %lu recoveries",
+                 devices[id].config.name, i2c_health_to_string(h.health),
+                 (unsigned long)h.transactions, (unsigned long)h.errors, (unsigned long)h.timeouts,
+                 (unsigned long)h.max_blocking_us, (unsigned long)h.deadline_misses,
+                 (unsigned long)h.bus_recoveries);
+    }
+}
+
+/**
+ * @brief Health task: bus recovery and re-probing, off the callers' paths
+ */
+static void i2c_health_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "I2C health task started");
+
+    int64_t last_report_time = esp_timer_get_time();
+
+    while (1) {
+        for (int p = 0; p < I2C_NUM_MAX; p++) {
+            if (ports[p].recovery_pending) {
+                recover_port((i2c_port_t)p);
+            }
+        }
+
+        int64_t now = esp_timer_get_time();
+        for (int id = 0; id < I2C_DEVICE_COUNT; id++) {
+            if (devices[id].registered && devices[id].offline && now >= devices[id].next_probe_us) {
+                probe_device((i2c_device_id_t)id);
+            }
+        }
+
+        if (now - last_report_time >= (int64_t)CONFIG_I2C_REPORT_INTERVAL_MS * 1000) {
+            last_report_time = now;
+            log_health_report();
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_I2C_HEALTH_POLL_MS));
+    }
+}
+
+esp_err_t i2c_bus_add_device(i2c_device_id_t id, const i2c_device_config_t *config)
+{
+    if (id >= I2C_DEVICE_COUNT || config == NULL || config->port >= I2C_NUM_MAX || config->freq_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (devices[id].registered) {
+        return i2c_bus_is_online(id) ? ESP_OK : ESP_ERR_NOT_FOUND;
+    }
+
+    i2c_port_state_t *port = &ports[config->port];
+    if (port->lock == NULL) {
+        port->lock = xSemaphoreCreateMutex();
+        if (port->lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (port->installed) {
+        if (port->sda_gpio != config->sda_gpio || port->scl_gpio != config->scl_gpio) {
+            ESP_LOGE(TAG, "%s: port %d already in use on other pins", config->name, config->port);
+            return ESP_ERR_INVALID_STATE;
+        }
+    } else {
+        ESP_LOGI(TAG, "Installing I2C port %d on SDA:%d, SCL:%d at %lu Hz",
+                 config->port, config->sda_gpio, config->scl_gpio, (unsigned long)config->freq_hz);
+        port->sda_gpio = config->sda_gpio;
+        port->scl_gpio = config->scl_gpio;
+        port->freq_hz = config->freq_hz;
+        esp_err_t ret = port_driver_install(config->port);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to install I2C driver on port %d: %s", config->port, esp_err_to_name(ret));
+            return ret;
+        }
+        port->installed = true;
+        port->recovery_pending = false;
+    }
+    port->users++;
+
+    if (health_task_handle == NULL) {
+        BaseType_t task_ret = xTaskCreate(
+            i2c_health_task,
+            "i2c_health",
+            CONFIG_TASK_STACK_I2C_HEALTH,
+            NULL,
+            CONFIG_TASK_PRIORITY_I2C_HEALTH,
+            &health_task_handle
+        );
+        if (task_ret != pdPASS) {
+            ESP_LOGW(TAG, "Failed to create I2C health task, failed devices will not be re-probed");
+        }
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    memset(&devices[id], 0, sizeof(i2c_device_state_t));
+    devices[id].config = *config;
+    devices[id].registered = true;
+    portEXIT_CRITICAL(&stats_lock);
+
+    uint8_t value;
+    esp_err_t ret = i2c_bus_read(id, config->probe_reg, &value, 1);
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&stats_lock);
+        mark_offline(&devices[id], esp_timer_get_time());
+        portEXIT_CRITICAL(&stats_lock);
+        ESP_LOGW(TAG, "%s not answering at 0x%02x (%s), re-probing in background",
+                 config->name, config->addr, esp_err_to_name(ret));
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ESP_LOGI(TAG, "%s answering at 0x%02x", config->name, config->addr);
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_remove_device(i2c_device_id_t id)
+{
+    if (id >= I2C_DEVICE_COUNT || !devices[id].registered) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    i2c_port_t port_num = devices[id].config.port;
+    i2c_port_state_t *port = &ports[port_num];
+
+    // Wait out an in-flight transaction or recovery before the driver can go
+    xSemaphoreTake(port->lock, portMAX_DELAY);
+    portENTER_CRITICAL(&stats_lock);
+    devices[id].registered = false;
+    portEXIT_CRITICAL(&stats_lock);
+
+    port->users--;
+    if (port->users <= 0 && port->installed) {
+        i2c_driver_delete(port_num);
+        port->installed = false;
+        port->users = 0;
+        port->recovery_pending = false;
+        ESP_LOGI(TAG, "I2C port %d released", port_num);
+    }
+    xSemaphoreGive(port->lock);
+
+    return ESP_OK;
+}
+
+void i2c_bus_report_failure(i2c_device_id_t id)
+{
+    if (id >= I2C_DEVICE_COUNT || !devices[id].registered) {
+        return;
+    }
+
+    bool went_offline = false;
+    portENTER_CRITICAL(&stats_lock);
+    if (!devices[id].offline) {
+        mark_offline(&devices[id], esp_timer_get_time());
+        went_offline = true;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    if (went_offline) {
+        ESP_LOGW(TAG, "%s reported unusable, re-probing in background", devices[id].config.name);
+    }
+}
+
+bool i2c_bus_is_online(i2c_device_id_t id)
+{
+    return id < I2C_DEVICE_COUNT && devices[id].registered && !devices[id].offline;
+}
+
+esp_err_t i2c_bus_get_health(i2c_device_id_t id, i2c_device_health_t *health)
+{
+    if (id >= I2C_DEVICE_COUNT || health == NULL || !devices[id].registered) {
+        return ESP_FAIL;
+    }
+
+    const i2c_device_state_t *dev = &devices[id];
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&stats_lock);
+    if (dev->offline) {
+        health->health = I2C_HEALTH_OFFLINE;
+    } else if (dev->last_error_us != 0 && now - dev->last_error_us < (int64_t)CONFIG_I2C_DEGRADED_HOLD_MS * 1000) {
+        health->health = I2C_HEALTH_DEGRADED;
+    } else {
+        health->health = I2C_HEALTH_OK;
+    }
+    health->transactions = dev->transactions;
+    health->errors = dev->errors;
+    health->timeouts = dev->timeouts;
+    health->deadline_misses = dev->deadline_misses;
+    health->max_blocking_us = dev->max_blocking_us;
+    health->probes = dev->probes;
+    health->next_probe_ms = (dev->offline && dev->next_probe_us > now) ?
+                            (uint32_t)((dev->next_probe_us - now) / 1000) : 0;
+    portEXIT_CRITICAL(&stats_lock);
+    health->bus_recoveries = ports[dev->config.port].recoveries;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_get_status_string(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_FAIL;
+    }
+
+    int written = snprintf(buffer, buffer_size, "I2C:");
+    uint32_t worst_us = 0;
+
+    for (int id = 0; id < I2C_DEVICE_COUNT && written >= 0 && (size_t)written < buffer_size; id++) {
+        i2c_device_health_t h;
+        if (i2c_bus_get_health((i2c_device_id_t)id, &h) != ESP_OK) {
+            continue;
+        }
+        if (h.max_blocking_us > worst_us) {
+            worst_us = h.max_blocking_us;
+        }
+        if (h.health == I2C_HEALTH_OFFLINE) {
+            written += snprintf(buffer + written, buffer_size - written, " %s offline (retry %lus)",
+                                devices[id].config.name, (unsigned long)(h.next_probe_ms / 1000));
+        } else {
+            written += snprintf(buffer + written, buffer_size - written, " %s %s",
+                                devices[id].config.name, i2c_health_to_string(h.health));
+        }
+    }
+
+    if (written >= 0 && (size_t)written < buffer_size) {
+        snprintf(buffer + written, buffer_size - written, ", worst %lu.%lu ms",
+                 (unsigned long)(worst_us / 1000), (unsigned long)((worst_us % 1000) / 100));
+    }
+    return ESP_OK;
+}
+
+const char* i2c_health_to_string(i2c_health_t health)
+{
+    switch (health) {
+        case I2C_HEALTH_OK:         return "ok";
+        case I2C_HEALTH_DEGRADED:   return "degraded";
+        case I2C_HEALTH_OFFLINE:    return "offline";
+        default:                    return "unknown";
+    }
+}
@@ -0,0 +1,171 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <driver/i2c.h>
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file i2c_bus.h
+ * @brief I2C reliability layer with bounded-latency register access
+ *
+ * Every transaction gets a deadline sized to its length on the wire, so a
+ * glitching device cannot block the caller for longer than the transfer
+ * should take. Bus lockups are cleared by clocking out SCL in the background,
+ * and devices that stop answering are taken offline and re-probed with
+ * exponential backoff; transactions to an offline device fail immediately.
+ */
+
+/**
+ * @brief Devices managed by the layer
+ */
+typedef enum {
+    I2C_DEVICE_DS3231,
+    I2C_DEVICE_MPU6050,
+    I2C_DEVICE_COUNT
+} i2c_device_id_t;
+
+/**
+ * @brief Device health published for the UI
+ */
+typedef enum {
+    I2C_HEALTH_OK,          // Answering
+    I2C_HEALTH_DEGRADED,    // Answering, but errors were seen recently
+    I2C_HEALTH_OFFLINE      // Not answering, re-probed in the background
+} i2c_health_t;
+
+/**
+ * @brief Called from the health task when an offline device answers again
+ *
+ * Re-configure the device here; register access is allowed although the
+ * device is still marked offline. Return an error to keep it offline.
+ */
+typedef esp_err_t (*i2c_online_cb_t)(void *user_ctx);
+
+/**
+ * @brief Device and bus description
+ */
+typedef struct {
+    const char *name;           // Short name for logs and the UI
+    i2c_port_t port;
+    gpio_num_t sda_gpio;
+    gpio_num_t scl_gpio;
+    uint32_t freq_hz;
+    uint8_t addr;
+    uint8_t probe_reg;          // Register read to check the device answers
+    i2c_online_cb_t on_online;  // Optional
+    void *user_ctx;
+} i2c_device_config_t;
+
+/**
+ * @brief Per-device health and latency statistics
+ */
+typedef struct {
+    i2c_health_t health;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t deadline_misses;       // Transactions that blocked longer than their deadline
+    uint32_t max_blocking_us;       // Worst-case time a caller was blocked
+    uint32_t bus_recoveries;        // SCL clock-outs on this device's bus
+    uint32_t probes;                // Re-probes while offline
+    uint32_t next_probe_ms;         // Time until the next re-probe (offline only)
+} i2c_device_health_t;
+
+/**
+ * @brief Register a device, installing the bus driver on first use
+ *
+ * The device is probed once. A device that does not answer stays registered
+ * and is re-probed in the background; its on_online callback runs when it does.
+ *
+ * @param id Device to register
+ * @param config Device and bus description
+ * @return ESP_OK if the device answered, ESP_ERR_NOT_FOUND if it is offline, other errors on failure
+ */
+esp_err_t i2c_bus_add_device(i2c_device_id_t id, const i2c_device_config_t *config);
+
+/**
+ * @brief Unregister a device, deleting the bus driver when it was the last user
+ *
+ * @param id Device to unregister
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if not registered
+ */
+esp_err_t i2c_bus_remove_device(i2c_device_id_t id);
+
+/**
+ * @brief Read consecutive registers
+ *
+ * @param id Device
+ * @param reg First register
+ * @param data Buffer for the register contents
+ * @param len Number of registers to read
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT past the deadline, ESP_ERR_INVALID_STATE while offline or recovering
+ */
+esp_err_t i2c_bus_read(i2c_device_id_t id, uint8_t reg, uint8_t *data, size_t len);
+
+/**
+ * @brief Write consecutive registers
+ *
+ * @param id Device
+ * @param reg First register
+ * @param data Register contents (at most CONFIG_I2C_MAX_WRITE_LEN bytes)
+ * @param len Number of registers to write
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT past the deadline, ESP_ERR_INVALID_STATE while offline or recovering
+ */
+esp_err_t i2c_bus_write(i2c_device_id_t id, uint8_t reg, const uint8_t *data, size_t len);
+
+/**
+ * @brief Take a device offline that answers but cannot be used
+ *
+ * For devices whose configuration failed; they are re-probed like any other
+ * offline device and their on_online callback runs when the probe succeeds.
+ *
+ * @param id Device
+ */
+void i2c_bus_report_failure(i2c_device_id_t id);
+
+/**
+ * @brief Check whether a device is answering
+ *
+ * @param id Device
+ * @return true if registered and not offline
+ */
+bool i2c_bus_is_online(i2c_device_id_t id);
+
+/**
+ * @brief Get health and latency statistics of a device
+ *
+ * @param id Device
+ * @param health Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t i2c_bus_get_health(i2c_device_id_t id, i2c_device_health_t *health);
+
+/**
+ * @brief Get formatted bus health summary for the diagnostics screen
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 64 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t i2c_bus_get_status_string(char *buffer, size_t buffer_size);
+
+/**
+ * @brief Get printable name of a health state
+ *
+ * @param health Health state
+ * @return Constant string
+ */
+const char* i2c_health_to_string(i2c_health_t health);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // I2C_BUS_H
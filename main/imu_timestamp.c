@@ -0,0 +1,220 @@
+#include "imu_timestamp.h"
+#include "project_config.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+#include <math.h>
+
+static const char *TAG = "IMUTimestamp";
+
+// Loop gains of the timeline tracker (fractions of the measured error)
+#define PHASE_CORRECTION_GAIN   0.25f   // Applied to the timeline offset every anchored batch
+#define PERIOD_CORRECTION_GAIN  0.0625f // Applied to the per-sample period estimate
+#define PERIOD_MAX_DEVIATION    0.05f   // MPU clock is specified to +-5% worst case
+
+// Data-ready edges captured in ISR context
+static portMUX_TYPE drdy_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t drdy_count = 0;      // Edges since init
+static volatile int64_t drdy_time_us = 0;     // Host time of the latest edge
+
+// Timeline state (only touched from the motion task)
+static bool module_initialized = false;
+static bool timeline_valid = false;
+static float nominal_period_us = 0.0f;
+static float period_us = 0.0f;
+static double next_sample_us = 0.0;           // Predicted timestamp of the next sample
+static int64_t edge_sample_offset = 0;        // sample index = (edge count - 1) + offset
+static int64_t last_assigned_us = 0;
+static uint32_t samples_since_anchor = 0;
+static uint64_t abs_error_sum_us = 0;
+static imu_timing_stats_t stats = {0};
+
+esp_err_t imu_timestamp_init(uint32_t sample_rate_hz)
+{
+    if (sample_rate_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nominal_period_us = 1000000.0f / (float)sample_rate_hz;
+    period_us = nominal_period_us;
+    timeline_valid = false;
+    next_sample_us = 0.0;
+    last_assigned_us = 0;
+    samples_since_anchor = 0;
+    abs_error_sum_us = 0;
+
+    portENTER_CRITICAL(&drdy_lock);
+    drdy_count = 0;
+    drdy_time_us = 0;
+    portEXIT_CRITICAL(&drdy_lock);
+    edge_sample_offset = 0;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.nominal_period_us = (uint32_t)nominal_period_us;
+    stats.estimated_period_us = period_us;
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "IMU timeline initialized (%lu Hz, %.1f us/sample)",
+             (unsigned long)sample_rate_hz, nominal_period_us);
+
+    return ESP_OK;
+}
+
+void IRAM_ATTR imu_timestamp_on_data_ready_isr(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&drdy_lock);
+    drdy_count++;
+    drdy_time_us = now;
+    portEXIT_CRITICAL_ISR(&drdy_lock);
+}
+
+void imu_timestamp_resync(void)
+{
+    portENTER_CRITICAL(&drdy_lock);
+    uint32_t edges = drdy_count;
+    portEXIT_CRITICAL(&drdy_lock);
+
+    // The next edge belongs to the first sample written after the reset
+    edge_sample_offset = (int64_t)stats.samples_total - (int64_t)edges;
+    timeline_valid = false;
+    stats.resyncs++;
+}
+
+/**
+ * @brief Start a new timeline so that sample @p index of the batch lands at @p anchor_us
+ */
+static void restart_timeline(uint32_t index, double anchor_us)
+{
+    next_sample_us = anchor_us - (double)index * period_us;
+    if (next_sample_us <= (double)last_assigned_us) {
+        next_sample_us = (double)last_assigned_us + 1.0;
+    }
+    samples_since_anchor = 0;
+    timeline_valid = true;
+}
+
+static void record_error(float error_us)
+{
+    uint32_t abs_error = (uint32_t)fabsf(error_us);
+
+    stats.anchored_batches++;
+    stats.last_abs_error_us = abs_error;
+    if (abs_error > stats.max_abs_error_us) {
+        stats.max_abs_error_us = abs_error;
+    }
+    abs_error_sum_us += abs_error;
+    stats.mean_abs_error_us = (uint32_t)(abs_error_sum_us / stats.anchored_batches);
+}
+
+void imu_timestamp_assign_batch(int64_t read_time_us, uint32_t count, int64_t *timestamps_us)
+{
+    if (!module_initialized || count == 0 || timestamps_us == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&drdy_lock);
+    uint32_t edges = drdy_count;
+    int64_t edge_time = drdy_time_us;
+    portEXIT_CRITICAL(&drdy_lock);
+
+    uint64_t first_index = stats.samples_total;
+
+    // Locate the sample that produced the latest data-ready edge within this batch
+    bool anchored = false;
+    uint32_t anchor_pos = 0;
+    if (edges > 0 && edge_time <= read_time_us) {
+        int64_t anchor_index = (int64_t)edges - 1 + edge_sample_offset;
+        int64_t pos = anchor_index - (int64_t)first_index;
+        if (pos >= 0 && pos < (int64_t)count) {
+            anchored = true;
+            anchor_pos = (uint32_t)pos;
+        }
+    }
+
+    if (!timeline_valid) {
+        if (anchored) {
+            restart_timeline(anchor_pos, (double)edge_time);
+        } else {
+            // No usable edge: newest sample is on average half a period old
+            restart_timeline(count - 1, (double)read_time_us - period_us * 0.5f);
+            if (edges > 0) {
+                // Realign edge numbering with the samples we actually received
+                edge_sample_offset = (int64_t)first_index + count - (int64_t)edges;
+            }
+        }
+    } else {
+        samples_since_anchor += count;
+
+        // Measure phase error against the best reference available
+        float error_us = 0.0f;
+        bool have_reference = false;
+        if (anchored) {
+            double predicted = next_sample_us + (double)anchor_pos * period_us;
+            error_us = (float)((double)edge_time - predicted);
+            have_reference = true;
+            record_error(error_us);
+        } else {
+            // Without an edge, only correct predictions that are physically impossible
+            double predicted_newest = next_sample_us + (double)(count - 1) * period_us;
+            if (predicted_newest > (double)read_time_us) {
+                error_us = (float)((double)read_time_us - predicted_newest);
+                have_reference = true;
+            } else if (predicted_newest < (double)read_time_us - period_us) {
+                error_us = (float)((double)read_time_us - period_us - predicted_newest);
+                have_reference = true;
+            }
+        }
+
+        if (have_reference && fabsf(error_us) > 4.0f * period_us) {
+            // Samples were lost or the FIFO restarted behind our back
+            ESP_LOGW(TAG, "Timeline error %.0f us, resynchronizing", error_us);
+            stats.resyncs++;
+            if (anchored) {
+                restart_timeline(anchor_pos, (double)edge_time);
+            } else {
+                restart_timeline(count - 1, (double)read_time_us - period_us * 0.5f);
+                edge_sample_offset = (int64_t)first_index + count - (int64_t)edges;
+            }
+        } else if (have_reference) {
+            next_sample_us += PHASE_CORRECTION_GAIN * error_us;
+
+            // Spread the residual over the samples since the last reference
+            if (samples_since_anchor > 0) {
+                period_us += PERIOD_CORRECTION_GAIN * error_us / (float)samples_since_anchor;
+                float min_period = nominal_period_us * (1.0f - PERIOD_MAX_DEVIATION);
+                float max_period = nominal_period_us * (1.0f + PERIOD_MAX_DEVIATION);
+                if (period_us < min_period) period_us = min_period;
+                if (period_us > max_period) period_us = max_period;
+            }
+            samples_since_anchor = 0;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        int64_t ts = (int64_t)(next_sample_us + (double)i * period_us);
+        if (ts <= last_assigned_us) {
+            ts = last_assigned_us + 1;   // Keep the timeline strictly monotonic
+        }
+        timestamps_us[i] = ts;
+        last_assigned_us = ts;
+    }
+    next_sample_us += (double)count * period_us;
+
+    stats.samples_total += count;
+    stats.batches_total++;
+    stats.estimated_period_us = period_us;
+    stats.drift_ppm = (int32_t)((period_us / nominal_period_us - 1.0f) * 1000000.0f);
+}
+
+esp_err_t imu_timestamp_get_stats(imu_timing_stats_t *out)
+{
+    if (!module_initialized || out == NULL) {
+        return ESP_FAIL;
+    }
+
+    memcpy(out, &stats, sizeof(imu_timing_stats_t));
+    return ESP_OK;
+}
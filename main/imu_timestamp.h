@@ -0,0 +1,84 @@
+#ifndef IMU_TIMESTAMP_H
+#define IMU_TIMESTAMP_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file imu_timestamp.h
+ * @brief Per-sample timeline reconstruction for batched IMU FIFO reads
+ *
+ * The MPU6050 FIFO is drained in batches, so the host only knows when a
+ * batch was read. This layer assigns every sample a timestamp on the
+ * esp_timer monotonic base (microseconds since boot) using:
+ * - the time of the most recent data-ready interrupt as a phase anchor
+ * - the number of samples in the FIFO and the configured output rate
+ * - a tracked estimate of the MPU's internal sample clock (drift correction)
+ */
+
+/**
+ * @brief Timing statistics of the reconstructed timeline
+ */
+typedef struct {
+    uint32_t samples_total;         // Samples timestamped since init
+    uint32_t batches_total;         // FIFO batches processed
+    uint32_t anchored_batches;      // Batches corrected against a data-ready edge
+    uint32_t resyncs;               // Timeline restarts (FIFO reset/overflow, lost anchor)
+    uint32_t nominal_period_us;     // Period from the configured sample rate
+    float estimated_period_us;      // Period tracked from the MPU's clock
+    int32_t drift_ppm;              // MPU clock vs host clock (+ = MPU slower)
+    uint32_t mean_abs_error_us;     // Mean |predicted - anchor| over anchored batches
+    uint32_t max_abs_error_us;      // Worst |predicted - anchor| seen
+    uint32_t last_abs_error_us;     // |predicted - anchor| of the latest anchored batch
+} imu_timing_stats_t;
+
+/**
+ * @brief Initialize the timestamping layer
+ *
+ * @param sample_rate_hz Configured IMU output data rate
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on a zero rate
+ */
+esp_err_t imu_timestamp_init(uint32_t sample_rate_hz);
+
+/**
+ * @brief Record a data-ready edge (call from the INT GPIO ISR)
+ */
+void imu_timestamp_on_data_ready_isr(void);
+
+/**
+ * @brief Restart the timeline after the FIFO has been reset or has overflowed
+ *
+ * The next batch re-anchors the timeline instead of continuing it.
+ */
+void imu_timestamp_resync(void);
+
+/**
+ * @brief Assign timestamps to one batch of FIFO samples
+ *
+ * Call this with the host time taken immediately before the FIFO count was
+ * read. Samples are ordered oldest first, as they come out of the FIFO.
+ *
+ * @param read_time_us esp_timer time sampled right before reading FIFO count
+ * @param count Number of samples in the batch
+ * @param timestamps_us Output array with room for @p count timestamps
+ */
+void imu_timestamp_assign_batch(int64_t read_time_us, uint32_t count, int64_t *timestamps_us);
+
+/**
+ * @brief Get timing error statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if not initialized or stats is NULL
+ */
+esp_err_t imu_timestamp_get_stats(imu_timing_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMU_TIMESTAMP_H
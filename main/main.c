@@ -2,13 +2,57 @@
 #include <esp_system.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <nvs_flash.h>
+#include <string.h>
 #include "display_module.h"
 #include "time_module.h"
 #include "pir_module.h"
 #include "mpu6050_module.h"
+#include "presence_module.h"
+#include "arrival_predictor.h"
+#include "coproc_module.h"
+#include "camera_preview.h"
+#include "sound_fx.h"
+#include "wifi_module.h"
+#include "net_client.h"
+#include "conn_manager.h"
+#include "telemetry.h"
+#include "wifi_power.h"
+#include "energy_module.h"
+#include "render_watchdog.h"
+#include "sleep_module.h"
+#include "resume_state.h"
+#include "i2c_bus.h"
+#include "refresh_policy.h"
+#include "hot_profile.h"
+#include "ui_strings.h"
+#include "ring_buffer.h"
+#include "project_config.h"
 
 static const char *TAG = "SmartAssistant";
 
+// Set by the arrival pre-warm hook, consumed by the main screen loop
+static volatile bool screen_refresh_requested = false;
+
+static esp_err_t prewarm_main_screen(void *user_ctx)
+{
+    screen_refresh_requested = true;
+    return ESP_OK;
+}
+
+static esp_err_t init_nvs(void)
+{
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition needs to be erased, stored settings are lost");
+        ret = nvs_flash_erase();
+        if (ret == ESP_OK) {
+            ret = nvs_flash_init();
+        }
+    }
+    return ret;
+}
+
 static esp_err_t run_boot_sequence(void)
 {
     ESP_LOGI(TAG, "Starting boot sequence...");
@@ -19,7 +63,10 @@ static esp_err_t run_boot_sequence(void)
         return ret;
     }
     
-    display_update_boot_status("Display initialized...", 10);
+    display_update_boot_status(ui_string(UI_STR_BOOT_DISPLAY), 10);
+    if (energy_module_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Energy module initialization failed, continuing without energy estimates");
+    }
     vTaskDelay(pdMS_TO_TICKS(500));
     
     for (int i = 0; i < 5; i++) {
@@ -27,19 +74,23 @@ static esp_err_t run_boot_sequence(void)
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    display_update_boot_status("Checking hardware...", 30);
+    display_update_boot_status(ui_string(UI_STR_BOOT_HARDWARE), 30);
     for (int i = 0; i < 15; i++) {
         display_task_handler();
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    display_update_boot_status("Loading configuration...", 50);
+    display_update_boot_status(ui_string(UI_STR_BOOT_CONFIG), 50);
+    esp_err_t nvs_ret = init_nvs();
+    if (nvs_ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS initialization failed (%s), settings will not persist", esp_err_to_name(nvs_ret));
+    }
     for (int i = 0; i < 10; i++) {
         display_task_handler();
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    display_update_boot_status("Initializing time module...", 60);
+    display_update_boot_status(ui_string(UI_STR_BOOT_TIME), 60);
     esp_err_t time_ret = time_module_init();
     if (time_ret != ESP_OK) {
         ESP_LOGW(TAG, "Time module initialization failed, continuing without RTC");
@@ -49,7 +100,7 @@ static esp_err_t run_boot_sequence(void)
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    display_update_boot_status("Initializing PIR sensor...", 65);
+    display_update_boot_status(ui_string(UI_STR_BOOT_PIR), 65);
     esp_err_t pir_ret = pir_module_init();
     if (pir_ret != ESP_OK) {
         ESP_LOGW(TAG, "PIR module initialization failed, continuing without PIR sensor");
@@ -59,7 +110,7 @@ static esp_err_t run_boot_sequence(void)
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    display_update_boot_status("Initializing motion sensor...", 67);
+    display_update_boot_status(ui_string(UI_STR_BOOT_MOTION), 67);
     esp_err_t mpu_ret = mpu6050_module_init();
     if (mpu_ret != ESP_OK) {
         ESP_LOGW(TAG, "MPU6050 module initialization failed, continuing without motion sensor");
@@ -69,25 +120,75 @@ static esp_err_t run_boot_sequence(void)
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    display_update_boot_status("Connecting to WiFi...", 70);
-    for (int i = 0; i < 20; i++) {
+    display_update_boot_status(ui_string(UI_STR_BOOT_PRESENCE), 68);
+    esp_err_t presence_ret = presence_module_init();
+    if (presence_ret != ESP_OK) {
+        ESP_LOGW(TAG, "Presence module initialization failed, continuing without presence tracking");
+    } else {
+        if (refresh_policy_init() != ESP_OK) {
+            ESP_LOGW(TAG, "Refresh policy initialization failed, keeping live refresh");
+        }
+        if (arrival_predictor_init() == ESP_OK) {
+            arrival_predictor_register_prewarm("screens", prewarm_main_screen, 0.0f, NULL);
+        } else {
+            ESP_LOGW(TAG, "Arrival predictor initialization failed, continuing without pre-warming");
+        }
+    }
+    
+    display_update_boot_status(ui_string(UI_STR_BOOT_COPROC), 69);
+    esp_err_t coproc_ret = coproc_module_init();
+    if (coproc_ret != ESP_OK) {
+        ESP_LOGW(TAG, "Co-processor module initialization failed, continuing without action recognition");
+    } else {
+        if (camera_preview_init() != ESP_OK) {
+            ESP_LOGW(TAG, "Camera preview initialization failed");
+        }
+        if (sound_fx_init() != ESP_OK) {
+            ESP_LOGW(TAG, "Sound effects initialization failed");
+        }
+        if (net_client_init() != ESP_OK) {
+            ESP_LOGW(TAG, "Net client initialization failed, requests go direct");
+        }
+    }
+    
+    if (presence_ret == ESP_OK && sleep_module_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Deep sleep supervision failed to start, staying awake when away");
+    }
+    
+    display_update_boot_status(ui_string(UI_STR_BOOT_WIFI), 70);
+    bool wifi_started = wifi_module_init() == ESP_OK;
+    if (wifi_started && conn_manager_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Connection manager initialization failed, no direct requests");
+    }
+#if CONFIG_TELEMETRY_ENABLE
+    if (wifi_started && telemetry_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Telemetry initialization failed, metrics stay local");
+    }
+#endif
+#if CONFIG_WIFI_POWER_ENABLE
+    if (wifi_started && wifi_power_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Wi-Fi power save initialization failed, keeping the driver default");
+    }
+#endif
+    for (int i = 0; i < CONFIG_WIFI_CONNECT_WAIT_MS / 100 && wifi_started && !wifi_is_connected(); i++) {
         display_task_handler();
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    display_update_boot_status("Starting services...", 90);
+    display_update_boot_status(ui_string(UI_STR_BOOT_SERVICES), 90);
     for (int i = 0; i < 10; i++) {
         display_task_handler();
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
-    display_update_boot_status("System ready!", 100);
+    display_update_boot_status(ui_string(UI_STR_BOOT_READY), 100);
     for (int i = 0; i < 10; i++) {
         display_task_handler();
         vTaskDelay(pdMS_TO_TICKS(100));
     }
     
     display_complete_boot_animation();
+    sleep_mark_main_screen_ready();
     
     // Start time display updates
     esp_err_t time_update_ret = time_module_start_display_updates();
@@ -100,31 +201,276 @@ static esp_err_t run_boot_sequence(void)
     return ESP_OK;
 }
 
+static esp_err_t run_resume_sequence(const resume_snapshot_t *snapshot)
+{
+    ESP_LOGI(TAG, "Resuming from deep sleep (%s)...", sleep_wake_reason_to_string(sleep_get_wake_reason()));
+    
+    // Panel first: the clock comes from RTC memory, no sensor is needed to draw it
+    esp_err_t ret = display_init_for_resume();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize display system: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    time_info_t now;
+    if (resume_state_estimate_time(&now) == ESP_OK) {
+        display_update_time(now.hour, now.minute, now.second);
+        display_update_date(now.year, now.month, now.day);
+    }
+    if (snapshot->weather[0] != '\0') {
+        display_update_weather(snapshot->weather);
+    }
+    if (display_render_now(CONFIG_RESUME_RENDER_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "First frame not flushed in time");
+    }
+    display_set_brightness(snapshot->brightness > 0 ? snapshot->brightness : CONFIG_RESUME_BRIGHTNESS_DEFAULT);
+    resume_state_mark_clock_visible();
+    sleep_mark_main_screen_ready();
+    
+    // The rest starts behind the visible clock
+    if (energy_module_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Energy module initialization failed, continuing without energy estimates");
+    }
+    
+    esp_err_t nvs_ret = init_nvs();
+    if (nvs_ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS initialization failed (%s), settings will not persist", esp_err_to_name(nvs_ret));
+    }
+    
+    if (time_module_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Time module initialization failed, continuing without RTC");
+    }
+    
+    // Connects in the background while the sensors come up; pooled TLS sessions survived in RTC memory
+    bool wifi_started = wifi_module_init() == ESP_OK;
+    if (wifi_started && conn_manager_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Connection manager initialization failed, no direct requests");
+    }
+    
+    if (pir_module_init() != ESP_OK) {
+        ESP_LOGW(TAG, "PIR module initialization failed, continuing without PIR sensor");
+    }
+    
+    if (mpu6050_module_init() != ESP_OK) {
+        ESP_LOGW(TAG, "MPU6050 module initialization failed, continuing without motion sensor");
+    }
+    
+    // Continue in the saved state so an arrival is seen as a transition out of AWAY
+    presence_restore(snapshot->presence_state, snapshot->activity_count);
+    esp_err_t presence_ret = presence_module_init();
+    if (presence_ret != ESP_OK) {
+        ESP_LOGW(TAG, "Presence module initialization failed, continuing without presence tracking");
+    } else {
+        if (refresh_policy_init() != ESP_OK) {
+            ESP_LOGW(TAG, "Refresh policy initialization failed, keeping live refresh");
+        }
+        if (arrival_predictor_init() == ESP_OK) {
+            arrival_predictor_register_prewarm("screens", prewarm_main_screen, 0.0f, NULL);
+        } else {
+            ESP_LOGW(TAG, "Arrival predictor initialization failed, continuing without pre-warming");
+        }
+    }
+#if CONFIG_TELEMETRY_ENABLE
+    if (wifi_started && telemetry_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Telemetry initialization failed, metrics stay local");
+    }
+#endif
+#if CONFIG_WIFI_POWER_ENABLE
+    if (wifi_started && wifi_power_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Wi-Fi power save initialization failed, keeping the driver default");
+    }
+#endif
+    
+    if (coproc_module_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Co-processor module initialization failed, continuing without action recognition");
+    } else {
+        if (camera_preview_init() != ESP_OK) {
+            ESP_LOGW(TAG, "Camera preview initialization failed");
+        }
+        if (sound_fx_init() != ESP_OK) {
+            ESP_LOGW(TAG, "Sound effects initialization failed");
+        }
+        if (net_client_init() != ESP_OK) {
+            ESP_LOGW(TAG, "Net client initialization failed, requests go direct");
+        }
+    }
+    
+    if (presence_ret == ESP_OK) {
+        if (sleep_get_wake_reason() == SLEEP_WAKE_ARRIVAL) {
+            presence_notify_activity();
+        }
+        if (sleep_module_start() != ESP_OK) {
+            ESP_LOGW(TAG, "Deep sleep supervision failed to start, staying awake when away");
+        }
+    }
+    
+    if (time_module_start_display_updates() != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to start time display updates");
+    }
+    
+    ESP_LOGI(TAG, "Resume completed");
+    
+    return ESP_OK;
+}
+
 static void run_main_screen(void)
 {
     ESP_LOGI(TAG, "Starting main screen...");
     
+#if CONFIG_DRAW_ACCEL_BENCHMARK
+    if (display_run_draw_benchmark() != ESP_OK) {
+        ESP_LOGW(TAG, "Draw benchmark failed");
+    }
+    
+#endif
+#if CONFIG_DISPLAY_SCROLL_BENCHMARK
+    if (display_run_scroll_benchmark() != ESP_OK) {
+        ESP_LOGW(TAG, "Scroll benchmark failed");
+    }
+    
+#endif
+#if CONFIG_STATUS_BAR_BENCHMARK
+    if (display_run_status_bar_benchmark() != ESP_OK) {
+        ESP_LOGW(TAG, "Status bar benchmark failed");
+    }
+    
+#endif
+#if CONFIG_RING_BENCHMARK
+    if (ring_buffer_run_benchmark() != ESP_OK) {
+        ESP_LOGW(TAG, "Ring buffer benchmark failed");
+    }
+    
+#endif
+#if CONFIG_NET_BENCHMARK
+    if (net_client_run_benchmark() != ESP_OK) {
+        ESP_LOGW(TAG, "Net benchmark failed");
+    }
+    
+#endif
+    if (display_start_render_watchdog() != ESP_OK) {
+        ESP_LOGW(TAG, "Render watchdog failed to start, render stalls will not be detected");
+    }
+    
+#if CONFIG_HOT_PROFILE_ENABLE
+    if (hot_profile_start(CONFIG_HOT_PROFILE_DURATION_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "Hot code profile failed to start");
+    }
+#endif
+    
     uint32_t sensor_update_counter = 0;
+    bool diagnostics_visible = false;
+    bool shake_was_detected = false;
     
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(10));
         display_task_handler();
         
-        // Update sensor status every 500ms (50 * 10ms)
+        // The time job only publishes the clock, drawing it takes the UI lock
+        time_display_update_t clock_update;
+        if (time_module_take_display_update(&clock_update)) {
+            display_set_clock_seconds(clock_update.show_seconds);
+            if (clock_update.time_valid) {
+                display_update_time(clock_update.time.hour, clock_update.time.minute, clock_update.time.second);
+                if (clock_update.update_date) {
+                    display_update_date(clock_update.time.year, clock_update.time.month, clock_update.time.day);
+                }
+            }
+        }
+        
+        // Shake cycles main -> diagnostics -> camera preview -> main
+        bool shake_detected = mpu6050_is_shake_detected();
+        if (shake_detected && !shake_was_detected) {
+            if (camera_preview_is_running()) {
+                camera_preview_stop();
+            } else if (diagnostics_visible) {
+                diagnostics_visible = false;
+                if (camera_preview_start() != ESP_OK) {
+                    display_show_diagnostics(false);
+                }
+            } else {
+                diagnostics_visible = true;
+                display_show_diagnostics(true);
+            }
+            screen_refresh_requested = true;
+        }
+        shake_was_detected = shake_detected;
+        
+        // Update sensor status every 500ms (50 * 10ms), or right away when pre-warmed
+        // or when the refresh policy returns to live
         sensor_update_counter++;
-        if (sensor_update_counter >= 50) {
+        bool refresh_now = screen_refresh_requested || refresh_policy_take_refresh();
+        if (sensor_update_counter >= 50 || refresh_now) {
+            screen_refresh_requested = false;
             sensor_update_counter = 0;
             
-            // Update PIR status
-            char pir_status_str[32];
-            if (pir_get_status_string(pir_status_str, sizeof(pir_status_str)) == ESP_OK) {
-                display_update_pir_status(pir_status_str);
+            // Status fields stay frozen while nobody is there to read them
+            if (refresh_policy_status_live() || refresh_now) {
+                // Update PIR status
+                char pir_status_str[32];
+                if (pir_get_status_string(pir_status_str, sizeof(pir_status_str)) == ESP_OK) {
+                    display_update_pir_status(pir_status_str);
+                }
+                
+                // Update Motion status
+                char motion_status_str[32];
+                if (mpu6050_get_status_string(motion_status_str, sizeof(motion_status_str)) == ESP_OK) {
+                    display_update_motion_status(motion_status_str);
+                }
+                
+                // Update Action recognition status
+                char action_status_str[32];
+                if (coproc_get_status_string(action_status_str, sizeof(action_status_str)) == ESP_OK) {
+                    display_update_action_status(action_status_str);
+                }
+                
+                // Update Wi-Fi status
+                char wifi_status_str[16];
+                if (wifi_get_status_string(wifi_status_str, sizeof(wifi_status_str)) == ESP_OK) {
+                    display_update_wifi_status(wifi_status_str);
+                }
+            }
+            
+            // Update diagnostics while visible
+            if (diagnostics_visible) {
+                static char diagnostics_str[640];
+                if (energy_get_summary_string(diagnostics_str, sizeof(diagnostics_str)) == ESP_OK) {
+                    size_t len = strlen(diagnostics_str);
+                    render_watchdog_get_status_string(diagnostics_str + len, sizeof(diagnostics_str) - len);
+                    len = strlen(diagnostics_str);
+                    if (len + 1 < sizeof(diagnostics_str)) {
+                        diagnostics_str[len++] = '\n';
+                        sleep_get_status_string(diagnostics_str + len, sizeof(diagnostics_str) - len);
+                    }
+                    len = strlen(diagnostics_str);
+                    if (len + 1 < sizeof(diagnostics_str)) {
+                        diagnostics_str[len++] = '\n';
+                        i2c_bus_get_status_string(diagnostics_str + len, sizeof(diagnostics_str) - len);
+                    }
+                    len = strlen(diagnostics_str);
+                    if (len + 1 < sizeof(diagnostics_str)) {
+                        diagnostics_str[len++] = '\n';
+                        refresh_policy_get_status_string(diagnostics_str + len, sizeof(diagnostics_str) - len);
+                    }
+                    len = strlen(diagnostics_str);
+                    if (len + 1 < sizeof(diagnostics_str)) {
+                        diagnostics_str[len++] = '\n';
+                        net_client_get_status_string(diagnostics_str + len, sizeof(diagnostics_str) - len);
+                    }
+                    len = strlen(diagnostics_str);
+                    if (len + 1 < sizeof(diagnostics_str)) {
+                        diagnostics_str[len++] = '\n';
+                        wifi_power_get_status_string(diagnostics_str + len, sizeof(diagnostics_str) - len);
+                    }
+                    display_update_diagnostics(diagnostics_str);
+                }
             }
             
-            // Update Motion status
-            char motion_status_str[32];
-            if (mpu6050_get_status_string(motion_status_str, sizeof(motion_status_str)) == ESP_OK) {
-                display_update_motion_status(motion_status_str);
+            // Update preview statistics while streaming
+            if (camera_preview_is_running()) {
+                char preview_str[96];
+                if (camera_preview_get_status_string(preview_str, sizeof(preview_str)) == ESP_OK) {
+                    display_update_preview_stats(preview_str);
+                }
             }
         }
     }
@@ -134,7 +480,14 @@ void app_main(void)
 {
     ESP_LOGI(TAG, "Smart Assistant starting...");
     
-    if (run_boot_sequence() != ESP_OK) {
+    // Wakeup cause first: it decides between the full boot and the fast resume
+    if (sleep_module_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Sleep module initialization failed");
+    }
+    
+    const resume_snapshot_t *snapshot = resume_state_get();
+    esp_err_t ret = (snapshot != NULL) ? run_resume_sequence(snapshot) : run_boot_sequence();
+    if (ret != ESP_OK) {
         ESP_LOGE(TAG, "System initialization failed, restarting in 5 seconds...");
         vTaskDelay(pdMS_TO_TICKS(5000));
         esp_restart();
@@ -1,7 +1,9 @@
 #include "mpu6050_module.h"
+#include "imu_timestamp.h"
+#include "i2c_bus.h"
 #include "project_config.h"
-#include "mpu6050.h"
-#include <driver/i2c.h>
+#include "service_task.h"
+#include "ui_strings.h"
 #include <driver/gpio.h>
 #include <esp_log.h>
 #include <esp_timer.h>
@@ -14,11 +16,71 @@
 
 static const char *TAG = "MPU6050Module";
 
+// MPU6050 registers used for FIFO sampling
+#define MPU6050_REG_SMPLRT_DIV      0x19
+#define MPU6050_REG_CONFIG          0x1A
+#define MPU6050_REG_GYRO_CONFIG     0x1B
+#define MPU6050_REG_ACCEL_CONFIG    0x1C
+#define MPU6050_REG_MOT_THR         0x1F
+#define MPU6050_REG_MOT_DUR         0x20
+#define MPU6050_REG_FIFO_EN         0x23
+#define MPU6050_REG_INT_PIN_CFG     0x37
+#define MPU6050_REG_INT_ENABLE      0x38
+#define MPU6050_REG_INT_STATUS      0x3A
+#define MPU6050_REG_USER_CTRL       0x6A
+#define MPU6050_REG_PWR_MGMT_1      0x6B
+#define MPU6050_REG_PWR_MGMT_2      0x6C
+#define MPU6050_REG_FIFO_COUNT_H    0x72
+#define MPU6050_REG_FIFO_R_W        0x74
+#define MPU6050_REG_WHO_AM_I        0x75
+
+#define MPU6050_DLPF_44HZ           0x03    // Gyro output rate 1kHz, accel bandwidth 44Hz
+#define MPU6050_PWR1_SLEEP          0x40
+#define MPU6050_ACCEL_FS_4G         0x08    // AFS_SEL = 1
+#define MPU6050_GYRO_FS_500DPS      0x08    // FS_SEL = 1
+#define MPU6050_ACCEL_LSB_PER_G_4G  8192.0f
+#define MPU6050_FIFO_EN_ACCEL       0x08
+#define MPU6050_INT_DATA_RDY        0x01
+#define MPU6050_INT_FIFO_OFLOW      0x10
+#define MPU6050_INT_MOT             0x40
+#define MPU6050_ACCEL_HPF_MASK      0x07
+#define MPU6050_ACCEL_HPF_5HZ       0x01    // Motion detection works on high-passed data
+#define MPU6050_MOT_THR_MG_PER_LSB  2
+#define MPU6050_STBY_GYRO_XYZ       0x07
+#define MPU6050_USER_CTRL_FIFO_EN   0x40
+#define MPU6050_USER_CTRL_FIFO_RST  0x04
+#define MPU6050_FIFO_SAMPLE_BYTES   6       // ACCEL_XOUT_H .. ACCEL_ZOUT_L
+#define MPU6050_FIFO_SIZE_BYTES     1024
+
+// Change-based gestures compare each sample against the one this many samples earlier
+#define GESTURE_HISTORY_LEN \
+    ((CONFIG_MPU6050_SAMPLE_RATE_HZ * CONFIG_MPU6050_GESTURE_WINDOW_MS) / 1000)
+
+/**
+ * @brief One timestamped accelerometer sample (g units)
+ */
+typedef struct {
+    float ax;
+    float ay;
+    float az;
+    int64_t timestamp_us;
+} accel_sample_t;
+
 // Module state
-static mpu6050_handle_t mpu6050_handle = NULL;
 static motion_status_t motion_status = {0};
-static TaskHandle_t motion_task_handle = NULL;
+static service_job_handle_t motion_job = NULL;
+static int64_t last_report_time = 0;
 static bool module_initialized = false;
+static float accel_sensitivity = MPU6050_ACCEL_LSB_PER_G_4G;
+static volatile bool device_ready = false;      // Configured and answering on I2C
+static bool drdy_isr_installed = false;
+static volatile bool sampling_parked = false;   // Set when the sensor is handed to the ULP
+static mpu6050_gesture_listener_t gesture_listener = NULL;
+static void *gesture_listener_ctx = NULL;
+
+// Gesture history (ring of the last GESTURE_HISTORY_LEN samples)
+static accel_sample_t gesture_history[GESTURE_HISTORY_LEN];
+static uint32_t gesture_history_count = 0;
 
 // STATE MACHINE VARIABLES - Clean separation of concerns
 static uint32_t last_shake_activity_time = 0;  // Last time shake activity detected
@@ -28,14 +90,6 @@ static uint32_t shake_start_time = 0;           // When continuous shake started
 static uint32_t shake_display_start = 0;        // When shake was confirmed (for display timer)
 static bool is_shaking = false;                 // STATE: Are we currently in shake mode?
 
-/**
- * @brief Get current time in milliseconds since boot
- */
-static uint32_t get_time_ms(void)
-{
-    return (uint32_t)(esp_timer_get_time() / 1000);
-}
-
 /**
  * @brief Get current time in seconds since boot
  */
@@ -58,28 +112,12 @@ static float calculate_magnitude(float x, float y, float z)
  * @brief Detect shake activity - FIXED for tilt resistance
  * STATE MACHINE: Detects CHANGES in acceleration, not absolute values
  */
-static bool detect_shake_activity(float ax, float ay, float az)
+static bool detect_shake_activity(const accel_sample_t *sample, const accel_sample_t *reference)
 {
-    static float prev_ax = 0, prev_ay = 0, prev_az = 0;
-    static bool first_run = true;
-    
-    if (first_run) {
-        prev_ax = ax;
-        prev_ay = ay; 
-        prev_az = az;
-        first_run = false;
-        return false;
-    }
-    
-    // Calculate CHANGE in acceleration (not absolute values)
-    float delta_x = fabsf(ax - prev_ax);
-    float delta_y = fabsf(ay - prev_ay);
-    float delta_z = fabsf(az - prev_az);
-    
-    // Update previous values
-    prev_ax = ax;
-    prev_ay = ay;
-    prev_az = az;
+    // Calculate CHANGE in acceleration over the gesture window (not absolute values)
+    float delta_x = fabsf(sample->ax - reference->ax);
+    float delta_y = fabsf(sample->ay - reference->ay);
+    float delta_z = fabsf(sample->az - reference->az);
     
     // Detect shake based on acceleration CHANGES
     float total_change = sqrtf(delta_x * delta_x + delta_y * delta_y + delta_z * delta_z);
@@ -91,26 +129,17 @@ static bool detect_shake_activity(float ax, float ay, float az)
  * @brief Detect tap gesture - FIXED for tilt resistance  
  * STATE MACHINE: Detects sudden Z-axis CHANGES, not absolute values
  */
-static bool detect_tap(float ax, float ay, float az)
+static bool detect_tap(const accel_sample_t *sample, const accel_sample_t *reference)
 {
-    static float prev_tap_z = 1.0f;
-    static bool tap_first_run = true;
-    uint32_t current_time = get_time_ms();
+    uint32_t current_time = (uint32_t)(sample->timestamp_us / 1000);
     
     // Don't detect tap if currently shaking
     if (is_shaking) {
         return false;
     }
     
-    if (tap_first_run) {
-        prev_tap_z = az;
-        tap_first_run = false;
-        return false;
-    }
-    
     // Detect CHANGE in Z-axis (not absolute value vs baseline)
-    float z_change = fabsf(az - prev_tap_z);
-    prev_tap_z = az;
+    float z_change = fabsf(sample->az - reference->az);
     
     // Very sensitive Z-axis change detection
     if (z_change > CONFIG_MPU6050_TAP_Z_THRESHOLD) {
@@ -123,173 +152,372 @@ static bool detect_tap(float ax, float ay, float az)
     return false;
 }
 
-
 /**
- * @brief Motion detection task
+ * @brief Run the gesture state machine on one timestamped sample
  */
-static void motion_detection_task(void *pvParameters)
+static void process_sample(const accel_sample_t *sample)
 {
-    ESP_LOGI(TAG, "Motion detection task started");
+    // Compare against the sample one gesture window earlier
+    uint32_t slot = gesture_history_count % GESTURE_HISTORY_LEN;
+    accel_sample_t reference = gesture_history[slot];
+    gesture_history[slot] = *sample;
+    gesture_history_count++;
+    if (gesture_history_count <= GESTURE_HISTORY_LEN) {
+        return;
+    }
+    
+    // Gesture timing runs on sample time, not on the time the batch was read
+    uint32_t current_time = (uint32_t)(sample->timestamp_us / 1000);
+    
+    // === STATE MACHINE IMPLEMENTATION ===
+    
+    // 1. Check for instantaneous activities
+    bool shake_activity = detect_shake_activity(sample, &reference);
+    bool tap_event = detect_tap(sample, &reference);
     
-    while (1) {
-        if (mpu6050_handle) {
-            mpu6050_acce_value_t accel_data;
-            esp_err_t ret = mpu6050_get_acce(mpu6050_handle, &accel_data);
+    // 2. SHAKE STATE MANAGEMENT
+    if (shake_activity) {
+        // Start shake timer if not already started
+        if (shake_start_time == 0) {
+            shake_start_time = current_time;
+        }
+        last_shake_activity_time = current_time;
+        
+        // Confirm SHAKE if continuous activity for required duration
+        if (!is_shaking && (current_time - shake_start_time >= CONFIG_MPU6050_SHAKE_MIN_DURATION_MS)) {
+            is_shaking = true;
+            motion_status.shake_detected = true;
+            motion_status.tap_detected = false; // Shake overrides tap
+            motion_status.last_motion_time = get_time_seconds();
+            shake_display_start = current_time; // Start display timer
+            ESP_LOGD(TAG, "Shake motion confirmed");
+            if (gesture_listener != NULL) {
+                gesture_listener(MPU6050_GESTURE_SHAKE, sample->timestamp_us, gesture_listener_ctx);
+            }
+        }
+    } else {
+        // No shake activity - check for timeout
+        if (shake_start_time > 0 && (current_time - last_shake_activity_time > CONFIG_MPU6050_SHAKE_TIMEOUT_MS)) {
+            // Reset shake detection state
+            shake_start_time = 0;
+            is_shaking = false;
+            ESP_LOGD(TAG, "Shake activity timeout");
             
-            if (ret == ESP_OK) {
-                uint32_t current_time = get_time_ms();
-                
-                // === STATE MACHINE IMPLEMENTATION ===
-                
-                // 1. Check for instantaneous activities
-                bool shake_activity = detect_shake_activity(accel_data.acce_x, accel_data.acce_y, accel_data.acce_z);
-                bool tap_event = detect_tap(accel_data.acce_x, accel_data.acce_y, accel_data.acce_z);
-                
-                // 2. SHAKE STATE MANAGEMENT
-                if (shake_activity) {
-                    // Start shake timer if not already started
-                    if (shake_start_time == 0) {
-                        shake_start_time = current_time;
-                    }
-                    last_shake_activity_time = current_time;
-                    
-                    // Confirm SHAKE if continuous activity for required duration
-                    if (!is_shaking && (current_time - shake_start_time >= CONFIG_MPU6050_SHAKE_MIN_DURATION_MS)) {
-                        is_shaking = true;
-                        motion_status.shake_detected = true;
-                        motion_status.tap_detected = false; // Shake overrides tap
-                        motion_status.last_motion_time = get_time_seconds();
-                        shake_display_start = current_time; // Start display timer
-                        ESP_LOGD(TAG, "Shake motion confirmed");
-                    }
-                } else {
-                    // No shake activity - check for timeout
-                    if (shake_start_time > 0 && (current_time - last_shake_activity_time > CONFIG_MPU6050_SHAKE_TIMEOUT_MS)) {
-                        // Reset shake detection state
-                        shake_start_time = 0;
-                        is_shaking = false;
-                        ESP_LOGD(TAG, "Shake activity timeout");
-                        
-                        // BUT keep displaying for minimum time if not elapsed
-                        if (shake_display_start > 0 && (current_time - shake_display_start < CONFIG_MPU6050_SHAKE_DISPLAY_MS)) {
-                            // Keep showing SHAKE until minimum display time
-                            motion_status.shake_detected = true;
-                        } else {
-                            // Clear display after minimum time
-                            motion_status.shake_detected = false;
-                            shake_display_start = 0;
-                        }
-                    }
-                }
-                
-                // 5. SHAKE DISPLAY TIMEOUT (minimum configured seconds)
-                if (motion_status.shake_detected && shake_display_start > 0 && !is_shaking) {
-                    if (current_time - shake_display_start >= CONFIG_MPU6050_SHAKE_DISPLAY_MS) {
-                        motion_status.shake_detected = false;
-                        shake_display_start = 0;
-                        ESP_LOGD(TAG, "Shake display timeout");
-                    }
-                }
-                
-                // 3. TAP EVENT HANDLING
-                if (tap_event) {
-                    motion_status.tap_detected = true;
-                    motion_status.last_motion_time = get_time_seconds();
-                    tap_display_start = current_time; // Start 0.8s display timer
-                    ESP_LOGD(TAG, "Tap motion detected");
-                }
-                
-                // 4. TAP DISPLAY TIMEOUT (configured duration)
-                if (motion_status.tap_detected && tap_display_start > 0) {
-                    if (current_time - tap_display_start >= CONFIG_MPU6050_TAP_DISPLAY_MS) {
-                        motion_status.tap_detected = false;
-                        tap_display_start = 0;
-                        ESP_LOGD(TAG, "Tap display timeout");
-                    }
-                }
+            // BUT keep displaying for minimum time if not elapsed
+            if (shake_display_start > 0 && (current_time - shake_display_start < CONFIG_MPU6050_SHAKE_DISPLAY_MS)) {
+                // Keep showing SHAKE until minimum display time
+                motion_status.shake_detected = true;
+            } else {
+                // Clear display after minimum time
+                motion_status.shake_detected = false;
+                shake_display_start = 0;
             }
         }
-        
-        // Check sensor at configured interval
-        vTaskDelay(pdMS_TO_TICKS(CONFIG_MPU6050_POLL_INTERVAL_MS));
+    }
+    
+    // 5. SHAKE DISPLAY TIMEOUT (minimum configured seconds)
+    if (motion_status.shake_detected && shake_display_start > 0 && !is_shaking) {
+        if (current_time - shake_display_start >= CONFIG_MPU6050_SHAKE_DISPLAY_MS) {
+            motion_status.shake_detected = false;
+            shake_display_start = 0;
+            ESP_LOGD(TAG, "Shake display timeout");
+        }
+    }
+    
+    // 3. TAP EVENT HANDLING
+    if (tap_event) {
+        motion_status.tap_detected = true;
+        motion_status.last_motion_time = get_time_seconds();
+        tap_display_start = current_time; // Start 0.8s display timer
+        ESP_LOGD(TAG, "Tap motion detected");
+        if (gesture_listener != NULL) {
+            gesture_listener(MPU6050_GESTURE_TAP, sample->timestamp_us, gesture_listener_ctx);
+        }
+    }
+    
+    // 4. TAP DISPLAY TIMEOUT (configured duration)
+    if (motion_status.tap_detected && tap_display_start > 0) {
+        if (current_time - tap_display_start >= CONFIG_MPU6050_TAP_DISPLAY_MS) {
+            motion_status.tap_detected = false;
+            tap_display_start = 0;
+            ESP_LOGD(TAG, "Tap display timeout");
+        }
     }
 }
 
-esp_err_t mpu6050_module_init(void)
+static esp_err_t mpu6050_write_reg(uint8_t reg, uint8_t value)
 {
-    ESP_LOGI(TAG, "Initializing MPU6050 module...");
+    return i2c_bus_write(I2C_DEVICE_MPU6050, reg, &value, 1);
+}
+
+static esp_err_t mpu6050_read_regs(uint8_t reg, uint8_t *data, size_t len)
+{
+    return i2c_bus_read(I2C_DEVICE_MPU6050, reg, data, len);
+}
+
+/**
+ * @brief Empty the FIFO and restart the sample timeline
+ */
+static esp_err_t mpu6050_fifo_reset(void)
+{
+    esp_err_t ret = mpu6050_write_reg(MPU6050_REG_USER_CTRL, MPU6050_USER_CTRL_FIFO_RST);
+    if (ret == ESP_OK) {
+        ret = mpu6050_write_reg(MPU6050_REG_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN);
+    }
+    imu_timestamp_resync();
+    gesture_history_count = 0;
+    return ret;
+}
+
+/**
+ * @brief Configure sample rate, accel-only FIFO and data-ready interrupt
+ */
+static esp_err_t mpu6050_fifo_configure(void)
+{
+    uint8_t divider = (uint8_t)(1000 / CONFIG_MPU6050_SAMPLE_RATE_HZ - 1);
     
-    if (module_initialized) {
-        ESP_LOGW(TAG, "MPU6050 module already initialized");
+    esp_err_t ret = mpu6050_write_reg(MPU6050_REG_CONFIG, MPU6050_DLPF_44HZ);
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_SMPLRT_DIV, divider);
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_FIFO_EN, MPU6050_FIFO_EN_ACCEL);
+    // INT pin: active high, push-pull, 50us pulse per sample
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_INT_PIN_CFG, 0x00);
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_INT_ENABLE, MPU6050_INT_DATA_RDY | MPU6050_INT_FIFO_OFLOW);
+    if (ret == ESP_OK) ret = mpu6050_fifo_reset();
+    
+    return ret;
+}
+
+/**
+ * @brief Wake the sensor, set the measurement ranges and start FIFO sampling
+ */
+static esp_err_t mpu6050_configure_device(void)
+{
+    uint8_t pwr_mgmt_1 = 0;
+    esp_err_t ret = mpu6050_read_regs(MPU6050_REG_PWR_MGMT_1, &pwr_mgmt_1, 1);
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_PWR_MGMT_1, pwr_mgmt_1 & ~MPU6050_PWR1_SLEEP);
+    // Motion wake may have left the gyros in standby
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_PWR_MGMT_2, 0x00);
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_ACCEL_CONFIG, MPU6050_ACCEL_FS_4G);
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_GYRO_CONFIG, MPU6050_GYRO_FS_500DPS);
+    if (ret == ESP_OK) ret = mpu6050_fifo_configure();
+    
+    device_ready = (ret == ESP_OK);
+    return ret;
+}
+
+/**
+ * @brief Re-configure the sensor when it answers again after going offline
+ */
+static esp_err_t mpu6050_on_online(void *user_ctx)
+{
+    esp_err_t ret = mpu6050_configure_device();
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "MPU6050 back online, sampling resumed");
+    }
+    return ret;
+}
+
+static void IRAM_ATTR mpu6050_drdy_isr(void *arg)
+{
+    imu_timestamp_on_data_ready_isr();
+}
+
+/**
+ * @brief Attach the data-ready interrupt used as the timeline phase anchor
+ */
+static esp_err_t mpu6050_drdy_interrupt_init(void)
+{
+    const gpio_num_t int_gpio = CONFIG_MPU6050_INT_GPIO;
+    if (int_gpio == GPIO_NUM_NC) {
+        ESP_LOGW(TAG, "MPU6050 INT not wired, sample timestamps use FIFO read time only");
         return ESP_OK;
     }
     
-    // Initialize dedicated I2C bus for MPU6050
-    ESP_LOGI(TAG, "Initializing dedicated I2C bus for MPU6050 on pins SDA:%d, SCL:%d", CONFIG_I2C1_SDA_GPIO, CONFIG_I2C1_SCL_GPIO);
-    
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = CONFIG_I2C1_SDA_GPIO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_io_num = CONFIG_I2C1_SCL_GPIO,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = CONFIG_I2C1_FREQ_HZ,
+    gpio_config_t int_config = {
+        .pin_bit_mask = (1ULL << int_gpio),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_POSEDGE
     };
     
-    esp_err_t ret = i2c_param_config(CONFIG_I2C1_PORT, &conf);
+    esp_err_t ret = gpio_config(&int_config);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure I2C for MPU6050: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    ret = i2c_driver_install(CONFIG_I2C1_PORT, conf.mode, 0, 0, 0);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to install I2C driver for MPU6050: %s", esp_err_to_name(ret));
+    // The ISR service may already be installed by another module
+    ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
         return ret;
     }
     
-    // Create MPU6050 device handle using the configurable I2C address
-    mpu6050_handle = mpu6050_create(CONFIG_I2C1_PORT, CONFIG_MPU6050_I2C_ADDR);
-    if (mpu6050_handle == NULL) {
-        ESP_LOGE(TAG, "Failed to create MPU6050 device handle");
-        return ESP_FAIL;
+    ret = gpio_isr_handler_add(int_gpio, mpu6050_drdy_isr, NULL);
+    if (ret == ESP_OK) {
+        drdy_isr_installed = true;
     }
+    return ret;
+}
+
+/**
+ * @brief Drain the FIFO and run gesture detection on every sample
+ */
+static void mpu6050_process_fifo(void)
+{
+    static uint8_t fifo_data[CONFIG_MPU6050_FIFO_MAX_BATCH * MPU6050_FIFO_SAMPLE_BYTES];
+    static int64_t timestamps[CONFIG_MPU6050_FIFO_MAX_BATCH];
     
-    // Wake up MPU6050
-    ret = mpu6050_wake_up(mpu6050_handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to wake up MPU6050: %s", esp_err_to_name(ret));
-        mpu6050_delete(mpu6050_handle);
-        mpu6050_handle = NULL;
+    uint8_t int_status = 0;
+    if (mpu6050_read_regs(MPU6050_REG_INT_STATUS, &int_status, 1) != ESP_OK) {
+        return;
+    }
+    if (int_status & MPU6050_INT_FIFO_OFLOW) {
+        ESP_LOGW(TAG, "FIFO overflow, resetting sample timeline");
+        mpu6050_fifo_reset();
+        return;
+    }
+    
+    // Host time must be taken before the count so no counted sample is newer than it
+    int64_t read_time = esp_timer_get_time();
+    uint8_t count_buf[2];
+    if (mpu6050_read_regs(MPU6050_REG_FIFO_COUNT_H, count_buf, sizeof(count_buf)) != ESP_OK) {
+        return;
+    }
+    
+    uint16_t fifo_bytes = ((uint16_t)count_buf[0] << 8) | count_buf[1];
+    if (fifo_bytes % MPU6050_FIFO_SAMPLE_BYTES != 0 || fifo_bytes >= MPU6050_FIFO_SIZE_BYTES) {
+        ESP_LOGW(TAG, "FIFO misaligned (%u bytes), resetting", fifo_bytes);
+        mpu6050_fifo_reset();
+        return;
+    }
+    
+    uint32_t samples = fifo_bytes / MPU6050_FIFO_SAMPLE_BYTES;
+    if (samples > CONFIG_MPU6050_FIFO_MAX_BATCH) {
+        // The remainder stays queued and is timestamped with the next batch
+        samples = CONFIG_MPU6050_FIFO_MAX_BATCH;
+    }
+    if (samples == 0) {
+        return;
+    }
+    
+    if (mpu6050_read_regs(MPU6050_REG_FIFO_R_W, fifo_data, samples * MPU6050_FIFO_SAMPLE_BYTES) != ESP_OK) {
+        // Partial reads leave the FIFO misaligned
+        mpu6050_fifo_reset();
+        return;
+    }
+    
+    imu_timestamp_assign_batch(read_time, samples, timestamps);
+    
+    for (uint32_t i = 0; i < samples; i++) {
+        const uint8_t *raw = &fifo_data[i * MPU6050_FIFO_SAMPLE_BYTES];
+        accel_sample_t sample = {
+            .ax = (int16_t)((raw[0] << 8) | raw[1]) / accel_sensitivity,
+            .ay = (int16_t)((raw[2] << 8) | raw[3]) / accel_sensitivity,
+            .az = (int16_t)((raw[4] << 8) | raw[5]) / accel_sensitivity,
+            .timestamp_us = timestamps[i]
+        };
+        process_sample(&sample);
+    }
+}
+
+/**
+ * @brief Motion detection job
+ */
+static uint32_t motion_detection_job(void *user_ctx)
+{
+    // An offline sensor is re-configured by the I2C layer through mpu6050_on_online()
+    if (device_ready && !i2c_bus_is_online(I2C_DEVICE_MPU6050)) {
+        device_ready = false;
+    }
+    if (device_ready && !sampling_parked) {
+        mpu6050_process_fifo();
+    }
+    
+    if (esp_timer_get_time() - last_report_time >= (int64_t)CONFIG_IMU_TIMING_REPORT_INTERVAL_MS * 1000) {
+        last_report_time = esp_timer_get_time();
+        imu_timing_stats_t stats;
+        if (imu_timestamp_get_stats(&stats) == ESP_OK) {
+            ESP_LOGI(TAG, "IMU timing: %lu samples, period %.1f us (%ld ppm), error mean %lu us max %lu us, %lu resyncs",
+                     (unsigned long)stats.samples_total, stats.estimated_period_us, (long)stats.drift_ppm,
+                     (unsigned long)stats.mean_abs_error_us, (unsigned long)stats.max_abs_error_us,
+                     (unsigned long)stats.resyncs);
+        }
+    }
+    
+    // Drain FIFO at configured interval
+    return CONFIG_MPU6050_POLL_INTERVAL_MS;
+}
+
+esp_err_t mpu6050_module_init(void)
+{
+    ESP_LOGI(TAG, "Initializing MPU6050 module...");
+    
+    if (module_initialized) {
+        ESP_LOGW(TAG, "MPU6050 module already initialized");
+        return ESP_OK;
+    }
+    
+    // Dedicated I2C bus for MPU6050
+    const i2c_device_config_t device_config = {
+        .name = "MPU",
+        .port = CONFIG_I2C1_PORT,
+        .sda_gpio = CONFIG_I2C1_SDA_GPIO,
+        .scl_gpio = CONFIG_I2C1_SCL_GPIO,
+        .freq_hz = CONFIG_I2C1_FREQ_HZ,
+        .addr = CONFIG_MPU6050_I2C_ADDR,
+        .probe_reg = MPU6050_REG_WHO_AM_I,
+        .on_online = mpu6050_on_online,
+        .user_ctx = NULL,
+    };
+    
+    esp_err_t ret = i2c_bus_add_device(I2C_DEVICE_MPU6050, &device_config);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_FOUND) {
+        ESP_LOGE(TAG, "Failed to set up I2C for MPU6050: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    // Configure accelerometer and gyroscope ranges
-    ret = mpu6050_config(mpu6050_handle, ACCE_FS_4G, GYRO_FS_500DPS);
+    // Batched FIFO sampling with per-sample timestamps; also after an aborted motion wake
+    sampling_parked = false;
+    imu_timestamp_init(CONFIG_MPU6050_SAMPLE_RATE_HZ);
+    if (ret == ESP_OK) {
+        ret = mpu6050_configure_device();
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to configure MPU6050: %s", esp_err_to_name(ret));
+            i2c_bus_report_failure(I2C_DEVICE_MPU6050);
+        }
+    }
+    if (!device_ready) {
+        // The I2C layer keeps probing; sampling starts once mpu6050_on_online() succeeds
+        ESP_LOGW(TAG, "MPU6050 not ready, continuing without motion until it answers");
+    }
+    
+    ret = mpu6050_drdy_interrupt_init();
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure MPU6050: %s", esp_err_to_name(ret));
-        mpu6050_delete(mpu6050_handle);
-        mpu6050_handle = NULL;
-        return ret;
+        ESP_LOGW(TAG, "Data-ready interrupt unavailable (%s), using FIFO read time only", esp_err_to_name(ret));
     }
     
     // Initialize motion status
     memset(&motion_status, 0, sizeof(motion_status_t));
     
-    // Create motion detection task
-    BaseType_t task_ret = xTaskCreate(
-        motion_detection_task,
-        "mpu6050_motion",
-        CONFIG_TASK_STACK_MPU6050,
-        NULL,
-        CONFIG_TASK_PRIORITY_MPU6050,
-        &motion_task_handle
-    );
-    
-    if (task_ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create motion detection task");
-        mpu6050_delete(mpu6050_handle);
-        mpu6050_handle = NULL;
+    // Drain the FIFO on the shared service task
+    last_report_time = esp_timer_get_time();
+    const service_job_config_t job_config = {
+        .name = "mpu6050_motion",
+        .run = motion_detection_job,
+        .user_ctx = NULL,
+        .first_delay_ms = 0,
+        .dedicated_stack = CONFIG_TASK_STACK_MPU6050,
+        .dedicated_priority = CONFIG_TASK_PRIORITY_MPU6050,
+    };
+    
+    if (service_job_add(&job_config, &motion_job) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add motion detection job");
+        if (drdy_isr_installed) {
+            gpio_isr_handler_remove(CONFIG_MPU6050_INT_GPIO);
+            drdy_isr_installed = false;
+        }
+        i2c_bus_remove_device(I2C_DEVICE_MPU6050);
+        device_ready = false;
         return ESP_FAIL;
     }
     
@@ -313,21 +541,21 @@ esp_err_t mpu6050_get_motion_status(motion_status_t *motion)
 esp_err_t mpu6050_get_status_string(char *buffer, size_t buffer_size)
 {
     if (!module_initialized || buffer == NULL || buffer_size < 32) {
-        snprintf(buffer, buffer_size, "MPU: Error");
+        snprintf(buffer, buffer_size, "%s", ui_string(UI_STR_MOTION_ERROR));
         return ESP_FAIL;
     }
     
-    if (!mpu6050_handle) {
-        snprintf(buffer, buffer_size, "MPU: Offline");
+    if (!device_ready) {
+        snprintf(buffer, buffer_size, "%s", ui_string(UI_STR_MOTION_OFFLINE));
         return ESP_OK;
     }
     
     if (motion_status.tap_detected) {
-        snprintf(buffer, buffer_size, "MPU: Tap");
+        snprintf(buffer, buffer_size, "%s", ui_string(UI_STR_MOTION_TAP));
     } else if (motion_status.shake_detected) {
-        snprintf(buffer, buffer_size, "MPU: Shake");
+        snprintf(buffer, buffer_size, "%s", ui_string(UI_STR_MOTION_SHAKE));
     } else {
-        snprintf(buffer, buffer_size, "MPU: Ready");
+        snprintf(buffer, buffer_size, "%s", ui_string(UI_STR_MOTION_READY));
     }
     
     return ESP_OK;
@@ -343,6 +571,50 @@ bool mpu6050_is_tap_detected(void)
     return module_initialized ? motion_status.tap_detected : false;
 }
 
+void mpu6050_set_gesture_listener(mpu6050_gesture_listener_t listener, void *user_ctx)
+{
+    gesture_listener_ctx = user_ctx;
+    gesture_listener = listener;
+}
+
+esp_err_t mpu6050_enable_motion_wake(uint16_t threshold_mg, uint8_t duration_ms)
+{
+    if (!module_initialized || !device_ready) {
+        return ESP_FAIL;
+    }
+    
+    // Park the motion job so it does not re-arm the FIFO, and let an in-flight drain finish
+    sampling_parked = true;
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_MPU6050_POLL_INTERVAL_MS * 2));
+    
+    // Stop the FIFO and data-ready traffic; only the motion status is polled while asleep
+    uint8_t accel_config = 0;
+    esp_err_t ret = mpu6050_write_reg(MPU6050_REG_USER_CTRL, 0x00);
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_FIFO_EN, 0x00);
+    if (ret == ESP_OK) ret = mpu6050_read_regs(MPU6050_REG_ACCEL_CONFIG, &accel_config, 1);
+    if (ret == ESP_OK) {
+        accel_config = (accel_config & ~MPU6050_ACCEL_HPF_MASK) | MPU6050_ACCEL_HPF_5HZ;
+        ret = mpu6050_write_reg(MPU6050_REG_ACCEL_CONFIG, accel_config);
+    }
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_MOT_THR, (uint8_t)(threshold_mg / MPU6050_MOT_THR_MG_PER_LSB));
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_MOT_DUR, duration_ms);
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_INT_ENABLE, MPU6050_INT_MOT);
+    if (ret == ESP_OK) ret = mpu6050_write_reg(MPU6050_REG_PWR_MGMT_2, MPU6050_STBY_GYRO_XYZ);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable motion wake: %s", esp_err_to_name(ret));
+        // Back to FIFO sampling; a sensor that does not answer is picked up by the I2C layer
+        if (mpu6050_configure_device() != ESP_OK) {
+            i2c_bus_report_failure(I2C_DEVICE_MPU6050);
+        }
+        sampling_parked = false;
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "Motion wake enabled (%u mg for %u ms)", threshold_mg, duration_ms);
+    return ESP_OK;
+}
+
 esp_err_t mpu6050_module_deinit(void)
 {
     ESP_LOGI(TAG, "Deinitializing MPU6050 module...");
@@ -352,20 +624,21 @@ esp_err_t mpu6050_module_deinit(void)
         return ESP_OK;
     }
     
-    // Delete motion detection task
-    if (motion_task_handle != NULL) {
-        vTaskDelete(motion_task_handle);
-        motion_task_handle = NULL;
+    // Remove motion detection job
+    if (motion_job != NULL) {
+        service_job_remove(motion_job);
+        motion_job = NULL;
     }
     
-    // Delete MPU6050 device
-    if (mpu6050_handle != NULL) {
-        mpu6050_delete(mpu6050_handle);
-        mpu6050_handle = NULL;
+    // Detach data-ready interrupt
+    if (drdy_isr_installed) {
+        gpio_isr_handler_remove(CONFIG_MPU6050_INT_GPIO);
+        drdy_isr_installed = false;
     }
     
-    // Delete dedicated I2C driver for MPU6050
-    i2c_driver_delete(CONFIG_I2C1_PORT);
+    // Release the dedicated bus (the driver goes with its last device)
+    i2c_bus_remove_device(I2C_DEVICE_MPU6050);
+    device_ready = false;
     
     module_initialized = false;
     ESP_LOGI(TAG, "MPU6050 module deinitialized");
@@ -18,13 +18,35 @@ typedef struct {
     uint32_t last_motion_time;  // Last motion detection time (seconds since boot)
 } motion_status_t;
 
+/**
+ * @brief Gestures reported to the gesture listener
+ */
+typedef enum {
+    MPU6050_GESTURE_TAP,        // Tap detected
+    MPU6050_GESTURE_SHAKE       // Shake confirmed (once per shake)
+} mpu6050_gesture_t;
+
+/**
+ * @brief Gesture callback
+ *
+ * Called from the motion job as soon as the gesture is recognized; keep it
+ * short and non-blocking.
+ *
+ * @param gesture Gesture just recognized
+ * @param timestamp_us esp_timer time of the sample that completed it
+ * @param user_ctx Context passed at registration
+ */
+typedef void (*mpu6050_gesture_listener_t)(mpu6050_gesture_t gesture, int64_t timestamp_us, void *user_ctx);
+
 /**
  * @brief Initialize MPU6050 sensor module
  * 
- * This function initializes the MPU6050 sensor using official espressif/mpu6050 driver
- * and sets up motion detection algorithms for shake and tap detection
+ * This function initializes the MPU6050 sensor through the I2C reliability layer
+ * and sets up motion detection algorithms for shake and tap detection. A sensor
+ * that does not answer is re-probed in the background and sampling starts
+ * when it does.
  * 
- * @return ESP_OK on success, ESP_FAIL on error
+ * @return ESP_OK on success (also with the sensor offline), ESP_FAIL on error
  */
 esp_err_t mpu6050_module_init(void);
 
@@ -59,8 +81,30 @@ bool mpu6050_is_shake_detected(void);
  */
 bool mpu6050_is_tap_detected(void);
 
+/**
+ * @brief Set the gesture listener
+ *
+ * For reactions that cannot wait for the next poll of the status flags.
+ *
+ * @param listener Callback (NULL to remove)
+ * @param user_ctx Context passed to the callback
+ */
+void mpu6050_set_gesture_listener(mpu6050_gesture_listener_t listener, void *user_ctx);
+
 // Tilt detection removed - not suitable for flat-mounted sensor
 
+/**
+ * @brief Switch the sensor to motion-interrupt mode for deep sleep
+ * 
+ * Disables FIFO sampling and enables the MPU6050 motion interrupt so that
+ * INT_STATUS reports motion to the ULP presence monitor.
+ * 
+ * @param threshold_mg Motion threshold in mg (2 mg resolution)
+ * @param duration_ms Time above threshold before motion is flagged
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t mpu6050_enable_motion_wake(uint16_t threshold_mg, uint8_t duration_ms);
+
 /**
  * @brief Deinitialize MPU6050 sensor module
  * 
@@ -0,0 +1,650 @@
+#include "net_client.h"
+#include "coproc_link.h"
+#include "coproc_module.h"
+#include "conn_manager.h"
+#include "telemetry.h"
+#include "wifi_module.h"
+#include "wifi_power.h"
+#include "project_config.h"
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/message_buffer.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "NetClient";
+
+#define ENTRY_MAX               (1 + COPROC_LINK_MAX_PAYLOAD)      // Message type + payload
+#define MSGBUF_ENTRY_SIZE       (ENTRY_MAX + sizeof(size_t))
+#define MSGBUF_SIZE             ((CONFIG_NET_OFFLOAD_WINDOW + 2) * MSGBUF_ENTRY_SIZE)
+#define BENCH_BASELINE_MS       1000
+
+/**
+ * @brief One open offloaded request
+ *
+ * The link RX task appends NET_ACCEPT, NET_RESPONSE and body chunk messages
+ * to rx; the requesting task reads them in order.
+ */
+typedef struct {
+    uint8_t id;                 // 0 when free
+    MessageBufferHandle_t rx;
+} offload_slot_t;
+
+/**
+ * @brief Cost measurement around one request
+ */
+typedef struct {
+    int64_t start_us;
+    uint32_t idle_start;
+    size_t free_before;
+    bool heap_monitored;
+} cost_probe_t;
+
+// Module state
+static bool module_initialized = false;
+static offload_slot_t slots[CONFIG_NET_MAX_OFFLOAD_REQUESTS];
+static SemaphoreHandle_t slots_lock = NULL;
+static uint8_t next_id = 1;
+static uint8_t rx_entry[ENTRY_MAX];             // Link RX task only
+
+// Statistics
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static net_client_stats_t stats = {0};
+static volatile bool heap_monitor_busy = false;
+
+static const char *route_name(net_route_t route)
+{
+    switch (route) {
+        case NET_ROUTE_OFFLOAD: return "offload";
+        case NET_ROUTE_DIRECT:  return "direct";
+        default:                return "auto";
+    }
+}
+
+/**
+ * @brief Idle time of all cores in run-time counter units (us)
+ */
+static uint32_t idle_time_us(void)
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    uint32_t total = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        total += ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+    }
+    return total;
+#else
+    return 0;
+#endif
+}
+
+static void probe_start(cost_probe_t *probe)
+{
+    // The local minimum is global, so only one request at a time is measured
+    bool monitor = false;
+    taskENTER_CRITICAL(&stats_lock);
+    if (!heap_monitor_busy) {
+        heap_monitor_busy = true;
+        monitor = true;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+
+    probe->heap_monitored = monitor && heap_caps_monitor_local_minimum_free_size_start() == ESP_OK;
+    if (monitor && !probe->heap_monitored) {
+        heap_monitor_busy = false;
+    }
+    probe->free_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    probe->idle_start = idle_time_us();
+    probe->start_us = esp_timer_get_time();
+}
+
+static void probe_stop(const cost_probe_t *probe, net_result_t *result)
+{
+    int64_t elapsed_us = esp_timer_get_time() - probe->start_us;
+    result->total_ms = (uint32_t)(elapsed_us / 1000);
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    uint32_t idle_us = idle_time_us() - probe->idle_start;
+    uint64_t capacity_us = (uint64_t)elapsed_us * portNUM_PROCESSORS;
+    result->cpu_us = capacity_us > idle_us ? (uint32_t)(capacity_us - idle_us) : 0;
+#endif
+
+    if (probe->heap_monitored) {
+        size_t minimum = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+        heap_caps_monitor_local_minimum_free_size_stop();
+        heap_monitor_busy = false;
+        result->heap_peak_bytes = probe->free_before > minimum ? (uint32_t)(probe->free_before - minimum) : 0;
+    }
+}
+
+static void record_result(const net_result_t *result, esp_err_t ret)
+{
+    taskENTER_CRITICAL(&stats_lock);
+    net_route_stats_t *route = &stats.route[result->route];
+    route->requests++;
+    if (ret != ESP_OK) {
+        route->failures++;
+    } else {
+        route->total_ms_sum += result->total_ms;
+        route->ttfb_ms_sum += result->ttfb_ms;
+        route->cpu_us_sum += result->cpu_us;
+        if (result->total_ms > route->max_total_ms) {
+            route->max_total_ms = result->total_ms;
+        }
+        if (result->heap_peak_bytes > route->max_heap_peak_bytes) {
+            route->max_heap_peak_bytes = result->heap_peak_bytes;
+        }
+    }
+    if (result->fell_back) {
+        stats.fallbacks++;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+static esp_err_t deliver(const net_request_t *request, net_result_t *result, int64_t start_us,
+                         const uint8_t *data, size_t len)
+{
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (result->body_bytes == 0) {
+        result->ttfb_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    }
+    result->body_bytes += len;
+    return request->on_data != NULL ? request->on_data(data, len, request->user_ctx) : ESP_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Offload over the co-processor link
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Proxy message handler, runs in the link RX task
+ */
+static void on_net_message(uint8_t type, const uint8_t *payload, size_t len, void *user_ctx)
+{
+    if (len == 0 || len > COPROC_LINK_MAX_PAYLOAD) {
+        return;
+    }
+
+    rx_entry[0] = type;
+    memcpy(&rx_entry[1], payload, len);
+
+    xSemaphoreTake(slots_lock, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_NET_MAX_OFFLOAD_REQUESTS; i++) {
+        if (slots[i].id != 0 && slots[i].id == payload[0]) {
+            // The credit window keeps the buffer from filling; a full one means a misbehaving proxy
+            if (xMessageBufferSend(slots[i].rx, rx_entry, len + 1, 0) == 0) {
+                taskENTER_CRITICAL(&stats_lock);
+                stats.offload_overflows++;
+                taskEXIT_CRITICAL(&stats_lock);
+            }
+            break;
+        }
+    }
+    xSemaphoreGive(slots_lock);
+}
+
+static offload_slot_t *slot_open(void)
+{
+    MessageBufferHandle_t rx = xMessageBufferCreate(MSGBUF_SIZE);
+    if (rx == NULL) {
+        return NULL;
+    }
+
+    offload_slot_t *slot = NULL;
+    xSemaphoreTake(slots_lock, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_NET_MAX_OFFLOAD_REQUESTS; i++) {
+        if (slots[i].id == 0) {
+            slot = &slots[i];
+            slot->id = next_id;
+            slot->rx = rx;
+            next_id = next_id == UINT8_MAX ? 1 : next_id + 1;
+            break;
+        }
+    }
+    xSemaphoreGive(slots_lock);
+
+    if (slot == NULL) {
+        vMessageBufferDelete(rx);
+    }
+    return slot;
+}
+
+static void slot_close(offload_slot_t *slot)
+{
+    xSemaphoreTake(slots_lock, portMAX_DELAY);
+    MessageBufferHandle_t rx = slot->rx;
+    slot->id = 0;
+    slot->rx = NULL;
+    xSemaphoreGive(slots_lock);
+
+    vMessageBufferDelete(rx);
+}
+
+static esp_err_t offload_send_request(const offload_slot_t *slot, const net_request_t *request,
+                                      uint32_t timeout_ms, uint8_t *scratch)
+{
+    const char *content_type = request->content_type != NULL ? request->content_type : "";
+    size_t url_len = strlen(request->url) + 1;
+    size_t type_len = strlen(content_type) + 1;
+    if (sizeof(coproc_net_request_t) + url_len + type_len > COPROC_LINK_MAX_PAYLOAD) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const coproc_net_request_t header = {
+        .id = slot->id,
+        .method = request->method == NET_METHOD_POST ? COPROC_NET_METHOD_POST : COPROC_NET_METHOD_GET,
+        .window = CONFIG_NET_OFFLOAD_WINDOW,
+        .flags = 0,
+        .body_len = (uint32_t)request->body_len,
+        .timeout_ms = timeout_ms,
+    };
+    memcpy(scratch, &header, sizeof(header));
+    memcpy(scratch + sizeof(header), request->url, url_len);
+    memcpy(scratch + sizeof(header) + url_len, content_type, type_len);
+
+    esp_err_t ret = coproc_link_send(COPROC_MSG_NET_REQUEST, scratch, sizeof(header) + url_len + type_len);
+
+    const uint8_t *body = request->body;
+    size_t sent = 0;
+    while (ret == ESP_OK && sent < request->body_len) {
+        size_t n = request->body_len - sent;
+        if (n > COPROC_NET_CHUNK_MAX) {
+            n = COPROC_NET_CHUNK_MAX;
+        }
+        const coproc_net_chunk_t chunk = {
+            .id = slot->id,
+            .flags = sent + n == request->body_len ? COPROC_NET_CHUNK_LAST : 0,
+        };
+        memcpy(scratch, &chunk, sizeof(chunk));
+        memcpy(scratch + sizeof(chunk), body + sent, n);
+        ret = coproc_link_send(COPROC_MSG_NET_REQUEST_BODY, scratch, sizeof(chunk) + n);
+        sent += n;
+    }
+    return ret;
+}
+
+/**
+ * @brief Run one request through the proxy
+ *
+ * @param accepted Set once the proxy has accepted; failures before that may fall back
+ */
+static esp_err_t perform_offload(const net_request_t *request, uint32_t timeout_ms, net_result_t *result,
+                                 int64_t start_us, bool *accepted)
+{
+    *accepted = false;
+
+    uint8_t *entry = heap_caps_malloc(ENTRY_MAX, MALLOC_CAP_INTERNAL);
+    offload_slot_t *slot = entry != NULL ? slot_open() : NULL;
+    if (slot == NULL) {
+        heap_caps_free(entry);
+        return ESP_ERR_NO_MEM;
+    }
+    const uint8_t id = slot->id;
+
+    esp_err_t ret = offload_send_request(slot, request, timeout_ms, entry);
+    bool done = false;
+    TickType_t wait = pdMS_TO_TICKS(CONFIG_NET_OFFLOAD_ACCEPT_TIMEOUT_MS);
+
+    while (ret == ESP_OK && !done) {
+        size_t len = xMessageBufferReceive(slot->rx, entry, ENTRY_MAX, wait);
+        if (len == 0) {
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+        const uint8_t *payload = entry + 1;
+        size_t payload_len = len - 1;
+
+        switch (entry[0]) {
+            case COPROC_MSG_NET_ACCEPT: {
+                coproc_net_accept_t accept;
+                if (payload_len < sizeof(accept)) {
+                    ret = ESP_FAIL;
+                    break;
+                }
+                memcpy(&accept, payload, sizeof(accept));
+                if (accept.error != COPROC_NET_ERR_NONE) {
+                    ESP_LOGW(TAG, "Proxy refused request %u (error %u)", id, accept.error);
+                    ret = ESP_FAIL;
+                    break;
+                }
+                *accepted = true;
+                wait = pdMS_TO_TICKS(timeout_ms);
+                break;
+            }
+            case COPROC_MSG_NET_RESPONSE: {
+                coproc_net_response_t response;
+                if (!*accepted || payload_len < sizeof(response)) {
+                    ret = ESP_FAIL;
+                    break;
+                }
+                memcpy(&response, payload, sizeof(response));
+                if (response.error != COPROC_NET_ERR_NONE) {
+                    ESP_LOGW(TAG, "Proxy request %u failed upstream (error %u)", id, response.error);
+                    ret = response.error == COPROC_NET_ERR_TIMEOUT ? ESP_ERR_TIMEOUT : ESP_FAIL;
+                    done = true;
+                    break;
+                }
+                result->status = response.status;
+                result->ttfb_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+                break;
+            }
+            case COPROC_MSG_NET_RESPONSE_BODY: {
+                coproc_net_chunk_t chunk;
+                if (result->status == 0 || payload_len < sizeof(chunk)) {
+                    ret = ESP_FAIL;
+                    break;
+                }
+                memcpy(&chunk, payload, sizeof(chunk));
+                ret = deliver(request, result, start_us, payload + sizeof(chunk), payload_len - sizeof(chunk));
+                if (chunk.flags & COPROC_NET_CHUNK_ERROR) {
+                    ret = ESP_FAIL;
+                }
+                done = (chunk.flags & (COPROC_NET_CHUNK_LAST | COPROC_NET_CHUNK_ERROR)) != 0;
+                if (ret == ESP_OK && !done) {
+                    const uint8_t credit[2] = { id, 1 };
+                    coproc_link_send(COPROC_MSG_NET_CREDIT, credit, sizeof(credit));
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (!done) {
+        coproc_link_send(COPROC_MSG_NET_CANCEL, &id, sizeof(id));
+    }
+    slot_close(slot);
+    heap_caps_free(entry);
+    return ret;
+}
+
+// -----------------------------------------------------------------------------
+// Direct over Wi-Fi
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    const net_request_t *request;
+    net_result_t *result;
+    int64_t start_us;
+} direct_ctx_t;
+
+static esp_err_t direct_body(const uint8_t *data, size_t len, void *user_ctx)
+{
+    direct_ctx_t *ctx = (direct_ctx_t *)user_ctx;
+    return deliver(ctx->request, ctx->result, ctx->start_us, data, len);
+}
+
+static esp_err_t perform_direct(const net_request_t *request, uint32_t timeout_ms, net_result_t *result,
+                                int64_t start_us)
+{
+    direct_ctx_t ctx = {
+        .request = request,
+        .result = result,
+        .start_us = start_us,
+    };
+    conn_exchange_t exchange;
+    wifi_power_hold(true);      // Replies must not wait for the next beacon wake
+    esp_err_t ret = conn_manager_perform(request, timeout_ms, direct_body, &ctx, &exchange);
+    wifi_power_hold(false);
+
+    result->status = exchange.status;
+    result->reused = exchange.reused;
+    result->handshake = exchange.handshake;
+    if (result->body_bytes == 0 && exchange.headers_us > 0) {
+        result->ttfb_ms = (uint32_t)((exchange.headers_us - start_us) / 1000);
+    }
+    return ret;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+esp_err_t net_client_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Net client already initialized");
+        return ESP_OK;
+    }
+
+    slots_lock = xSemaphoreCreateMutex();
+    if (slots_lock == NULL) {
+        ESP_LOGE(TAG, "Failed to create slot lock");
+        return ESP_ERR_NO_MEM;
+    }
+
+    const uint8_t types[] = { COPROC_MSG_NET_ACCEPT, COPROC_MSG_NET_RESPONSE, COPROC_MSG_NET_RESPONSE_BODY };
+    for (size_t i = 0; i < sizeof(types); i++) {
+        esp_err_t ret = coproc_link_register_handler(types[i], on_net_message, NULL);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register proxy handler: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Net client initialized (offload %s, window %d chunks)",
+             CONFIG_NET_OFFLOAD_ENABLE ? "enabled" : "disabled", CONFIG_NET_OFFLOAD_WINDOW);
+
+    return ESP_OK;
+}
+
+bool net_client_offload_available(void)
+{
+    return CONFIG_NET_OFFLOAD_ENABLE && module_initialized && coproc_get_state() == COPROC_STATE_RUNNING;
+}
+
+esp_err_t net_client_perform(const net_request_t *request, net_result_t *result)
+{
+    net_result_t local_result;
+    if (result == NULL) {
+        result = &local_result;
+    }
+    memset(result, 0, sizeof(*result));
+    if (request == NULL || request->url == NULL || (request->body_len > 0 && request->body == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t timeout_ms = request->timeout_ms > 0 ? request->timeout_ms : CONFIG_NET_TIMEOUT_MS;
+    bool try_offload = request->route == NET_ROUTE_OFFLOAD ||
+                       (request->route == NET_ROUTE_AUTO && net_client_offload_available());
+    bool try_direct = request->route == NET_ROUTE_DIRECT || request->route == NET_ROUTE_AUTO;
+
+    cost_probe_t probe;
+    probe_start(&probe);
+
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    if (try_offload && module_initialized) {
+        bool accepted = false;
+        result->route = NET_ROUTE_OFFLOAD;
+        ret = perform_offload(request, timeout_ms, result, probe.start_us, &accepted);
+        if (accepted || request->route == NET_ROUTE_OFFLOAD) {
+            try_direct = false;
+        } else if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Offload not accepted (%s), going direct", esp_err_to_name(ret));
+            result->fell_back = true;
+        }
+    }
+    if (try_direct && (ret != ESP_OK || !try_offload)) {
+        result->route = NET_ROUTE_DIRECT;
+        result->status = 0;
+        result->body_bytes = 0;
+        ret = wifi_is_connected() ? perform_direct(request, timeout_ms, result, probe.start_us)
+                                  : ESP_ERR_INVALID_STATE;
+    }
+
+    probe_stop(&probe, result);
+    if (result->route != NET_ROUTE_AUTO) {
+        record_result(result, ret);
+    }
+    if (result->route == NET_ROUTE_DIRECT && ret == ESP_OK) {
+        telemetry_note_radio_activity();    // Radio still awake: queued telemetry can go along
+    }
+
+    ESP_LOG_LEVEL(ret == ESP_OK ? ESP_LOG_DEBUG : ESP_LOG_WARN, TAG,
+                  "%s %s: %s, status %d, %lu bytes, ttfb %lu ms, total %lu ms",
+                  route_name(result->route), request->url, esp_err_to_name(ret), result->status,
+                  (unsigned long)result->body_bytes, (unsigned long)result->ttfb_ms,
+                  (unsigned long)result->total_ms);
+    return ret;
+}
+
+esp_err_t net_client_get_stats(net_client_stats_t *out)
+{
+    if (out == NULL) {
+        return ESP_FAIL;
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    taskEXIT_CRITICAL(&stats_lock);
+    return ESP_OK;
+}
+
+esp_err_t net_client_get_status_string(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size < 96) {
+        return ESP_FAIL;
+    }
+
+    net_client_stats_t snapshot;
+    net_client_get_stats(&snapshot);
+
+    int len = snprintf(buffer, buffer_size, "Net:");
+    for (int route = NET_ROUTE_OFFLOAD; route <= NET_ROUTE_DIRECT && len < (int)buffer_size; route++) {
+        const net_route_stats_t *r = &snapshot.route[route];
+        uint32_t ok = r->requests - r->failures;
+        len += snprintf(buffer + len, buffer_size - len, " %s %lu/%lu %lu ms",
+                        route_name((net_route_t)route), (unsigned long)ok, (unsigned long)r->requests,
+                        (unsigned long)(ok > 0 ? r->total_ms_sum / ok : 0));
+    }
+    if (len < (int)buffer_size) {
+        snprintf(buffer + len, buffer_size - len, ", %lu fallbacks", (unsigned long)snapshot.fallbacks);
+    }
+    return ESP_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Benchmark
+// -----------------------------------------------------------------------------
+
+typedef struct {
+    uint32_t ok;
+    uint64_t ttfb_ms;
+    uint64_t total_ms;
+    uint32_t max_total_ms;
+    uint32_t max_heap;
+    uint64_t cpu_us;
+    uint64_t bytes;
+    uint32_t reused;
+} bench_totals_t;
+
+static void bench_run(const char *url, net_route_t route, bool reuse, uint32_t baseline_permille)
+{
+    const char *label = route != NET_ROUTE_DIRECT ? route_name(route) : reuse ? "reuse" : "direct";
+    conn_manager_stats_t conn_before;
+    conn_manager_set_reuse(reuse);
+    conn_manager_get_stats(&conn_before);
+
+    bench_totals_t totals = {0};
+    for (int i = 0; i < CONFIG_NET_BENCH_REQUESTS; i++) {
+        const net_request_t request = {
+            .url = url,
+            .method = NET_METHOD_GET,
+            .route = route,
+        };
+        net_result_t result;
+        if (net_client_perform(&request, &result) != ESP_OK) {
+            continue;
+        }
+        // Busy time the rest of the system spends anyway is not the request's
+        uint32_t background_us = (uint32_t)((uint64_t)result.total_ms * 1000 * portNUM_PROCESSORS *
+                                            baseline_permille / 1000);
+        totals.ok++;
+        totals.ttfb_ms += result.ttfb_ms;
+        totals.total_ms += result.total_ms;
+        totals.bytes += result.body_bytes;
+        totals.cpu_us += result.cpu_us > background_us ? result.cpu_us - background_us : 0;
+        totals.reused += result.reused;
+        if (result.total_ms > totals.max_total_ms) {
+            totals.max_total_ms = result.total_ms;
+        }
+        if (result.heap_peak_bytes > totals.max_heap) {
+            totals.max_heap = result.heap_peak_bytes;
+        }
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+    conn_manager_stats_t conn_after;
+    conn_manager_get_stats(&conn_after);
+    conn_manager_set_reuse(true);
+
+    if (totals.ok == 0) {
+        ESP_LOGW(TAG, "%-7s %s: all %d requests failed", label, url, CONFIG_NET_BENCH_REQUESTS);
+        return;
+    }
+    ESP_LOGI(TAG, "%-7s %s: %lu/%d ok, %lu bytes, ttfb %lu ms, total mean %lu max %lu ms, "
+             "peak heap %lu bytes, CPU %lu us/request",
+             label, url, (unsigned long)totals.ok, CONFIG_NET_BENCH_REQUESTS,
+             (unsigned long)(totals.bytes / totals.ok), (unsigned long)(totals.ttfb_ms / totals.ok),
+             (unsigned long)(totals.total_ms / totals.ok), (unsigned long)totals.max_total_ms,
+             (unsigned long)totals.max_heap, (unsigned long)(totals.cpu_us / totals.ok));
+
+    if (route == NET_ROUTE_DIRECT) {
+        uint32_t full = conn_after.handshakes_full - conn_before.handshakes_full;
+        uint32_t ticket = conn_after.handshakes_ticket - conn_before.handshakes_ticket;
+        uint64_t full_ms = conn_after.handshake_ms_full - conn_before.handshake_ms_full;
+        uint64_t ticket_ms = conn_after.handshake_ms_ticket - conn_before.handshake_ms_ticket;
+        ESP_LOGI(TAG, "%-7s handshakes: %lu full (mean %lu ms), %lu with ticket (mean %lu ms), "
+                 "%lu requests on kept-alive connections",
+                 label, (unsigned long)full, (unsigned long)(full > 0 ? full_ms / full : 0),
+                 (unsigned long)ticket, (unsigned long)(ticket > 0 ? ticket_ms / ticket : 0),
+                 (unsigned long)totals.reused);
+    }
+}
+
+esp_err_t net_client_run_benchmark(void)
+{
+    ESP_LOGI(TAG, "Net benchmark: waiting for Wi-Fi and the co-processor...");
+
+    bool direct_up = wifi_wait_connected(CONFIG_NET_BENCH_WAIT_MS) == ESP_OK;
+    bool offload_up = module_initialized && coproc_request_resume(CONFIG_COPROC_BOOT_TIMEOUT_MS) == ESP_OK;
+    if (!direct_up && !offload_up) {
+        ESP_LOGW(TAG, "Net benchmark skipped, neither Wi-Fi nor the co-processor is up");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Background load, subtracted from every request's CPU time
+    uint32_t baseline_permille = 0;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    uint32_t idle_start = idle_time_us();
+    vTaskDelay(pdMS_TO_TICKS(BENCH_BASELINE_MS));
+    uint32_t idle_us = idle_time_us() - idle_start;
+    uint32_t capacity_us = BENCH_BASELINE_MS * 1000 * portNUM_PROCESSORS;
+    baseline_permille = idle_us < capacity_us ? (capacity_us - idle_us) / (capacity_us / 1000) : 0;
+#else
+    ESP_LOGW(TAG, "CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS is off, CPU time not measured");
+#endif
+    ESP_LOGI(TAG, "Net benchmark: %d requests per URL and route, background load %lu.%lu%%",
+             CONFIG_NET_BENCH_REQUESTS, (unsigned long)(baseline_permille / 10),
+             (unsigned long)(baseline_permille % 10));
+
+    const char *urls[] = { CONFIG_NET_BENCH_URL, CONFIG_NET_BENCH_STREAM_URL };
+    for (size_t i = 0; i < sizeof(urls) / sizeof(urls[0]); i++) {
+        if (offload_up) {
+            bench_run(urls[i], NET_ROUTE_OFFLOAD, true, baseline_permille);
+        }
+        if (direct_up) {
+            bench_run(urls[i], NET_ROUTE_DIRECT, false, baseline_permille);
+            bench_run(urls[i], NET_ROUTE_DIRECT, true, baseline_permille);
+        }
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,160 @@
+#ifndef NET_CLIENT_H
+#define NET_CLIENT_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file net_client.h
+ * @brief HTTP(S) requests, offloaded to the co-processor or made directly
+ *
+ * With offload, the request goes over the co-processor link to a proxy on the
+ * Orange Pi (tools/net_proxy.py) that does the HTTPS over Ethernet; the ESP
+ * only sees compact request, response and body-chunk messages, so no TLS
+ * session or socket buffers are allocated here. The response body is
+ * streamed back under a credit window of CONFIG_NET_OFFLOAD_WINDOW chunks.
+ *
+ * NET_ROUTE_AUTO offloads while the co-processor is running and falls back
+ * to a direct request over Wi-Fi (conn_manager.h) when it is not, or when
+ * the proxy does not accept the request within
+ * CONFIG_NET_OFFLOAD_ACCEPT_TIMEOUT_MS. Once the
+ * proxy has accepted a request it is never repeated on the other route, so
+ * a POST is not sent twice.
+ */
+
+typedef enum {
+    NET_ROUTE_AUTO,             // Offload when possible, direct otherwise
+    NET_ROUTE_OFFLOAD,          // Proxy on the co-processor only
+    NET_ROUTE_DIRECT,           // Over Wi-Fi only, see conn_manager.h
+    NET_ROUTE_COUNT
+} net_route_t;
+
+typedef enum {
+    NET_METHOD_GET,
+    NET_METHOD_POST
+} net_method_t;
+
+/**
+ * @brief Response body callback, called in the requesting task
+ *
+ * @param data Body bytes (valid only during the call)
+ * @param len Number of bytes
+ * @param user_ctx Context from the request
+ * @return ESP_OK to continue, anything else aborts the request
+ */
+typedef esp_err_t (*net_data_cb_t)(const uint8_t *data, size_t len, void *user_ctx);
+
+typedef struct {
+    const char *url;
+    net_method_t method;
+    const char *content_type;   // Request body type, NULL for none
+    const void *body;
+    size_t body_len;
+    net_data_cb_t on_data;      // NULL discards the body
+    void *user_ctx;
+    uint32_t timeout_ms;        // 0 for CONFIG_NET_TIMEOUT_MS
+    net_route_t route;
+} net_request_t;
+
+/**
+ * @brief Outcome and cost of one request
+ */
+typedef struct {
+    net_route_t route;          // Route that served the request
+    bool fell_back;             // AUTO tried offload first
+    int status;                 // HTTP status, 0 if no response
+    uint32_t body_bytes;
+    uint32_t ttfb_ms;           // Start -> first body byte (headers for an empty body)
+    uint32_t total_ms;
+    uint32_t heap_peak_bytes;   // Internal RAM in use at the worst point, 0 if not measured
+    uint32_t cpu_us;            // Busy time of both cores, 0 without FreeRTOS run-time stats
+    bool reused;                // Direct: served on a kept-alive connection
+    bool handshake;             // Direct: made a new TLS handshake
+} net_result_t;
+
+typedef struct {
+    uint32_t requests;
+    uint32_t failures;
+    uint64_t total_ms_sum;
+    uint64_t ttfb_ms_sum;
+    uint32_t max_total_ms;
+    uint32_t max_heap_peak_bytes;
+    uint64_t cpu_us_sum;
+} net_route_stats_t;
+
+typedef struct {
+    net_route_stats_t route[NET_ROUTE_COUNT];   // OFFLOAD and DIRECT
+    uint32_t fallbacks;
+    uint32_t offload_overflows;                 // Chunks beyond the credit window, dropped
+} net_client_stats_t;
+
+/**
+ * @brief Register the proxy message handlers on the co-processor link
+ *
+ * Call after coproc_module_init(). Direct requests work without it.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM on allocation failure
+ */
+esp_err_t net_client_init(void);
+
+/**
+ * @brief Make one request, blocking until the body is complete
+ *
+ * A direct HTTPS request may do a TLS handshake in the calling task, which
+ * needs about CONFIG_TASK_STACK_CONN bytes of stack.
+ *
+ * @param request Request description
+ * @param result Optional, filled in also on failure
+ * @return ESP_OK when a response was received (any HTTP status),
+ *         ESP_ERR_INVALID_STATE if no route is available, ESP_ERR_TIMEOUT,
+ *         the callback's error if it aborted, ESP_FAIL on transport errors
+ */
+esp_err_t net_client_perform(const net_request_t *request, net_result_t *result);
+
+/**
+ * @brief Check whether requests can be offloaded right now
+ *
+ * @return true when offload is enabled and the co-processor is running
+ */
+bool net_client_offload_available(void);
+
+/**
+ * @brief Get request statistics per route
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t net_client_get_stats(net_client_stats_t *stats);
+
+/**
+ * @brief Get a one-line request summary for the diagnostics screen
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 96 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t net_client_get_status_string(char *buffer, size_t buffer_size);
+
+/**
+ * @brief Compare offloaded and direct requests against CONFIG_NET_BENCH_URL
+ *
+ * Waits for Wi-Fi and the co-processor, runs CONFIG_NET_BENCH_REQUESTS
+ * requests per URL and route, and logs latency, peak heap and CPU time.
+ * Direct requests run twice, with new connections and full handshakes, then
+ * with kept-alive connections and session tickets, and log the handshakes.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a route never came up
+ */
+esp_err_t net_client_run_benchmark(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_CLIENT_H
@@ -1,11 +1,10 @@
 #include "pir_module.h"
 #include "project_config.h"
+#include "service_task.h"
+#include "ui_strings.h"
 #include <driver/gpio.h>
 #include <esp_log.h>
 #include <esp_timer.h>
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
-#include <freertos/queue.h>
 #include <string.h>
 #include <stdio.h>
 
@@ -18,8 +17,8 @@ static pir_status_t pir_status = {
     .no_motion_duration = 0
 };
 
-// Task and timer handles
-static TaskHandle_t pir_task_handle = NULL;
+// Service job handle
+static service_job_handle_t pir_job = NULL;
 static bool pir_module_initialized = false;
 
 /**
@@ -31,43 +30,39 @@ static uint32_t get_time_seconds(void)
 }
 
 /**
- * @brief PIR sensor monitoring task
+ * @brief PIR sensor monitoring job
  */
-static void pir_monitoring_task(void *pvParameters)
+static uint32_t pir_monitoring_job(void *user_ctx)
 {
-    ESP_LOGI(TAG, "PIR monitoring task started");
-    
-    while (1) {
-        // Read current PIR sensor state
-        int gpio_level = gpio_get_level(CONFIG_PIR_OUTPUT_GPIO);
-        bool current_motion = (gpio_level == 1);
-        uint32_t current_time = get_time_seconds();
-        
-        // Update PIR status
-        if (current_motion) {
-            if (!pir_status.motion_detected) {
-                // Motion just detected
-                ESP_LOGI(TAG, "Motion detected!");
-                pir_status.motion_detected = true;
-                pir_status.last_motion_time = current_time;
-                pir_status.no_motion_duration = 0;
-            }
-        } else {
-            if (pir_status.motion_detected) {
-                // Motion just stopped
-                ESP_LOGI(TAG, "Motion stopped");
-                pir_status.motion_detected = false;
-                pir_status.last_motion_time = current_time;
-            }
-            // Update no motion duration
-            if (pir_status.last_motion_time > 0) {
-                pir_status.no_motion_duration = current_time - pir_status.last_motion_time;
-            }
+    // Read current PIR sensor state
+    int gpio_level = gpio_get_level(CONFIG_PIR_OUTPUT_GPIO);
+    bool current_motion = (gpio_level == 1);
+    uint32_t current_time = get_time_seconds();
+    
+    // Update PIR status
+    if (current_motion) {
+        if (!pir_status.motion_detected) {
+            // Motion just detected
+            ESP_LOGI(TAG, "Motion detected!");
+            pir_status.motion_detected = true;
+            pir_status.last_motion_time = current_time;
+            pir_status.no_motion_duration = 0;
+        }
+    } else {
+        if (pir_status.motion_detected) {
+            // Motion just stopped
+            ESP_LOGI(TAG, "Motion stopped");
+            pir_status.motion_detected = false;
+            pir_status.last_motion_time = current_time;
+        }
+        // Update no motion duration
+        if (pir_status.last_motion_time > 0) {
+            pir_status.no_motion_duration = current_time - pir_status.last_motion_time;
         }
-        
-        // Check PIR sensor at configured interval
-        vTaskDelay(pdMS_TO_TICKS(CONFIG_PIR_POLL_INTERVAL_MS));
     }
+    
+    // Check PIR sensor at configured interval
+    return CONFIG_PIR_POLL_INTERVAL_MS;
 }
 
 esp_err_t pir_module_init(void)
@@ -99,18 +94,19 @@ esp_err_t pir_module_init(void)
     pir_status.last_motion_time = 0;
     pir_status.no_motion_duration = 0;
     
-    // Create PIR monitoring task
-    BaseType_t task_ret = xTaskCreate(
-        pir_monitoring_task,
-        "pir_monitor",
-        CONFIG_TASK_STACK_PIR,
-        NULL,
-        CONFIG_TASK_PRIORITY_PIR,
-        &pir_task_handle
-    );
-    
-    if (task_ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create PIR monitoring task");
+    // Poll on the shared service task
+    const service_job_config_t job_config = {
+        .name = "pir_monitor",
+        .run = pir_monitoring_job,
+        .user_ctx = NULL,
+        .first_delay_ms = 0,
+        .dedicated_stack = CONFIG_TASK_STACK_PIR,
+        .dedicated_priority = CONFIG_TASK_PRIORITY_PIR,
+    };
+    
+    ret = service_job_add(&job_config, &pir_job);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add PIR monitoring job");
         return ESP_FAIL;
     }
     
@@ -138,12 +134,12 @@ esp_err_t pir_get_status_string(char *buffer, size_t buffer_size)
     }
     
     if (pir_status.motion_detected) {
-        snprintf(buffer, buffer_size, "PIR: Yes");
+        snprintf(buffer, buffer_size, "%s", ui_string(UI_STR_PIR_YES));
     } else {
         if (pir_status.no_motion_duration == 0) {
-            snprintf(buffer, buffer_size, "PIR: No");
+            snprintf(buffer, buffer_size, "%s", ui_string(UI_STR_PIR_NONE));
         } else {
-            snprintf(buffer, buffer_size, "PIR: No (%lus ago)", (unsigned long)pir_status.no_motion_duration);
+            snprintf(buffer, buffer_size, ui_string(UI_STR_PIR_AGO), (unsigned long)pir_status.no_motion_duration);
         }
     }
     
@@ -169,10 +165,10 @@ esp_err_t pir_module_deinit(void)
         return ESP_OK;
     }
     
-    // Delete PIR monitoring task
-    if (pir_task_handle != NULL) {
-        vTaskDelete(pir_task_handle);
-        pir_task_handle = NULL;
+    // Remove PIR monitoring job
+    if (pir_job != NULL) {
+        service_job_remove(pir_job);
+        pir_job = NULL;
     }
     
     // Reset GPIO pin
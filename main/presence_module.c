@@ -0,0 +1,214 @@
+#include "presence_module.h"
+#include "project_config.h"
+#include "pir_module.h"
+#include "mpu6050_module.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const char *TAG = "PresenceModule";
+
+#define PRESENCE_MAX_LISTENERS  8
+
+typedef struct {
+    presence_listener_t callback;
+    void *user_ctx;
+} presence_listener_entry_t;
+
+// Module state
+static bool module_initialized = false;
+static TaskHandle_t presence_task_handle = NULL;
+static presence_state_t current_state = PRESENCE_STATE_PRESENT;
+static uint32_t state_enter_time = 0;           // Seconds since boot
+static volatile uint32_t last_activity_time = 0; // Seconds since boot
+static presence_listener_entry_t listeners[PRESENCE_MAX_LISTENERS];
+static int listener_count = 0;
+static uint32_t activity_count = 0;             // Rising edges of sensor activity
+static bool restored = false;
+static presence_state_t restored_state = PRESENCE_STATE_PRESENT;
+
+/**
+ * @brief Get current time in seconds since boot
+ */
+static uint32_t get_time_seconds(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+static void set_state(presence_state_t new_state)
+{
+    if (new_state == current_state) {
+        return;
+    }
+
+    presence_state_t old_state = current_state;
+    current_state = new_state;
+    state_enter_time = get_time_seconds();
+    ESP_LOGI(TAG, "Presence: %s -> %s", presence_state_to_string(old_state), presence_state_to_string(new_state));
+
+    for (int i = 0; i < listener_count; i++) {
+        listeners[i].callback(new_state, old_state, listeners[i].user_ctx);
+    }
+}
+
+/**
+ * @brief Presence tracking task
+ */
+static void presence_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Presence task started");
+
+    bool was_active = false;
+
+    while (1) {
+        uint32_t now = get_time_seconds();
+
+        bool active = pir_is_motion_detected() || mpu6050_is_tap_detected() || mpu6050_is_shake_detected();
+        if (active) {
+            last_activity_time = now;
+            if (!was_active) {
+                activity_count++;
+            }
+        }
+        was_active = active;
+
+        uint32_t inactive = now - last_activity_time;
+        if (inactive >= CONFIG_PRESENCE_AWAY_TIMEOUT_S) {
+            set_state(PRESENCE_STATE_AWAY);
+        } else if (inactive >= CONFIG_PRESENCE_IDLE_TIMEOUT_S) {
+            set_state(PRESENCE_STATE_IDLE);
+        } else {
+            set_state(PRESENCE_STATE_PRESENT);
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_PRESENCE_POLL_INTERVAL_MS));
+    }
+}
+
+esp_err_t presence_module_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Presence module already initialized");
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Initializing presence module...");
+
+    // Someone just powered us on, so start out present; after deep sleep continue where we left off
+    uint32_t now = get_time_seconds();
+    current_state = restored ? restored_state : PRESENCE_STATE_PRESENT;
+    state_enter_time = now;
+    switch (current_state) {
+        case PRESENCE_STATE_AWAY:
+            last_activity_time = now - CONFIG_PRESENCE_AWAY_TIMEOUT_S;
+            break;
+        case PRESENCE_STATE_IDLE:
+            last_activity_time = now - CONFIG_PRESENCE_IDLE_TIMEOUT_S;
+            break;
+        default:
+            last_activity_time = now;
+            break;
+    }
+
+    BaseType_t task_ret = xTaskCreate(
+        presence_task,
+        "presence",
+        CONFIG_TASK_STACK_PRESENCE,
+        NULL,
+        CONFIG_TASK_PRIORITY_PRESENCE,
+        &presence_task_handle
+    );
+
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create presence task");
+        return ESP_FAIL;
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Presence module initialized (idle after %ds, away after %ds)",
+             CONFIG_PRESENCE_IDLE_TIMEOUT_S, CONFIG_PRESENCE_AWAY_TIMEOUT_S);
+
+    return ESP_OK;
+}
+
+presence_state_t presence_get_state(void)
+{
+    return current_state;
+}
+
+uint32_t presence_get_seconds_in_state(void)
+{
+    return module_initialized ? get_time_seconds() - state_enter_time : 0;
+}
+
+void presence_notify_activity(void)
+{
+    last_activity_time = get_time_seconds();
+    activity_count++;
+}
+
+uint32_t presence_get_activity_count(void)
+{
+    return activity_count;
+}
+
+void presence_restore(presence_state_t state, uint32_t saved_activity_count)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Presence already running, restore ignored");
+        return;
+    }
+
+    restored = true;
+    restored_state = state;
+    activity_count = saved_activity_count;
+}
+
+esp_err_t presence_register_listener(presence_listener_t listener, void *user_ctx)
+{
+    if (listener == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (listener_count >= PRESENCE_MAX_LISTENERS) {
+        ESP_LOGE(TAG, "No free presence listener slot");
+        return ESP_ERR_NO_MEM;
+    }
+
+    listeners[listener_count].callback = listener;
+    listeners[listener_count].user_ctx = user_ctx;
+    listener_count++;
+    return ESP_OK;
+}
+
+const char* presence_state_to_string(presence_state_t state)
+{
+    switch (state) {
+        case PRESENCE_STATE_PRESENT:
+            return "Present";
+        case PRESENCE_STATE_IDLE:
+            return "Idle";
+        case PRESENCE_STATE_AWAY:
+            return "Away";
+        default:
+            return "Unknown";
+    }
+}
+
+esp_err_t presence_module_deinit(void)
+{
+    if (!module_initialized) {
+        return ESP_OK;
+    }
+
+    if (presence_task_handle != NULL) {
+        vTaskDelete(presence_task_handle);
+        presence_task_handle = NULL;
+    }
+
+    listener_count = 0;
+    module_initialized = false;
+    ESP_LOGI(TAG, "Presence module deinitialized");
+
+    return ESP_OK;
+}
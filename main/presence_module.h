@@ -0,0 +1,106 @@
+#ifndef PRESENCE_MODULE_H
+#define PRESENCE_MODULE_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Presence state derived from PIR, motion sensor and touch activity
+ */
+typedef enum {
+    PRESENCE_STATE_PRESENT,     // Activity within the idle timeout
+    PRESENCE_STATE_IDLE,        // No activity for a while, user probably still nearby
+    PRESENCE_STATE_AWAY         // No activity for the away timeout
+} presence_state_t;
+
+/**
+ * @brief Presence state change callback
+ *
+ * Called from the presence task; keep it short and non-blocking.
+ *
+ * @param new_state State just entered
+ * @param old_state State just left
+ * @param user_ctx Context passed at registration
+ */
+typedef void (*presence_listener_t)(presence_state_t new_state, presence_state_t old_state, void *user_ctx);
+
+/**
+ * @brief Initialize presence tracking
+ *
+ * Starts a task that folds PIR and MPU6050 activity into a presence state.
+ * Call after pir_module_init() and mpu6050_module_init().
+ *
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t presence_module_init(void);
+
+/**
+ * @brief Get current presence state
+ *
+ * @return Current state (PRESENCE_STATE_PRESENT before init)
+ */
+presence_state_t presence_get_state(void);
+
+/**
+ * @brief Get time spent in the current state
+ *
+ * @return Seconds since the last state change
+ */
+uint32_t presence_get_seconds_in_state(void);
+
+/**
+ * @brief Report user activity from a source the module does not poll (touch, button)
+ */
+void presence_notify_activity(void);
+
+/**
+ * @brief Get the number of activity events seen since power-on
+ *
+ * @return Sensor activity onsets plus presence_notify_activity() calls
+ */
+uint32_t presence_get_activity_count(void);
+
+/**
+ * @brief Continue from a state saved before deep sleep
+ *
+ * Call before presence_module_init(). The state starts its timeout afresh.
+ *
+ * @param state Presence state to start in
+ * @param saved_activity_count Activity counter to continue from
+ */
+void presence_restore(presence_state_t state, uint32_t saved_activity_count);
+
+/**
+ * @brief Register a state change listener
+ *
+ * @param listener Callback to invoke on every state change
+ * @param user_ctx Context passed to the callback
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if all listener slots are used
+ */
+esp_err_t presence_register_listener(presence_listener_t listener, void *user_ctx);
+
+/**
+ * @brief Get printable name of a presence state
+ *
+ * @param state Presence state
+ * @return Constant string ("Present", "Idle", "Away")
+ */
+const char* presence_state_to_string(presence_state_t state);
+
+/**
+ * @brief Deinitialize presence tracking
+ *
+ * @return ESP_OK on success
+ */
+esp_err_t presence_module_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PRESENCE_MODULE_H
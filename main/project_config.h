@@ -3,6 +3,7 @@
 
 #include <driver/gpio.h>
 #include <hal/i2c_types.h>
+#include <hal/uart_types.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -48,9 +49,23 @@ extern "C" {
 #define CONFIG_I2C_PORT                 CONFIG_I2C0_PORT
 #define CONFIG_I2C_FREQ_HZ              CONFIG_I2C0_FREQ_HZ
 
+// MPU6050 data-ready interrupt (set to GPIO_NUM_NC if INT is not wired)
+#define CONFIG_MPU6050_INT_GPIO         GPIO_NUM_4
+
 // PIR Sensor Configuration
 #define CONFIG_PIR_OUTPUT_GPIO          GPIO_NUM_7
 
+// DS3231 INT/SQW alarm output (open drain, active low; must be an RTC GPIO for deep sleep wakeup)
+#define CONFIG_DS3231_INT_GPIO          GPIO_NUM_21
+
+// Co-processor (Orange Pi One) link and power control
+#define CONFIG_COPROC_UART_PORT         UART_NUM_1
+#define CONFIG_COPROC_UART_TX_GPIO      GPIO_NUM_17
+#define CONFIG_COPROC_UART_RX_GPIO      GPIO_NUM_16
+#define CONFIG_COPROC_UART_BAUD         921600
+#define CONFIG_COPROC_POWER_GPIO        GPIO_NUM_15  // Load switch enable, high = powered
+#define CONFIG_COPROC_WAKE_GPIO         GPIO_NUM_14  // Wake-from-suspend line, pulsed high
+
 // =============================================================================
 // I2C Device Addresses
 // =============================================================================
@@ -65,6 +80,23 @@ extern "C" {
 #define CONFIG_TASK_PRIORITY_MPU6050    5   // Highest - motion detection is time-sensitive
 #define CONFIG_TASK_PRIORITY_PIR        4   // Medium - presence detection
 #define CONFIG_TASK_PRIORITY_DISPLAY    3   // Lower - UI updates can tolerate some delay
+#define CONFIG_TASK_PRIORITY_PRESENCE   3   // Presence state aggregation
+#define CONFIG_TASK_PRIORITY_ARRIVAL    2   // Arrival prediction and pre-warming
+#define CONFIG_TASK_PRIORITY_COPROC_LINK 4  // Link RX must keep up with the UART
+#define CONFIG_TASK_PRIORITY_COPROC_POWER 2 // Co-processor power orchestration
+#define CONFIG_TASK_PRIORITY_PREVIEW    3   // Camera preview decode and draw, like the display
+#define CONFIG_TASK_PRIORITY_ENERGY     1   // Lowest - energy accounting
+#define CONFIG_TASK_PRIORITY_RENDER_WATCHDOG 6  // Must preempt whatever is blocking the render loop
+#define CONFIG_TASK_PRIORITY_SLEEP      1   // Deep sleep supervision
+#define CONFIG_TASK_PRIORITY_I2C_HEALTH 2   // I2C bus recovery and device re-probing
+#define CONFIG_TASK_PRIORITY_HOT_PROFILE 1  // Profile sampler setup and report
+#define CONFIG_TASK_PRIORITY_RING_BENCH 2   // Ring buffer benchmark producers and consumer
+#define CONFIG_TASK_PRIORITY_TIME       5   // Clock refresh (dedicated task mode only)
+#define CONFIG_TASK_PRIORITY_SERVICE    5   // Shared service jobs, includes the MPU6050 FIFO drain
+#define CONFIG_TASK_PRIORITY_SERVICE_REPORT 1 // Service job report (dedicated task mode only)
+#define CONFIG_TASK_PRIORITY_CONN       2   // Connection prefetch and idle connection close
+#define CONFIG_TASK_PRIORITY_TELEMETRY  1   // Telemetry batches and MQTT flushes
+#define CONFIG_TASK_PRIORITY_WIFI_POWER 1   // Gateway ping rounds (dedicated task mode only)
 
 // =============================================================================
 // Task Stack Sizes
@@ -73,6 +105,24 @@ extern "C" {
 #define CONFIG_TASK_STACK_MPU6050       4096
 #define CONFIG_TASK_STACK_PIR           2048
 #define CONFIG_TASK_STACK_DISPLAY       4096
+#define CONFIG_TASK_STACK_PRESENCE      2048
+#define CONFIG_TASK_STACK_ARRIVAL       4096
+#define CONFIG_TASK_STACK_COPROC_LINK   3072
+#define CONFIG_TASK_STACK_COPROC_POWER  3072
+#define CONFIG_TASK_STACK_PREVIEW       3072
+#define CONFIG_TASK_STACK_ENERGY        3072
+#define CONFIG_TASK_STACK_RENDER_WATCHDOG 3072
+#define CONFIG_TASK_STACK_SLEEP         4096
+#define CONFIG_TASK_STACK_I2C_HEALTH    3072
+#define CONFIG_TASK_STACK_HOT_PROFILE   4096
+#define CONFIG_TASK_STACK_RING_BENCH    3072
+#define CONFIG_TASK_STACK_TIME          4096  // Dedicated task mode only
+#define CONFIG_TASK_STACK_SERVICE       4096  // Deepest job (MPU6050 gesture detection) plus the report
+#define CONFIG_TASK_STACK_CONN          6144  // TLS handshake and close_notify
+#define CONFIG_TASK_STACK_CONN_IDLE     2048  // Idle connection check (dedicated task mode only)
+#define CONFIG_TASK_STACK_TELEMETRY     4096  // MQTT flush
+#define CONFIG_TASK_STACK_TELEMETRY_BATCH 3072  // Batch encoding (dedicated task mode only)
+#define CONFIG_TASK_STACK_WIFI_POWER    2048  // Ping round start (dedicated task mode only)
 
 // =============================================================================
 // Motion Detection Configuration
@@ -87,8 +137,14 @@ extern "C" {
 #define CONFIG_MPU6050_SHAKE_DISPLAY_MS     800     // Shake display duration
 #define CONFIG_MPU6050_SHAKE_TIMEOUT_MS     500     // Shake reset timeout
 
+// MPU6050 FIFO sampling (samples are batched and timestamped per sample)
+#define CONFIG_MPU6050_SAMPLE_RATE_HZ       100     // FIFO output data rate
+#define CONFIG_MPU6050_GESTURE_WINDOW_MS    50      // Sample spacing compared by change-based gestures
+#define CONFIG_MPU6050_FIFO_MAX_BATCH       32      // Max samples drained per poll
+#define CONFIG_IMU_TIMING_REPORT_INTERVAL_MS 60000  // Timing statistics log period
+
 // Sensor polling intervals
-#define CONFIG_MPU6050_POLL_INTERVAL_MS     50      // 20Hz update rate
+#define CONFIG_MPU6050_POLL_INTERVAL_MS     50      // 20Hz FIFO drain rate
 #define CONFIG_PIR_POLL_INTERVAL_MS         500     // 2Hz update rate
 #define CONFIG_MAIN_LOOP_INTERVAL_MS        10      // Main display update rate
 
@@ -102,15 +158,244 @@ extern "C" {
 #define CONFIG_DISPLAY_BUFFER_LINES     25
 #define CONFIG_DISPLAY_DEFAULT_BRIGHTNESS 80       // Percentage (0-100)
 
+// Hardware scroll region (ILI9488 vertical scrolling, screen x axis in landscape)
+#define CONFIG_DISPLAY_HW_SCROLL_REVERSED   1       // swap_xy + mirror_y store screen x in reverse frame memory row order
+#define CONFIG_DISPLAY_SCROLL_BENCHMARK     0       // Compare SPI bytes per line against an LVGL scroll once after boot
+#define CONFIG_DISPLAY_SCROLL_BENCH_STEPS   60      // Benchmark scroll steps
+#define CONFIG_DISPLAY_SCROLL_BENCH_STEP_PX 4       // Columns per benchmark step
+
+// Main screen status widget
+#define CONFIG_STATUS_BAR_SLOT_TEXT_MAX     32      // Bytes per status text, including the terminator
+#define CONFIG_STATUS_BAR_BENCHMARK         0       // Compare against one label per field once after boot
+#define CONFIG_STATUS_BAR_BENCH_UPDATES     60      // Field updates rendered per benchmark run
+
 // LVGL Configuration
 #define CONFIG_LVGL_UPDATE_PERIOD_MS    5
+#define CONFIG_DISPLAY_LOCK_TIMEOUT_MS  1000       // Max wait for the UI lock from other tasks
+
+// Render loop stall watchdog
+#define CONFIG_RENDER_HANDLER_DEADLINE_MS   500     // Max time inside lv_timer_handler()
+#define CONFIG_RENDER_LOOP_DEADLINE_MS      500     // Max gap between lv_timer_handler() calls
+#define CONFIG_RENDER_FLUSH_DEADLINE_MS     200     // Max time from flush start to flush ready
+#define CONFIG_RENDER_WATCHDOG_CHECK_MS     50      // Deadline check rate
+#define CONFIG_RENDER_WATCHDOG_REPORT_INTERVAL_MS 60000 // Stall statistics log period
+#define CONFIG_RENDER_WATCHDOG_BACKTRACE    1       // Print all task backtraces on a stall
+#define CONFIG_RENDER_WATCHDOG_BACKTRACE_DEPTH 16
+
+// Accelerated LVGL blend backend
+#define CONFIG_DRAW_ACCEL_ENABLE            1       // Use the accelerated blend routines (0 = stock renderer)
+#define CONFIG_DRAW_ACCEL_BENCHMARK         0       // Compare against the stock renderer once after boot
+#define CONFIG_DRAW_ACCEL_ITERATIONS        50      // Benchmark repetitions per blend operation
+#define CONFIG_DRAW_ACCEL_FADE_STEPS        16      // Benchmark frames in the full-screen fade
+
+// =============================================================================
+// Hot Code Placement Profiling (see tools/hot_placement.py)
+// =============================================================================
+
+#define CONFIG_HOT_PROFILE_ENABLE           0       // Sample PCs on the main screen once after boot and log the profile
+#define CONFIG_HOT_PROFILE_DURATION_MS      60000   // Profiling window
+#define CONFIG_HOT_PROFILE_SAMPLE_HZ        1000    // PC samples per second and core
+#define CONFIG_HOT_PROFILE_BUCKETS          2048    // Distinct 16-byte code blocks tracked (power of two)
+#define CONFIG_HOT_PROFILE_REPORT_TOP       256     // Hottest flash blocks logged
+#define CONFIG_HOT_PLACEMENT_IRAM_BUDGET    24576   // Bytes of hot code moved to IRAM by the generated fragment
+#define CONFIG_HOT_PLACEMENT_DRAM_BUDGET    16384   // Bytes of hot read-only tables moved to DRAM
+
+// =============================================================================
+// Lock-free Ring Buffers (ring_buffer.h)
+// =============================================================================
+
+#define CONFIG_RING_BENCHMARK               0       // Compare against FreeRTOS queues across cores once after boot
+#define CONFIG_RING_BENCH_ITEMS             100000  // Elements per benchmark run
+#define CONFIG_RING_BENCH_CAPACITY          256     // Ring and queue length (power of two)
+#define CONFIG_RING_BENCH_BATCH             32      // Elements per reserve/commit in the batch run
 
 // =============================================================================
 // Time Module Configuration  
 // =============================================================================
 
 #define CONFIG_TIME_UPDATE_INTERVAL_MS  1000       // 1 second clock updates
-#define CONFIG_TIME_I2C_TIMEOUT_MS      1000       // I2C transaction timeout
+
+// =============================================================================
+// I2C Reliability
+// =============================================================================
+
+#define CONFIG_I2C_DEADLINE_MARGIN      2           // Deadline = wire time of the transaction x margin
+#define CONFIG_I2C_DEADLINE_MIN_US      2000        // Floor for short transactions (driver and task switch overhead)
+#define CONFIG_I2C_MAX_WRITE_LEN        16          // Largest register block written at once
+#define CONFIG_I2C_OFFLINE_AFTER_ERRORS 3           // Consecutive errors -> device offline
+#define CONFIG_I2C_REPROBE_MIN_MS       1000        // First re-probe of an offline device
+#define CONFIG_I2C_REPROBE_MAX_MS       60000       // Backoff ceiling (doubles per failed probe)
+#define CONFIG_I2C_DEGRADED_HOLD_MS     10000       // An error shows as degraded this long
+#define CONFIG_I2C_RECOVERY_CLOCKS      9           // SCL pulses to free a slave holding SDA
+#define CONFIG_I2C_HEALTH_POLL_MS       100         // Recovery and re-probe check rate
+#define CONFIG_I2C_REPORT_INTERVAL_MS   60000       // Health statistics log period
+
+// =============================================================================
+// Presence Configuration
+// =============================================================================
+
+#define CONFIG_PRESENCE_POLL_INTERVAL_MS    500     // Presence state evaluation rate
+#define CONFIG_PRESENCE_IDLE_TIMEOUT_S      60      // No activity -> IDLE
+#define CONFIG_PRESENCE_AWAY_TIMEOUT_S      600     // No activity -> AWAY
+
+// Arrival prediction (per weekday and time-of-day slot)
+#define CONFIG_ARRIVAL_SLOT_MINUTES         30      // Time-of-day slot width
+#define CONFIG_ARRIVAL_LEARNING_RATE        0.25f   // Weekly EWMA weight of a new observation
+#define CONFIG_ARRIVAL_PREWARM_THRESHOLD    0.5f    // Pre-warm when P(arrival) reaches this
+#define CONFIG_ARRIVAL_PREWARM_LEAD_MIN     5       // Look-ahead before the predicted slot
+#define CONFIG_ARRIVAL_PREWARM_WINDOW_MIN   30      // Keep subsystems warm this long
+#define CONFIG_ARRIVAL_CHECK_INTERVAL_MS    60000   // Prediction check rate
+
+// =============================================================================
+// Co-processor Power Orchestration
+// =============================================================================
+
+#define CONFIG_COPROC_AWAY_ACTION           COPROC_AWAY_ACTION_SUSPEND  // or COPROC_AWAY_ACTION_POWER_OFF
+#define CONFIG_COPROC_SUSPEND_AFTER_AWAY_S  300     // AWAY this long -> suspend/power off
+#define CONFIG_COPROC_POLL_INTERVAL_MS      1000    // Orchestration check rate
+#define CONFIG_COPROC_SUSPEND_ACK_TIMEOUT_MS 5000   // Wait for SUSPEND_ACK
+#define CONFIG_COPROC_SHUTDOWN_GRACE_MS     3000    // Ack -> power cut (filesystem sync)
+#define CONFIG_COPROC_RESUME_TIMEOUT_MS     5000    // RESUME -> READY
+#define CONFIG_COPROC_BOOT_TIMEOUT_MS       60000   // Power on -> READY (Linux boot)
+#define CONFIG_COPROC_BOOT_RETRY_MS         30000   // Power stays off this long after a failed boot
+#define CONFIG_COPROC_WAKE_PULSE_MS         10      // Wake line pulse width
+#define CONFIG_COPROC_RUNNING_CURRENT_MA    400.0f  // Orange Pi One draw with camera running
+
+// Camera preview (shake from the diagnostics screen; RLE RGB565 thumbnails over the link)
+#define CONFIG_PREVIEW_WIDTH                160     // Thumbnail requested from the co-processor
+#define CONFIG_PREVIEW_HEIGHT               120
+#define CONFIG_PREVIEW_SCALE                2       // Pixel replication on the panel
+#define CONFIG_PREVIEW_REGION_WIDTH         (CONFIG_PREVIEW_WIDTH * CONFIG_PREVIEW_SCALE)
+#define CONFIG_PREVIEW_REGION_HEIGHT        (CONFIG_PREVIEW_HEIGHT * CONFIG_PREVIEW_SCALE)
+#define CONFIG_PREVIEW_REGION_Y             40      // Below the statistics line, centered horizontally
+#define CONFIG_PREVIEW_MAX_FPS              15
+#define CONFIG_PREVIEW_FRAMES_IN_FLIGHT     2       // Unacknowledged frames the co-processor may send
+#define CONFIG_PREVIEW_RING_SLOTS           16      // Received stripes queued for decoding (power of two)
+#define CONFIG_PREVIEW_STRIPE_ROWS          16      // Panel rows per DMA stripe
+#define CONFIG_PREVIEW_REPORT_INTERVAL_MS   10000   // Statistics log period while previewing
+
+// UI sound effects, mixed over speech by the co-processor (sound_fx.c, tools/sfx_mixer.py)
+#define CONFIG_SOUND_FX_ENABLE              1       // Play effects on tap and shake
+#define CONFIG_SOUND_FX_GAIN_TAP            200     // Per effect, 255 = as recorded
+#define CONFIG_SOUND_FX_GAIN_SHAKE          255
+#define CONFIG_SOUND_FX_GAIN_PRESS          255
+#define CONFIG_SOUND_FX_REPORT_EVERY        16      // Latency summary log period, in started effects
+
+// =============================================================================
+// Deep Sleep with ULP RISC-V Presence Monitoring
+// =============================================================================
+
+#define CONFIG_DEEP_SLEEP_AFTER_AWAY_S      1800    // AWAY this long (co-processor down) -> deep sleep
+#define CONFIG_DEEP_SLEEP_POLL_INTERVAL_MS  10000   // Sleep condition check rate
+#define CONFIG_DEEP_SLEEP_ALARM_HOUR        6       // Daily DS3231 wakeup
+#define CONFIG_DEEP_SLEEP_ALARM_MINUTE      30
+
+#define CONFIG_ULP_POLL_PERIOD_MS           100     // ULP wakeup period
+#define CONFIG_ULP_USE_MPU6050              1       // Also poll the MPU6050 motion interrupt
+#define CONFIG_ULP_MOTION_THRESHOLD_MG      40      // MPU6050 motion interrupt threshold
+#define CONFIG_ULP_MOTION_DURATION_MS       5       // Time above threshold before motion is flagged
+#define CONFIG_ULP_CONFIRM_PIR_EDGES        2       // PIR edges in the window that confirm an arrival
+#define CONFIG_ULP_CONFIRM_WINDOW_S         60      // Confirmation window opened by a PIR edge
+
+// Sleep current model (uA)
+#define CONFIG_DEEP_SLEEP_BASE_CURRENT_UA   12.0f   // ESP32-S3 deep sleep, RTC peripherals on, ULP timer running
+#define CONFIG_DEEP_SLEEP_SENSORS_CURRENT_UA 560.0f // PIR quiescent + MPU6050 accelerometer with gyros in standby
+#define CONFIG_ULP_ACTIVE_CURRENT_UA        500.0f  // While the ULP program runs
+
+// Fast resume from RTC memory
+#define CONFIG_RESUME_CLOCK_BUDGET_MS       300     // Wakeup -> clock visible on the panel
+#define CONFIG_RESUME_RENDER_TIMEOUT_MS     200     // First frame render + flush
+#define CONFIG_RESUME_BRIGHTNESS_DEFAULT    80      // Used when no brightness was saved
+
+// =============================================================================
+// Service Jobs (service_task.c)
+// =============================================================================
+
+#define CONFIG_SERVICE_MAX_JOBS             8       // Job table size, including the report job
+#define CONFIG_SERVICE_REPORT_INTERVAL_MS   60000   // Per-job jitter and stack RAM log period
+#define CONFIG_SERVICE_DEDICATED_TASKS      0       // 1: one task per job again, for comparison
+
+// =============================================================================
+// Networking (wifi_module.c, net_client.c, conn_manager.c, wifi_power.c)
+// =============================================================================
+
+#define CONFIG_WIFI_SSID                    ""      // Empty: Wi-Fi stays off
+#define CONFIG_WIFI_PASSWORD                ""
+#define CONFIG_WIFI_CONNECT_WAIT_MS         2000    // Boot waits this long for the first connection
+#define CONFIG_WIFI_RECONNECT_MIN_MS        1000    // Backoff after a drop, doubling per failure
+#define CONFIG_WIFI_RECONNECT_MAX_MS        60000
+
+// HTTP(S) requests, offloaded to the proxy on the co-processor (tools/net_proxy.py) while it runs
+#define CONFIG_NET_OFFLOAD_ENABLE           1       // 0: always direct over Wi-Fi
+#define CONFIG_NET_OFFLOAD_ACCEPT_TIMEOUT_MS 500    // Proxy silent this long -> fall back to direct
+#define CONFIG_NET_OFFLOAD_WINDOW           4       // Response chunks in flight per request
+#define CONFIG_NET_MAX_OFFLOAD_REQUESTS     2       // Concurrent offloaded requests
+#define CONFIG_NET_TIMEOUT_MS               15000   // Default request timeout
+#define CONFIG_NET_DIRECT_BUFFER_SIZE       1024    // Direct request headers, receive buffer and read size
+// #define CONFIG_NET_CA_PEM                "-----BEGIN CERTIFICATE-----\n..." // Trust only this CA (mock server) instead of the bundle
+
+// Direct requests: kept-alive connections and TLS session tickets (conn_manager.c)
+#define CONFIG_NET_KEEPALIVE_HOSTS          "192.168.1.20"  // Comma-separated hosts whose connections are pooled
+#define CONFIG_NET_CONN_POOL_SIZE           2       // Pooled connections, each holds a TLS context and socket
+#define CONFIG_NET_CONN_IDLE_TIMEOUT_MS     30000   // Close a pooled connection idle this long
+#define CONFIG_NET_CONN_IDLE_CHECK_MS       1000    // Idle and server-close check period while any is pooled
+#define CONFIG_NET_CONN_CLOSE_TIMEOUT_MS    500     // Send timeout for the TLS close_notify of an idle connection
+#define CONFIG_NET_SESSION_CACHE_HOSTS      2       // Session tickets kept in RTC memory
+#define CONFIG_NET_SESSION_MAX_BYTES        512     // Serialized session, ticket included
+#define CONFIG_NET_SESSION_MAX_AGE_S        86400   // Common server ticket lifetime
+
+// Offload vs direct (with and without reuse) comparison against a local mock server (tools/net_proxy.py mock)
+#define CONFIG_NET_BENCHMARK                0       // Run once after boot
+#define CONFIG_NET_BENCH_URL                "https://192.168.1.20:8443/weather"
+#define CONFIG_NET_BENCH_STREAM_URL         "https://192.168.1.20:8443/stream"
+#define CONFIG_NET_BENCH_REQUESTS           10      // Per URL and route
+#define CONFIG_NET_BENCH_WAIT_MS            15000   // Wait for Wi-Fi before giving up on the direct route
+
+// Telemetry batches over MQTT (telemetry.c, tools/telemetry_collector.py)
+#define CONFIG_TELEMETRY_ENABLE             1
+#define CONFIG_TELEMETRY_MQTT_URI           "mqtt://192.168.1.20:1883"
+#define CONFIG_TELEMETRY_TOPIC_PREFIX       "desk"  // Topic: <prefix>/<mac>/telemetry
+#define CONFIG_TELEMETRY_BATCH_INTERVAL_S   300     // Aggregation window, one batch each
+#define CONFIG_TELEMETRY_PUBLISH_INTERVAL_S 3600    // Scheduled flush period
+#define CONFIG_TELEMETRY_PIGGYBACK_MIN_S    600     // Flush early after other traffic, at most this often
+#define CONFIG_TELEMETRY_QUEUE_BATCHES      48      // Ring size: 4 h of windows offline, then the oldest are dropped
+#define CONFIG_TELEMETRY_BATCH_MAX_BYTES    384     // One encoded batch (about 250 bytes in practice)
+#define CONFIG_TELEMETRY_CONNECT_TIMEOUT_MS 5000
+#define CONFIG_TELEMETRY_ACK_TIMEOUT_MS     3000    // Per batch PUBACK
+
+// Wi-Fi power save by presence (wifi_power.c)
+#define CONFIG_WIFI_POWER_ENABLE            1
+#define CONFIG_WIFI_POWER_LISTEN_IDLE       3       // Beacons between wakes when idle (max modem sleep)
+#define CONFIG_WIFI_POWER_LISTEN_AWAY       10      // Beacons between wakes when away, about 1 s
+#define CONFIG_WIFI_POWER_LIGHT_SLEEP_AWAY  0       // 1: light sleep between beacons when away; needs CONFIG_PM_ENABLE
+                                                    // and a backlight PWM clock that runs in light sleep
+#define CONFIG_WIFI_POWER_DIALOGUE_TIMEOUT_S 300    // Dialogue mode ends on its own after this
+#define CONFIG_WIFI_POWER_PING_INTERVAL_S   900     // Gateway ping round period
+#define CONFIG_WIFI_POWER_PING_SETTLE_S     20      // First round this long after entering a level
+#define CONFIG_WIFI_POWER_PING_COUNT        5       // Pings per round, 1 s apart
+#define CONFIG_WIFI_POWER_BEACON_MS         102     // Access point beacon interval (100 TU)
+#define CONFIG_WIFI_POWER_DTIM_PERIOD       1       // Access point DTIM period, in beacons
+#define CONFIG_WIFI_POWER_WAKE_MS           3       // Receiver on time per beacon wake, for the radio-on estimate
+
+// =============================================================================
+// Energy Model (no meter in the loop; calibrate coefficients against a bench supply)
+// =============================================================================
+
+#define CONFIG_ENERGY_SUPPLY_VOLTAGE_V      3.3f    // Rail the currents below are drawn from
+#define CONFIG_ENERGY_SAMPLE_INTERVAL_MS    1000    // Active time integration rate
+#define CONFIG_ENERGY_REPORT_INTERVAL_MS    60000   // Estimate window and console log period
+
+// Current while fully active (mA)
+#define CONFIG_ENERGY_CPU_80MHZ_MA          30.0f   // ESP32-S3 dual core, radio off
+#define CONFIG_ENERGY_CPU_160MHZ_MA         42.0f
+#define CONFIG_ENERGY_CPU_240MHZ_MA         56.0f
+#define CONFIG_ENERGY_CPU_LIGHT_SLEEP_MA    0.25f   // Automatic light sleep, Wi-Fi associated between beacons
+#define CONFIG_ENERGY_BACKLIGHT_MA          60.0f   // At 100% PWM duty
+#define CONFIG_ENERGY_DISPLAY_SPI_MA        12.0f   // SPI + GDMA + panel GRAM write during a flush
+#define CONFIG_ENERGY_I2C_MA                1.5f    // Bus pull-ups and device active current
+#define CONFIG_ENERGY_WIFI_TX_MA            285.0f  // 802.11n, 17 dBm
+#define CONFIG_ENERGY_WIFI_RX_MA            95.0f
+#define CONFIG_ENERGY_AUDIO_I2S_MA          25.0f   // Microphone + codec while streaming
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,177 @@
+#include "refresh_policy.h"
+#include "display_module.h"
+#include "presence_module.h"
+#include "time_module.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "RefreshPolicy";
+
+#define MIN_RATE_WINDOW_US          (60LL * 1000000)    // Shorter spans give meaningless hourly rates
+
+static bool module_initialized = false;
+static volatile refresh_policy_t current_policy = REFRESH_POLICY_LIVE;
+static volatile bool refresh_pending = false;
+
+// Flush accounting, written by the presence task and read by the UI
+static portMUX_TYPE policy_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t policy_since_us = 0;
+static uint32_t flushes_at_switch = 0;
+static uint32_t policy_flushes[REFRESH_POLICY_COUNT];
+static uint64_t policy_active_us[REFRESH_POLICY_COUNT];
+
+static refresh_policy_t policy_for_state(presence_state_t state)
+{
+    switch (state) {
+        case PRESENCE_STATE_IDLE:   return REFRESH_POLICY_REDUCED;
+        case PRESENCE_STATE_AWAY:   return REFRESH_POLICY_MINIMAL;
+        default:                    return REFRESH_POLICY_LIVE;
+    }
+}
+
+static void switch_policy(refresh_policy_t policy)
+{
+    int64_t now_us = esp_timer_get_time();
+    uint32_t flushes = display_get_flush_count();
+
+    portENTER_CRITICAL(&policy_lock);
+    refresh_policy_t old_policy = current_policy;
+    uint32_t spent_flushes = flushes - flushes_at_switch;
+    uint64_t spent_us = (uint64_t)(now_us - policy_since_us);
+    policy_flushes[old_policy] += spent_flushes;
+    policy_active_us[old_policy] += spent_us;
+    flushes_at_switch = flushes;
+    policy_since_us = now_us;
+    current_policy = policy;
+    if (policy == REFRESH_POLICY_LIVE) {
+        refresh_pending = true;
+    }
+    portEXIT_CRITICAL(&policy_lock);
+
+    ESP_LOGI(TAG, "%s -> %s after %lu s with %lu flushes",
+             refresh_policy_to_string(old_policy), refresh_policy_to_string(policy),
+             (unsigned long)(spent_us / 1000000), (unsigned long)spent_flushes);
+
+    // Show the new clock format now rather than at the next minute
+    time_module_request_update();
+}
+
+static void presence_changed(presence_state_t new_state, presence_state_t old_state, void *user_ctx)
+{
+    refresh_policy_t policy = policy_for_state(new_state);
+    if (policy != current_policy) {
+        switch_policy(policy);
+    }
+}
+
+esp_err_t refresh_policy_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Refresh policy already initialized");
+        return ESP_OK;
+    }
+
+    policy_since_us = esp_timer_get_time();
+    flushes_at_switch = display_get_flush_count();
+    current_policy = policy_for_state(presence_get_state());
+
+    esp_err_t ret = presence_register_listener(presence_changed, NULL);
+    if (ret != ESP_OK) {
+        current_policy = REFRESH_POLICY_LIVE;
+        return ret;
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Refresh policy initialized (%s)", refresh_policy_to_string(current_policy));
+
+    return ESP_OK;
+}
+
+refresh_policy_t refresh_policy_get(void)
+{
+    return current_policy;
+}
+
+bool refresh_policy_clock_shows_seconds(void)
+{
+    return current_policy == REFRESH_POLICY_LIVE;
+}
+
+bool refresh_policy_date_live(void)
+{
+    return current_policy != REFRESH_POLICY_MINIMAL;
+}
+
+bool refresh_policy_status_live(void)
+{
+    return current_policy == REFRESH_POLICY_LIVE;
+}
+
+bool refresh_policy_take_refresh(void)
+{
+    if (!refresh_pending) {
+        return false;
+    }
+    refresh_pending = false;
+    return true;
+}
+
+esp_err_t refresh_policy_get_stats(refresh_policy_t policy, refresh_policy_stats_t *stats)
+{
+    if (stats == NULL || policy >= REFRESH_POLICY_COUNT) {
+        return ESP_FAIL;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    uint32_t flushes = display_get_flush_count();
+
+    portENTER_CRITICAL(&policy_lock);
+    uint32_t total_flushes = policy_flushes[policy];
+    uint64_t total_us = policy_active_us[policy];
+    if (policy == current_policy) {
+        total_flushes += flushes - flushes_at_switch;
+        total_us += (uint64_t)(now_us - policy_since_us);
+    }
+    portEXIT_CRITICAL(&policy_lock);
+
+    memset(stats, 0, sizeof(refresh_policy_stats_t));
+    stats->flushes = total_flushes;
+    stats->active_s = (uint32_t)(total_us / 1000000);
+    if (total_us >= MIN_RATE_WINDOW_US) {
+        stats->flushes_per_hour = (uint32_t)((uint64_t)total_flushes * 3600ULL * 1000000ULL / total_us);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t refresh_policy_get_status_string(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_FAIL;
+    }
+
+    refresh_policy_stats_t s[REFRESH_POLICY_COUNT];
+    for (int i = 0; i < REFRESH_POLICY_COUNT; i++) {
+        refresh_policy_get_stats((refresh_policy_t)i, &s[i]);
+    }
+
+    snprintf(buffer, buffer_size, "Flushes/h: %s %lu, %s %lu, %s %lu (now %s)",
+             refresh_policy_to_string(REFRESH_POLICY_LIVE), (unsigned long)s[REFRESH_POLICY_LIVE].flushes_per_hour,
+             refresh_policy_to_string(REFRESH_POLICY_REDUCED), (unsigned long)s[REFRESH_POLICY_REDUCED].flushes_per_hour,
+             refresh_policy_to_string(REFRESH_POLICY_MINIMAL), (unsigned long)s[REFRESH_POLICY_MINIMAL].flushes_per_hour,
+             refresh_policy_to_string(current_policy));
+    return ESP_OK;
+}
+
+const char* refresh_policy_to_string(refresh_policy_t policy)
+{
+    switch (policy) {
+        case REFRESH_POLICY_LIVE:       return "live";
+        case REFRESH_POLICY_REDUCED:    return "reduced";
+        case REFRESH_POLICY_MINIMAL:    return "minimal";
+        default:                        return "unknown";
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef REFRESH_POLICY_H
+#define REFRESH_POLICY_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file refresh_policy.h
+ * @brief Presence-driven UI refresh rates
+ *
+ * Nobody looks at a seconds display in an empty room. The policy follows the
+ * presence state: live clock and status while someone is present, a
+ * minute clock with frozen status when idle, and only the minute clock when
+ * away. Switching back to live wakes the time task and refreshes the status
+ * right away. Panel flushes are counted per policy to show what each costs.
+ */
+
+/**
+ * @brief UI refresh policies
+ */
+typedef enum {
+    REFRESH_POLICY_LIVE,        // Present: clock with seconds, status every 500 ms
+    REFRESH_POLICY_REDUCED,     // Idle: minute clock and date, status frozen
+    REFRESH_POLICY_MINIMAL,     // Away: minute clock only
+    REFRESH_POLICY_COUNT
+} refresh_policy_t;
+
+/**
+ * @brief Flush statistics of one policy since boot
+ */
+typedef struct {
+    uint32_t flushes;           // Panel flushes while the policy was active
+    uint32_t active_s;          // Time the policy was active
+    uint32_t flushes_per_hour;  // flushes / active time, 0 until active for a minute
+} refresh_policy_stats_t;
+
+/**
+ * @brief Follow the presence state
+ *
+ * Call after presence_module_init(). Without presence tracking the policy
+ * stays live.
+ *
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t refresh_policy_init(void);
+
+/**
+ * @brief Get the active policy
+ *
+ * @return Active policy
+ */
+refresh_policy_t refresh_policy_get(void);
+
+/**
+ * @brief Check whether the clock shows seconds
+ *
+ * @return true under the live policy
+ */
+bool refresh_policy_clock_shows_seconds(void);
+
+/**
+ * @brief Check whether the date is kept up to date
+ *
+ * @return false under the minimal policy
+ */
+bool refresh_policy_date_live(void);
+
+/**
+ * @brief Check whether the status fields are refreshed
+ *
+ * @return true under the live policy
+ */
+bool refresh_policy_status_live(void);
+
+/**
+ * @brief Consume a pending status refresh after a switch to the live policy
+ *
+ * @return true once per switch back to live
+ */
+bool refresh_policy_take_refresh(void);
+
+/**
+ * @brief Get flush statistics of a policy
+ *
+ * @param policy Policy
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL on invalid arguments
+ */
+esp_err_t refresh_policy_get_stats(refresh_policy_t policy, refresh_policy_stats_t *stats);
+
+/**
+ * @brief Get formatted flushes per hour of every policy for the diagnostics screen
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 64 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t refresh_policy_get_status_string(char *buffer, size_t buffer_size);
+
+/**
+ * @brief Get printable name of a policy
+ *
+ * @param policy Policy
+ * @return Constant string
+ */
+const char* refresh_policy_to_string(refresh_policy_t policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REFRESH_POLICY_H
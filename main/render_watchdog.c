@@ -0,0 +1,336 @@
+#include "render_watchdog.h"
+#include "telemetry.h"
+#include "project_config.h"
+#include <esp_debug_helpers.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "RenderWatchdog";
+
+#define STALL_EVENT_HISTORY     8
+
+// Render loop timestamps, written by the render task and the flush ISR
+static portMUX_TYPE timing_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool in_handler = false;
+static int64_t handler_enter_us = 0;
+static int64_t handler_exit_us = 0;
+static bool flush_pending = false;
+static int64_t flush_start_us = 0;
+static int64_t flush_done_us = 0;
+static uint32_t handler_max_us = 0;
+static uint32_t flush_max_us = 0;
+
+// Watchdog state
+static bool module_initialized = false;
+static TaskHandle_t watchdog_task_handle = NULL;
+static SemaphoreHandle_t watched_ui_lock = NULL;
+static bool stall_active = false;
+static render_stall_event_t current_stall;
+static int64_t stall_start_us = 0;
+
+// Recorded events and statistics, read by other tasks
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static render_stall_event_t events[STALL_EVENT_HISTORY];
+static size_t event_head = 0;
+static size_t event_count = 0;
+static render_watchdog_stats_t stats = {0};
+
+typedef struct {
+    bool in_handler;
+    int64_t handler_enter_us;
+    int64_t handler_exit_us;
+    bool flush_pending;
+    int64_t flush_start_us;
+    int64_t flush_done_us;
+} timing_snapshot_t;
+
+static void take_snapshot(timing_snapshot_t *snap)
+{
+    portENTER_CRITICAL(&timing_lock);
+    snap->in_handler = in_handler;
+    snap->handler_enter_us = handler_enter_us;
+    snap->handler_exit_us = handler_exit_us;
+    snap->flush_pending = flush_pending;
+    snap->flush_start_us = flush_start_us;
+    snap->flush_done_us = flush_done_us;
+    portEXIT_CRITICAL(&timing_lock);
+}
+
+/**
+ * @brief Check the deadlines against a snapshot
+ *
+ * @param snap Timestamps
+ * @param now Current time
+ * @param kind Set to the stall kind when a deadline is missed
+ * @param since Set to the time the missed deadline started counting from
+ * @return true when a deadline is missed
+ */
+static bool deadline_missed(const timing_snapshot_t *snap, int64_t now, render_stall_kind_t *kind, int64_t *since)
+{
+    if (snap->flush_pending && now - snap->flush_start_us > (int64_t)CONFIG_RENDER_FLUSH_DEADLINE_MS * 1000) {
+        *kind = RENDER_STALL_FLUSH;
+        *since = snap->flush_start_us;
+        return true;
+    }
+    if (snap->in_handler && now - snap->handler_enter_us > (int64_t)CONFIG_RENDER_HANDLER_DEADLINE_MS * 1000) {
+        *kind = RENDER_STALL_HANDLER;
+        *since = snap->handler_enter_us;
+        return true;
+    }
+    if (!snap->in_handler && snap->handler_exit_us != 0 &&
+        now - snap->handler_exit_us > (int64_t)CONFIG_RENDER_LOOP_DEADLINE_MS * 1000) {
+        *kind = RENDER_STALL_LOOP;
+        *since = snap->handler_exit_us;
+        return true;
+    }
+    return false;
+}
+
+static void begin_stall(render_stall_kind_t kind, int64_t since, int64_t now)
+{
+    stall_active = true;
+    stall_start_us = since;
+
+    current_stall.kind = kind;
+    current_stall.start_ms = (uint32_t)(since / 1000);
+    current_stall.duration_ms = 0;
+
+    TaskHandle_t holder = (watched_ui_lock != NULL) ? xSemaphoreGetMutexHolder(watched_ui_lock) : NULL;
+    snprintf(current_stall.lock_holder, sizeof(current_stall.lock_holder), "%s",
+             (holder != NULL) ? pcTaskGetName(holder) : "-");
+
+    ESP_LOGW(TAG, "Render stall (%s): no progress for %lu ms, UI lock held by %s",
+             render_stall_kind_to_string(kind), (unsigned long)((now - since) / 1000), current_stall.lock_holder);
+#if CONFIG_RENDER_WATCHDOG_BACKTRACE
+    esp_backtrace_print_all_tasks(CONFIG_RENDER_WATCHDOG_BACKTRACE_DEPTH);
+#endif
+}
+
+static void end_stall(const timing_snapshot_t *snap, int64_t now)
+{
+    // The stall ended at the last sign of progress, not when we noticed
+    int64_t progress_us = snap->handler_exit_us > snap->flush_done_us ? snap->handler_exit_us : snap->flush_done_us;
+    if (progress_us <= stall_start_us) {
+        progress_us = now;
+    }
+
+    stall_active = false;
+    current_stall.duration_ms = (uint32_t)((progress_us - stall_start_us) / 1000);
+
+    portENTER_CRITICAL(&stats_lock);
+    events[event_head] = current_stall;
+    event_head = (event_head + 1) % STALL_EVENT_HISTORY;
+    if (event_count < STALL_EVENT_HISTORY) {
+        event_count++;
+    }
+    stats.stall_count++;
+    stats.window_stall_count++;
+    stats.total_stall_ms += current_stall.duration_ms;
+    if (current_stall.duration_ms > stats.worst_stall_ms) {
+        stats.worst_stall_ms = current_stall.duration_ms;
+    }
+    if (current_stall.duration_ms > stats.window_worst_stall_ms) {
+        stats.window_worst_stall_ms = current_stall.duration_ms;
+    }
+    stats.last_event = current_stall;
+    portEXIT_CRITICAL(&stats_lock);
+
+    ESP_LOGW(TAG, "Render stall (%s) recovered after %lu ms",
+             render_stall_kind_to_string(current_stall.kind), (unsigned long)current_stall.duration_ms);
+}
+
+static void report_window(void)
+{
+    portENTER_CRITICAL(&timing_lock);
+    uint32_t window_handler_max_us = handler_max_us;
+    uint32_t window_flush_max_us = flush_max_us;
+    handler_max_us = 0;
+    flush_max_us = 0;
+    portEXIT_CRITICAL(&timing_lock);
+
+    portENTER_CRITICAL(&stats_lock);
+    render_watchdog_stats_t snapshot = stats;
+    stats.handler_max_us = window_handler_max_us;
+    stats.flush_max_us = window_flush_max_us;
+    stats.window_stall_count = 0;
+    stats.window_worst_stall_ms = 0;
+    portEXIT_CRITICAL(&stats_lock);
+
+    ESP_LOGI(TAG, "Render: %lu stalls (worst %lu ms) in last %d s, %lu since boot (worst %lu ms) | handler max %lu us, flush max %lu us",
+             (unsigned long)snapshot.window_stall_count, (unsigned long)snapshot.window_worst_stall_ms,
+             CONFIG_RENDER_WATCHDOG_REPORT_INTERVAL_MS / 1000,
+             (unsigned long)snapshot.stall_count, (unsigned long)snapshot.worst_stall_ms,
+             (unsigned long)window_handler_max_us, (unsigned long)window_flush_max_us);
+}
+
+/**
+ * @brief Render watchdog task
+ */
+static void render_watchdog_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Render watchdog task started");
+
+    int64_t last_report_us = esp_timer_get_time();
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_RENDER_WATCHDOG_CHECK_MS));
+
+        int64_t now = esp_timer_get_time();
+        timing_snapshot_t snap;
+        take_snapshot(&snap);
+
+        render_stall_kind_t kind;
+        int64_t since;
+        bool missed = deadline_missed(&snap, now, &kind, &since);
+        if (missed && !stall_active) {
+            begin_stall(kind, since, now);
+        } else if (!missed && stall_active) {
+            end_stall(&snap, now);
+        }
+
+        if (now - last_report_us >= (int64_t)CONFIG_RENDER_WATCHDOG_REPORT_INTERVAL_MS * 1000) {
+            report_window();
+            last_report_us = now;
+        }
+    }
+}
+
+esp_err_t render_watchdog_init(SemaphoreHandle_t ui_lock)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Render watchdog already initialized");
+        return ESP_OK;
+    }
+
+    watched_ui_lock = ui_lock;
+
+    BaseType_t task_ret = xTaskCreate(
+        render_watchdog_task,
+        "render_wdt",
+        CONFIG_TASK_STACK_RENDER_WATCHDOG,
+        NULL,
+        CONFIG_TASK_PRIORITY_RENDER_WATCHDOG,
+        &watchdog_task_handle
+    );
+
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create render watchdog task");
+        return ESP_FAIL;
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Render watchdog initialized (handler %d ms, loop %d ms, flush %d ms)",
+             CONFIG_RENDER_HANDLER_DEADLINE_MS, CONFIG_RENDER_LOOP_DEADLINE_MS, CONFIG_RENDER_FLUSH_DEADLINE_MS);
+
+    return ESP_OK;
+}
+
+void render_watchdog_handler_enter(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&timing_lock);
+    in_handler = true;
+    handler_enter_us = now;
+    portEXIT_CRITICAL(&timing_lock);
+}
+
+void render_watchdog_handler_exit(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&timing_lock);
+    in_handler = false;
+    handler_exit_us = now;
+    uint32_t elapsed_us = (uint32_t)(now - handler_enter_us);
+    if (elapsed_us > handler_max_us) {
+        handler_max_us = elapsed_us;
+    }
+    portEXIT_CRITICAL(&timing_lock);
+    telemetry_observe(TELEMETRY_HIST_FRAME, elapsed_us);
+}
+
+void render_watchdog_flush_start(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&timing_lock);
+    flush_pending = true;
+    flush_start_us = now;
+    portEXIT_CRITICAL(&timing_lock);
+}
+
+void IRAM_ATTR render_watchdog_flush_ready(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_SAFE(&timing_lock);
+    flush_pending = false;
+    flush_done_us = now;
+    uint32_t elapsed_us = (uint32_t)(now - flush_start_us);
+    if (elapsed_us > flush_max_us) {
+        flush_max_us = elapsed_us;
+    }
+    portEXIT_CRITICAL_SAFE(&timing_lock);
+    telemetry_observe(TELEMETRY_HIST_FLUSH, elapsed_us);
+}
+
+esp_err_t render_watchdog_get_stats(render_watchdog_stats_t *out)
+{
+    if (!module_initialized || out == NULL) {
+        return ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    memcpy(out, &stats, sizeof(render_watchdog_stats_t));
+    portEXIT_CRITICAL(&stats_lock);
+    return ESP_OK;
+}
+
+size_t render_watchdog_get_events(render_stall_event_t *out, size_t max_events)
+{
+    if (out == NULL) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    size_t n = (event_count < max_events) ? event_count : max_events;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = events[(event_head + STALL_EVENT_HISTORY - 1 - i) % STALL_EVENT_HISTORY];
+    }
+    portEXIT_CRITICAL(&stats_lock);
+    return n;
+}
+
+esp_err_t render_watchdog_get_status_string(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_FAIL;
+    }
+
+    render_watchdog_stats_t s;
+    if (render_watchdog_get_stats(&s) != ESP_OK) {
+        snprintf(buffer, buffer_size, "Render: watchdog off");
+        return ESP_OK;
+    }
+
+    if (s.stall_count == 0) {
+        snprintf(buffer, buffer_size, "Render: no stalls, handler max %lu ms",
+                 (unsigned long)(s.handler_max_us / 1000));
+    } else {
+        snprintf(buffer, buffer_size, "Render: %lu stalls, worst %lu ms, last %s %lu ms (%s)",
+                 (unsigned long)s.stall_count, (unsigned long)s.worst_stall_ms,
+                 render_stall_kind_to_string(s.last_event.kind), (unsigned long)s.last_event.duration_ms,
+                 s.last_event.lock_holder);
+    }
+    return ESP_OK;
+}
+
+const char* render_stall_kind_to_string(render_stall_kind_t kind)
+{
+    switch (kind) {
+        case RENDER_STALL_HANDLER:  return "handler";
+        case RENDER_STALL_LOOP:     return "loop";
+        case RENDER_STALL_FLUSH:    return "flush";
+        default:                    return "unknown";
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef RENDER_WATCHDOG_H
+#define RENDER_WATCHDOG_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file render_watchdog.h
+ * @brief Detects stalls of the LVGL render loop and attributes them
+ *
+ * The display module timestamps every lv_timer_handler() entry and exit and
+ * every panel flush. A watchdog task checks the timestamps against deadlines;
+ * when one is missed it prints the task backtraces and the current holder of
+ * the UI lock, and records a stall event once the loop makes progress again.
+ */
+
+/**
+ * @brief Where the render loop was stuck
+ */
+typedef enum {
+    RENDER_STALL_HANDLER,   // Inside lv_timer_handler() (or waiting for the UI lock)
+    RENDER_STALL_LOOP,      // Render task not calling lv_timer_handler()
+    RENDER_STALL_FLUSH      // Panel flush started but flush-ready never came
+} render_stall_kind_t;
+
+/**
+ * @brief One recorded stall
+ */
+typedef struct {
+    render_stall_kind_t kind;
+    uint32_t start_ms;          // Milliseconds since boot
+    uint32_t duration_ms;
+    char lock_holder[16];       // Task holding the UI lock when detected, "-" if none
+} render_stall_event_t;
+
+/**
+ * @brief Stall statistics
+ */
+typedef struct {
+    uint32_t stall_count;               // Since boot
+    uint32_t worst_stall_ms;            // Since boot
+    uint32_t total_stall_ms;            // Since boot
+    uint32_t window_stall_count;        // Last report window
+    uint32_t window_worst_stall_ms;     // Last report window
+    uint32_t handler_max_us;            // Longest lv_timer_handler() run, last window
+    uint32_t flush_max_us;              // Longest flush, last window
+    render_stall_event_t last_event;    // Valid when stall_count > 0
+} render_watchdog_stats_t;
+
+/**
+ * @brief Start the watchdog task
+ *
+ * Call once the render loop runs steadily; timestamps are collected before
+ * this but no deadlines are enforced.
+ *
+ * @param ui_lock Mutex guarding LVGL, used to report its holder (may be NULL)
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t render_watchdog_init(SemaphoreHandle_t ui_lock);
+
+/**
+ * @brief Mark entry into lv_timer_handler(), called from the render task
+ */
+void render_watchdog_handler_enter(void);
+
+/**
+ * @brief Mark exit from lv_timer_handler(), called from the render task
+ */
+void render_watchdog_handler_exit(void);
+
+/**
+ * @brief Mark the start of a panel flush, called from the flush callback
+ */
+void render_watchdog_flush_start(void);
+
+/**
+ * @brief Mark flush completion, safe to call from ISR context
+ */
+void render_watchdog_flush_ready(void);
+
+/**
+ * @brief Get stall statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if not initialized or stats is NULL
+ */
+esp_err_t render_watchdog_get_stats(render_watchdog_stats_t *stats);
+
+/**
+ * @brief Get recent stall events, newest first
+ *
+ * @param events Array to fill
+ * @param max_events Size of the array
+ * @return Number of events written
+ */
+size_t render_watchdog_get_events(render_stall_event_t *events, size_t max_events);
+
+/**
+ * @brief Get formatted stall summary for the diagnostics screen
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 64 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t render_watchdog_get_status_string(char *buffer, size_t buffer_size);
+
+/**
+ * @brief Get printable name of a stall kind
+ *
+ * @param kind Stall kind
+ * @return Constant string
+ */
+const char* render_stall_kind_to_string(render_stall_kind_t kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RENDER_WATCHDOG_H
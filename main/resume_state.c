@@ -0,0 +1,153 @@
+#include "resume_state.h"
+#include "project_config.h"
+#include "display_module.h"
+#include "sleep_module.h"
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+static const char *TAG = "ResumeState";
+
+#define RESUME_MAGIC                0x52534D31  // "RSM1"
+
+/**
+ * @brief Everything kept in RTC slow memory
+ */
+typedef struct {
+    uint32_t magic;
+    resume_snapshot_t snapshot;
+    int64_t time_saved_wall_us;     // RTC timer when last_time was read
+    uint32_t resumes;
+    uint32_t budget_misses;
+    uint32_t last_clock_visible_ms;
+    uint64_t clock_visible_sum_ms;
+    uint32_t max_clock_visible_ms;
+} resume_rtc_record_t;
+
+static RTC_DATA_ATTR resume_rtc_record_t rtc_record;
+
+static bool clock_visible_recorded = false;
+
+static int64_t get_wall_clock_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+esp_err_t resume_state_save(void)
+{
+    resume_snapshot_t *snap = &rtc_record.snapshot;
+    memset(snap, 0, sizeof(resume_snapshot_t));
+
+    snap->time_valid = (time_module_get_time(&snap->last_time) == ESP_OK &&
+                        snap->last_time.status == TIME_STATUS_OK);
+    rtc_record.time_saved_wall_us = get_wall_clock_us();
+
+    snap->presence_state = presence_get_state();
+    snap->activity_count = presence_get_activity_count();
+    snap->brightness = display_get_brightness();
+    if (display_get_weather(snap->weather, sizeof(snap->weather)) != ESP_OK) {
+        snap->weather[0] = '\0';
+    }
+
+    rtc_record.magic = RESUME_MAGIC;
+
+    ESP_LOGI(TAG, "Snapshot saved: time %s, %s, %lu activities, brightness %d%%",
+             snap->time_valid ? "valid" : "invalid", presence_state_to_string(snap->presence_state),
+             (unsigned long)snap->activity_count, snap->brightness);
+    return ESP_OK;
+}
+
+const resume_snapshot_t* resume_state_get(void)
+{
+    // RTC_DATA_ATTR is reloaded from flash on a reset, so a valid magic means deep sleep
+    if (rtc_record.magic != RESUME_MAGIC || sleep_get_wake_reason() == SLEEP_WAKE_COLD_BOOT) {
+        return NULL;
+    }
+    return &rtc_record.snapshot;
+}
+
+esp_err_t resume_state_estimate_time(time_info_t *time_info)
+{
+    const resume_snapshot_t *snap = resume_state_get();
+    if (time_info == NULL || snap == NULL || !snap->time_valid) {
+        return ESP_FAIL;
+    }
+
+    struct tm tm_saved = {
+        .tm_year = snap->last_time.year - 1900,
+        .tm_mon = snap->last_time.month - 1,
+        .tm_mday = snap->last_time.day,
+        .tm_hour = snap->last_time.hour,
+        .tm_min = snap->last_time.minute,
+        .tm_sec = snap->last_time.second,
+        .tm_isdst = 0,
+    };
+    time_t t = mktime(&tm_saved);
+    if (t == (time_t)-1) {
+        return ESP_FAIL;
+    }
+    t += (time_t)((get_wall_clock_us() - rtc_record.time_saved_wall_us) / 1000000);
+
+    struct tm tm_now;
+    localtime_r(&t, &tm_now);
+    time_info->year = tm_now.tm_year + 1900;
+    time_info->month = tm_now.tm_mon + 1;
+    time_info->day = tm_now.tm_mday;
+    time_info->hour = tm_now.tm_hour;
+    time_info->minute = tm_now.tm_min;
+    time_info->second = tm_now.tm_sec;
+    time_info->weekday = tm_now.tm_wday;
+    time_info->status = TIME_STATUS_OK;
+
+    return ESP_OK;
+}
+
+uint32_t resume_state_mark_clock_visible(void)
+{
+    uint32_t elapsed_ms = sleep_get_ms_since_wake();
+    if (clock_visible_recorded) {
+        return elapsed_ms;
+    }
+    clock_visible_recorded = true;
+
+    rtc_record.resumes++;
+    rtc_record.last_clock_visible_ms = elapsed_ms;
+    rtc_record.clock_visible_sum_ms += elapsed_ms;
+    if (elapsed_ms > rtc_record.max_clock_visible_ms) {
+        rtc_record.max_clock_visible_ms = elapsed_ms;
+    }
+
+    if (elapsed_ms > CONFIG_RESUME_CLOCK_BUDGET_MS) {
+        rtc_record.budget_misses++;
+        ESP_LOGW(TAG, "Clock visible after %lu ms, over the %d ms budget (%lu of %lu resumes)",
+                 (unsigned long)elapsed_ms, CONFIG_RESUME_CLOCK_BUDGET_MS,
+                 (unsigned long)rtc_record.budget_misses, (unsigned long)rtc_record.resumes);
+    } else {
+        ESP_LOGI(TAG, "Clock visible after %lu ms (budget %d ms)",
+                 (unsigned long)elapsed_ms, CONFIG_RESUME_CLOCK_BUDGET_MS);
+    }
+
+    return elapsed_ms;
+}
+
+esp_err_t resume_state_get_stats(resume_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_FAIL;
+    }
+
+    memset(stats, 0, sizeof(resume_stats_t));
+    stats->resumes = rtc_record.resumes;
+    stats->budget_misses = rtc_record.budget_misses;
+    stats->last_clock_visible_ms = rtc_record.last_clock_visible_ms;
+    stats->max_clock_visible_ms = rtc_record.max_clock_visible_ms;
+    if (rtc_record.resumes > 0) {
+        stats->avg_clock_visible_ms = (uint32_t)(rtc_record.clock_visible_sum_ms / rtc_record.resumes);
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,91 @@
+#ifndef RESUME_STATE_H
+#define RESUME_STATE_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "presence_module.h"
+#include "time_module.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file resume_state.h
+ * @brief Snapshot kept in RTC slow memory for a fast resume after deep sleep
+ *
+ * Saved right before deep sleep. On wakeup the main screen is drawn from the
+ * snapshot before any sensor is touched, then the remaining modules are started.
+ */
+
+/**
+ * @brief State saved before deep sleep
+ */
+typedef struct {
+    time_info_t last_time;              // Last DS3231 reading
+    bool time_valid;                    // last_time came from a working RTC
+    presence_state_t presence_state;
+    uint32_t activity_count;            // Presence activity counter
+    int brightness;                     // Settings: backlight level (0-100)
+    char weather[32];                   // Last weather text shown
+} resume_snapshot_t;
+
+/**
+ * @brief Fast resume statistics, kept in RTC memory across sleeps
+ */
+typedef struct {
+    uint32_t resumes;
+    uint32_t budget_misses;             // Resumes slower than CONFIG_RESUME_CLOCK_BUDGET_MS
+    uint32_t last_clock_visible_ms;     // Wakeup -> clock visible, last resume
+    uint32_t avg_clock_visible_ms;
+    uint32_t max_clock_visible_ms;
+} resume_stats_t;
+
+/**
+ * @brief Save the snapshot to RTC memory
+ *
+ * Call right before deep sleep, while the display and time modules still run.
+ *
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t resume_state_save(void);
+
+/**
+ * @brief Get the snapshot saved before the deep sleep we woke from
+ *
+ * @return Snapshot, or NULL after a cold boot or if nothing valid was saved
+ */
+const resume_snapshot_t* resume_state_get(void);
+
+/**
+ * @brief Estimate the current time from the snapshot and the RTC timer
+ *
+ * The RTC timer keeps counting in deep sleep, so the saved DS3231 time plus
+ * the elapsed time is good to the second without an I2C transaction.
+ *
+ * @param time_info Pointer to store the estimated time
+ * @return ESP_OK on success, ESP_FAIL if no valid time was saved
+ */
+esp_err_t resume_state_estimate_time(time_info_t *time_info);
+
+/**
+ * @brief Record that the clock is visible and check the resume budget
+ *
+ * @return Milliseconds from wakeup to the clock being visible
+ */
+uint32_t resume_state_mark_clock_visible(void);
+
+/**
+ * @brief Get fast resume statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t resume_state_get_stats(resume_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RESUME_STATE_H
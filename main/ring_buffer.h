@@ -0,0 +1,387 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <esp_attr.h>
+#include <esp_err.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ring_buffer.h
+ * @brief Lock-free fixed-capacity rings for ISR-to-task data paths
+ *
+ * Two flavors over caller-provided storage, both with a power-of-two
+ * capacity and free-running 32-bit indices:
+ *
+ * - ring_spsc_t: one producer, one consumer. Reserve/commit hands out the
+ *   contiguous free run up to the wrap point, peek/release the contiguous
+ *   filled run, so batches (IMU FIFO reads, mic frames, link bytes) are
+ *   written and read in place.
+ * - ring_mpsc_t: any number of producers, one consumer. Producers claim one
+ *   slot with a compare-and-swap and publish it through a per-slot sequence
+ *   number, so ISRs on both cores and tasks can post to the same ring.
+ *
+ * No critical sections are taken; acquire/release ordering on the indices
+ * makes the element data visible before the index that publishes it. All
+ * functions are force-inlined and call only memcpy, so they can be used
+ * from IRAM ISRs. The rings do not block: pair them with a task
+ * notification to wake the consumer.
+ */
+
+// =============================================================================
+// Single producer, single consumer
+// =============================================================================
+
+/**
+ * @brief SPSC ring, initialize with ring_spsc_init() or RING_SPSC_DEFINE()
+ */
+typedef struct {
+    uint8_t *storage;
+    uint32_t elem_size;
+    uint32_t mask;                  // capacity - 1
+    _Atomic uint32_t head;          // Next slot to write, owned by the producer
+    _Atomic uint32_t tail;          // Next slot to read, owned by the consumer
+} ring_spsc_t;
+
+/**
+ * @brief Define a statically allocated SPSC ring of capacity elements of type
+ */
+#define RING_SPSC_DEFINE(name, type, capacity)                                  \
+    _Static_assert(((capacity) & ((capacity) - 1)) == 0 && (capacity) > 0,      \
+                   #name " capacity must be a power of two");                   \
+    static type name##_storage[capacity];                                       \
+    static ring_spsc_t name = {                                                 \
+        .storage = (uint8_t *)name##_storage,                                   \
+        .elem_size = sizeof(type),                                              \
+        .mask = (capacity) - 1,                                                 \
+    }
+
+/**
+ * @brief Initialize an SPSC ring over caller storage
+ *
+ * @param ring Ring
+ * @param storage capacity * elem_size bytes
+ * @param elem_size Element size in bytes
+ * @param capacity Number of elements, power of two
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG otherwise
+ */
+FORCE_INLINE_ATTR esp_err_t ring_spsc_init(ring_spsc_t *ring, void *storage, uint32_t elem_size, uint32_t capacity)
+{
+    if (ring == NULL || storage == NULL || elem_size == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ring->storage = (uint8_t *)storage;
+    ring->elem_size = elem_size;
+    ring->mask = capacity - 1;
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    return ESP_OK;
+}
+
+/**
+ * @brief Number of elements waiting, from either side
+ */
+FORCE_INLINE_ATTR uint32_t ring_spsc_count(ring_spsc_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+/**
+ * @brief Reserve contiguous free slots (producer)
+ *
+ * @param ring Ring
+ * @param count In: slots wanted; out: slots available at the returned address
+ *              (less than asked when the ring is nearly full or wraps)
+ * @return First slot to write, NULL if the ring is full
+ */
+FORCE_INLINE_ATTR void *ring_spsc_reserve(ring_spsc_t *ring, uint32_t *count)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t free_slots = ring->mask + 1 - (head - tail);
+    uint32_t to_wrap = ring->mask + 1 - (head & ring->mask);
+    uint32_t n = *count;
+    if (n > free_slots) {
+        n = free_slots;
+    }
+    if (n > to_wrap) {
+        n = to_wrap;
+    }
+    *count = n;
+    return n > 0 ? ring->storage + (size_t)(head & ring->mask) * ring->elem_size : NULL;
+}
+
+/**
+ * @brief Publish slots written after ring_spsc_reserve() (producer)
+ *
+ * @param ring Ring
+ * @param count Slots written, at most the count returned by the reserve
+ */
+FORCE_INLINE_ATTR void ring_spsc_commit(ring_spsc_t *ring, uint32_t count)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + count, memory_order_release);
+}
+
+/**
+ * @brief Get the contiguous run of filled slots (consumer)
+ *
+ * @param ring Ring
+ * @param count Out: slots readable at the returned address
+ * @return Oldest element, NULL if the ring is empty
+ */
+FORCE_INLINE_ATTR const void *ring_spsc_peek(ring_spsc_t *ring, uint32_t *count)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t used = head - tail;
+    uint32_t to_wrap = ring->mask + 1 - (tail & ring->mask);
+    *count = used < to_wrap ? used : to_wrap;
+    return *count > 0 ? ring->storage + (size_t)(tail & ring->mask) * ring->elem_size : NULL;
+}
+
+/**
+ * @brief Return slots read after ring_spsc_peek() to the producer (consumer)
+ *
+ * @param ring Ring
+ * @param count Slots consumed, at most the count returned by the peek
+ */
+FORCE_INLINE_ATTR void ring_spsc_release(ring_spsc_t *ring, uint32_t count)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+}
+
+/**
+ * @brief Copy one element in (producer)
+ *
+ * @return false if the ring is full
+ */
+FORCE_INLINE_ATTR bool ring_spsc_push(ring_spsc_t *ring, const void *item)
+{
+    uint32_t n = 1;
+    void *slot = ring_spsc_reserve(ring, &n);
+    if (slot == NULL) {
+        return false;
+    }
+    memcpy(slot, item, ring->elem_size);
+    ring_spsc_commit(ring, 1);
+    return true;
+}
+
+/**
+ * @brief Copy one element out (consumer)
+ *
+ * @return false if the ring is empty
+ */
+FORCE_INLINE_ATTR bool ring_spsc_pop(ring_spsc_t *ring, void *item)
+{
+    uint32_t n;
+    const void *slot = ring_spsc_peek(ring, &n);
+    if (slot == NULL) {
+        return false;
+    }
+    memcpy(item, slot, ring->elem_size);
+    ring_spsc_release(ring, 1);
+    return true;
+}
+
+// =============================================================================
+// Multiple producers, single consumer
+// =============================================================================
+
+/**
+ * @brief MPSC ring, initialize with ring_mpsc_init() or RING_MPSC_DEFINE()
+ *
+ * Slot i is free for the producer claiming index i when seq[i] == i and
+ * holds data for the consumer when seq[i] == i + 1.
+ */
+typedef struct {
+    uint8_t *storage;
+    _Atomic uint32_t *seq;          // One sequence number per slot
+    uint32_t elem_size;
+    uint32_t mask;
+    _Atomic uint32_t head;          // Next index to claim, shared by the producers
+    _Atomic uint32_t tail;          // Next index to read, owned by the consumer
+} ring_mpsc_t;
+
+/**
+ * @brief Define a statically allocated MPSC ring of capacity elements of type
+ *
+ * The ring still has to be passed to ring_mpsc_init() once, which numbers the slots.
+ */
+#define RING_MPSC_DEFINE(name, type, capacity)                                  \
+    _Static_assert(((capacity) & ((capacity) - 1)) == 0 && (capacity) > 0,      \
+                   #name " capacity must be a power of two");                   \
+    static type name##_storage[capacity];                                       \
+    static _Atomic uint32_t name##_seq[capacity];                               \
+    static ring_mpsc_t name = {                                                 \
+        .storage = (uint8_t *)name##_storage,                                   \
+        .seq = name##_seq,                                                      \
+        .elem_size = sizeof(type),                                              \
+        .mask = (capacity) - 1,                                                 \
+    }
+
+/**
+ * @brief Initialize an MPSC ring over caller storage
+ *
+ * @param ring Ring
+ * @param storage capacity * elem_size bytes, or NULL to keep the storage of RING_MPSC_DEFINE()
+ * @param seq capacity sequence numbers, or NULL to keep those of RING_MPSC_DEFINE()
+ * @param elem_size Element size in bytes (ignored when storage is NULL)
+ * @param capacity Number of elements, power of two (ignored when storage is NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG otherwise
+ */
+FORCE_INLINE_ATTR esp_err_t ring_mpsc_init(ring_mpsc_t *ring, void *storage, _Atomic uint32_t *seq,
+                                       uint32_t elem_size, uint32_t capacity)
+{
+    if (ring == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (storage != NULL) {
+        if (seq == NULL || elem_size == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        ring->storage = (uint8_t *)storage;
+        ring->seq = seq;
+        ring->elem_size = elem_size;
+        ring->mask = capacity - 1;
+    } else if (ring->storage == NULL || ring->seq == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint32_t i = 0; i <= ring->mask; i++) {
+        atomic_store_explicit(&ring->seq[i], i, memory_order_relaxed);
+    }
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_release);
+    return ESP_OK;
+}
+
+/**
+ * @brief Claim one slot (any producer, ISR or task, either core)
+ *
+ * A claimed slot must be committed promptly: the consumer sees later slots
+ * only after it.
+ *
+ * @return Slot to write, NULL if the ring is full
+ */
+FORCE_INLINE_ATTR void *ring_mpsc_reserve(ring_mpsc_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&ring->seq[head & ring->mask], memory_order_acquire);
+        int32_t diff = (int32_t)(seq - head);
+        if (diff < 0) {
+            return NULL;    // Slot not yet released by the consumer: full
+        }
+        if (diff > 0) {
+            head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+            continue;       // Another producer claimed it
+        }
+        if (atomic_compare_exchange_weak_explicit(&ring->head, &head, head + 1,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            return ring->storage + (size_t)(head & ring->mask) * ring->elem_size;
+        }
+    }
+}
+
+/**
+ * @brief Publish a slot written after ring_mpsc_reserve()
+ *
+ * @param ring Ring
+ * @param slot Address returned by the reserve
+ */
+FORCE_INLINE_ATTR void ring_mpsc_commit(ring_mpsc_t *ring, void *slot)
+{
+    uint32_t index = (uint32_t)(((uint8_t *)slot - ring->storage) / ring->elem_size);
+    uint32_t seq = atomic_load_explicit(&ring->seq[index], memory_order_relaxed);
+    atomic_store_explicit(&ring->seq[index], seq + 1, memory_order_release);
+}
+
+/**
+ * @brief Get the oldest element (consumer)
+ *
+ * @return Element, NULL if the ring is empty or the oldest slot is not committed yet
+ */
+FORCE_INLINE_ATTR const void *ring_mpsc_peek(ring_mpsc_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t seq = atomic_load_explicit(&ring->seq[tail & ring->mask], memory_order_acquire);
+    if (seq != tail + 1) {
+        return NULL;
+    }
+    return ring->storage + (size_t)(tail & ring->mask) * ring->elem_size;
+}
+
+/**
+ * @brief Hand the element returned by ring_mpsc_peek() back to the producers (consumer)
+ */
+FORCE_INLINE_ATTR void ring_mpsc_release(ring_mpsc_t *ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    // The slot becomes claimable again one lap later
+    atomic_store_explicit(&ring->seq[tail & ring->mask], tail + ring->mask + 1, memory_order_release);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_relaxed);
+}
+
+/**
+ * @brief Copy one element in (any producer)
+ *
+ * @return false if the ring is full
+ */
+FORCE_INLINE_ATTR bool ring_mpsc_push(ring_mpsc_t *ring, const void *item)
+{
+    void *slot = ring_mpsc_reserve(ring);
+    if (slot == NULL) {
+        return false;
+    }
+    memcpy(slot, item, ring->elem_size);
+    ring_mpsc_commit(ring, slot);
+    return true;
+}
+
+/**
+ * @brief Copy one element out (consumer)
+ *
+ * @return false if nothing is ready
+ */
+FORCE_INLINE_ATTR bool ring_mpsc_pop(ring_mpsc_t *ring, void *item)
+{
+    const void *slot = ring_mpsc_peek(ring);
+    if (slot == NULL) {
+        return false;
+    }
+    memcpy(item, slot, ring->elem_size);
+    ring_mpsc_release(ring);
+    return true;
+}
+
+// =============================================================================
+// Benchmark (ring_buffer_bench.c)
+// =============================================================================
+
+/**
+ * @brief Measure cross-core throughput against FreeRTOS queues and log it
+ *
+ * Producers and the consumer run pinned to different cores and every
+ * received element is checked for loss, duplication and per-producer order.
+ *
+ * @return ESP_OK if all runs completed without ordering errors, ESP_FAIL on
+ *         ordering errors, ESP_ERR_NO_MEM or ESP_ERR_TIMEOUT if a run could not complete
+ */
+esp_err_t ring_buffer_run_benchmark(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RING_BUFFER_H
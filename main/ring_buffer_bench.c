@@ -0,0 +1,301 @@
+#include "ring_buffer.h"
+#include "project_config.h"
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <inttypes.h>
+
+static const char *TAG = "RingBench";
+
+#define PRODUCER_SHIFT          24      // Element = producer id << 24 | sequence
+#define SEQUENCE_MASK           ((1U << PRODUCER_SHIFT) - 1)
+#define MAX_PRODUCERS           2
+#define DONE_TIMEOUT_MS         30000
+#define PAUSE_CHECK_SPINS       256     // Loop iterations between clock reads (power of two)
+#define PAUSE_INTERVAL_US       1000000 // Spinning time between pauses, well inside the task watchdog timeout
+
+typedef enum {
+    BENCH_SPSC_COPY,            // ring_spsc_push/pop, one element at a time
+    BENCH_SPSC_BATCH,           // ring_spsc_reserve/commit and peek/release
+    BENCH_MPSC,                 // ring_mpsc_push/pop from two producers
+    BENCH_QUEUE,                // xQueueSend/xQueueReceive
+} bench_mode_t;
+
+typedef struct bench_ctx bench_ctx_t;
+
+typedef struct {
+    bench_ctx_t *ctx;
+    uint32_t id;
+} producer_arg_t;
+
+struct bench_ctx {
+    bench_mode_t mode;
+    int producers;
+    uint32_t items;             // Per producer
+    ring_spsc_t spsc;
+    ring_mpsc_t mpsc;
+    QueueHandle_t queue;
+    SemaphoreHandle_t done;
+    volatile bool start;
+    int64_t start_us;
+    int64_t end_us;
+    uint32_t received;
+    uint32_t order_errors;
+    producer_arg_t producer_args[MAX_PRODUCERS];
+};
+
+/*
+ * The benchmark tasks spin on the rings above IDLE priority, pinned to both
+ * cores. Without a pause IDLE never runs and the task watchdog fires; one
+ * tick per PAUSE_INTERVAL_US costs at most a percent of the measured rate.
+ */
+typedef struct {
+    uint32_t spins;
+    int64_t next_pause_us;
+} bench_pacer_t;
+
+static inline void bench_pace(bench_pacer_t *pacer)
+{
+    if ((++pacer->spins & (PAUSE_CHECK_SPINS - 1)) != 0) {
+        return;
+    }
+    int64_t now_us = esp_timer_get_time();
+    if (pacer->next_pause_us == 0) {
+        pacer->next_pause_us = now_us + PAUSE_INTERVAL_US;
+    } else if (now_us >= pacer->next_pause_us) {
+        vTaskDelay(1);
+        pacer->next_pause_us = esp_timer_get_time() + PAUSE_INTERVAL_US;
+    }
+}
+
+static void producer_task(void *arg)
+{
+    producer_arg_t *producer = (producer_arg_t *)arg;
+    bench_ctx_t *ctx = producer->ctx;
+    uint32_t tag = producer->id << PRODUCER_SHIFT;
+
+    // Blocked until start: the creating task may share the core at a lower priority
+    while (!ctx->start) {
+        vTaskDelay(1);
+    }
+
+    bench_pacer_t pacer = {0};
+    uint32_t seq = 0;
+    while (seq < ctx->items) {
+        bench_pace(&pacer);
+        switch (ctx->mode) {
+            case BENCH_SPSC_COPY: {
+                uint32_t value = tag | seq;
+                if (ring_spsc_push(&ctx->spsc, &value)) {
+                    seq++;
+                }
+                break;
+            }
+            case BENCH_SPSC_BATCH: {
+                uint32_t n = CONFIG_RING_BENCH_BATCH;
+                if (n > ctx->items - seq) {
+                    n = ctx->items - seq;
+                }
+                uint32_t *slots = ring_spsc_reserve(&ctx->spsc, &n);
+                for (uint32_t i = 0; i < n; i++) {
+                    slots[i] = tag | (seq + i);
+                }
+                if (n > 0) {
+                    ring_spsc_commit(&ctx->spsc, n);
+                    seq += n;
+                }
+                break;
+            }
+            case BENCH_MPSC: {
+                uint32_t value = tag | seq;
+                if (ring_mpsc_push(&ctx->mpsc, &value)) {
+                    seq++;
+                }
+                break;
+            }
+            case BENCH_QUEUE: {
+                uint32_t value = tag | seq;
+                if (xQueueSend(ctx->queue, &value, portMAX_DELAY) == pdTRUE) {
+                    seq++;
+                }
+                break;
+            }
+        }
+    }
+
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void consumer_task(void *arg)
+{
+    bench_ctx_t *ctx = (bench_ctx_t *)arg;
+    uint32_t expected[MAX_PRODUCERS] = {0};
+    uint32_t total = ctx->items * ctx->producers;
+
+    while (!ctx->start) {
+        vTaskDelay(1);
+    }
+
+    bench_pacer_t pacer = {0};
+    while (ctx->received < total) {
+        bench_pace(&pacer);
+        uint32_t batch[CONFIG_RING_BENCH_BATCH];
+        uint32_t n = 0;
+
+        switch (ctx->mode) {
+            case BENCH_SPSC_COPY:
+                n = ring_spsc_pop(&ctx->spsc, &batch[0]) ? 1 : 0;
+                break;
+            case BENCH_SPSC_BATCH: {
+                const uint32_t *slots = ring_spsc_peek(&ctx->spsc, &n);
+                if (n > CONFIG_RING_BENCH_BATCH) {
+                    n = CONFIG_RING_BENCH_BATCH;
+                }
+                for (uint32_t i = 0; i < n; i++) {
+                    batch[i] = slots[i];
+                }
+                if (n > 0) {
+                    ring_spsc_release(&ctx->spsc, n);
+                }
+                break;
+            }
+            case BENCH_MPSC:
+                n = ring_mpsc_pop(&ctx->mpsc, &batch[0]) ? 1 : 0;
+                break;
+            case BENCH_QUEUE:
+                n = xQueueReceive(ctx->queue, &batch[0], portMAX_DELAY) == pdTRUE ? 1 : 0;
+                break;
+        }
+
+        // Every producer's sequence must arrive complete and in order
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t id = batch[i] >> PRODUCER_SHIFT;
+            if (id >= (uint32_t)ctx->producers || (batch[i] & SEQUENCE_MASK) != expected[id]) {
+                ctx->order_errors++;
+            }
+            if (id < MAX_PRODUCERS) {
+                expected[id] = (batch[i] & SEQUENCE_MASK) + 1;
+            }
+        }
+        ctx->received += n;
+    }
+
+    ctx->end_us = esp_timer_get_time();
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t run_one(bench_ctx_t *ctx, const char *name)
+{
+    int tasks = 1 + ctx->producers;
+
+    ctx->start = false;
+    ctx->received = 0;
+    ctx->order_errors = 0;
+
+    // Consumer on core 0, producers on core 1 first so the data always crosses cores
+    if (xTaskCreatePinnedToCore(consumer_task, "ring_cons", CONFIG_TASK_STACK_RING_BENCH, ctx,
+                                CONFIG_TASK_PRIORITY_RING_BENCH, NULL, 0) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (int p = 0; p < ctx->producers; p++) {
+        ctx->producer_args[p].ctx = ctx;
+        ctx->producer_args[p].id = p;
+        if (xTaskCreatePinnedToCore(producer_task, "ring_prod", CONFIG_TASK_STACK_RING_BENCH, &ctx->producer_args[p],
+                                    CONFIG_TASK_PRIORITY_RING_BENCH, NULL, (p + 1) % portNUM_PROCESSORS) != pdPASS) {
+            // The tasks already created wait for start forever and keep the context
+            ESP_LOGE(TAG, "Failed to create producer task, abandoning benchmark");
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    ctx->start_us = esp_timer_get_time();
+    ctx->start = true;
+
+    for (int t = 0; t < tasks; t++) {
+        if (xSemaphoreTake(ctx->done, pdMS_TO_TICKS(DONE_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "%s: timed out after %" PRIu32 " elements", name, ctx->received);
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    uint32_t total = ctx->items * ctx->producers;
+    int64_t elapsed_us = ctx->end_us - ctx->start_us;
+    ESP_LOGI(TAG, "%-14s %7" PRIu32 " elements in %7ld us, %8lu elements/s, %" PRIu32 " order errors",
+             name, total, (long)elapsed_us,
+             (unsigned long)(elapsed_us > 0 ? (uint64_t)total * 1000000ULL / elapsed_us : 0),
+             ctx->order_errors);
+
+    return ctx->order_errors == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t ring_buffer_run_benchmark(void)
+{
+    const uint32_t capacity = CONFIG_RING_BENCH_CAPACITY;
+    bench_ctx_t *ctx = heap_caps_calloc(1, sizeof(bench_ctx_t), MALLOC_CAP_INTERNAL);
+    uint32_t *storage = heap_caps_malloc(capacity * sizeof(uint32_t), MALLOC_CAP_INTERNAL);
+    _Atomic uint32_t *seq = heap_caps_malloc(capacity * sizeof(uint32_t), MALLOC_CAP_INTERNAL);
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    if (ctx == NULL || storage == NULL || seq == NULL) {
+        goto out;
+    }
+    ctx->done = xSemaphoreCreateCounting(1 + MAX_PRODUCERS, 0);
+    ctx->queue = xQueueCreate(capacity, sizeof(uint32_t));
+    if (ctx->done == NULL || ctx->queue == NULL) {
+        goto out;
+    }
+
+    ESP_LOGI(TAG, "Cross-core throughput, %d-element capacity, uint32 elements", (int)capacity);
+    ctx->items = CONFIG_RING_BENCH_ITEMS;
+    ctx->producers = 1;
+
+    ctx->mode = BENCH_QUEUE;
+    ret = run_one(ctx, "xQueue");
+
+    if (ret == ESP_OK) {
+        ring_spsc_init(&ctx->spsc, storage, sizeof(uint32_t), capacity);
+        ctx->mode = BENCH_SPSC_COPY;
+        ret = run_one(ctx, "spsc push/pop");
+    }
+    if (ret == ESP_OK) {
+        ring_spsc_init(&ctx->spsc, storage, sizeof(uint32_t), capacity);
+        ctx->mode = BENCH_SPSC_BATCH;
+        ret = run_one(ctx, "spsc batch");
+    }
+    if (ret == ESP_OK) {
+        ring_mpsc_init(&ctx->mpsc, storage, seq, sizeof(uint32_t), capacity);
+        ctx->mode = BENCH_MPSC;
+        ctx->producers = MAX_PRODUCERS;
+        ctx->items = CONFIG_RING_BENCH_ITEMS / MAX_PRODUCERS;
+        ret = run_one(ctx, "mpsc 2 prod");
+    }
+
+    if (ret == ESP_ERR_TIMEOUT) {
+        // Tasks may still be touching the buffers
+        ESP_LOGE(TAG, "Benchmark abandoned, buffers leaked");
+        return ret;
+    }
+
+out:
+    if (ret == ESP_ERR_NO_MEM) {
+        ESP_LOGE(TAG, "Out of memory");
+    }
+    if (ctx != NULL) {
+        if (ctx->queue != NULL) {
+            vQueueDelete(ctx->queue);
+        }
+        if (ctx->done != NULL) {
+            vSemaphoreDelete(ctx->done);
+        }
+    }
+    heap_caps_free(ctx);
+    heap_caps_free(storage);
+    heap_caps_free((void *)seq);
+    return ret;
+}
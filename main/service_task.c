@@ -0,0 +1,382 @@
+#include "service_task.h"
+#include "project_config.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <string.h>
+
+static const char *TAG = "ServiceTask";
+
+#define DEADLINE_NONE           INT64_MAX
+#define REMOVE_TIMEOUT_MS       500
+
+struct service_job {
+    bool in_use;
+    bool active;                // Cleared by service_job_remove()
+    bool running;               // Step in progress
+    bool wake_pending;          // Woken while running
+    service_job_config_t config;
+    int64_t deadline_us;        // DEADLINE_NONE while idle
+    TaskHandle_t task;          // Dedicated mode only
+
+    // Written only by the context running the job
+    uint32_t runs;
+    uint64_t late_sum_us;
+    uint32_t late_max_us;
+    uint32_t run_max_us;
+};
+
+static portMUX_TYPE jobs_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct service_job jobs[CONFIG_SERVICE_MAX_JOBS];
+static bool module_initialized = false;
+static TaskHandle_t service_task_handle = NULL;
+static service_job_handle_t report_job = NULL;
+
+static TickType_t ticks_until(int64_t deadline_us)
+{
+    if (deadline_us == DEADLINE_NONE) {
+        return portMAX_DELAY;
+    }
+    int64_t wait_us = deadline_us - esp_timer_get_time();
+    if (wait_us <= 0) {
+        return 0;
+    }
+    // Round up so a job is never dispatched before its deadline
+    int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+    return (TickType_t)((wait_us + tick_us - 1) / tick_us);
+}
+
+/**
+ * @brief Run one step of a job marked running and schedule the next one
+ */
+static void run_job(struct service_job *job, int64_t now)
+{
+    uint32_t late_us = now > job->deadline_us ? (uint32_t)(now - job->deadline_us) : 0;
+    job->runs++;
+    job->late_sum_us += late_us;
+    if (late_us > job->late_max_us) {
+        job->late_max_us = late_us;
+    }
+
+    uint32_t delay_ms = job->config.run(job->config.user_ctx);
+
+    int64_t done = esp_timer_get_time();
+    if ((uint32_t)(done - now) > job->run_max_us) {
+        job->run_max_us = (uint32_t)(done - now);
+    }
+
+    portENTER_CRITICAL(&jobs_lock);
+    if (job->wake_pending) {
+        job->deadline_us = done;
+    } else if (delay_ms == SERVICE_JOB_IDLE) {
+        job->deadline_us = DEADLINE_NONE;
+    } else {
+        // Relative to the deadline, not the dispatch time, so periodic jobs do not drift;
+        // an overrun job runs once more right away instead of catching up
+        job->deadline_us += (int64_t)delay_ms * 1000;
+        if (job->deadline_us < done) {
+            job->deadline_us = done;
+        }
+    }
+    job->wake_pending = false;
+    job->running = false;
+    portEXIT_CRITICAL(&jobs_lock);
+}
+
+/**
+ * @brief Shared service task: dispatch due jobs earliest deadline first
+ */
+static void service_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Service task started");
+
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        struct service_job *next = NULL;
+
+        portENTER_CRITICAL(&jobs_lock);
+        for (int i = 0; i < CONFIG_SERVICE_MAX_JOBS; i++) {
+            struct service_job *job = &jobs[i];
+            if (job->in_use && job->active && job->task == NULL &&
+                (next == NULL || job->deadline_us < next->deadline_us)) {
+                next = job;
+            }
+        }
+        int64_t next_deadline = next != NULL ? next->deadline_us : DEADLINE_NONE;
+        bool due = next_deadline <= now;
+        if (due) {
+            next->running = true;
+        }
+        portEXIT_CRITICAL(&jobs_lock);
+
+        if (due) {
+            run_job(next, now);
+        } else {
+            ulTaskNotifyTake(pdTRUE, ticks_until(next_deadline));
+        }
+    }
+}
+
+/**
+ * @brief Task body of a job in CONFIG_SERVICE_DEDICATED_TASKS mode
+ */
+static void dedicated_job_task(void *pvParameters)
+{
+    struct service_job *job = (struct service_job *)pvParameters;
+
+    while (1) {
+        int64_t now = esp_timer_get_time();
+
+        portENTER_CRITICAL(&jobs_lock);
+        bool active = job->active;
+        int64_t deadline = job->deadline_us;
+        bool due = active && deadline <= now;
+        if (due) {
+            job->running = true;
+        }
+        portEXIT_CRITICAL(&jobs_lock);
+
+        if (!active) {
+            break;
+        }
+        if (due) {
+            run_job(job, now);
+        } else {
+            ulTaskNotifyTake(pdTRUE, ticks_until(deadline));
+        }
+    }
+
+    job->task = NULL;
+    vTaskDelete(NULL);
+}
+
+static uint32_t report_job_run(void *user_ctx)
+{
+    service_log_report();
+    return CONFIG_SERVICE_REPORT_INTERVAL_MS;
+}
+
+static esp_err_t service_task_init(void)
+{
+    if (!CONFIG_SERVICE_DEDICATED_TASKS) {
+        BaseType_t task_ret = xTaskCreate(
+            service_task,
+            "service",
+            CONFIG_TASK_STACK_SERVICE,
+            NULL,
+            CONFIG_TASK_PRIORITY_SERVICE,
+            &service_task_handle
+        );
+
+        if (task_ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create service task");
+            return ESP_FAIL;
+        }
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Service jobs initialized (%s, up to %d jobs)",
+             CONFIG_SERVICE_DEDICATED_TASKS ? "dedicated tasks" : "shared task", CONFIG_SERVICE_MAX_JOBS);
+
+    // Not a module job: left out of the RAM comparison
+    const service_job_config_t report_config = {
+        .name = "service_rpt",
+        .run = report_job_run,
+        .user_ctx = NULL,
+        .first_delay_ms = CONFIG_SERVICE_REPORT_INTERVAL_MS,
+        .dedicated_stack = CONFIG_TASK_STACK_SERVICE,
+        .dedicated_priority = CONFIG_TASK_PRIORITY_SERVICE_REPORT,
+    };
+    if (service_job_add(&report_config, &report_job) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to add the service report job");
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t service_job_add(const service_job_config_t *config, service_job_handle_t *handle)
+{
+    if (config == NULL || config->run == NULL || config->name == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!module_initialized) {
+        esp_err_t ret = service_task_init();
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    struct service_job *job = NULL;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&jobs_lock);
+    for (int i = 0; i < CONFIG_SERVICE_MAX_JOBS; i++) {
+        if (!jobs[i].in_use) {
+            job = &jobs[i];
+            memset(job, 0, sizeof(*job));
+            job->in_use = true;
+            job->config = *config;
+            job->deadline_us = config->first_delay_ms == SERVICE_JOB_IDLE ?
+                               DEADLINE_NONE : now + (int64_t)config->first_delay_ms * 1000;
+            job->active = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&jobs_lock);
+
+    if (job == NULL) {
+        ESP_LOGE(TAG, "No free job slot for %s", config->name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (CONFIG_SERVICE_DEDICATED_TASKS) {
+        BaseType_t task_ret = xTaskCreate(
+            dedicated_job_task,
+            config->name,
+            config->dedicated_stack,
+            job,
+            config->dedicated_priority,
+            &job->task
+        );
+
+        if (task_ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create task for job %s", config->name);
+            job->active = false;
+            job->in_use = false;
+            return ESP_FAIL;
+        }
+    } else {
+        xTaskNotifyGive(service_task_handle);
+    }
+
+    if (handle != NULL) {
+        *handle = job;
+    }
+    ESP_LOGI(TAG, "Job %s added", config->name);
+
+    return ESP_OK;
+}
+
+esp_err_t service_job_remove(service_job_handle_t handle)
+{
+    if (handle == NULL || handle < &jobs[0] || handle >= &jobs[CONFIG_SERVICE_MAX_JOBS] || !handle->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&jobs_lock);
+    handle->active = false;
+    TaskHandle_t task = handle->task;
+    portEXIT_CRITICAL(&jobs_lock);
+
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (task != NULL && task != self) {
+        // The dedicated task leaves its loop and clears its handle
+        xTaskNotifyGive(task);
+        int timeout = REMOVE_TIMEOUT_MS / 10;
+        while (handle->task != NULL && timeout-- > 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        if (handle->task != NULL) {
+            vTaskDelete(handle->task);
+            handle->task = NULL;
+        }
+    } else if (task == NULL && self != service_task_handle) {
+        int timeout = REMOVE_TIMEOUT_MS / 10;
+        while (handle->running && timeout-- > 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+
+    ESP_LOGI(TAG, "Job %s removed", handle->config.name);
+    handle->in_use = false;
+
+    return ESP_OK;
+}
+
+void service_job_wake(service_job_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&jobs_lock);
+    if (handle->running) {
+        handle->wake_pending = true;
+    } else if (handle->deadline_us > now) {
+        handle->deadline_us = now;
+    }
+    TaskHandle_t task = handle->task != NULL ? handle->task : service_task_handle;
+    portEXIT_CRITICAL(&jobs_lock);
+
+    if (task != NULL) {
+        xTaskNotifyGive(task);
+    }
+}
+
+size_t service_get_job_stats(service_job_stats_t *stats, size_t max_jobs)
+{
+    size_t count = 0;
+
+    for (int i = 0; i < CONFIG_SERVICE_MAX_JOBS && count < max_jobs; i++) {
+        const struct service_job *job = &jobs[i];
+        if (!job->in_use) {
+            continue;
+        }
+        stats[count++] = (service_job_stats_t) {
+            .name = job->config.name,
+            .runs = job->runs,
+            .late_mean_us = job->runs > 0 ? (uint32_t)(job->late_sum_us / job->runs) : 0,
+            .late_max_us = job->late_max_us,
+            .run_max_us = job->run_max_us,
+            .dedicated_stack = job->config.dedicated_stack,
+        };
+    }
+
+    return count;
+}
+
+void service_log_report(void)
+{
+    if (!module_initialized) {
+        return;
+    }
+
+    int module_jobs = 0;
+    uint32_t dedicated_bytes = 0;
+    uint32_t dedicated_peak = 0;
+
+    for (int i = 0; i < CONFIG_SERVICE_MAX_JOBS; i++) {
+        const struct service_job *job = &jobs[i];
+        if (!job->in_use) {
+            continue;
+        }
+
+        uint32_t late_mean = job->runs > 0 ? (uint32_t)(job->late_sum_us / job->runs) : 0;
+        ESP_LOGI(TAG, "  %-14s %6lu runs, late mean %5lu us max %6lu us, step max %6lu us",
+                 job->config.name, (unsigned long)job->runs, (unsigned long)late_mean,
+                 (unsigned long)job->late_max_us, (unsigned long)job->run_max_us);
+
+        if (job == report_job) {
+            continue;
+        }
+        module_jobs++;
+        dedicated_bytes += job->config.dedicated_stack;
+        TaskHandle_t task = job->task;
+        if (task != NULL) {
+            dedicated_peak += job->config.dedicated_stack - uxTaskGetStackHighWaterMark(task);
+        }
+    }
+
+    if (CONFIG_SERVICE_DEDICATED_TASKS) {
+        ESP_LOGI(TAG, "%d module jobs on dedicated tasks: %lu B of stack, %lu B peak use",
+                 module_jobs, (unsigned long)dedicated_bytes, (unsigned long)dedicated_peak);
+    } else {
+        uint32_t peak = CONFIG_TASK_STACK_SERVICE - uxTaskGetStackHighWaterMark(service_task_handle);
+        ESP_LOGI(TAG, "%d module jobs on one task: %d B of stack (%lu B peak use) instead of %lu B, %ld B saved",
+                 module_jobs, CONFIG_TASK_STACK_SERVICE, (unsigned long)peak, (unsigned long)dedicated_bytes,
+                 (long)dedicated_bytes - CONFIG_TASK_STACK_SERVICE);
+    }
+}
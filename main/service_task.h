@@ -0,0 +1,120 @@
+#ifndef SERVICE_TASK_H
+#define SERVICE_TASK_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file service_task.h
+ * @brief Cooperative jobs sharing one service task
+ *
+ * Low-rate periodic and event-driven module work runs as jobs on a single
+ * task instead of one mostly sleeping task per module. A job is a
+ * non-blocking step function: it does one round of work, keeps its state in
+ * its own context and returns how long until it wants to run again. Due
+ * jobs are dispatched earliest deadline first; the task sleeps until the
+ * next deadline or a wake.
+ *
+ * Every job records how late it was dispatched and how long it ran. With
+ * CONFIG_SERVICE_DEDICATED_TASKS each job gets its own task again, running
+ * the same step function with the same bookkeeping, so both layouts can be
+ * compared from the periodic report.
+ */
+
+/**
+ * @brief Returned by a job to sleep until service_job_wake()
+ */
+#define SERVICE_JOB_IDLE    UINT32_MAX
+
+/**
+ * @brief Job step function
+ *
+ * Must not block for longer than a short bus transaction; every other job
+ * waits while it runs.
+ *
+ * @param user_ctx Context given in the job configuration
+ * @return Milliseconds from this run's deadline to the next run, or SERVICE_JOB_IDLE
+ */
+typedef uint32_t (*service_job_fn_t)(void *user_ctx);
+
+/**
+ * @brief Job configuration
+ */
+typedef struct {
+    const char *name;               // Task name in dedicated mode, report label
+    service_job_fn_t run;
+    void *user_ctx;
+    uint32_t first_delay_ms;        // Delay before the first run, SERVICE_JOB_IDLE to wait for a wake
+    uint32_t dedicated_stack;       // Stack the job would need as its own task (bytes)
+    UBaseType_t dedicated_priority; // Priority the job would have as its own task
+} service_job_config_t;
+
+typedef struct service_job *service_job_handle_t;
+
+/**
+ * @brief Per-job dispatch statistics
+ */
+typedef struct {
+    const char *name;
+    uint32_t runs;
+    uint32_t late_mean_us;          // Dispatch time minus deadline
+    uint32_t late_max_us;
+    uint32_t run_max_us;            // Longest step
+    uint32_t dedicated_stack;
+} service_job_stats_t;
+
+/**
+ * @brief Add a job, starting the service task on first use
+ *
+ * @param config Job configuration, copied
+ * @param handle Pointer to store the job handle (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM when the
+ *         job table is full, ESP_FAIL if the task cannot be created
+ */
+esp_err_t service_job_add(const service_job_config_t *config, service_job_handle_t *handle);
+
+/**
+ * @brief Remove a job
+ *
+ * Waits for a step in progress to finish unless called from the job itself.
+ *
+ * @param handle Job handle
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an unknown handle
+ */
+esp_err_t service_job_remove(service_job_handle_t handle);
+
+/**
+ * @brief Run a job as soon as possible
+ *
+ * A wake during a step makes the job run again right after it.
+ *
+ * @param handle Job handle (NULL is ignored)
+ */
+void service_job_wake(service_job_handle_t handle);
+
+/**
+ * @brief Get dispatch statistics of all jobs
+ *
+ * @param stats Array to fill
+ * @param max_jobs Size of the array
+ * @return Number of jobs written
+ */
+size_t service_get_job_stats(service_job_stats_t *stats, size_t max_jobs);
+
+/**
+ * @brief Log per-job jitter and the stack RAM saved against dedicated tasks
+ */
+void service_log_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SERVICE_TASK_H
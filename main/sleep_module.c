@@ -0,0 +1,375 @@
+#include "sleep_module.h"
+#include "project_config.h"
+#include "presence_module.h"
+#include "coproc_module.h"
+#include "mpu6050_module.h"
+#include "time_module.h"
+#include "display_module.h"
+#include "resume_state.h"
+#include <driver/rtc_io.h>
+#include <esp_log.h>
+#include <esp_private/esp_clk.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <soc/rtc.h>
+#include <soc/rtc_cntl_reg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ulp_riscv.h>
+#include "ulp_main.h"
+
+static const char *TAG = "SleepModule";
+
+extern const uint8_t ulp_main_bin_start[] asm("_binary_ulp_main_bin_start");
+extern const uint8_t ulp_main_bin_end[] asm("_binary_ulp_main_bin_end");
+
+/**
+ * @brief Bookkeeping that has to survive deep sleep
+ */
+typedef struct {
+    uint32_t sleeps;
+    uint32_t wakes_arrival;
+    uint32_t wakes_alarm;
+    int64_t sleep_enter_us;         // Wall clock (RTC timer) at sleep entry
+    uint64_t total_sleep_us;
+    double total_charge_uas;        // Estimated charge drawn while asleep (uA * s)
+    float last_sleep_current_ua;
+    uint32_t last_wake_latency_ms;
+    uint64_t wake_latency_sum_ms;
+    uint32_t wake_latency_count;
+    uint32_t last_pir_events;
+    uint32_t last_motion_events;
+    uint32_t last_arrivals;
+    uint32_t last_i2c_errors;
+} sleep_rtc_record_t;
+
+static RTC_DATA_ATTR sleep_rtc_record_t rtc_record;
+
+// RTC slow clock count taken by the wake stub, before the bootloader loads and checks the app
+static RTC_DATA_ATTR uint64_t wake_rtc_ticks = 0;
+
+// Module state
+static bool module_initialized = false;
+static TaskHandle_t sleep_task_handle = NULL;
+static sleep_wake_reason_t wake_reason = SLEEP_WAKE_COLD_BOOT;
+static bool latency_recorded = false;
+
+static int64_t get_wall_clock_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**
+ * @brief Fold the ULP counters of the sleep that just ended into the record
+ */
+static void account_finished_sleep(void)
+{
+    int64_t slept_us = get_wall_clock_us() - rtc_record.sleep_enter_us;
+    if (slept_us <= 0) {
+        return;
+    }
+
+    // Chip and sensors draw a constant base; the ULP adds its active time share
+    double ulp_duty = (double)ulp_active_us_total / (double)slept_us;
+    float current_ua = CONFIG_DEEP_SLEEP_BASE_CURRENT_UA + CONFIG_DEEP_SLEEP_SENSORS_CURRENT_UA +
+                       (float)(ulp_duty * CONFIG_ULP_ACTIVE_CURRENT_UA);
+
+    rtc_record.total_sleep_us += (uint64_t)slept_us;
+    rtc_record.total_charge_uas += (double)current_ua * ((double)slept_us / 1000000.0);
+    rtc_record.last_sleep_current_ua = current_ua;
+    rtc_record.last_pir_events = ulp_pir_events;
+    rtc_record.last_motion_events = ulp_motion_events;
+    rtc_record.last_arrivals = ulp_arrivals;
+    rtc_record.last_i2c_errors = ulp_i2c_errors;
+
+    ESP_LOGI(TAG, "Slept %lu s: ~%.1f uA average (ULP %lu runs, max %lu us/run) | PIR %lu, motion %lu, arrivals %lu, I2C errors %lu",
+             (unsigned long)(slept_us / 1000000), current_ua, (unsigned long)ulp_runs,
+             (unsigned long)ulp_active_us_max, (unsigned long)ulp_pir_events,
+             (unsigned long)ulp_motion_events, (unsigned long)ulp_arrivals, (unsigned long)ulp_i2c_errors);
+}
+
+/**
+ * @brief Deep sleep supervision task
+ */
+static void sleep_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Sleep task started");
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_DEEP_SLEEP_POLL_INTERVAL_MS));
+
+        if (presence_get_state() != PRESENCE_STATE_AWAY ||
+            presence_get_seconds_in_state() < CONFIG_DEEP_SLEEP_AFTER_AWAY_S) {
+            continue;
+        }
+
+        // Wait for the co-processor orchestration to bring it down first
+        if (coproc_prepare_deep_sleep() != ESP_OK) {
+            ESP_LOGD(TAG, "Co-processor still up, postponing deep sleep");
+            continue;
+        }
+
+        sleep_enter_deep();
+        coproc_cancel_deep_sleep();
+        ESP_LOGE(TAG, "Deep sleep entry failed, staying awake");
+    }
+}
+
+esp_err_t sleep_module_init(void)
+{
+    if (module_initialized) {
+        return ESP_OK;
+    }
+
+    switch (esp_sleep_get_wakeup_cause()) {
+        case ESP_SLEEP_WAKEUP_UNDEFINED:
+            wake_reason = SLEEP_WAKE_COLD_BOOT;
+            break;
+        case ESP_SLEEP_WAKEUP_ULP:
+            wake_reason = SLEEP_WAKE_ARRIVAL;
+            rtc_record.wakes_arrival++;
+            break;
+        case ESP_SLEEP_WAKEUP_EXT0:
+            wake_reason = SLEEP_WAKE_ALARM;
+            rtc_record.wakes_alarm++;
+            break;
+        default:
+            wake_reason = SLEEP_WAKE_OTHER;
+            break;
+    }
+
+    if (wake_reason != SLEEP_WAKE_COLD_BOOT) {
+        // The ULP timer keeps running after wakeup; stop it before reading its counters
+        ulp_riscv_timer_stop();
+        account_finished_sleep();
+        rtc_gpio_deinit(CONFIG_PIR_OUTPUT_GPIO);
+        rtc_gpio_deinit(CONFIG_I2C1_SDA_GPIO);
+        rtc_gpio_deinit(CONFIG_I2C1_SCL_GPIO);
+        rtc_gpio_deinit(CONFIG_DS3231_INT_GPIO);
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Sleep module initialized (wake reason: %s)", sleep_wake_reason_to_string(wake_reason));
+
+    return ESP_OK;
+}
+
+esp_err_t sleep_module_start(void)
+{
+    if (!module_initialized) {
+        return ESP_FAIL;
+    }
+    if (sleep_task_handle != NULL) {
+        return ESP_OK;
+    }
+
+    if (wake_reason == SLEEP_WAKE_ALARM) {
+        time_module_clear_alarm_flag();
+    }
+
+    BaseType_t task_ret = xTaskCreate(
+        sleep_task,
+        "sleep_task",
+        CONFIG_TASK_STACK_SLEEP,
+        NULL,
+        CONFIG_TASK_PRIORITY_SLEEP,
+        &sleep_task_handle
+    );
+
+    if (task_ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create sleep task");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Deep sleep after %ds away, daily alarm %02d:%02d",
+             CONFIG_DEEP_SLEEP_AFTER_AWAY_S, CONFIG_DEEP_SLEEP_ALARM_HOUR, CONFIG_DEEP_SLEEP_ALARM_MINUTE);
+    return ESP_OK;
+}
+
+/**
+ * @brief Deep sleep wake stub, runs from RTC fast memory right after the wakeup
+ *
+ * Only RTC memory and registers are usable here, so the RTC timer is read
+ * directly rather than through esp_rtc_get_time_us().
+ */
+void RTC_IRAM_ATTR esp_wake_deep_sleep(void)
+{
+    SET_PERI_REG_MASK(RTC_CNTL_TIME_UPDATE_REG, RTC_CNTL_TIME_UPDATE);
+    uint64_t ticks = READ_PERI_REG(RTC_CNTL_TIME0_REG);
+    ticks |= (uint64_t)READ_PERI_REG(RTC_CNTL_TIME1_REG) << 32;
+    wake_rtc_ticks = ticks;
+    esp_default_wake_deep_sleep();
+}
+
+sleep_wake_reason_t sleep_get_wake_reason(void)
+{
+    return wake_reason;
+}
+
+uint32_t sleep_get_ms_since_wake(void)
+{
+    if (wake_reason == SLEEP_WAKE_COLD_BOOT || wake_rtc_ticks == 0) {
+        return (uint32_t)(esp_timer_get_time() / 1000);
+    }
+    uint64_t ticks = rtc_time_get() - wake_rtc_ticks;
+    return (uint32_t)(rtc_time_slowclk_to_us(ticks, esp_clk_slowclk_cal_get()) / 1000);
+}
+
+void sleep_mark_main_screen_ready(void)
+{
+    if (wake_reason == SLEEP_WAKE_COLD_BOOT || latency_recorded) {
+        return;
+    }
+    latency_recorded = true;
+
+    uint32_t latency_ms = sleep_get_ms_since_wake();
+    rtc_record.last_wake_latency_ms = latency_ms;
+    rtc_record.wake_latency_sum_ms += latency_ms;
+    rtc_record.wake_latency_count++;
+
+    ESP_LOGI(TAG, "Wake (%s) -> main screen in %lu ms (avg %lu ms over %lu wakes)",
+             sleep_wake_reason_to_string(wake_reason), (unsigned long)latency_ms,
+             (unsigned long)(rtc_record.wake_latency_sum_ms / rtc_record.wake_latency_count),
+             (unsigned long)rtc_record.wake_latency_count);
+}
+
+/**
+ * @brief Bring back what sleep_enter_deep() took down when the ULP could not be started
+ */
+static void abort_deep_sleep(int brightness, bool mpu_handed_over)
+{
+    ulp_riscv_timer_stop();
+    if (mpu_handed_over && mpu6050_module_init() != ESP_OK) {
+        ESP_LOGW(TAG, "MPU6050 not back after the aborted sleep, continuing without motion");
+    }
+    time_module_start_display_updates();
+    display_set_brightness(brightness);
+}
+
+esp_err_t sleep_enter_deep(void)
+{
+    ESP_LOGI(TAG, "Entering deep sleep with ULP presence monitoring");
+
+    // Load before anything is torn down, so a bad image leaves the device as it was
+    esp_err_t ret = ulp_riscv_load_binary(ulp_main_bin_start, ulp_main_bin_end - ulp_main_bin_start);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to load ULP program: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Before the display goes dark, so the snapshot holds the user's brightness
+    resume_state_save();
+
+    int brightness = display_get_brightness();
+    time_module_stop_display_updates();
+    display_set_brightness(0);
+
+    if (time_module_set_alarm(CONFIG_DEEP_SLEEP_ALARM_HOUR, CONFIG_DEEP_SLEEP_ALARM_MINUTE) != ESP_OK) {
+        ESP_LOGW(TAG, "DS3231 alarm not set, only arrivals will wake the device");
+    }
+
+    // Hand the MPU6050 bus to the ULP; without it the ULP watches the PIR only
+    bool use_mpu = false;
+    if (CONFIG_ULP_USE_MPU6050 &&
+        mpu6050_enable_motion_wake(CONFIG_ULP_MOTION_THRESHOLD_MG, CONFIG_ULP_MOTION_DURATION_MS) == ESP_OK) {
+        mpu6050_module_deinit();
+        use_mpu = true;
+    }
+
+    ulp_pir_gpio = CONFIG_PIR_OUTPUT_GPIO;
+    ulp_sda_gpio = CONFIG_I2C1_SDA_GPIO;
+    ulp_scl_gpio = CONFIG_I2C1_SCL_GPIO;
+    ulp_mpu_addr = CONFIG_MPU6050_I2C_ADDR;
+    ulp_use_mpu = use_mpu ? 1 : 0;
+    ulp_confirm_pir_edges = CONFIG_ULP_CONFIRM_PIR_EDGES;
+    ulp_confirm_window_runs = (CONFIG_ULP_CONFIRM_WINDOW_S * 1000) / CONFIG_ULP_POLL_PERIOD_MS;
+
+    ulp_set_wakeup_period(0, CONFIG_ULP_POLL_PERIOD_MS * 1000);
+    ret = ulp_riscv_run();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start ULP program: %s", esp_err_to_name(ret));
+        abort_deep_sleep(brightness, use_mpu);
+        return ret;
+    }
+
+    // DS3231 INT/SQW is open drain, active low
+    rtc_gpio_init(CONFIG_DS3231_INT_GPIO);
+    rtc_gpio_pullup_en(CONFIG_DS3231_INT_GPIO);
+    rtc_gpio_pulldown_dis(CONFIG_DS3231_INT_GPIO);
+
+    esp_sleep_enable_ulp_wakeup();
+    esp_sleep_enable_ext0_wakeup(CONFIG_DS3231_INT_GPIO, 0);
+
+    rtc_record.sleeps++;
+    rtc_record.sleep_enter_us = get_wall_clock_us();
+    wake_rtc_ticks = 0;     // Set again by the wake stub
+
+    ESP_LOGI(TAG, "Sleeping (ULP every %d ms, MPU6050 %s)", CONFIG_ULP_POLL_PERIOD_MS, use_mpu ? "on" : "off");
+    esp_deep_sleep_start();
+
+    return ESP_FAIL;
+}
+
+esp_err_t sleep_get_stats(sleep_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_FAIL;
+    }
+
+    memset(stats, 0, sizeof(sleep_stats_t));
+    stats->sleeps = rtc_record.sleeps;
+    stats->wakes_arrival = rtc_record.wakes_arrival;
+    stats->wakes_alarm = rtc_record.wakes_alarm;
+    stats->total_sleep_s = (uint32_t)(rtc_record.total_sleep_us / 1000000);
+    if (rtc_record.total_sleep_us > 0) {
+        stats->avg_sleep_current_ua = (float)(rtc_record.total_charge_uas / ((double)rtc_record.total_sleep_us / 1000000.0));
+    }
+    stats->last_sleep_current_ua = rtc_record.last_sleep_current_ua;
+    stats->last_wake_latency_ms = rtc_record.last_wake_latency_ms;
+    if (rtc_record.wake_latency_count > 0) {
+        stats->avg_wake_latency_ms = (uint32_t)(rtc_record.wake_latency_sum_ms / rtc_record.wake_latency_count);
+    }
+    stats->last_pir_events = rtc_record.last_pir_events;
+    stats->last_motion_events = rtc_record.last_motion_events;
+    stats->last_arrivals = rtc_record.last_arrivals;
+    stats->last_i2c_errors = rtc_record.last_i2c_errors;
+
+    return ESP_OK;
+}
+
+esp_err_t sleep_get_status_string(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_FAIL;
+    }
+
+    sleep_stats_t s;
+    sleep_get_stats(&s);
+    resume_stats_t r;
+    resume_state_get_stats(&r);
+    if (s.sleeps == 0) {
+        snprintf(buffer, buffer_size, "Sleep: none since power-on");
+    } else {
+        snprintf(buffer, buffer_size, "Sleep: %lu (%luh), ~%.0f uA avg, wake %lu ms avg, %lu over budget",
+                 (unsigned long)s.sleeps, (unsigned long)(s.total_sleep_s / 3600),
+                 s.avg_sleep_current_ua, (unsigned long)s.avg_wake_latency_ms,
+                 (unsigned long)r.budget_misses);
+    }
+    return ESP_OK;
+}
+
+const char* sleep_wake_reason_to_string(sleep_wake_reason_t reason)
+{
+    switch (reason) {
+        case SLEEP_WAKE_COLD_BOOT:  return "cold boot";
+        case SLEEP_WAKE_ARRIVAL:    return "arrival";
+        case SLEEP_WAKE_ALARM:      return "alarm";
+        case SLEEP_WAKE_OTHER:      return "other";
+        default:                    return "unknown";
+    }
+}
@@ -0,0 +1,130 @@
+#ifndef SLEEP_MODULE_H
+#define SLEEP_MODULE_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file sleep_module.h
+ * @brief Deep sleep with ULP RISC-V presence monitoring
+ *
+ * After a long absence the main cores go to deep sleep. The ULP RISC-V
+ * coprocessor keeps watching the PIR output (and optionally the MPU6050
+ * motion interrupt) and wakes the main cores on a confirmed arrival; the
+ * DS3231 daily alarm wakes them on schedule.
+ */
+
+/**
+ * @brief Why the firmware is running
+ */
+typedef enum {
+    SLEEP_WAKE_COLD_BOOT,   // Power-on or reset, not a deep sleep wakeup
+    SLEEP_WAKE_ARRIVAL,     // ULP confirmed an arrival
+    SLEEP_WAKE_ALARM,       // DS3231 scheduled alarm
+    SLEEP_WAKE_OTHER        // Any other wakeup source
+} sleep_wake_reason_t;
+
+/**
+ * @brief Deep sleep statistics, kept in RTC memory across sleeps
+ */
+typedef struct {
+    uint32_t sleeps;                    // Deep sleeps entered since power-on
+    uint32_t wakes_arrival;
+    uint32_t wakes_alarm;
+    uint32_t total_sleep_s;             // Time spent in deep sleep
+    float avg_sleep_current_ua;         // Estimated average over all sleeps
+    float last_sleep_current_ua;        // Estimated average over the last sleep
+    uint32_t last_wake_latency_ms;      // Wakeup -> main screen, last wake
+    uint32_t avg_wake_latency_ms;       // Wakeup -> main screen, all wakes
+    uint32_t last_pir_events;           // ULP counters of the last sleep
+    uint32_t last_motion_events;
+    uint32_t last_arrivals;
+    uint32_t last_i2c_errors;
+} sleep_stats_t;
+
+/**
+ * @brief Process the wakeup cause and reclaim pins held during sleep
+ *
+ * Call first in app_main(): the wake reason selects the full boot or the fast resume.
+ *
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t sleep_module_init(void);
+
+/**
+ * @brief Start the task that enters deep sleep after a long absence
+ *
+ * Requires presence_module_init() and time_module_init().
+ *
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t sleep_module_start(void);
+
+/**
+ * @brief Get why the firmware is running
+ *
+ * @return Wake reason of the current boot
+ */
+sleep_wake_reason_t sleep_get_wake_reason(void);
+
+/**
+ * @brief Get the time since the deep sleep wakeup
+ *
+ * Counted from the wake stub, so ROM, bootloader and image loading are
+ * included. After a cold boot, counted from application start.
+ *
+ * @return Milliseconds since the wakeup
+ */
+uint32_t sleep_get_ms_since_wake(void);
+
+/**
+ * @brief Record that the main screen is shown, for wake latency statistics
+ */
+void sleep_mark_main_screen_ready(void);
+
+/**
+ * @brief Enter deep sleep with ULP presence monitoring
+ *
+ * Does not return on success. On failure the display, clock updates and
+ * MPU6050 are back as they were; the caller releases the co-processor holds.
+ *
+ * @return Error from the ULP loader if the ULP program could not be loaded or started
+ */
+esp_err_t sleep_enter_deep(void);
+
+/**
+ * @brief Get deep sleep statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t sleep_get_stats(sleep_stats_t *stats);
+
+/**
+ * @brief Get formatted deep sleep summary for the diagnostics screen
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 80 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t sleep_get_status_string(char *buffer, size_t buffer_size);
+
+/**
+ * @brief Get printable name of a wake reason
+ *
+ * @param reason Wake reason
+ * @return Constant string
+ */
+const char* sleep_wake_reason_to_string(sleep_wake_reason_t reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SLEEP_MODULE_H
@@ -0,0 +1,187 @@
+#include "sound_fx.h"
+#include "coproc_module.h"
+#include "mpu6050_module.h"
+#include "project_config.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+
+static const char *TAG = "SoundFx";
+
+#define PENDING_SLOTS           8       // Power of two, indexed by seq
+
+/**
+ * @brief SFX_PLAY waiting for its SFX_STARTED
+ */
+typedef struct {
+    bool waiting;
+    uint8_t seq;
+    int64_t event_us;
+    int64_t sent_us;
+} pending_play_t;
+
+// Module state
+static bool module_initialized = false;
+static portMUX_TYPE fx_lock = portMUX_INITIALIZER_UNLOCKED;
+static pending_play_t pending[PENDING_SLOTS];
+static uint8_t next_seq = 0;
+
+// Statistics
+static sound_fx_stats_t stats = {0};
+static uint64_t latency_sum_us = 0;
+static uint64_t link_sum_us = 0;
+
+static const uint8_t effect_gain[COPROC_SFX_COUNT] = {
+    [COPROC_SFX_TAP] = CONFIG_SOUND_FX_GAIN_TAP,
+    [COPROC_SFX_SHAKE] = CONFIG_SOUND_FX_GAIN_SHAKE,
+    [COPROC_SFX_PRESS] = CONFIG_SOUND_FX_GAIN_PRESS,
+};
+
+static void on_sfx_started(uint8_t type, const uint8_t *payload, size_t len, void *user_ctx)
+{
+    int64_t now_us = esp_timer_get_time();
+    coproc_sfx_started_t report;
+    if (len < sizeof(report)) {
+        return;
+    }
+    memcpy(&report, payload, sizeof(report));
+
+    pending_play_t *slot = &pending[report.seq & (PENDING_SLOTS - 1)];
+    taskENTER_CRITICAL(&fx_lock);
+    bool matched = slot->waiting && slot->seq == report.seq;
+    pending_play_t play = *slot;
+    slot->waiting = false;
+    taskEXIT_CRITICAL(&fx_lock);
+    if (!matched) {
+        ESP_LOGD(TAG, "SFX_STARTED %u without a pending request", report.seq);
+        return;
+    }
+
+    // Half the round trip without the co-processor's time is the one-way link delay
+    int64_t round_trip_us = now_us - play.sent_us - report.held_us;
+    uint32_t link_us = round_trip_us > 0 ? (uint32_t)(round_trip_us / 2) : 0;
+    uint32_t latency_us = (uint32_t)(play.sent_us - play.event_us) + link_us + report.until_sound_us;
+
+    taskENTER_CRITICAL(&fx_lock);
+    if (report.flags & COPROC_SFX_FLAG_DROPPED) {
+        stats.dropped++;
+    } else {
+        stats.started++;
+        if (report.flags & COPROC_SFX_FLAG_STOLEN) {
+            stats.stolen++;
+        }
+        latency_sum_us += latency_us;
+        link_sum_us += link_us;
+        stats.last_latency_us = latency_us;
+        stats.mean_latency_us = (uint32_t)(latency_sum_us / stats.started);
+        stats.mean_link_us = (uint32_t)(link_sum_us / stats.started);
+        if (latency_us > stats.max_latency_us) {
+            stats.max_latency_us = latency_us;
+        }
+    }
+    stats.mixer_load_permille = report.mixer_load;
+    sound_fx_stats_t snapshot = stats;
+    taskEXIT_CRITICAL(&fx_lock);
+
+    if (report.flags & COPROC_SFX_FLAG_DROPPED) {
+        ESP_LOGW(TAG, "Effect %u not played by the co-processor", report.seq);
+        return;
+    }
+    ESP_LOGD(TAG, "Effect %u sounding %lu us after the event (link %lu us, %u voices, mixer %u.%u%%)",
+             report.seq, (unsigned long)latency_us, (unsigned long)link_us, report.voices,
+             report.mixer_load / 10, report.mixer_load % 10);
+    if (snapshot.started % CONFIG_SOUND_FX_REPORT_EVERY == 0) {
+        ESP_LOGI(TAG, "%lu effects: trigger -> sound mean %lu us, max %lu us (link %lu us), %lu stolen, %lu link busy, mixer %u.%u%% CPU",
+                 (unsigned long)snapshot.started, (unsigned long)snapshot.mean_latency_us,
+                 (unsigned long)snapshot.max_latency_us, (unsigned long)snapshot.mean_link_us,
+                 (unsigned long)snapshot.stolen, (unsigned long)snapshot.busy, report.mixer_load / 10, report.mixer_load % 10);
+    }
+}
+
+static void on_gesture(mpu6050_gesture_t gesture, int64_t timestamp_us, void *user_ctx)
+{
+    sound_fx_play(gesture == MPU6050_GESTURE_SHAKE ? COPROC_SFX_SHAKE : COPROC_SFX_TAP, timestamp_us);
+}
+
+esp_err_t sound_fx_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Sound effects already initialized");
+        return ESP_OK;
+    }
+
+    esp_err_t ret = coproc_link_register_handler(COPROC_MSG_SFX_STARTED, on_sfx_started, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register SFX_STARTED handler: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    module_initialized = true;
+#if CONFIG_SOUND_FX_ENABLE
+    mpu6050_set_gesture_listener(on_gesture, NULL);
+    ESP_LOGI(TAG, "Sound effects on tap and shake");
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t sound_fx_play(coproc_sfx_t effect, int64_t event_us)
+{
+    if (effect >= COPROC_SFX_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!module_initialized || coproc_get_state() != COPROC_STATE_RUNNING) {
+        taskENTER_CRITICAL(&fx_lock);
+        stats.skipped++;
+        taskEXIT_CRITICAL(&fx_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    if (event_us <= 0 || event_us > now_us) {
+        event_us = now_us;
+    }
+
+    taskENTER_CRITICAL(&fx_lock);
+    uint8_t seq = next_seq++;
+    pending_play_t *slot = &pending[seq & (PENDING_SLOTS - 1)];
+    slot->waiting = true;
+    slot->seq = seq;
+    slot->event_us = event_us;
+    slot->sent_us = now_us;
+    stats.requested++;
+    taskEXIT_CRITICAL(&fx_lock);
+
+    coproc_sfx_play_t request = {
+        .seq = seq,
+        .effect = (uint8_t)effect,
+        .gain = effect_gain[effect],
+        .flags = 0,
+        .event_age_us = (uint32_t)(now_us - event_us),
+    };
+    // Called from the motion job, so never wait for the link: a late effect is worse than none
+    esp_err_t ret = coproc_link_try_send(COPROC_MSG_SFX_PLAY, &request, sizeof(request));
+    if (ret != ESP_OK) {
+        taskENTER_CRITICAL(&fx_lock);
+        slot->waiting = false;
+        stats.requested--;
+        if (ret == ESP_ERR_TIMEOUT) {
+            stats.busy++;
+        }
+        taskEXIT_CRITICAL(&fx_lock);
+    }
+    return ret;
+}
+
+esp_err_t sound_fx_get_stats(sound_fx_stats_t *out)
+{
+    if (out == NULL) {
+        return ESP_FAIL;
+    }
+
+    taskENTER_CRITICAL(&fx_lock);
+    *out = stats;
+    taskEXIT_CRITICAL(&fx_lock);
+    return ESP_OK;
+}
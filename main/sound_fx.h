@@ -0,0 +1,80 @@
+#ifndef SOUND_FX_H
+#define SOUND_FX_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "coproc_link.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file sound_fx.h
+ * @brief Audible feedback for tap, shake and press, played by the co-processor
+ *
+ * The speaker is driven by the co-processor, which keeps the effects decoded
+ * in memory and mixes them over speech (tools/sfx_mixer.py). Gestures go out
+ * as SFX_PLAY straight from the motion job, without waiting for the main
+ * loop to poll the status flags. The job never blocks on the link: when
+ * another frame is being sent or the UART buffer is full, the effect is
+ * dropped and counted as busy.
+ *
+ * Every SFX_STARTED report gives one trigger-to-sound estimate: event ->
+ * message sent, plus half the link round trip without the co-processor's
+ * own time, plus the co-processor's receipt -> first sample at the DAC.
+ */
+
+/**
+ * @brief Sound effect statistics
+ */
+typedef struct {
+    uint32_t requested;             // SFX_PLAY sent
+    uint32_t skipped;               // Co-processor not running, not sent
+    uint32_t busy;                  // Link busy, effect dropped
+    uint32_t started;               // SFX_STARTED received
+    uint32_t dropped;               // SFX_STARTED with COPROC_SFX_FLAG_DROPPED
+    uint32_t stolen;                // Started by cutting the oldest voice
+    uint32_t last_latency_us;       // Trigger -> sound estimate
+    uint32_t mean_latency_us;
+    uint32_t max_latency_us;
+    uint32_t mean_link_us;          // One-way link delay estimate
+    uint16_t mixer_load_permille;   // Last reported mixer CPU
+} sound_fx_stats_t;
+
+/**
+ * @brief Register the link handler and the gesture listener
+ *
+ * Call after coproc_module_init() and mpu6050_module_init().
+ *
+ * @return ESP_OK on success, error code from the link otherwise
+ */
+esp_err_t sound_fx_init(void);
+
+/**
+ * @brief Ask the co-processor to play an effect
+ *
+ * Does not block; safe to call from service jobs.
+ *
+ * @param effect Effect to play
+ * @param event_us esp_timer time of the triggering event (0 = now)
+ * @return ESP_OK when sent, ESP_ERR_INVALID_STATE if the co-processor is not
+ *         running, ESP_ERR_TIMEOUT if the link is busy (effect dropped),
+ *         ESP_ERR_INVALID_ARG for an unknown effect
+ */
+esp_err_t sound_fx_play(coproc_sfx_t effect, int64_t event_us);
+
+/**
+ * @brief Get sound effect statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t sound_fx_get_stats(sound_fx_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SOUND_FX_H
@@ -0,0 +1,270 @@
+#include "status_bar.h"
+#include "project_config.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "StatusBar";
+
+#define STATUS_SLOT_MARGIN          10
+#define STATUS_SLOT_HEIGHT          18
+#define STATUS_SLOT_LINE_PITCH      20
+#define STATUS_SLOT_LEFT_WIDTH      220
+#define STATUS_SLOT_RIGHT_WIDTH     160
+
+/**
+ * @brief Slot rectangle relative to the widget
+ */
+typedef struct {
+    lv_coord_t x;
+    lv_coord_t y;
+    lv_coord_t w;
+    lv_text_align_t align;
+} status_slot_layout_t;
+
+// Same positions the per-field labels had on the main screen
+static const status_slot_layout_t slot_layout[STATUS_SLOT_COUNT] = {
+    [STATUS_SLOT_ACTION]    = { STATUS_SLOT_MARGIN, STATUS_SLOT_MARGIN,
+                                STATUS_SLOT_LEFT_WIDTH, LV_TEXT_ALIGN_LEFT },
+    [STATUS_SLOT_PIR]       = { STATUS_SLOT_MARGIN, STATUS_SLOT_MARGIN + STATUS_SLOT_LINE_PITCH,
+                                STATUS_SLOT_LEFT_WIDTH, LV_TEXT_ALIGN_LEFT },
+    [STATUS_SLOT_MOTION]    = { STATUS_SLOT_MARGIN, STATUS_SLOT_MARGIN + 2 * STATUS_SLOT_LINE_PITCH,
+                                STATUS_SLOT_LEFT_WIDTH, LV_TEXT_ALIGN_LEFT },
+    [STATUS_SLOT_WEATHER]   = { CONFIG_DISPLAY_WIDTH - STATUS_SLOT_MARGIN - STATUS_SLOT_RIGHT_WIDTH, STATUS_SLOT_MARGIN,
+                                STATUS_SLOT_RIGHT_WIDTH, LV_TEXT_ALIGN_RIGHT },
+    [STATUS_SLOT_ASSISTANT] = { STATUS_SLOT_MARGIN, CONFIG_DISPLAY_HEIGHT - STATUS_SLOT_MARGIN - STATUS_SLOT_HEIGHT,
+                                STATUS_SLOT_LEFT_WIDTH, LV_TEXT_ALIGN_LEFT },
+    [STATUS_SLOT_WIFI]      = { CONFIG_DISPLAY_WIDTH - STATUS_SLOT_MARGIN - STATUS_SLOT_RIGHT_WIDTH,
+                                CONFIG_DISPLAY_HEIGHT - STATUS_SLOT_MARGIN - STATUS_SLOT_HEIGHT,
+                                STATUS_SLOT_RIGHT_WIDTH, LV_TEXT_ALIGN_RIGHT },
+};
+
+/**
+ * @brief Per-widget text storage, kept in the object's user data
+ */
+typedef struct {
+    char text[STATUS_SLOT_COUNT][CONFIG_STATUS_BAR_SLOT_TEXT_MAX];
+} status_bar_data_t;
+
+static void get_slot_area(lv_obj_t *bar, status_slot_t slot, lv_area_t *area)
+{
+    lv_area_t coords;
+    lv_obj_get_coords(bar, &coords);
+    const status_slot_layout_t *layout = &slot_layout[slot];
+    lv_area_set(area, coords.x1 + layout->x, coords.y1 + layout->y,
+                coords.x1 + layout->x + layout->w - 1, coords.y1 + layout->y + STATUS_SLOT_HEIGHT - 1);
+}
+
+static void status_bar_draw(lv_event_t *e)
+{
+    lv_obj_t *bar = lv_event_get_target(e);
+    status_bar_data_t *data = lv_obj_get_user_data(bar);
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    if (data == NULL) {
+        return;
+    }
+
+    lv_draw_label_dsc_t label_dsc;
+    lv_draw_label_dsc_init(&label_dsc);
+    lv_obj_init_draw_label_dsc(bar, LV_PART_MAIN, &label_dsc);
+    label_dsc.flag |= LV_TEXT_FLAG_EXPAND;     // One line per slot, never wrap
+
+    // Clip each slot to its rectangle so long text cannot reach a neighbour
+    const lv_area_t *clip_ori = draw_ctx->clip_area;
+    for (int slot = 0; slot < STATUS_SLOT_COUNT; slot++) {
+        if (data->text[slot][0] == '\0') {
+            continue;
+        }
+        lv_area_t slot_area;
+        lv_area_t slot_clip;
+        get_slot_area(bar, (status_slot_t)slot, &slot_area);
+        if (!_lv_area_intersect(&slot_clip, clip_ori, &slot_area)) {
+            continue;
+        }
+        label_dsc.align = slot_layout[slot].align;
+        draw_ctx->clip_area = &slot_clip;
+        lv_draw_label(draw_ctx, &label_dsc, &slot_area, data->text[slot], NULL);
+    }
+    draw_ctx->clip_area = clip_ori;
+}
+
+static void status_bar_delete(lv_event_t *e)
+{
+    lv_obj_t *bar = lv_event_get_target(e);
+    status_bar_data_t *data = lv_obj_get_user_data(bar);
+    if (data != NULL) {
+        lv_mem_free(data);
+        lv_obj_set_user_data(bar, NULL);
+    }
+}
+
+lv_obj_t* status_bar_create(lv_obj_t *parent)
+{
+    status_bar_data_t *data = lv_mem_alloc(sizeof(status_bar_data_t));
+    if (data == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate status bar data");
+        return NULL;
+    }
+    memset(data, 0, sizeof(status_bar_data_t));
+
+    lv_obj_t *bar = lv_obj_create(parent);
+    lv_obj_remove_style_all(bar);
+    lv_obj_set_size(bar, lv_obj_get_width(parent), lv_obj_get_height(parent));
+    lv_obj_clear_flag(bar, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_user_data(bar, data);
+    lv_obj_add_event_cb(bar, status_bar_draw, LV_EVENT_DRAW_MAIN, NULL);
+    lv_obj_add_event_cb(bar, status_bar_delete, LV_EVENT_DELETE, NULL);
+
+    return bar;
+}
+
+void status_bar_set_text(lv_obj_t *bar, status_slot_t slot, const char *text)
+{
+    if (bar == NULL || slot >= STATUS_SLOT_COUNT || text == NULL) {
+        return;
+    }
+    status_bar_data_t *data = lv_obj_get_user_data(bar);
+    if (data == NULL || strncmp(data->text[slot], text, CONFIG_STATUS_BAR_SLOT_TEXT_MAX - 1) == 0) {
+        return;
+    }
+
+    snprintf(data->text[slot], CONFIG_STATUS_BAR_SLOT_TEXT_MAX, "%s", text);
+
+    lv_area_t slot_area;
+    get_slot_area(bar, slot, &slot_area);
+    lv_obj_invalidate_area(bar, &slot_area);
+}
+
+const char* status_bar_get_text(lv_obj_t *bar, status_slot_t slot)
+{
+    status_bar_data_t *data = (bar != NULL) ? lv_obj_get_user_data(bar) : NULL;
+    if (data == NULL || slot >= STATUS_SLOT_COUNT) {
+        return "";
+    }
+    return data->text[slot];
+}
+
+// Status texts the benchmark cycles through, same lengths as the real ones
+static const char *bench_texts[STATUS_SLOT_COUNT][2] = {
+    [STATUS_SLOT_ACTION]    = { "Action: --", "Action: Wave" },
+    [STATUS_SLOT_PIR]       = { "PIR: No", "PIR: Yes" },
+    [STATUS_SLOT_MOTION]    = { "MPU: None", "MPU: Tap" },
+    [STATUS_SLOT_WEATHER]   = { "21C Rainy", "22C Cloudy" },
+    [STATUS_SLOT_ASSISTANT] = { "Assistant", "Listening" },
+    [STATUS_SLOT_WIFI]      = { "WiFi: OK", "WiFi: --" },
+};
+
+static const lv_align_t bench_label_align[STATUS_SLOT_COUNT] = {
+    [STATUS_SLOT_ACTION]    = LV_ALIGN_TOP_LEFT,
+    [STATUS_SLOT_PIR]       = LV_ALIGN_TOP_LEFT,
+    [STATUS_SLOT_MOTION]    = LV_ALIGN_TOP_LEFT,
+    [STATUS_SLOT_WEATHER]   = LV_ALIGN_TOP_RIGHT,
+    [STATUS_SLOT_ASSISTANT] = LV_ALIGN_BOTTOM_LEFT,
+    [STATUS_SLOT_WIFI]      = LV_ALIGN_BOTTOM_RIGHT,
+};
+
+typedef struct {
+    uint32_t objects;
+    uint32_t heap_bytes;
+    uint32_t update_us;
+} bench_result_t;
+
+static lv_obj_t* bench_create_screen(void)
+{
+    lv_obj_t *screen = lv_obj_create(NULL);
+    lv_obj_clear_flag(screen, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_color(screen, lv_color_black(), LV_STATE_DEFAULT);
+    lv_obj_set_style_text_color(screen, lv_color_white(), LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(screen, &lv_font_montserrat_14, LV_STATE_DEFAULT);
+    return screen;
+}
+
+static uint32_t bench_heap_used(void)
+{
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+}
+
+static esp_err_t bench_run(lv_disp_t *disp, lv_obj_t *prev_screen, bool composite, bench_result_t *result)
+{
+    lv_obj_t *screen = bench_create_screen();
+    lv_scr_load(screen);
+    lv_refr_now(disp);
+
+    uint32_t heap_before = bench_heap_used();
+    lv_obj_t *bar = NULL;
+    lv_obj_t *labels[STATUS_SLOT_COUNT] = { NULL };
+    if (composite) {
+        bar = status_bar_create(screen);
+        if (bar == NULL) {
+            lv_scr_load(prev_screen);
+            lv_obj_del(screen);
+            return ESP_ERR_NO_MEM;
+        }
+        for (int slot = 0; slot < STATUS_SLOT_COUNT; slot++) {
+            status_bar_set_text(bar, (status_slot_t)slot, bench_texts[slot][0]);
+        }
+        result->objects = 1;
+    } else {
+        for (int slot = 0; slot < STATUS_SLOT_COUNT; slot++) {
+            const status_slot_layout_t *layout = &slot_layout[slot];
+            labels[slot] = lv_label_create(screen);
+            lv_label_set_text(labels[slot], bench_texts[slot][0]);
+            lv_coord_t x = (layout->align == LV_TEXT_ALIGN_RIGHT) ? -STATUS_SLOT_MARGIN : layout->x;
+            lv_coord_t y = (slot == STATUS_SLOT_ASSISTANT || slot == STATUS_SLOT_WIFI) ? -STATUS_SLOT_MARGIN : layout->y;
+            lv_obj_align(labels[slot], bench_label_align[slot], x, y);
+        }
+        result->objects = STATUS_SLOT_COUNT;
+    }
+    result->heap_bytes = bench_heap_used() - heap_before;
+    lv_refr_now(disp);
+
+    // Change one field per frame, cycling through the slots like the main loop does
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < CONFIG_STATUS_BAR_BENCH_UPDATES; i++) {
+        int slot = i % STATUS_SLOT_COUNT;
+        const char *text = bench_texts[slot][(i / STATUS_SLOT_COUNT + 1) % 2];
+        if (composite) {
+            status_bar_set_text(bar, (status_slot_t)slot, text);
+        } else {
+            lv_label_set_text(labels[slot], text);
+        }
+        lv_refr_now(disp);
+    }
+    result->update_us = (uint32_t)((esp_timer_get_time() - start_us) / CONFIG_STATUS_BAR_BENCH_UPDATES);
+
+    lv_scr_load(prev_screen);
+    lv_obj_del(screen);
+    return ESP_OK;
+}
+
+esp_err_t status_bar_run_benchmark(lv_disp_t *disp)
+{
+    if (disp == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    lv_obj_t *prev_screen = lv_scr_act();
+    bench_result_t labels = { 0 };
+    bench_result_t composite = { 0 };
+
+    esp_err_t ret = bench_run(disp, prev_screen, false, &labels);
+    if (ret == ESP_OK) {
+        ret = bench_run(disp, prev_screen, true, &composite);
+    }
+    lv_refr_now(disp);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Benchmark failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Labels:    %lu objects, %lu heap bytes, %lu us per field update",
+             (unsigned long)labels.objects, (unsigned long)labels.heap_bytes, (unsigned long)labels.update_us);
+    ESP_LOGI(TAG, "Composite: %lu objects, %lu heap bytes, %lu us per field update",
+             (unsigned long)composite.objects, (unsigned long)composite.heap_bytes, (unsigned long)composite.update_us);
+
+    return ESP_OK;
+}
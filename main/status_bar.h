@@ -0,0 +1,82 @@
+#ifndef STATUS_BAR_H
+#define STATUS_BAR_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file status_bar.h
+ * @brief Composite status widget for the main screen
+ *
+ * One LVGL object owns a fixed layout of text slots around the screen edges
+ * and draws all of them in a single draw callback. Changing a slot only
+ * invalidates that slot's rectangle; setting the same text again is free.
+ */
+
+/**
+ * @brief Text slots, one per status field
+ */
+typedef enum {
+    STATUS_SLOT_ACTION,         // Top-left, first line
+    STATUS_SLOT_PIR,            // Top-left, second line
+    STATUS_SLOT_MOTION,         // Top-left, third line
+    STATUS_SLOT_WEATHER,        // Top-right
+    STATUS_SLOT_ASSISTANT,      // Bottom-left
+    STATUS_SLOT_WIFI,           // Bottom-right
+    STATUS_SLOT_COUNT
+} status_slot_t;
+
+/**
+ * @brief Create the status widget covering its parent
+ *
+ * Text color and font come from the object's styles, as for a label.
+ *
+ * @param parent Parent object, normally a screen
+ * @return The widget, or NULL if out of memory
+ */
+lv_obj_t* status_bar_create(lv_obj_t *parent);
+
+/**
+ * @brief Set the text of a slot
+ *
+ * Texts longer than CONFIG_STATUS_BAR_SLOT_TEXT_MAX - 1 are truncated; text
+ * wider than the slot is clipped.
+ *
+ * @param bar Widget from status_bar_create()
+ * @param slot Slot to change
+ * @param text New text
+ */
+void status_bar_set_text(lv_obj_t *bar, status_slot_t slot, const char *text);
+
+/**
+ * @brief Get the text of a slot
+ *
+ * @param bar Widget from status_bar_create()
+ * @param slot Slot
+ * @return Slot text, or "" if bar is not a status widget
+ */
+const char* status_bar_get_text(lv_obj_t *bar, status_slot_t slot);
+
+/**
+ * @brief Compare the widget against one label per field and log the results
+ *
+ * Builds both versions on temporary screens and measures object count,
+ * LVGL heap use and the render time of a single field update.
+ * Call with the UI lock held.
+ *
+ * @param disp Registered display
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if a test screen cannot be built
+ */
+esp_err_t status_bar_run_benchmark(lv_disp_t *disp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATUS_BAR_H
@@ -0,0 +1,645 @@
+#include "telemetry.h"
+#include "i2c_bus.h"
+#include "presence_module.h"
+#include "render_watchdog.h"
+#include "service_task.h"
+#include "wifi_module.h"
+#include "wifi_power.h"
+#include "project_config.h"
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_mac.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <mqtt_client.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char *TAG = "Telemetry";
+
+#define FORMAT_VERSION          1
+#define CLOCK_SET_MIN_S         1600000000LL    // time() below this: clock never set
+
+// MQTT client events
+#define EVENT_CONNECTED         BIT0
+#define EVENT_DISCONNECTED      BIT1
+#define EVENT_PUBLISHED         BIT2
+
+/**
+ * @brief Duration histogram of one window
+ */
+typedef struct {
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+    uint32_t buckets[TELEMETRY_HIST_BUCKETS];
+} hist_t;
+
+/**
+ * @brief One encoded batch in the ring
+ */
+typedef struct {
+    uint32_t seq;
+    uint16_t len;
+    uint8_t data[CONFIG_TELEMETRY_BATCH_MAX_BYTES];
+} batch_slot_t;
+
+/**
+ * @brief Bounded CBOR writer; overflow is sticky and checked once at the end
+ */
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+} cbor_writer_t;
+
+// Module state
+static bool module_initialized = false;
+static service_job_handle_t batch_job = NULL;
+static TaskHandle_t uplink_task_handle = NULL;
+static volatile bool flush_requested = false;
+
+// Open window, fed from other tasks and the flush ISR
+static portMUX_TYPE hist_lock = portMUX_INITIALIZER_UNLOCKED;
+static hist_t hists[TELEMETRY_HIST_COUNT];
+static portMUX_TYPE presence_lock = portMUX_INITIALIZER_UNLOCKED;
+static presence_state_t presence_state = PRESENCE_STATE_PRESENT;
+static int64_t presence_mark_us = 0;
+static uint64_t presence_us[3] = {0};
+static int64_t window_start_us = 0;
+
+// Module counters at the previous window end, batch job only
+static i2c_device_health_t prev_i2c[I2C_DEVICE_COUNT];
+static render_watchdog_stats_t prev_render;
+static wifi_stats_t prev_wifi;
+static uint32_t prev_dropped = 0;
+
+// Queued batches (ring, oldest at ring_head), PSRAM when present
+static SemaphoreHandle_t ring_lock = NULL;
+static batch_slot_t *ring = NULL;
+static uint32_t ring_head = 0;
+static uint32_t ring_count = 0;
+static RTC_DATA_ATTR uint32_t next_seq = 0;
+
+// Uplink, uplink task only (events from the MQTT task)
+static esp_mqtt_client_handle_t mqtt_client = NULL;
+static EventGroupHandle_t mqtt_events = NULL;
+static volatile int acked_msg_id = -1;
+static char topic[64];
+static batch_slot_t uplink_batch;
+static int64_t last_flush_us = 0;
+
+// Statistics
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static telemetry_stats_t stats = {0};
+
+// -----------------------------------------------------------------------------
+// CBOR
+// -----------------------------------------------------------------------------
+
+static void cbor_head(cbor_writer_t *w, uint8_t major, uint64_t value)
+{
+    uint8_t head[9];
+    size_t n;
+    if (value < 24) {
+        head[0] = (uint8_t)((major << 5) | value);
+        n = 1;
+    } else if (value <= UINT8_MAX) {
+        head[0] = (uint8_t)((major << 5) | 24);
+        head[1] = (uint8_t)value;
+        n = 2;
+    } else if (value <= UINT16_MAX) {
+        head[0] = (uint8_t)((major << 5) | 25);
+        head[1] = (uint8_t)(value >> 8);
+        head[2] = (uint8_t)value;
+        n = 3;
+    } else if (value <= UINT32_MAX) {
+        head[0] = (uint8_t)((major << 5) | 26);
+        for (int i = 0; i < 4; i++) {
+            head[1 + i] = (uint8_t)(value >> (24 - 8 * i));
+        }
+        n = 5;
+    } else {
+        head[0] = (uint8_t)((major << 5) | 27);
+        for (int i = 0; i < 8; i++) {
+            head[1 + i] = (uint8_t)(value >> (56 - 8 * i));
+        }
+        n = 9;
+    }
+
+    if (w->len + n > w->size) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(&w->buf[w->len], head, n);
+    w->len += n;
+}
+
+static void cbor_uint(cbor_writer_t *w, uint64_t value)
+{
+    cbor_head(w, 0, value);
+}
+
+static void cbor_int(cbor_writer_t *w, int64_t value)
+{
+    if (value < 0) {
+        cbor_head(w, 1, (uint64_t)(-1 - value));
+    } else {
+        cbor_head(w, 0, (uint64_t)value);
+    }
+}
+
+static void cbor_array(cbor_writer_t *w, size_t items)
+{
+    cbor_head(w, 4, items);
+}
+
+static void cbor_map(cbor_writer_t *w, size_t pairs)
+{
+    cbor_head(w, 5, pairs);
+}
+
+// -----------------------------------------------------------------------------
+// Aggregation
+// -----------------------------------------------------------------------------
+
+void IRAM_ATTR telemetry_observe(telemetry_hist_t hist, uint32_t value_us)
+{
+    if (hist >= TELEMETRY_HIST_COUNT) {
+        return;
+    }
+
+    int bucket = 0;
+    if (value_us >= (1u << TELEMETRY_HIST_MIN_SHIFT)) {
+        bucket = 31 - __builtin_clz(value_us) - (TELEMETRY_HIST_MIN_SHIFT - 1);
+        if (bucket >= TELEMETRY_HIST_BUCKETS) {
+            bucket = TELEMETRY_HIST_BUCKETS - 1;
+        }
+    }
+
+    portENTER_CRITICAL_SAFE(&hist_lock);
+    hist_t *h = &hists[hist];
+    h->count++;
+    h->sum_us += value_us;
+    if (value_us > h->max_us) {
+        h->max_us = value_us;
+    }
+    h->buckets[bucket]++;
+    portEXIT_CRITICAL_SAFE(&hist_lock);
+}
+
+static void on_presence_change(presence_state_t new_state, presence_state_t old_state, void *user_ctx)
+{
+    int64_t now = esp_timer_get_time();
+    taskENTER_CRITICAL(&presence_lock);
+    presence_us[old_state] += (uint64_t)(now - presence_mark_us);
+    presence_mark_us = now;
+    presence_state = new_state;
+    taskEXIT_CRITICAL(&presence_lock);
+}
+
+static void encode_hist(cbor_writer_t *w, const hist_t *h)
+{
+    cbor_array(w, 4);
+    cbor_uint(w, h->count);
+    cbor_uint(w, h->sum_us);
+    cbor_uint(w, h->max_us);
+    cbor_array(w, TELEMETRY_HIST_BUCKETS);
+    for (int i = 0; i < TELEMETRY_HIST_BUCKETS; i++) {
+        cbor_uint(w, h->buckets[i]);
+    }
+}
+
+/**
+ * @brief Close the open window into a CBOR batch
+ *
+ * @return Batch length, 0 if it did not fit CONFIG_TELEMETRY_BATCH_MAX_BYTES
+ */
+static size_t build_batch(uint8_t *buf, size_t size, uint32_t seq)
+{
+    int64_t now = esp_timer_get_time();
+
+    hist_t window_hists[TELEMETRY_HIST_COUNT];
+    taskENTER_CRITICAL(&hist_lock);
+    memcpy(window_hists, hists, sizeof(hists));
+    memset(hists, 0, sizeof(hists));
+    taskEXIT_CRITICAL(&hist_lock);
+
+    uint64_t window_presence_us[3];
+    taskENTER_CRITICAL(&presence_lock);
+    presence_us[presence_state] += (uint64_t)(now - presence_mark_us);
+    presence_mark_us = now;
+    memcpy(window_presence_us, presence_us, sizeof(presence_us));
+    memset(presence_us, 0, sizeof(presence_us));
+    taskEXIT_CRITICAL(&presence_lock);
+
+    uint32_t window_s = (uint32_t)((now - window_start_us + 500000) / 1000000);
+    window_start_us = now;
+    int64_t wall_s = (int64_t)time(NULL);
+
+    telemetry_stats_t current;
+    telemetry_get_stats(&current);
+    render_watchdog_stats_t render = {0};
+    render_watchdog_get_stats(&render);
+    wifi_stats_t wifi = {0};
+    wifi_get_stats(&wifi);
+
+    cbor_writer_t w = { .buf = buf, .size = size };
+    cbor_map(&w, 12);
+    cbor_uint(&w, 0);
+    cbor_uint(&w, FORMAT_VERSION);
+    cbor_uint(&w, 1);
+    cbor_uint(&w, seq);
+    cbor_uint(&w, 2);
+    cbor_uint(&w, wall_s >= CLOCK_SET_MIN_S ? (uint64_t)wall_s : 0);
+    cbor_uint(&w, 3);
+    cbor_uint(&w, window_s);
+
+    for (int i = 0; i < TELEMETRY_HIST_COUNT; i++) {
+        cbor_uint(&w, 4 + i);
+        encode_hist(&w, &window_hists[i]);
+    }
+
+    cbor_uint(&w, 6);
+    cbor_array(&w, I2C_DEVICE_COUNT);
+    for (int i = 0; i < I2C_DEVICE_COUNT; i++) {
+        i2c_device_health_t health = {0};
+        i2c_bus_get_health((i2c_device_id_t)i, &health);
+        cbor_array(&w, 3);
+        cbor_uint(&w, health.transactions - prev_i2c[i].transactions);
+        cbor_uint(&w, health.errors - prev_i2c[i].errors);
+        cbor_uint(&w, health.timeouts - prev_i2c[i].timeouts);
+        prev_i2c[i] = health;
+    }
+
+    cbor_uint(&w, 7);
+    cbor_array(&w, 3);
+    for (int i = 0; i < 3; i++) {
+        cbor_uint(&w, (window_presence_us[i] + 500000) / 1000000);
+    }
+
+    cbor_uint(&w, 8);
+    cbor_array(&w, 3);
+    cbor_uint(&w, heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    cbor_uint(&w, heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    cbor_uint(&w, heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+
+    cbor_uint(&w, 9);
+    cbor_array(&w, 2);
+    cbor_uint(&w, render.stall_count - prev_render.stall_count);
+    cbor_uint(&w, render.total_stall_ms - prev_render.total_stall_ms);
+    prev_render = render;
+
+    cbor_uint(&w, 10);
+    cbor_array(&w, 2);
+    cbor_uint(&w, wifi.disconnects - prev_wifi.disconnects);
+    cbor_int(&w, wifi.rssi);
+    prev_wifi = wifi;
+
+    cbor_uint(&w, 11);
+    cbor_uint(&w, current.batches_dropped - prev_dropped);
+    prev_dropped = current.batches_dropped;
+
+    return w.overflow ? 0 : w.len;
+}
+
+static void enqueue_batch(const uint8_t *data, size_t len, uint32_t seq)
+{
+    xSemaphoreTake(ring_lock, portMAX_DELAY);
+    if (ring_count == CONFIG_TELEMETRY_QUEUE_BATCHES) {
+        // Full while offline: the oldest window is the least useful one
+        ring_head = (ring_head + 1) % CONFIG_TELEMETRY_QUEUE_BATCHES;
+        ring_count--;
+        taskENTER_CRITICAL(&stats_lock);
+        stats.batches_dropped++;
+        taskEXIT_CRITICAL(&stats_lock);
+    }
+    batch_slot_t *slot = &ring[(ring_head + ring_count) % CONFIG_TELEMETRY_QUEUE_BATCHES];
+    slot->seq = seq;
+    slot->len = (uint16_t)len;
+    memcpy(slot->data, data, len);
+    ring_count++;
+    uint32_t queued = ring_count;
+    xSemaphoreGive(ring_lock);
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.batches_built++;
+    stats.queued = queued;
+    stats.last_batch_bytes = (uint32_t)len;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+static uint32_t batch_job_run(void *user_ctx)
+{
+    static uint8_t buf[CONFIG_TELEMETRY_BATCH_MAX_BYTES];
+
+    uint32_t seq = next_seq++;
+    size_t len = build_batch(buf, sizeof(buf), seq);
+    if (len == 0) {
+        ESP_LOGE(TAG, "Batch %lu does not fit %d bytes", (unsigned long)seq, CONFIG_TELEMETRY_BATCH_MAX_BYTES);
+    } else {
+        enqueue_batch(buf, len, seq);
+        ESP_LOGD(TAG, "Batch %lu: %u bytes", (unsigned long)seq, (unsigned)len);
+    }
+
+    // Publish on schedule, or before the ring starts dropping
+    telemetry_stats_t current;
+    telemetry_get_stats(&current);
+    int64_t since_flush_s = (esp_timer_get_time() - last_flush_us) / 1000000;
+    if (flush_requested || since_flush_s >= CONFIG_TELEMETRY_PUBLISH_INTERVAL_S ||
+        current.queued * 4 >= CONFIG_TELEMETRY_QUEUE_BATCHES * 3) {
+        flush_requested = false;
+        xTaskNotifyGive(uplink_task_handle);
+    }
+
+    return CONFIG_TELEMETRY_BATCH_INTERVAL_S * 1000;
+}
+
+// -----------------------------------------------------------------------------
+// Uplink
+// -----------------------------------------------------------------------------
+
+static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)event_data;
+    switch ((esp_mqtt_event_id_t)event_id) {
+        case MQTT_EVENT_CONNECTED:
+            xEventGroupSetBits(mqtt_events, EVENT_CONNECTED);
+            break;
+        case MQTT_EVENT_DISCONNECTED:
+        case MQTT_EVENT_ERROR:
+            xEventGroupSetBits(mqtt_events, EVENT_DISCONNECTED);
+            break;
+        case MQTT_EVENT_PUBLISHED:
+            acked_msg_id = event->msg_id;
+            xEventGroupSetBits(mqtt_events, EVENT_PUBLISHED);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Copy the oldest queued batch to uplink_batch
+ *
+ * @return false when the ring is empty
+ */
+static bool peek_oldest(void)
+{
+    xSemaphoreTake(ring_lock, portMAX_DELAY);
+    bool have = ring_count > 0;
+    if (have) {
+        const batch_slot_t *slot = &ring[ring_head];
+        uplink_batch.seq = slot->seq;
+        uplink_batch.len = slot->len;
+        memcpy(uplink_batch.data, slot->data, slot->len);
+    }
+    xSemaphoreGive(ring_lock);
+    return have;
+}
+
+static void remove_oldest(uint32_t seq)
+{
+    xSemaphoreTake(ring_lock, portMAX_DELAY);
+    // The batch job may have dropped it meanwhile
+    if (ring_count > 0 && ring[ring_head].seq == seq) {
+        ring_head = (ring_head + 1) % CONFIG_TELEMETRY_QUEUE_BATCHES;
+        ring_count--;
+    }
+    uint32_t queued = ring_count;
+    xSemaphoreGive(ring_lock);
+
+    taskENTER_CRITICAL(&stats_lock);
+    stats.queued = queued;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+/**
+ * @brief Connect, publish every queued batch with QoS 1, disconnect
+ */
+static void flush_queue(void)
+{
+    int64_t start_us = esp_timer_get_time();
+    last_flush_us = start_us;
+
+    xEventGroupClearBits(mqtt_events, EVENT_CONNECTED | EVENT_DISCONNECTED | EVENT_PUBLISHED);
+    wifi_power_hold(true);      // Each PUBACK would otherwise wait for the next beacon wake
+    if (esp_mqtt_client_start(mqtt_client) != ESP_OK) {
+        ESP_LOGW(TAG, "MQTT client failed to start");
+        wifi_power_hold(false);
+        return;
+    }
+
+    bool ok = false;
+    uint32_t published = 0;
+    uint32_t bytes = 0;
+    EventBits_t bits = xEventGroupWaitBits(mqtt_events, EVENT_CONNECTED | EVENT_DISCONNECTED, pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(CONFIG_TELEMETRY_CONNECT_TIMEOUT_MS));
+    if (bits & EVENT_CONNECTED) {
+        ok = true;
+        while (peek_oldest()) {
+            xEventGroupClearBits(mqtt_events, EVENT_PUBLISHED);
+            int msg_id = esp_mqtt_client_publish(mqtt_client, topic, (const char *)uplink_batch.data,
+                                                 uplink_batch.len, 1, 0);
+            if (msg_id < 0) {
+                ok = false;
+                break;
+            }
+
+            // Batches leave the ring only once the broker has them
+            bool acked = false;
+            int64_t deadline_us = esp_timer_get_time() + (int64_t)CONFIG_TELEMETRY_ACK_TIMEOUT_MS * 1000;
+            while (!acked) {
+                int64_t left_ms = (deadline_us - esp_timer_get_time()) / 1000;
+                if (left_ms <= 0) {
+                    break;
+                }
+                bits = xEventGroupWaitBits(mqtt_events, EVENT_PUBLISHED | EVENT_DISCONNECTED, pdTRUE, pdFALSE,
+                                           pdMS_TO_TICKS(left_ms));
+                if (bits & EVENT_DISCONNECTED) {
+                    break;
+                }
+                acked = (bits & EVENT_PUBLISHED) && acked_msg_id == msg_id;
+            }
+            if (!acked) {
+                ok = false;
+                break;
+            }
+            remove_oldest(uplink_batch.seq);
+            published++;
+            bytes += uplink_batch.len;
+        }
+    }
+    esp_mqtt_client_stop(mqtt_client);
+    wifi_power_hold(false);
+
+    uint32_t flush_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    taskENTER_CRITICAL(&stats_lock);
+    stats.flushes++;
+    stats.batches_published += published;
+    stats.bytes_published += bytes;
+    if (ok) {
+        stats.last_flush_ms = flush_ms;
+    } else {
+        stats.flush_failures++;
+    }
+    uint32_t queued = stats.queued;
+    taskEXIT_CRITICAL(&stats_lock);
+
+    if (ok) {
+        ESP_LOGI(TAG, "Published %lu batches (%lu bytes) in %lu ms", (unsigned long)published,
+                 (unsigned long)bytes, (unsigned long)flush_ms);
+    } else {
+        ESP_LOGW(TAG, "Flush failed after %lu batches, %lu still queued", (unsigned long)published,
+                 (unsigned long)queued);
+    }
+}
+
+static void uplink_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!wifi_is_connected()) {
+            ESP_LOGD(TAG, "No Wi-Fi, batches stay queued");
+            continue;
+        }
+        flush_queue();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+esp_err_t telemetry_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Telemetry already initialized");
+        return ESP_OK;
+    }
+
+    // The ring can hold hours of batches; keep it out of internal RAM when there is PSRAM
+    size_t ring_bytes = CONFIG_TELEMETRY_QUEUE_BATCHES * sizeof(batch_slot_t);
+    ring = heap_caps_malloc(ring_bytes, MALLOC_CAP_SPIRAM);
+    if (ring == NULL) {
+        ring = heap_caps_malloc(ring_bytes, MALLOC_CAP_INTERNAL);
+    }
+    ring_lock = xSemaphoreCreateMutex();
+    mqtt_events = xEventGroupCreate();
+    if (ring == NULL || ring_lock == NULL || mqtt_events == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate the batch ring (%u bytes)", (unsigned)ring_bytes);
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t mac[6] = {0};
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    char client_id[24];
+    snprintf(client_id, sizeof(client_id), "desk-%02x%02x%02x%02x%02x%02x",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    snprintf(topic, sizeof(topic), "%s/%02x%02x%02x%02x%02x%02x/telemetry", CONFIG_TELEMETRY_TOPIC_PREFIX,
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+    const esp_mqtt_client_config_t mqtt_config = {
+        .broker.address.uri = CONFIG_TELEMETRY_MQTT_URI,
+        .credentials.client_id = client_id,
+        .session.keepalive = 60,
+        .network.disable_auto_reconnect = true,
+    };
+    mqtt_client = esp_mqtt_client_init(&mqtt_config);
+    if (mqtt_client == NULL) {
+        ESP_LOGE(TAG, "Failed to create the MQTT client");
+        return ESP_FAIL;
+    }
+    esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+
+    int64_t now = esp_timer_get_time();
+    window_start_us = now;
+    presence_mark_us = now;
+    presence_state = presence_get_state();
+    last_flush_us = now;
+    for (int i = 0; i < I2C_DEVICE_COUNT; i++) {
+        i2c_bus_get_health((i2c_device_id_t)i, &prev_i2c[i]);
+    }
+    render_watchdog_get_stats(&prev_render);
+    wifi_get_stats(&prev_wifi);
+    if (presence_register_listener(on_presence_change, NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "No presence listener slot, presence time not reported");
+    }
+
+    if (xTaskCreate(uplink_task, "telemetry", CONFIG_TASK_STACK_TELEMETRY, NULL,
+                    CONFIG_TASK_PRIORITY_TELEMETRY, &uplink_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create the uplink task");
+        return ESP_FAIL;
+    }
+
+    const service_job_config_t job_config = {
+        .name = "telemetry",
+        .run = batch_job_run,
+        .user_ctx = NULL,
+        .first_delay_ms = CONFIG_TELEMETRY_BATCH_INTERVAL_S * 1000,
+        .dedicated_stack = CONFIG_TASK_STACK_TELEMETRY_BATCH,
+        .dedicated_priority = CONFIG_TASK_PRIORITY_TELEMETRY,
+    };
+    if (service_job_add(&job_config, &batch_job) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add the batch job");
+        return ESP_FAIL;
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Telemetry to %s every %d s, %d s windows, up to %d batches (%u bytes) queued",
+             topic, CONFIG_TELEMETRY_PUBLISH_INTERVAL_S, CONFIG_TELEMETRY_BATCH_INTERVAL_S,
+             CONFIG_TELEMETRY_QUEUE_BATCHES, (unsigned)ring_bytes);
+
+    return ESP_OK;
+}
+
+void telemetry_note_radio_activity(void)
+{
+    if (!module_initialized) {
+        return;
+    }
+
+    int64_t since_flush_s = (esp_timer_get_time() - last_flush_us) / 1000000;
+    if (since_flush_s < CONFIG_TELEMETRY_PIGGYBACK_MIN_S) {
+        return;
+    }
+    taskENTER_CRITICAL(&stats_lock);
+    bool queued = stats.queued > 0;
+    if (queued) {
+        stats.piggybacked++;
+    }
+    taskEXIT_CRITICAL(&stats_lock);
+    if (queued) {
+        last_flush_us = esp_timer_get_time();   // One flush per burst of requests
+        xTaskNotifyGive(uplink_task_handle);
+    }
+}
+
+esp_err_t telemetry_flush(void)
+{
+    if (!module_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    flush_requested = true;
+    service_job_wake(batch_job);
+    return ESP_OK;
+}
+
+esp_err_t telemetry_get_stats(telemetry_stats_t *out)
+{
+    if (out == NULL) {
+        return ESP_FAIL;
+    }
+
+    taskENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    taskEXIT_CRITICAL(&stats_lock);
+    return ESP_OK;
+}
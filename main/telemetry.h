@@ -0,0 +1,123 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file telemetry.h
+ * @brief Performance metrics aggregated on the device, published in batches over MQTT
+ *
+ * Metrics are aggregated over windows of CONFIG_TELEMETRY_BATCH_INTERVAL_S:
+ * counters as deltas and durations as log2 histograms. Each window is
+ * closed into one CBOR batch and queued in a ring of
+ * CONFIG_TELEMETRY_QUEUE_BATCHES. When the ring is full, the oldest batch is
+ * dropped and the drop is counted in the next batch.
+ *
+ * Queued batches are published with QoS 1 to
+ * CONFIG_TELEMETRY_TOPIC_PREFIX/<mac>/telemetry. The connection is opened
+ * for the flush and closed after the last PUBACK, so there is no keepalive
+ * traffic between flushes. A flush is made every
+ * CONFIG_TELEMETRY_PUBLISH_INTERVAL_S, when the ring is three quarters
+ * full, or earlier when a direct request has just woken the radio anyway.
+ * Without Wi-Fi the batches wait in the ring.
+ *
+ * A batch is a CBOR map with integer keys (decoded by
+ * tools/telemetry_collector.py):
+ *   0  format version (1)
+ *   1  batch sequence number, continued across deep sleep
+ *   2  window end, Unix seconds (0 while the clock is not set)
+ *   3  window length, seconds
+ *   4  frame time (lv_timer_handler run): [count, sum_us, max_us, [buckets]]
+ *   5  panel flush time, same layout
+ *   6  I2C per device, i2c_device_id_t order: [[transactions, errors, timeouts], ...]
+ *   7  presence seconds in the window: [present, idle, away]
+ *   8  internal heap bytes: [minimum free since boot, free, largest block]
+ *   9  render stalls in the window: [count, total_ms]
+ *   10 Wi-Fi: [disconnects in the window, RSSI dBm]
+ *   11 batches dropped since the previous batch
+ * Bucket 0 counts values below 2^TELEMETRY_HIST_MIN_SHIFT us, and bucket
+ * i counts values below twice the bound of bucket i - 1. The last bucket
+ * is open-ended.
+ */
+
+#define TELEMETRY_HIST_BUCKETS      16
+#define TELEMETRY_HIST_MIN_SHIFT    8       // Bucket 0: below 256 us, last bucket: 4.2 s and up
+
+/**
+ * @brief Duration histograms fed by other modules
+ */
+typedef enum {
+    TELEMETRY_HIST_FRAME,       // lv_timer_handler() run
+    TELEMETRY_HIST_FLUSH,       // Panel flush
+    TELEMETRY_HIST_COUNT
+} telemetry_hist_t;
+
+/**
+ * @brief Telemetry statistics since boot
+ */
+typedef struct {
+    uint32_t batches_built;
+    uint32_t batches_dropped;       // Oldest dropped from a full ring
+    uint32_t batches_published;     // Acknowledged by the broker
+    uint32_t queued;                // Waiting in the ring
+    uint32_t flushes;               // Broker connections made
+    uint32_t flush_failures;        // Connect or PUBACK timeout
+    uint32_t piggybacked;           // Flushes started by radio activity
+    uint32_t bytes_published;
+    uint32_t last_batch_bytes;
+    uint32_t last_flush_ms;         // Connect -> last PUBACK
+} telemetry_stats_t;
+
+/**
+ * @brief Start aggregating, and publishing once Wi-Fi is up
+ *
+ * Call after presence_module_init() and wifi_module_init().
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the ring cannot be allocated,
+ *         ESP_FAIL on other errors
+ */
+esp_err_t telemetry_init(void);
+
+/**
+ * @brief Add one duration to a histogram, safe from ISR context
+ *
+ * @param hist Histogram
+ * @param value_us Duration in microseconds
+ */
+void telemetry_observe(telemetry_hist_t hist, uint32_t value_us);
+
+/**
+ * @brief Report that the radio was just used for other traffic
+ *
+ * Queued batches are then flushed while the radio is still awake, if the
+ * last flush is at least CONFIG_TELEMETRY_PIGGYBACK_MIN_S old.
+ */
+void telemetry_note_radio_activity(void);
+
+/**
+ * @brief Close the current window and publish everything queued now
+ *
+ * @return ESP_OK if the flush was started, ESP_ERR_INVALID_STATE before init
+ */
+esp_err_t telemetry_flush(void);
+
+/**
+ * @brief Get telemetry statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t telemetry_get_stats(telemetry_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_H
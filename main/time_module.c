@@ -1,10 +1,11 @@
 #include "time_module.h"
-#include "display_module.h"
+#include "refresh_policy.h"
+#include "i2c_bus.h"
 #include "project_config.h"
+#include "service_task.h"
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <sys/time.h>
-#include <driver/i2c.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
@@ -15,7 +16,7 @@ static const char *TAG = "TimeModule";
 #define DS3231_I2C_PORT         CONFIG_I2C0_PORT
 #define DS3231_SDA_GPIO         CONFIG_I2C0_SDA_GPIO
 #define DS3231_SCL_GPIO         CONFIG_I2C0_SCL_GPIO
-#define DS3231_I2C_FREQ_HZ      100000
+#define DS3231_I2C_FREQ_HZ      CONFIG_I2C0_FREQ_HZ
 
 // DS3231 register addresses
 #define DS3231_REG_SECONDS      0x00
@@ -25,16 +26,27 @@ static const char *TAG = "TimeModule";
 #define DS3231_REG_DATE         0x04
 #define DS3231_REG_MONTH        0x05
 #define DS3231_REG_YEAR         0x06
+#define DS3231_REG_ALARM1_SEC   0x07
+#define DS3231_REG_CONTROL      0x0E
+#define DS3231_REG_STATUS       0x0F
+
+// DS3231 control/status bits
+#define DS3231_CONTROL_INTCN    0x04    // INT/SQW pin signals alarms instead of square wave
+#define DS3231_CONTROL_A1IE     0x01    // Alarm 1 drives INT/SQW low
+#define DS3231_STATUS_A1F       0x01    // Alarm 1 matched
+#define DS3231_ALARM_MASK       0x80    // AxMx bit: ignore this field when matching
 
 // Module state
 static bool module_initialized = false;
 static bool rtc_available = false;
 static time_status_t current_status = TIME_STATUS_NOT_SET;
 static time_info_t last_known_time = {0};
-static TaskHandle_t time_update_task_handle = NULL;
-static bool time_update_running = false;
+static service_job_handle_t time_update_job = NULL;
 
-// Using old I2C driver for compatibility with MPU6050
+// Latest clock for the UI loop, see time_module_take_display_update()
+static portMUX_TYPE display_update_lock = portMUX_INITIALIZER_UNLOCKED;
+static time_display_update_t display_update;
+static bool display_update_pending = false;
 
 // Forward declarations
 static esp_err_t ds3231_init(void);
@@ -42,82 +54,93 @@ static esp_err_t ds3231_read_time(time_info_t *time_info);
 static esp_err_t ds3231_write_time(const time_info_t *time_info);
 static uint8_t bcd_to_dec(uint8_t val);
 static uint8_t dec_to_bcd(uint8_t val);
+static esp_err_t ds3231_read_regs(uint8_t reg, uint8_t *data, size_t len);
+static esp_err_t ds3231_write_regs(uint8_t reg, const uint8_t *data, size_t len);
+static esp_err_t ds3231_on_online(void *user_ctx);
+
+
+static esp_err_t ds3231_read_regs(uint8_t reg, uint8_t *data, size_t len)
+{
+    return i2c_bus_read(I2C_DEVICE_DS3231, reg, data, len);
+}
+
+static esp_err_t ds3231_write_regs(uint8_t reg, const uint8_t *data, size_t len)
+{
+    return i2c_bus_write(I2C_DEVICE_DS3231, reg, data, len);
+}
 
 static esp_err_t ds3231_init(void)
 {
-    ESP_LOGI(TAG, "Initializing DS3231 RTC with legacy I2C API on pins SDA:%d, SCL:%d", DS3231_SDA_GPIO, DS3231_SCL_GPIO);
-    
-    // Configure I2C
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = DS3231_SDA_GPIO,
-        .scl_io_num = DS3231_SCL_GPIO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = DS3231_I2C_FREQ_HZ,
+    ESP_LOGI(TAG, "Initializing DS3231 RTC on pins SDA:%d, SCL:%d", DS3231_SDA_GPIO, DS3231_SCL_GPIO);
+    
+    const i2c_device_config_t device_config = {
+        .name = "RTC",
+        .port = DS3231_I2C_PORT,
+        .sda_gpio = DS3231_SDA_GPIO,
+        .scl_gpio = DS3231_SCL_GPIO,
+        .freq_hz = DS3231_I2C_FREQ_HZ,
+        .addr = DS3231_I2C_ADDR,
+        .probe_reg = DS3231_REG_SECONDS,
+        .on_online = ds3231_on_online,
+        .user_ctx = NULL,
     };
     
-    esp_err_t ret = i2c_param_config(DS3231_I2C_PORT, &conf);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure I2C parameters: %s", esp_err_to_name(ret));
+    esp_err_t ret = i2c_bus_add_device(I2C_DEVICE_DS3231, &device_config);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "DS3231 RTC communication test successful");
+        if (ds3231_on_online(NULL) != ESP_OK) {
+            i2c_bus_report_failure(I2C_DEVICE_DS3231);
+        }
+    } else if (ret == ESP_ERR_NOT_FOUND) {
+        // The I2C layer keeps probing and calls ds3231_on_online() once it answers
+        ESP_LOGW(TAG, "DS3231 RTC not found, continuing without RTC until it answers");
+        rtc_available = false;
+        current_status = TIME_STATUS_RTC_ERROR;
+    } else {
+        ESP_LOGE(TAG, "Failed to set up DS3231 I2C bus: %s", esp_err_to_name(ret));
+        rtc_available = false;
+        current_status = TIME_STATUS_RTC_ERROR;
         return ret;
     }
     
-    ret = i2c_driver_install(DS3231_I2C_PORT, conf.mode, 0, 0, 0);
+    return ESP_OK; // Don't fail initialization if RTC is not available
+}
+
+/**
+ * @brief Bring the RTC into use, at init or when it answers again
+ */
+static esp_err_t ds3231_on_online(void *user_ctx)
+{
+    rtc_available = true;
+    
+    // Test read current time and show what we get
+    time_info_t test_time;
+    esp_err_t ret = ds3231_read_time(&test_time);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to install I2C driver: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    // Test communication with DS3231 - read seconds register
-    uint8_t test_data;
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, DS3231_REG_SECONDS, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_READ, true);
-    i2c_master_read_byte(cmd, &test_data, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-    ret = i2c_master_cmd_begin(DS3231_I2C_PORT, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
-    
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "DS3231 RTC communication test successful (seconds reg: 0x%02x)", test_data);
-        rtc_available = true;
-        current_status = TIME_STATUS_OK;
-        
-        // Test read current time and show what we get
-        time_info_t test_time;
-        esp_err_t read_ret = ds3231_read_time(&test_time);
-        if (read_ret == ESP_OK) {
-            ESP_LOGI(TAG, "Current RTC time: %04d-%02d-%02d %02d:%02d:%02d", 
-                     test_time.year, test_time.month, test_time.day,
-                     test_time.hour, test_time.minute, test_time.second);
-            
-            // If year is 2000, RTC needs to be set with current time
-            if (test_time.year == 2000) {
-                ESP_LOGW(TAG, "RTC shows default time, setting to 2025-07-20 15:35:00");
-                time_info_t new_time = {
-                    .year = 2025,
-                    .month = 7,
-                    .day = 20,
-                    .hour = 15,
-                    .minute = 35,
-                    .second = 0,
-                    .weekday = 0,
-                    .status = TIME_STATUS_OK
-                };
-                ds3231_write_time(&new_time);
-            }
-        }
-    } else {
-        ESP_LOGW(TAG, "DS3231 RTC not found or communication failed: %s", esp_err_to_name(ret));
-        rtc_available = false;
-        current_status = TIME_STATUS_RTC_ERROR;
+    ESP_LOGI(TAG, "Current RTC time: %04d-%02d-%02d %02d:%02d:%02d", 
+             test_time.year, test_time.month, test_time.day,
+             test_time.hour, test_time.minute, test_time.second);
+    
+    // If year is 2000, RTC needs to be set with current time
+    if (test_time.year == 2000) {
+        ESP_LOGW(TAG, "RTC shows default time, setting to 2025-07-20 15:35:00");
+        time_info_t new_time = {
+            .year = 2025,
+            .month = 7,
+            .day = 20,
+            .hour = 15,
+            .minute = 35,
+            .second = 0,
+            .weekday = 0,
+            .status = TIME_STATUS_OK
+        };
+        ds3231_write_time(&new_time);
     }
     
-    return ESP_OK; // Don't fail initialization if RTC is not available
+    return ESP_OK;
 }
 
 static uint8_t bcd_to_dec(uint8_t val)
@@ -137,16 +160,7 @@ static esp_err_t ds3231_read_time(time_info_t *time_info)
     }
     
     uint8_t data[7];
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, DS3231_REG_SECONDS, true);
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_READ, true);
-    i2c_master_read(cmd, data, 7, I2C_MASTER_LAST_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(DS3231_I2C_PORT, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
+    esp_err_t ret = ds3231_read_regs(DS3231_REG_SECONDS, data, sizeof(data));
     
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to read time from DS3231: %s", esp_err_to_name(ret));
@@ -192,14 +206,7 @@ static esp_err_t ds3231_write_time(const time_info_t *time_info)
     data[5] = dec_to_bcd(time_info->month);
     data[6] = dec_to_bcd(time_info->year - 2000);
     
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (DS3231_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, DS3231_REG_SECONDS, true);
-    i2c_master_write(cmd, data, 7, true);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(DS3231_I2C_PORT, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
+    esp_err_t ret = ds3231_write_regs(DS3231_REG_SECONDS, data, sizeof(data));
     
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to write time to DS3231: %s", esp_err_to_name(ret));
@@ -214,38 +221,61 @@ static esp_err_t ds3231_write_time(const time_info_t *time_info)
     return ESP_OK;
 }
 
-static void time_update_task(void *arg)
+static void publish_display_update(const time_display_update_t *update)
 {
-    ESP_LOGI(TAG, "Time update task started with legacy I2C API");
-    
-    while (time_update_running) {
-        if (rtc_available) {
-            time_info_t current_time;
-            esp_err_t ret = ds3231_read_time(&current_time);
-            
-            if (ret == ESP_OK) {
-                // Update display with real time from RTC
-                display_update_time(current_time.hour, current_time.minute, current_time.second);
-                display_update_date(current_time.year, current_time.month, current_time.day);
-                ESP_LOGI(TAG, "Display updated: %04d-%02d-%02d %02d:%02d:%02d", 
-                         current_time.year, current_time.month, current_time.day,
-                         current_time.hour, current_time.minute, current_time.second);
-            } else {
-                ESP_LOGW(TAG, "Failed to read time from RTC, keeping previous display");
+    taskENTER_CRITICAL(&display_update_lock);
+    display_update = *update;
+    display_update_pending = true;
+    taskEXIT_CRITICAL(&display_update_lock);
+}
+
+static uint32_t time_update_job_run(void *user_ctx)
+{
+    // At minute resolution sleep to the next minute; a policy change wakes the job early
+    uint32_t delay_ms = 1000;
+    time_display_update_t update = {
+        .show_seconds = refresh_policy_clock_shows_seconds(),
+        .update_date = refresh_policy_date_live(),
+    };
+    
+    if (rtc_available) {
+        esp_err_t ret = ds3231_read_time(&update.time);
+        
+        if (ret == ESP_OK) {
+            update.time_valid = true;
+            if (!update.show_seconds) {
+                delay_ms = (60 - update.time.second) * 1000;
             }
+            ESP_LOGI(TAG, "Display time published: %04d-%02d-%02d %02d:%02d:%02d", 
+                     update.time.year, update.time.month, update.time.day,
+                     update.time.hour, update.time.minute, update.time.second);
         } else {
-            ESP_LOGW(TAG, "RTC not available, skipping time update");
+            ESP_LOGW(TAG, "Failed to read time from RTC, keeping previous display");
         }
-        
-        // Update every second
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    } else {
+        ESP_LOGW(TAG, "RTC not available, skipping time update");
     }
     
-    ESP_LOGI(TAG, "Time update task ending");
-    time_update_task_handle = NULL;
-    vTaskDelete(NULL);
+    // The UI loop draws it; this job never waits for the UI lock
+    publish_display_update(&update);
+    return delay_ms;
 }
 
+bool time_module_take_display_update(time_display_update_t *update)
+{
+    if (update == NULL) {
+        return false;
+    }
+    
+    taskENTER_CRITICAL(&display_update_lock);
+    bool pending = display_update_pending;
+    if (pending) {
+        *update = display_update;
+        display_update_pending = false;
+    }
+    taskEXIT_CRITICAL(&display_update_lock);
+    return pending;
+}
 
 esp_err_t time_module_init(void)
 {
@@ -310,6 +340,57 @@ esp_err_t time_module_set_time(int year, int month, int day, int hour, int minut
     }
 }
 
+esp_err_t time_module_set_alarm(int hour, int minute)
+{
+    if (!module_initialized || !rtc_available) {
+        return ESP_FAIL;
+    }
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Alarm 1: match seconds, minutes and hours, ignore day/date (fires daily)
+    uint8_t alarm[4] = {
+        dec_to_bcd(0),
+        dec_to_bcd(minute),
+        dec_to_bcd(hour),
+        DS3231_ALARM_MASK
+    };
+    esp_err_t ret = ds3231_write_regs(DS3231_REG_ALARM1_SEC, alarm, sizeof(alarm));
+    
+    uint8_t control = 0;
+    if (ret == ESP_OK) ret = ds3231_read_regs(DS3231_REG_CONTROL, &control, 1);
+    if (ret == ESP_OK) {
+        control |= DS3231_CONTROL_INTCN | DS3231_CONTROL_A1IE;
+        ret = ds3231_write_regs(DS3231_REG_CONTROL, &control, 1);
+    }
+    if (ret == ESP_OK) ret = time_module_clear_alarm_flag();
+    
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set DS3231 alarm: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ESP_LOGI(TAG, "Daily alarm set for %02d:%02d", hour, minute);
+    return ESP_OK;
+}
+
+esp_err_t time_module_clear_alarm_flag(void)
+{
+    if (!module_initialized || !rtc_available) {
+        return ESP_FAIL;
+    }
+    
+    // Clearing A1F releases the INT/SQW line
+    uint8_t status = 0;
+    esp_err_t ret = ds3231_read_regs(DS3231_REG_STATUS, &status, 1);
+    if (ret == ESP_OK && (status & DS3231_STATUS_A1F)) {
+        status &= (uint8_t)~DS3231_STATUS_A1F;
+        ret = ds3231_write_regs(DS3231_REG_STATUS, &status, 1);
+    }
+    return ret;
+}
+
 const char* time_module_get_status_string(void)
 {
     switch (current_status) {
@@ -326,31 +407,33 @@ const char* time_module_get_status_string(void)
     }
 }
 
+void time_module_request_update(void)
+{
+    service_job_wake(time_update_job);
+}
+
 esp_err_t time_module_start_display_updates(void)
 {
     if (!module_initialized) {
         return ESP_FAIL;
     }
     
-    if (time_update_task_handle != NULL) {
+    if (time_update_job != NULL) {
         ESP_LOGW(TAG, "Display updates already running");
         return ESP_OK;
     }
     
-    time_update_running = true;
-    
-    BaseType_t ret = xTaskCreate(
-        time_update_task,
-        "time_update",
-        4096,
-        NULL,
-        5,
-        &time_update_task_handle
-    );
+    const service_job_config_t job_config = {
+        .name = "time_update",
+        .run = time_update_job_run,
+        .user_ctx = NULL,
+        .first_delay_ms = 0,
+        .dedicated_stack = CONFIG_TASK_STACK_TIME,
+        .dedicated_priority = CONFIG_TASK_PRIORITY_TIME,
+    };
     
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create time update task");
-        time_update_running = false;
+    if (service_job_add(&job_config, &time_update_job) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add time update job");
         return ESP_FAIL;
     }
     
@@ -361,21 +444,10 @@ esp_err_t time_module_start_display_updates(void)
 
 esp_err_t time_module_stop_display_updates(void)
 {
-    if (time_update_task_handle != NULL) {
-        time_update_running = false;
-        
-        // Wait for task to finish
-        int timeout = 50; // 500ms timeout
-        while (time_update_task_handle != NULL && timeout > 0) {
-            vTaskDelay(pdMS_TO_TICKS(10));
-            timeout--;
-        }
-        
-        // Force delete if still running
-        if (time_update_task_handle != NULL) {
-            vTaskDelete(time_update_task_handle);
-            time_update_task_handle = NULL;
-        }
+    if (time_update_job != NULL) {
+        // Waits for an update in progress
+        service_job_remove(time_update_job);
+        time_update_job = NULL;
         
         ESP_LOGI(TAG, "Stopped display updates");
     }
@@ -394,10 +466,8 @@ esp_err_t time_module_deinit(void)
     // Stop display updates
     time_module_stop_display_updates();
     
-    // Cleanup I2C driver
-    if (rtc_available) {
-        i2c_driver_delete(DS3231_I2C_PORT);
-    }
+    // Release the bus (the driver goes with the last device on it)
+    i2c_bus_remove_device(I2C_DEVICE_DS3231);
     
     rtc_available = false;
     module_initialized = false;
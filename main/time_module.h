@@ -33,6 +33,16 @@ typedef struct {
     time_status_t status;
 } time_info_t;
 
+/**
+ * @brief Clock update for the screen, see time_module_take_display_update()
+ */
+typedef struct {
+    time_info_t time;
+    bool time_valid;        // false when the RTC could not be read; only show_seconds applies
+    bool show_seconds;
+    bool update_date;
+} time_display_update_t;
+
 /**
  * @brief Initialize the time module
  * 
@@ -66,6 +76,25 @@ esp_err_t time_module_get_time(time_info_t *time_info);
  */
 esp_err_t time_module_set_time(int year, int month, int day, int hour, int minute, int second);
 
+/**
+ * @brief Arm the DS3231 daily alarm
+ * 
+ * Alarm 1 pulls the INT/SQW pin low every day at the given time until
+ * time_module_clear_alarm_flag() is called.
+ * 
+ * @param hour Hour (0-23)
+ * @param minute Minute (0-59)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG for an invalid time, ESP_FAIL on error
+ */
+esp_err_t time_module_set_alarm(int hour, int minute);
+
+/**
+ * @brief Acknowledge a fired DS3231 alarm and release the INT/SQW pin
+ * 
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t time_module_clear_alarm_flag(void);
+
 /**
  * @brief Get time status string for display
  * 
@@ -76,7 +105,8 @@ const char* time_module_get_status_string(void);
 /**
  * @brief Start periodic time updates to display
  * 
- * This will automatically update the display every second
+ * Publishes the time every second (every minute at minute resolution) for
+ * time_module_take_display_update()
  * 
  * @return ESP_OK on success, ESP_FAIL on error
  */
@@ -89,6 +119,26 @@ esp_err_t time_module_start_display_updates(void);
  */
 esp_err_t time_module_stop_display_updates(void);
 
+/**
+ * @brief Update the display now instead of at the next scheduled update
+ * 
+ * Safe to call from any task; does nothing while display updates are stopped.
+ */
+void time_module_request_update(void);
+
+/**
+ * @brief Take the clock update published since the last call
+ *
+ * The update job runs on the shared service task and must not wait for the
+ * UI lock, so it only publishes the time; the UI loop takes it here and
+ * draws it with display_set_clock_seconds(), display_update_time() and
+ * display_update_date().
+ *
+ * @param update Pointer to store the update
+ * @return true if a new update was taken
+ */
+bool time_module_take_display_update(time_display_update_t *update);
+
 /**
  * @brief Deinitialize time module and free resources
  * 
@@ -0,0 +1,75 @@
+#include "ui_strings.h"
+#include <stddef.h>
+
+/*
+ * tools/font_subset.py reads the string literals of this table to build the
+ * UI font glyph set; keep every fixed UI text here and nothing else.
+ */
+static const char *const ui_strings[UI_STR_COUNT] = {
+    [UI_STR_APP_TITLE]          = "Smart Assistant",
+    [UI_STR_BOOT_STARTING]      = "Starting...",
+    [UI_STR_BOOT_DISPLAY]       = "Display initialized...",
+    [UI_STR_BOOT_HARDWARE]      = "Checking hardware...",
+    [UI_STR_BOOT_CONFIG]        = "Loading configuration...",
+    [UI_STR_BOOT_TIME]          = "Initializing time module...",
+    [UI_STR_BOOT_PIR]           = "Initializing PIR sensor...",
+    [UI_STR_BOOT_MOTION]        = "Initializing motion sensor...",
+    [UI_STR_BOOT_PRESENCE]      = "Starting presence tracking...",
+    [UI_STR_BOOT_COPROC]        = "Starting co-processor...",
+    [UI_STR_BOOT_WIFI]          = "Connecting to WiFi...",
+    [UI_STR_BOOT_SERVICES]      = "Starting services...",
+    [UI_STR_BOOT_READY]         = "System ready!",
+
+    [UI_STR_TIME_FORMAT_HMS]    = "%02d:%02d:%02d",
+    [UI_STR_TIME_FORMAT_HM]     = "%02d:%02d",
+    [UI_STR_DATE_FORMAT]        = "%s %d, %d",
+    [UI_STR_MONTH_JAN]          = "Jan",
+    [UI_STR_MONTH_FEB]          = "Feb",
+    [UI_STR_MONTH_MAR]          = "Mar",
+    [UI_STR_MONTH_APR]          = "Apr",
+    [UI_STR_MONTH_MAY]          = "May",
+    [UI_STR_MONTH_JUN]          = "Jun",
+    [UI_STR_MONTH_JUL]          = "Jul",
+    [UI_STR_MONTH_AUG]          = "Aug",
+    [UI_STR_MONTH_SEP]          = "Sep",
+    [UI_STR_MONTH_OCT]          = "Oct",
+    [UI_STR_MONTH_NOV]          = "Nov",
+    [UI_STR_MONTH_DEC]          = "Dec",
+    [UI_STR_RTC_ERROR]          = "RTC Error",
+    [UI_STR_ACTION_NONE]        = "Action: --",
+    [UI_STR_ACTION_FORMAT]      = "Action: %s",
+    [UI_STR_PIR_NONE]           = "PIR: No",
+    [UI_STR_PIR_YES]            = "PIR: Yes",
+    [UI_STR_PIR_AGO]            = "PIR: No (%lus ago)",
+    [UI_STR_MOTION_NONE]        = "MPU: None",
+    [UI_STR_MOTION_ERROR]       = "MPU: Error",
+    [UI_STR_MOTION_OFFLINE]     = "MPU: Offline",
+    [UI_STR_MOTION_TAP]         = "MPU: Tap",
+    [UI_STR_MOTION_SHAKE]       = "MPU: Shake",
+    [UI_STR_MOTION_READY]       = "MPU: Ready",
+    [UI_STR_ASSISTANT]          = "Assistant",
+    [UI_STR_WIFI_OK]            = "WiFi: OK",
+    [UI_STR_WIFI_NONE]          = "WiFi: --",
+
+    [UI_STR_DIAG_TITLE]         = "Diagnostics",
+    [UI_STR_DIAG_COLLECTING]    = "Collecting...",
+
+    [UI_STR_PREVIEW_WAITING]    = "Waiting for camera...",
+    [UI_STR_PREVIEW_STATS]      = "%lu.%lu fps  %lu kbit/s (%lu%% link)  decode %lu.%lu ms  %lu stale",
+};
+
+const char* ui_string(ui_string_id_t id)
+{
+    if ((unsigned)id >= UI_STR_COUNT || ui_strings[id] == NULL) {
+        return "";
+    }
+    return ui_strings[id];
+}
+
+const char* ui_month_name(int month)
+{
+    if (month < 1 || month > 12) {
+        return "";
+    }
+    return ui_strings[UI_STR_MONTH_JAN + month - 1];
+}
@@ -0,0 +1,103 @@
+#ifndef UI_STRINGS_H
+#define UI_STRINGS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file ui_strings.h
+ * @brief Fixed texts shown on the screens
+ *
+ * Every fixed UI text lives in the table in ui_strings.c. The build extracts
+ * the codepoints used there (tools/font_subset.py) and fails if the UI font
+ * lacks a glyph; with the source TTF available it regenerates the font with
+ * exactly those glyphs. Numbers formatted into the texts are covered by the
+ * conversions in the format strings. %s arguments and the diagnostics lines
+ * come from the modules listed as font sources in main/CMakeLists.txt, whose
+ * string literals the build scans as well.
+ */
+
+/**
+ * @brief Text identifiers
+ */
+typedef enum {
+    // Boot screen
+    UI_STR_APP_TITLE,
+    UI_STR_BOOT_STARTING,
+    UI_STR_BOOT_DISPLAY,
+    UI_STR_BOOT_HARDWARE,
+    UI_STR_BOOT_CONFIG,
+    UI_STR_BOOT_TIME,
+    UI_STR_BOOT_PIR,
+    UI_STR_BOOT_MOTION,
+    UI_STR_BOOT_PRESENCE,
+    UI_STR_BOOT_COPROC,
+    UI_STR_BOOT_WIFI,
+    UI_STR_BOOT_SERVICES,
+    UI_STR_BOOT_READY,
+
+    // Main screen
+    UI_STR_TIME_FORMAT_HMS,     // hours, minutes, seconds
+    UI_STR_TIME_FORMAT_HM,      // hours, minutes
+    UI_STR_DATE_FORMAT,         // month name, day, year
+    UI_STR_MONTH_JAN,           // Followed by the other months in order
+    UI_STR_MONTH_FEB,
+    UI_STR_MONTH_MAR,
+    UI_STR_MONTH_APR,
+    UI_STR_MONTH_MAY,
+    UI_STR_MONTH_JUN,
+    UI_STR_MONTH_JUL,
+    UI_STR_MONTH_AUG,
+    UI_STR_MONTH_SEP,
+    UI_STR_MONTH_OCT,
+    UI_STR_MONTH_NOV,
+    UI_STR_MONTH_DEC,
+    UI_STR_RTC_ERROR,
+    UI_STR_ACTION_NONE,
+    UI_STR_ACTION_FORMAT,       // state or action name
+    UI_STR_PIR_NONE,
+    UI_STR_PIR_YES,
+    UI_STR_PIR_AGO,             // seconds since the last motion
+    UI_STR_MOTION_NONE,
+    UI_STR_MOTION_ERROR,
+    UI_STR_MOTION_OFFLINE,
+    UI_STR_MOTION_TAP,
+    UI_STR_MOTION_SHAKE,
+    UI_STR_MOTION_READY,
+    UI_STR_ASSISTANT,
+    UI_STR_WIFI_OK,
+    UI_STR_WIFI_NONE,
+
+    // Diagnostics screen
+    UI_STR_DIAG_TITLE,
+    UI_STR_DIAG_COLLECTING,
+
+    // Camera preview screen
+    UI_STR_PREVIEW_WAITING,
+    UI_STR_PREVIEW_STATS,       // fps, tenths, kbit/s, link %, decode ms, tenths, stale frames
+
+    UI_STR_COUNT
+} ui_string_id_t;
+
+/**
+ * @brief Get a fixed UI text
+ *
+ * @param id Text identifier
+ * @return Constant UTF-8 string, "" for an unknown identifier
+ */
+const char* ui_string(ui_string_id_t id);
+
+/**
+ * @brief Get the name of a month
+ *
+ * @param month Month 1-12
+ * @return Constant UTF-8 string, "" outside 1-12
+ */
+const char* ui_month_name(int month);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UI_STRINGS_H
@@ -0,0 +1,244 @@
+/**
+ * @file main.c
+ * @brief ULP RISC-V presence monitor, runs while the main cores are in deep sleep
+ *
+ * Woken by the ULP timer every CONFIG_ULP_POLL_PERIOD_MS. Each run samples the
+ * PIR output and, when enabled, polls the MPU6050 motion interrupt status over
+ * bit-banged I2C. A PIR edge opens a confirmation window; the main cores are
+ * woken only when the window sees another PIR edge or device motion.
+ *
+ * Globals are shared with the main program as ulp_<name> (see sleep_module.c).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ulp_riscv_utils.h"
+#include "ulp_riscv_gpio.h"
+
+#define MPU6050_REG_INT_STATUS      0x3A
+#define MPU6050_INT_MOT             0x40
+
+#define I2C_HALF_PERIOD_CYCLES      (uint32_t)(ULP_RISCV_CYCLES_PER_US * 5)     // ~100 kHz
+#define I2C_STRETCH_TIMEOUT         100
+
+// Configuration, written by the main program before the ULP is started
+uint32_t pir_gpio;
+uint32_t sda_gpio;
+uint32_t scl_gpio;
+uint32_t mpu_addr;
+uint32_t use_mpu;
+uint32_t confirm_pir_edges;
+uint32_t confirm_window_runs;
+
+// Counters, read by the main program after wakeup
+uint32_t runs;
+uint32_t pir_events;
+uint32_t motion_events;
+uint32_t arrivals;
+uint32_t i2c_errors;
+uint32_t active_us_total;
+uint32_t active_us_max;
+uint32_t wake_pending;
+
+// Run-to-run state (ULP memory is retained between timer wakeups)
+static bool pins_ready = false;
+static uint32_t last_pir_level = 0;
+static uint32_t window_runs_left = 0;
+static uint32_t window_edges = 0;
+static bool window_motion = false;
+
+static void i2c_delay(void)
+{
+    ulp_riscv_delay_cycles(I2C_HALF_PERIOD_CYCLES);
+}
+
+// Open-drain emulation: drive low by enabling the output, release by disabling it
+static void line_low(uint32_t gpio)
+{
+    ulp_riscv_gpio_output_enable((gpio_num_t)gpio);
+}
+
+static void line_release(uint32_t gpio)
+{
+    ulp_riscv_gpio_output_disable((gpio_num_t)gpio);
+}
+
+static bool scl_release(void)
+{
+    line_release(scl_gpio);
+    for (int i = 0; i < I2C_STRETCH_TIMEOUT; i++) {
+        if (ulp_riscv_gpio_get_level((gpio_num_t)scl_gpio)) {
+            return true;
+        }
+        i2c_delay();
+    }
+    return false;
+}
+
+static void i2c_init_line(uint32_t gpio)
+{
+    ulp_riscv_gpio_init((gpio_num_t)gpio);
+    ulp_riscv_gpio_input_enable((gpio_num_t)gpio);
+    ulp_riscv_gpio_output_level((gpio_num_t)gpio, 0);
+    ulp_riscv_gpio_pullup((gpio_num_t)gpio);
+    line_release(gpio);
+}
+
+static bool i2c_start(void)
+{
+    line_release(sda_gpio);
+    if (!scl_release()) {
+        return false;
+    }
+    i2c_delay();
+    line_low(sda_gpio);
+    i2c_delay();
+    line_low(scl_gpio);
+    return true;
+}
+
+static void i2c_stop(void)
+{
+    line_low(sda_gpio);
+    i2c_delay();
+    scl_release();
+    i2c_delay();
+    line_release(sda_gpio);
+    i2c_delay();
+}
+
+static bool i2c_write_byte(uint8_t byte)
+{
+    for (int bit = 7; bit >= 0; bit--) {
+        if (byte & (1 << bit)) {
+            line_release(sda_gpio);
+        } else {
+            line_low(sda_gpio);
+        }
+        i2c_delay();
+        if (!scl_release()) {
+            return false;
+        }
+        i2c_delay();
+        line_low(scl_gpio);
+    }
+
+    // Acknowledge bit
+    line_release(sda_gpio);
+    i2c_delay();
+    if (!scl_release()) {
+        return false;
+    }
+    bool ack = (ulp_riscv_gpio_get_level((gpio_num_t)sda_gpio) == 0);
+    i2c_delay();
+    line_low(scl_gpio);
+    return ack;
+}
+
+static uint8_t i2c_read_byte_nack(void)
+{
+    uint8_t byte = 0;
+    line_release(sda_gpio);
+    for (int bit = 7; bit >= 0; bit--) {
+        i2c_delay();
+        scl_release();
+        if (ulp_riscv_gpio_get_level((gpio_num_t)sda_gpio)) {
+            byte |= (1 << bit);
+        }
+        i2c_delay();
+        line_low(scl_gpio);
+    }
+
+    // NACK: leave SDA released for the ninth clock
+    i2c_delay();
+    scl_release();
+    i2c_delay();
+    line_low(scl_gpio);
+    return byte;
+}
+
+static bool mpu_read_reg(uint8_t reg, uint8_t *value)
+{
+    bool ok = i2c_start() &&
+              i2c_write_byte((uint8_t)(mpu_addr << 1)) &&
+              i2c_write_byte(reg) &&
+              i2c_start() &&
+              i2c_write_byte((uint8_t)((mpu_addr << 1) | 1));
+    if (ok) {
+        *value = i2c_read_byte_nack();
+    }
+    i2c_stop();
+    return ok;
+}
+
+int main(void)
+{
+    uint32_t start_cycles = ulp_riscv_get_cpu_cycles();
+
+    if (!pins_ready) {
+        ulp_riscv_gpio_init((gpio_num_t)pir_gpio);
+        ulp_riscv_gpio_input_enable((gpio_num_t)pir_gpio);
+        if (use_mpu) {
+            i2c_init_line(sda_gpio);
+            i2c_init_line(scl_gpio);
+        }
+        last_pir_level = ulp_riscv_gpio_get_level((gpio_num_t)pir_gpio);
+        pins_ready = true;
+    }
+
+    runs++;
+
+    bool pir_edge = false;
+    uint32_t pir_level = ulp_riscv_gpio_get_level((gpio_num_t)pir_gpio);
+    if (pir_level && !last_pir_level) {
+        pir_events++;
+        pir_edge = true;
+    }
+    last_pir_level = pir_level;
+
+    bool motion = false;
+    if (use_mpu) {
+        uint8_t int_status;
+        if (mpu_read_reg(MPU6050_REG_INT_STATUS, &int_status)) {
+            if (int_status & MPU6050_INT_MOT) {
+                motion_events++;
+                motion = true;
+            }
+        } else {
+            i2c_errors++;
+        }
+    }
+
+    // A PIR edge opens (or extends) the confirmation window
+    if (pir_edge) {
+        if (window_runs_left == 0) {
+            window_edges = 0;
+            window_motion = false;
+        }
+        window_edges++;
+        window_runs_left = confirm_window_runs;
+    }
+
+    if (window_runs_left > 0) {
+        window_motion = window_motion || motion;
+        if (window_edges >= confirm_pir_edges || window_motion) {
+            arrivals++;
+            window_runs_left = 0;
+            if (!wake_pending) {
+                wake_pending = 1;
+                ulp_riscv_wakeup_main_processor();
+            }
+        } else {
+            window_runs_left--;
+        }
+    }
+
+    uint32_t active_us = (uint32_t)((ulp_riscv_get_cpu_cycles() - start_cycles) / ULP_RISCV_CYCLES_PER_US);
+    active_us_total += active_us;
+    if (active_us > active_us_max) {
+        active_us_max = active_us;
+    }
+
+    // Returning halts the ULP until the next timer wakeup
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include "wifi_module.h"
+#include "ui_strings.h"
+#include "project_config.h"
+#include <esp_event.h>
+#include <esp_log.h>
+#include <esp_netif.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/timers.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "WiFiModule";
+
+#define WIFI_CONNECTED_BIT      BIT0
+
+// Module state
+static bool module_initialized = false;
+static EventGroupHandle_t wifi_events = NULL;
+static TimerHandle_t reconnect_timer = NULL;
+static uint32_t reconnect_delay_ms = 0;
+static int64_t connect_start_us = 0;
+static wifi_stats_t stats = {0};
+
+static void reconnect_timer_callback(TimerHandle_t timer)
+{
+    connect_start_us = esp_timer_get_time();
+    esp_err_t ret = esp_wifi_connect();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Reconnect failed to start: %s", esp_err_to_name(ret));
+    }
+}
+
+static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        connect_start_us = esp_timer_get_time();
+        esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        const wifi_event_sta_disconnected_t *event = (const wifi_event_sta_disconnected_t *)event_data;
+        if (xEventGroupGetBits(wifi_events) & WIFI_CONNECTED_BIT) {
+            stats.disconnects++;
+            ESP_LOGW(TAG, "Disconnected (reason %d)", event->reason);
+        }
+        xEventGroupClearBits(wifi_events, WIFI_CONNECTED_BIT);
+        stats.connected = false;
+        stats.rssi = 0;
+
+        // Back off so a missing access point does not keep the radio busy
+        reconnect_delay_ms = reconnect_delay_ms == 0 ? CONFIG_WIFI_RECONNECT_MIN_MS : reconnect_delay_ms * 2;
+        if (reconnect_delay_ms > CONFIG_WIFI_RECONNECT_MAX_MS) {
+            reconnect_delay_ms = CONFIG_WIFI_RECONNECT_MAX_MS;
+        }
+        xTimerChangePeriod(reconnect_timer, pdMS_TO_TICKS(reconnect_delay_ms), 0);
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        const ip_event_got_ip_t *event = (const ip_event_got_ip_t *)event_data;
+        stats.connects++;
+        stats.connected = true;
+        stats.last_connect_ms = (uint32_t)((esp_timer_get_time() - connect_start_us) / 1000);
+        reconnect_delay_ms = 0;
+
+        wifi_ap_record_t ap;
+        if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) {
+            stats.rssi = ap.rssi;
+        }
+        ESP_LOGI(TAG, "Connected, IP " IPSTR " after %lu ms, RSSI %d dBm",
+                 IP2STR(&event->ip_info.ip), (unsigned long)stats.last_connect_ms, stats.rssi);
+        xEventGroupSetBits(wifi_events, WIFI_CONNECTED_BIT);
+    }
+}
+
+esp_err_t wifi_module_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Wi-Fi module already initialized");
+        return ESP_OK;
+    }
+
+    if (strlen(CONFIG_WIFI_SSID) == 0) {
+        ESP_LOGW(TAG, "No SSID configured, Wi-Fi disabled");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ESP_LOGI(TAG, "Initializing Wi-Fi station...");
+
+    wifi_events = xEventGroupCreate();
+    reconnect_timer = xTimerCreate("wifi_retry", pdMS_TO_TICKS(CONFIG_WIFI_RECONNECT_MIN_MS), pdFALSE,
+                                   NULL, reconnect_timer_callback);
+    if (wifi_events == NULL || reconnect_timer == NULL) {
+        ESP_LOGE(TAG, "Failed to create Wi-Fi event group or timer");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = esp_netif_init();
+    if (ret == ESP_OK) {
+        ret = esp_event_loop_create_default();
+        if (ret == ESP_ERR_INVALID_STATE) {
+            ret = ESP_OK;   // Already created by another module
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Network stack initialization failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    esp_netif_create_default_wifi_sta();
+
+    wifi_init_config_t init_config = WIFI_INIT_CONFIG_DEFAULT();
+    ret = esp_wifi_init(&init_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Wi-Fi driver initialization failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, wifi_event_handler, NULL, NULL);
+    esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, wifi_event_handler, NULL, NULL);
+
+    wifi_config_t wifi_config = {
+        .sta = {
+            .threshold.authmode = strlen(CONFIG_WIFI_PASSWORD) > 0 ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN,
+        },
+    };
+    strncpy((char *)wifi_config.sta.ssid, CONFIG_WIFI_SSID, sizeof(wifi_config.sta.ssid));
+    strncpy((char *)wifi_config.sta.password, CONFIG_WIFI_PASSWORD, sizeof(wifi_config.sta.password));
+
+    ret = esp_wifi_set_mode(WIFI_MODE_STA);
+    if (ret == ESP_OK) {
+        ret = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_wifi_start();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start Wi-Fi: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    module_initialized = true;
+    ESP_LOGI(TAG, "Connecting to %s...", CONFIG_WIFI_SSID);
+
+    return ESP_OK;
+}
+
+bool wifi_is_connected(void)
+{
+    return module_initialized && (xEventGroupGetBits(wifi_events) & WIFI_CONNECTED_BIT) != 0;
+}
+
+esp_err_t wifi_wait_connected(uint32_t timeout_ms)
+{
+    if (!module_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    EventBits_t bits = xEventGroupWaitBits(wifi_events, WIFI_CONNECTED_BIT, pdFALSE, pdTRUE,
+                                           pdMS_TO_TICKS(timeout_ms));
+    return (bits & WIFI_CONNECTED_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t wifi_get_stats(wifi_stats_t *out)
+{
+    if (out == NULL) {
+        return ESP_FAIL;
+    }
+
+    *out = stats;
+    return ESP_OK;
+}
+
+esp_err_t wifi_get_status_string(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size < 16) {
+        return ESP_FAIL;
+    }
+
+    snprintf(buffer, buffer_size, "%s", ui_string(wifi_is_connected() ? UI_STR_WIFI_OK : UI_STR_WIFI_NONE));
+    return ESP_OK;
+}
@@ -0,0 +1,79 @@
+#ifndef WIFI_MODULE_H
+#define WIFI_MODULE_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file wifi_module.h
+ * @brief Wi-Fi station connection to CONFIG_WIFI_SSID
+ *
+ * Connects in the background and reconnects after a drop, backing off up to
+ * CONFIG_WIFI_RECONNECT_MAX_MS between attempts.
+ */
+
+/**
+ * @brief Wi-Fi statistics
+ */
+typedef struct {
+    bool connected;
+    uint32_t connects;              // Successful connections (IP acquired)
+    uint32_t disconnects;
+    uint32_t last_connect_ms;       // Connect request -> IP
+    int8_t rssi;                    // dBm, 0 when not connected
+} wifi_stats_t;
+
+/**
+ * @brief Initialize the network stack and start connecting
+ *
+ * Call after NVS is initialized. Returns without waiting for the connection.
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if no SSID is configured,
+ *         error code from the Wi-Fi driver otherwise
+ */
+esp_err_t wifi_module_init(void);
+
+/**
+ * @brief Check whether the station has an IP address
+ *
+ * @return true when connected
+ */
+bool wifi_is_connected(void);
+
+/**
+ * @brief Wait until the station has an IP address
+ *
+ * @param timeout_ms Maximum time to wait
+ * @return ESP_OK when connected, ESP_ERR_TIMEOUT otherwise,
+ *         ESP_ERR_INVALID_STATE if not initialized
+ */
+esp_err_t wifi_wait_connected(uint32_t timeout_ms);
+
+/**
+ * @brief Get Wi-Fi statistics
+ *
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL if stats is NULL
+ */
+esp_err_t wifi_get_stats(wifi_stats_t *stats);
+
+/**
+ * @brief Get formatted Wi-Fi status string for the status bar
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 16 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t wifi_get_status_string(char *buffer, size_t buffer_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WIFI_MODULE_H
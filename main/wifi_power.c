@@ -0,0 +1,502 @@
+#include "wifi_power.h"
+#include "energy_module.h"
+#include "presence_module.h"
+#include "service_task.h"
+#include "wifi_module.h"
+#include "project_config.h"
+#include <esp_log.h>
+#include <esp_netif.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <ping/ping_sock.h>
+#include <sdkconfig.h>
+#include <stdio.h>
+#include <string.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+
+static const char *TAG = "WiFiPower";
+
+#define MIN_RATE_WINDOW_US          (60LL * 1000000)    // Shorter spans give meaningless hourly rates
+
+/**
+ * @brief Driver settings of a level
+ */
+typedef struct {
+    wifi_ps_type_t ps;
+    uint16_t listen_interval;       // Beacons between wakes under WIFI_PS_MAX_MODEM, 0: unused
+    bool light_sleep;
+} level_config_t;
+
+static const level_config_t level_config[WIFI_POWER_COUNT] = {
+    [WIFI_POWER_PERFORMANCE] = { WIFI_PS_NONE, 0, false },
+    [WIFI_POWER_RESPONSIVE]  = { WIFI_PS_MIN_MODEM, 0, false },
+    [WIFI_POWER_SAVING]      = { WIFI_PS_MAX_MODEM, CONFIG_WIFI_POWER_LISTEN_IDLE, false },
+    [WIFI_POWER_MINIMAL]     = { WIFI_PS_MAX_MODEM, CONFIG_WIFI_POWER_LISTEN_AWAY, CONFIG_WIFI_POWER_LIGHT_SLEEP_AWAY },
+};
+
+// Module state
+static bool module_initialized = false;
+static SemaphoreHandle_t level_mutex = NULL;
+static volatile wifi_power_level_t current_level = WIFI_POWER_RESPONSIVE;
+static bool dialogue_active = false;
+static int64_t dialogue_since_us = 0;
+static uint32_t holds = 0;
+static uint16_t applied_listen_interval = 0;
+static volatile uint16_t level_listen_interval[WIFI_POWER_COUNT];  // Read back from the driver, 0: not yet
+static bool applied_light_sleep = false;
+static service_job_handle_t ping_job = NULL;
+static int64_t ping_due_us = 0;
+
+// Level accounting, read by the UI
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t level_since_us = 0;
+static uint32_t level_switches = 0;
+static uint64_t level_active_us[WIFI_POWER_COUNT];
+static uint32_t level_entries[WIFI_POWER_COUNT];
+static uint32_t pings_sent[WIFI_POWER_COUNT];
+static uint32_t pings_received[WIFI_POWER_COUNT];
+static uint64_t ping_sum_ms[WIFI_POWER_COUNT];
+static uint32_t ping_max_ms[WIFI_POWER_COUNT];
+
+// Ping round in progress, counted only if the level held for all of it
+static volatile bool ping_running = false;
+static wifi_power_level_t round_level;
+static uint32_t round_switches;
+static uint32_t round_received;
+static uint32_t round_sum_ms;
+static uint32_t round_max_ms;
+
+static wifi_power_level_t level_for_state(presence_state_t state)
+{
+    switch (state) {
+        case PRESENCE_STATE_IDLE:   return WIFI_POWER_SAVING;
+        case PRESENCE_STATE_AWAY:   return WIFI_POWER_MINIMAL;
+        default:                    return WIFI_POWER_RESPONSIVE;
+    }
+}
+
+/**
+ * @brief Fraction of the time the receiver is on while associated and quiet
+ *
+ * Under max modem sleep the wake period is the listen interval the driver
+ * reported when the level was last applied, the configured one until then.
+ */
+static float radio_duty(wifi_power_level_t level)
+{
+    uint32_t beacons;
+    switch (level_config[level].ps) {
+        case WIFI_PS_MIN_MODEM:
+            beacons = CONFIG_WIFI_POWER_DTIM_PERIOD;
+            break;
+        case WIFI_PS_MAX_MODEM:
+            beacons = level_listen_interval[level] != 0 ? level_listen_interval[level]
+                                                        : level_config[level].listen_interval;
+            break;
+        default:
+            return 1.0f;
+    }
+    float duty = (float)CONFIG_WIFI_POWER_WAKE_MS / ((float)beacons * CONFIG_WIFI_POWER_BEACON_MS);
+    return duty < 1.0f ? duty : 1.0f;
+}
+
+static void configure_light_sleep(bool enable)
+{
+    if (enable == applied_light_sleep) {
+        return;
+    }
+#if CONFIG_PM_ENABLE
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .light_sleep_enable = enable,
+    };
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to %s automatic light sleep: %s", enable ? "enable" : "disable", esp_err_to_name(ret));
+        return;
+    }
+#endif
+    applied_light_sleep = enable;
+}
+
+/**
+ * @brief Switch the driver to a level; level_mutex must be held
+ */
+static void apply_level(wifi_power_level_t level, const char *reason)
+{
+    const level_config_t *config = &level_config[level];
+
+    // Only max modem sleep uses it; the ping rounds show whether the driver took it while associated
+    if (config->listen_interval != 0) {
+        wifi_config_t wifi_config;
+        esp_err_t ret = esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
+        if (ret == ESP_OK && config->listen_interval != applied_listen_interval) {
+            wifi_config.sta.listen_interval = config->listen_interval;
+            ret = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+            if (ret == ESP_OK) {
+                ret = esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
+            }
+        }
+        if (ret == ESP_OK) {
+            // 0 leaves the driver at its default of 3 beacons
+            applied_listen_interval = wifi_config.sta.listen_interval != 0 ? wifi_config.sta.listen_interval : 3;
+            level_listen_interval[level] = applied_listen_interval;
+            if (applied_listen_interval != config->listen_interval) {
+                ESP_LOGW(TAG, "Driver listen interval is %u, not %u", applied_listen_interval, config->listen_interval);
+            }
+        } else {
+            ESP_LOGW(TAG, "Failed to set listen interval %u: %s", config->listen_interval, esp_err_to_name(ret));
+        }
+    }
+    esp_err_t ret = esp_wifi_set_ps(config->ps);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set power save mode %d: %s", config->ps, esp_err_to_name(ret));
+    }
+    configure_light_sleep(config->light_sleep);
+    energy_set_duty(ENERGY_CONSUMER_WIFI_RX, radio_duty(level));
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&stats_lock);
+    wifi_power_level_t old_level = current_level;
+    uint64_t spent_us = (uint64_t)(now_us - level_since_us);
+    level_active_us[old_level] += spent_us;
+    level_entries[level]++;
+    level_since_us = now_us;
+    level_switches++;
+    current_level = level;
+    portEXIT_CRITICAL(&stats_lock);
+
+    // Transfers come and go all the time; presence and dialogue changes are worth a line
+    if (strcmp(reason, "transfer") == 0) {
+        ESP_LOGD(TAG, "%s -> %s (%s)", wifi_power_level_to_string(old_level), wifi_power_level_to_string(level), reason);
+    } else {
+        ESP_LOGI(TAG, "%s -> %s (%s) after %lu s",
+                 wifi_power_level_to_string(old_level), wifi_power_level_to_string(level), reason,
+                 (unsigned long)(spent_us / 1000000));
+    }
+
+    // Measure a level soon after entering it, unless it already has samples
+    if (strcmp(reason, "transfer") != 0 || pings_sent[level] == 0) {
+        int64_t due_us = now_us + (int64_t)CONFIG_WIFI_POWER_PING_SETTLE_S * 1000000;
+        portENTER_CRITICAL(&stats_lock);
+        bool sooner = due_us < ping_due_us;
+        if (sooner) {
+            ping_due_us = due_us;
+        }
+        portEXIT_CRITICAL(&stats_lock);
+        if (sooner) {
+            service_job_wake(ping_job);
+        }
+    }
+}
+
+/**
+ * @brief Pick the level for the current inputs; level_mutex must be held
+ */
+static void select_level(const char *reason)
+{
+    wifi_power_level_t level = (dialogue_active || holds > 0) ? WIFI_POWER_PERFORMANCE
+                                                              : level_for_state(presence_get_state());
+    if (level != current_level) {
+        apply_level(level, reason);
+    }
+}
+
+static void presence_changed(presence_state_t new_state, presence_state_t old_state, void *user_ctx)
+{
+    xSemaphoreTake(level_mutex, portMAX_DELAY);
+    select_level("presence");
+    xSemaphoreGive(level_mutex);
+}
+
+static void on_ping_success(esp_ping_handle_t session, void *args)
+{
+    uint32_t elapsed_ms = 0;
+    esp_ping_get_profile(session, ESP_PING_PROF_TIMEGAP, &elapsed_ms, sizeof(elapsed_ms));
+    round_received++;
+    round_sum_ms += elapsed_ms;
+    if (elapsed_ms > round_max_ms) {
+        round_max_ms = elapsed_ms;
+    }
+}
+
+static void on_ping_end(esp_ping_handle_t session, void *args)
+{
+    uint32_t transmitted = 0;
+    esp_ping_get_profile(session, ESP_PING_PROF_REQUEST, &transmitted, sizeof(transmitted));
+
+    portENTER_CRITICAL(&stats_lock);
+    bool valid = round_switches == level_switches;
+    if (valid) {
+        pings_sent[round_level] += transmitted;
+        pings_received[round_level] += round_received;
+        ping_sum_ms[round_level] += round_sum_ms;
+        if (round_max_ms > ping_max_ms[round_level]) {
+            ping_max_ms[round_level] = round_max_ms;
+        }
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    if (!valid) {
+        ESP_LOGD(TAG, "Ping round discarded, level changed during it");
+    } else if (round_received > 0) {
+        ESP_LOGI(TAG, "Gateway ping at %s: %lu/%lu replies, mean %lu ms, max %lu ms",
+                 wifi_power_level_to_string(round_level), (unsigned long)round_received,
+                 (unsigned long)transmitted, (unsigned long)(round_sum_ms / round_received),
+                 (unsigned long)round_max_ms);
+    } else {
+        ESP_LOGW(TAG, "Gateway ping at %s: no replies to %lu requests",
+                 wifi_power_level_to_string(round_level), (unsigned long)transmitted);
+    }
+
+    esp_ping_delete_session(session);
+    ping_running = false;
+}
+
+static esp_err_t start_ping_round(void)
+{
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    esp_netif_ip_info_t ip_info;
+    if (netif == NULL || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK || ip_info.gw.addr == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ip_addr_t gateway = IPADDR4_INIT(ip_info.gw.addr);
+    esp_ping_config_t config = ESP_PING_DEFAULT_CONFIG();
+    config.target_addr = gateway;
+    config.count = CONFIG_WIFI_POWER_PING_COUNT;
+
+    esp_ping_callbacks_t callbacks = {
+        .cb_args = NULL,
+        .on_ping_success = on_ping_success,
+        .on_ping_timeout = NULL,
+        .on_ping_end = on_ping_end,
+    };
+
+    portENTER_CRITICAL(&stats_lock);
+    round_level = current_level;
+    round_switches = level_switches;
+    portEXIT_CRITICAL(&stats_lock);
+    round_received = 0;
+    round_sum_ms = 0;
+    round_max_ms = 0;
+
+    esp_ping_handle_t session;
+    esp_err_t ret = esp_ping_new_session(&config, &callbacks, &session);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ping_running = true;
+    ret = esp_ping_start(session);
+    if (ret != ESP_OK) {
+        ping_running = false;
+        esp_ping_delete_session(session);
+    }
+    return ret;
+}
+
+static uint32_t ping_job_run(void *user_ctx)
+{
+    int64_t now_us = esp_timer_get_time();
+    int64_t dialogue_deadline_us = dialogue_since_us + (int64_t)CONFIG_WIFI_POWER_DIALOGUE_TIMEOUT_S * 1000000;
+
+    // A dialogue whose end was never reported must not keep the radio on all day
+    if (dialogue_active && now_us >= dialogue_deadline_us) {
+        ESP_LOGW(TAG, "Dialogue mode still on after %d s, ending it", CONFIG_WIFI_POWER_DIALOGUE_TIMEOUT_S);
+        wifi_power_set_dialogue(false);
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    int64_t due_us = ping_due_us;
+    portEXIT_CRITICAL(&stats_lock);
+    if (!ping_running && now_us >= due_us) {
+        bool started = wifi_is_connected() && start_ping_round() == ESP_OK;
+        due_us = now_us + (int64_t)(started ? CONFIG_WIFI_POWER_PING_INTERVAL_S : CONFIG_WIFI_POWER_PING_SETTLE_S) * 1000000;
+        portENTER_CRITICAL(&stats_lock);
+        ping_due_us = due_us;
+        portEXIT_CRITICAL(&stats_lock);
+    }
+
+    int64_t next_us = due_us;
+    if (dialogue_active && dialogue_deadline_us < next_us) {
+        next_us = dialogue_deadline_us;
+    }
+    int64_t delay_ms = (next_us - now_us) / 1000;
+    return delay_ms > 1000 ? (uint32_t)delay_ms : 1000;
+}
+
+esp_err_t wifi_power_init(void)
+{
+    if (module_initialized) {
+        ESP_LOGW(TAG, "Wi-Fi power save already initialized");
+        return ESP_OK;
+    }
+
+    level_mutex = xSemaphoreCreateMutex();
+    if (level_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create level mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+#if !CONFIG_PM_ENABLE
+    if (CONFIG_WIFI_POWER_LIGHT_SLEEP_AWAY) {
+        ESP_LOGW(TAG, "CONFIG_PM_ENABLE is off, no light sleep when away");
+    }
+#endif
+
+    int64_t now_us = esp_timer_get_time();
+    level_since_us = now_us;
+    ping_due_us = now_us + (int64_t)CONFIG_WIFI_POWER_PING_SETTLE_S * 1000000;
+
+    const service_job_config_t job_config = {
+        .name = "wifi_power",
+        .run = ping_job_run,
+        .user_ctx = NULL,
+        .first_delay_ms = CONFIG_WIFI_POWER_PING_SETTLE_S * 1000,
+        .dedicated_stack = CONFIG_TASK_STACK_WIFI_POWER,
+        .dedicated_priority = CONFIG_TASK_PRIORITY_WIFI_POWER,
+    };
+    if (service_job_add(&job_config, &ping_job) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add the ping job");
+        vSemaphoreDelete(level_mutex);
+        level_mutex = NULL;
+        return ESP_FAIL;
+    }
+
+    // The driver starts in min modem sleep, which is the responsive level
+    xSemaphoreTake(level_mutex, portMAX_DELAY);
+    module_initialized = true;
+    energy_set_duty(ENERGY_CONSUMER_WIFI_RX, radio_duty(current_level));
+    select_level("presence");
+    xSemaphoreGive(level_mutex);
+
+    esp_err_t ret = presence_register_listener(presence_changed, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No presence listener slot, staying %s", wifi_power_level_to_string(current_level));
+    }
+
+    ESP_LOGI(TAG, "Wi-Fi power save initialized (%s, listen %d/%d beacons idle/away)",
+             wifi_power_level_to_string(current_level), CONFIG_WIFI_POWER_LISTEN_IDLE, CONFIG_WIFI_POWER_LISTEN_AWAY);
+
+    return ESP_OK;
+}
+
+void wifi_power_set_dialogue(bool active)
+{
+    if (!module_initialized) {
+        return;
+    }
+
+    xSemaphoreTake(level_mutex, portMAX_DELAY);
+    if (active && !dialogue_active) {
+        dialogue_since_us = esp_timer_get_time();
+    }
+    dialogue_active = active;
+    select_level("dialogue");
+    xSemaphoreGive(level_mutex);
+
+    // The job watches for a dialogue that is never ended
+    if (active) {
+        service_job_wake(ping_job);
+    }
+}
+
+void wifi_power_hold(bool hold)
+{
+    if (!module_initialized) {
+        return;
+    }
+
+    xSemaphoreTake(level_mutex, portMAX_DELAY);
+    if (hold) {
+        holds++;
+    } else if (holds > 0) {
+        holds--;
+    }
+    select_level("transfer");
+    xSemaphoreGive(level_mutex);
+}
+
+wifi_power_level_t wifi_power_get_level(void)
+{
+    return current_level;
+}
+
+esp_err_t wifi_power_get_stats(wifi_power_level_t level, wifi_power_stats_t *stats)
+{
+    if (stats == NULL || level >= WIFI_POWER_COUNT) {
+        return ESP_FAIL;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&stats_lock);
+    uint64_t active_us = level_active_us[level];
+    if (level == current_level) {
+        active_us += (uint64_t)(now_us - level_since_us);
+    }
+    uint32_t entries = level_entries[level];
+    uint32_t sent = pings_sent[level];
+    uint32_t received = pings_received[level];
+    uint64_t sum_ms = ping_sum_ms[level];
+    uint32_t max_ms = ping_max_ms[level];
+    portEXIT_CRITICAL(&stats_lock);
+
+    memset(stats, 0, sizeof(wifi_power_stats_t));
+    stats->active_s = (uint32_t)(active_us / 1000000);
+    stats->entries = entries;
+    stats->pings_sent = sent;
+    stats->pings_received = received;
+    stats->ping_mean_ms = received > 0 ? (uint32_t)(sum_ms / received) : 0;
+    stats->ping_max_ms = max_ms;
+    stats->radio_on_s_per_hour = (uint32_t)(radio_duty(level) * 3600.0f + 0.5f);
+
+    return ESP_OK;
+}
+
+esp_err_t wifi_power_get_status_string(char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return ESP_FAIL;
+    }
+
+    // Radio-on time per hour over all levels, weighted by the time spent in each
+    uint64_t total_s = 0;
+    float radio_s = 0.0f;
+    int len = snprintf(buffer, buffer_size, "WiFi ping ms/radio s/h:");
+    for (int i = 0; i < WIFI_POWER_COUNT && len < (int)buffer_size; i++) {
+        wifi_power_stats_t s;
+        wifi_power_get_stats((wifi_power_level_t)i, &s);
+        total_s += s.active_s;
+        radio_s += (float)s.radio_on_s_per_hour * s.active_s;
+        if (s.pings_received > 0) {
+            len += snprintf(buffer + len, buffer_size - len, " %s %lu/%lu", wifi_power_level_to_string((wifi_power_level_t)i),
+                            (unsigned long)s.ping_mean_ms, (unsigned long)s.radio_on_s_per_hour);
+        } else {
+            len += snprintf(buffer + len, buffer_size - len, " %s -/%lu", wifi_power_level_to_string((wifi_power_level_t)i),
+                            (unsigned long)s.radio_on_s_per_hour);
+        }
+    }
+    if (len < (int)buffer_size && total_s * 1000000 >= (uint64_t)MIN_RATE_WINDOW_US) {
+        len += snprintf(buffer + len, buffer_size - len, ", avg %lu", (unsigned long)(radio_s / total_s + 0.5f));
+    }
+    if (len < (int)buffer_size) {
+        snprintf(buffer + len, buffer_size - len, " (now %s)", wifi_power_level_to_string(current_level));
+    }
+    return ESP_OK;
+}
+
+const char* wifi_power_level_to_string(wifi_power_level_t level)
+{
+    switch (level) {
+        case WIFI_POWER_PERFORMANCE:    return "perf";
+        case WIFI_POWER_RESPONSIVE:     return "resp";
+        case WIFI_POWER_SAVING:         return "save";
+        case WIFI_POWER_MINIMAL:        return "min";
+        default:                        return "unknown";
+    }
+}
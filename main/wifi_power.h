@@ -0,0 +1,118 @@
+#ifndef WIFI_POWER_H
+#define WIFI_POWER_H
+
+#include <esp_err.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file wifi_power.h
+ * @brief Presence-driven Wi-Fi power save
+ *
+ * The radio only has to listen often while someone can notice the delay.
+ * The level follows the presence state. When present, the station wakes
+ * for every DTIM beacon. When idle or away, it wakes only every
+ * CONFIG_WIFI_POWER_LISTEN_IDLE or CONFIG_WIFI_POWER_LISTEN_AWAY beacons.
+ * When away, the chip may also light-sleep between beacons.
+ *
+ * Dialogue mode and direct transfers switch to full performance at once.
+ * Each level is measured with ping rounds to the gateway. Its radio-on
+ * time is estimated from the beacon wakeups and reported to the energy
+ * model.
+ */
+
+/**
+ * @brief Wi-Fi power levels
+ */
+typedef enum {
+    WIFI_POWER_PERFORMANCE,     // Dialogue or transfer: no power save
+    WIFI_POWER_RESPONSIVE,      // Present: modem sleep, wake every DTIM
+    WIFI_POWER_SAVING,          // Idle: modem sleep, wake every CONFIG_WIFI_POWER_LISTEN_IDLE beacons
+    WIFI_POWER_MINIMAL,         // Away: every CONFIG_WIFI_POWER_LISTEN_AWAY beacons, optional light sleep
+    WIFI_POWER_COUNT
+} wifi_power_level_t;
+
+/**
+ * @brief Statistics of one level since boot
+ */
+typedef struct {
+    uint32_t active_s;              // Time the level was active
+    uint32_t entries;               // Switches into the level
+    uint32_t pings_sent;            // Gateway pings in complete rounds
+    uint32_t pings_received;
+    uint32_t ping_mean_ms;          // Round trip, 0 before the first reply
+    uint32_t ping_max_ms;
+    uint32_t radio_on_s_per_hour;   // Estimated from the beacon wakeups at the driver's listen interval
+} wifi_power_stats_t;
+
+/**
+ * @brief Follow the presence state
+ *
+ * Call after wifi_module_init() and presence_module_init().
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM or ESP_FAIL on error
+ */
+esp_err_t wifi_power_init(void);
+
+/**
+ * @brief Enter or leave dialogue mode
+ *
+ * Switches to full performance at once. Dialogue mode ends on its own after
+ * CONFIG_WIFI_POWER_DIALOGUE_TIMEOUT_S.
+ *
+ * @param active true when a dialogue starts, false when it ends
+ */
+void wifi_power_set_dialogue(bool active);
+
+/**
+ * @brief Keep full performance during a transfer
+ *
+ * Calls nest: every hold must be released.
+ *
+ * @param hold true to acquire, false to release
+ */
+void wifi_power_hold(bool hold);
+
+/**
+ * @brief Get the active level
+ *
+ * @return Active level (WIFI_POWER_RESPONSIVE before init)
+ */
+wifi_power_level_t wifi_power_get_level(void);
+
+/**
+ * @brief Get statistics of a level
+ *
+ * @param level Level
+ * @param stats Pointer to store the statistics
+ * @return ESP_OK on success, ESP_FAIL on invalid arguments
+ */
+esp_err_t wifi_power_get_stats(wifi_power_level_t level, wifi_power_stats_t *stats);
+
+/**
+ * @brief Get formatted ping and radio-on time per level for the diagnostics screen
+ *
+ * @param buffer Buffer to store the formatted string (should be at least 96 bytes)
+ * @param buffer_size Size of the buffer
+ * @return ESP_OK on success, ESP_FAIL on error
+ */
+esp_err_t wifi_power_get_status_string(char *buffer, size_t buffer_size);
+
+/**
+ * @brief Get printable name of a level
+ *
+ * @param level Level
+ * @return Constant string
+ */
+const char* wifi_power_level_to_string(wifi_power_level_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WIFI_POWER_H
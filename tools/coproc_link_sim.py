@@ -0,0 +1,370 @@
+#!/usr/bin/env python3
+"""Host-side stand-in for the Orange Pi end of the co-processor link.
+
+Speaks the framed protocol from main/coproc_link.h over a serial port (for
+example a USB-UART adapter wired to the ESP32-S3 link pins) and models the
+co-processor power states, so the ESP-side orchestration can be exercised
+without the real board:
+
+    OFF/BOOTING --(boot delay)--> RUNNING --SUSPEND--> SUSPENDED/OFF
+    SUSPENDED --RESUME--> RESUMING --(resume delay)--> RUNNING
+
+While RUNNING it emits an ACTION_RESULT every --result-interval seconds.
+
+After PREVIEW_START it streams RGB565 frames as RLE-coded PREVIEW_STRIPE
+messages, keeping at most the requested number of frames unacknowledged.
+Frames are a moving test pattern, or come from --preview-source (a video file
+or camera index, needs OpenCV).
+
+With --net-proxy it also serves offloaded HTTP(S) requests while RUNNING
+(tools/net_proxy.py), so the ESP falls back to Wi-Fi while it is not.
+
+With --sfx it plays the UI sound effects (tools/sfx_mixer.py) on a simulated
+DAC, or on --alsa DEVICE, and reports each one's start back to the ESP.
+
+Usage (inside the ESP-IDF Python environment, which ships pyserial):
+    python tools/coproc_link_sim.py --port /dev/ttyUSB0
+    python tools/coproc_link_sim.py --port /dev/ttyUSB0 --boot-delay 2 --preview-source clips/desk.mp4
+"""
+
+import argparse
+import binascii
+import random
+import struct
+import threading
+import time
+
+import serial
+
+SYNC = 0xA5
+MAX_PAYLOAD = 512
+
+MSG_PING = 0x01
+MSG_PONG = 0x02
+MSG_SUSPEND = 0x10
+MSG_SUSPEND_ACK = 0x11
+MSG_RESUME = 0x12
+MSG_READY = 0x13
+MSG_ACTION_RESULT = 0x20
+MSG_PREVIEW_START = 0x30
+MSG_PREVIEW_STOP = 0x31
+MSG_PREVIEW_STRIPE = 0x32
+MSG_PREVIEW_ACK = 0x33
+MSG_NET_REQUEST = 0x40          # Through MSG_NET_CANCEL, see net_proxy.py
+MSG_NET_CANCEL = 0x46
+MSG_SFX_PLAY = 0x50
+
+STRIPE_HEADER = struct.Struct("<HHBB")
+PREVIEW_LAST_STRIPE = 0x01
+
+ACTIONS = ["EMPTY", "BED", "PC", "STUDY", "PHONE", "TABLET", "DRINK"]
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, same as crc16_update() in coproc_link.c."""
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+def rle_encode_row(pixels):
+    """RLE of one row of RGB565 values, as decoded by camera_preview.c.
+
+    Control byte 0x00-0x7F: control + 1 literal pixels follow.
+    Control byte 0x80-0xFF: the next pixel repeats control - 0x7F times.
+    """
+    out = bytearray()
+    literal = []
+
+    def flush():
+        while literal:
+            chunk = literal[:128]
+            del literal[:128]
+            out.append(len(chunk) - 1)
+            out.extend(struct.pack("<%dH" % len(chunk), *chunk))
+
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while i + run < len(pixels) and run < 128 and pixels[i + run] == pixels[i]:
+            run += 1
+        if run >= 2:
+            flush()
+            out.append(0x7F + run)
+            out += struct.pack("<H", pixels[i])
+        else:
+            literal.append(pixels[i])
+        i += run
+    flush()
+    return bytes(out)
+
+
+class PreviewSource:
+    """Frames as rows of RGB565 values: a test pattern or OpenCV capture."""
+
+    def __init__(self, source):
+        self.cap = None
+        self.tick = 0
+        if source is not None:
+            import cv2      # Only needed for real frames
+            self.cv2 = cv2
+            self.cap = cv2.VideoCapture(int(source) if source.isdigit() else source)
+            if not self.cap.isOpened():
+                raise SystemExit("error: cannot open preview source %s" % source)
+
+    def frame(self, width, height):
+        self.tick += 1
+        if self.cap is None:
+            # Flat bands with a moving bar: long runs, like a mostly still room
+            bar = self.tick * 2 % width
+            rows = []
+            for y in range(height):
+                band = (y * 8 // height) & 0x07
+                color = ((band * 4) << 11) | ((band * 8) << 5) | (31 - band * 4)
+                row = [color] * width
+                for x in range(bar, min(width, bar + 8)):
+                    row[x] = 0xFFFF
+                rows.append(row)
+            return rows
+
+        ok, image = self.cap.read()
+        if not ok:
+            self.cap.set(self.cv2.CAP_PROP_POS_FRAMES, 0)
+            ok, image = self.cap.read()
+            if not ok:
+                raise SystemExit("error: preview source gave no frames")
+        image = self.cv2.resize(image, (width, height), interpolation=self.cv2.INTER_AREA)
+        b = image[:, :, 0].astype("uint16") >> 3
+        g = image[:, :, 1].astype("uint16") >> 2
+        r = image[:, :, 2].astype("uint16") >> 3
+        return ((r << 11) | (g << 5) | b).tolist()
+
+
+def stripes_of(frame_id, rows):
+    """Pack whole rows into PREVIEW_STRIPE payloads of at most MAX_PAYLOAD bytes."""
+    encoded = [rle_encode_row(row) for row in rows]
+    payloads = []
+    y = 0
+    while y < len(encoded):
+        data = bytearray()
+        count = 0
+        while (y + count < len(encoded) and count < 255 and
+               STRIPE_HEADER.size + len(data) + len(encoded[y + count]) <= MAX_PAYLOAD):
+            data += encoded[y + count]
+            count += 1
+        last = PREVIEW_LAST_STRIPE if y + count == len(encoded) else 0
+        payloads.append(STRIPE_HEADER.pack(frame_id & 0xFFFF, y, count, last) + data)
+        y += count
+    return payloads
+
+
+class Preview:
+    """Streams frames while the ESP has credits left."""
+
+    def __init__(self, link, source):
+        self.link = link
+        self.source = source
+        self.cond = threading.Condition()
+        self.request = None             # (width, height, max_fps, frames_in_flight)
+        self.in_flight = set()
+        self.frame_id = 0
+        self.sent = 0
+        self.bytes = 0
+
+    def start(self, payload):
+        width, height, max_fps, frames_in_flight = struct.unpack_from("<HHBB", payload)
+        print("  preview %dx%d, %d fps, %d in flight" % (width, height, max_fps, frames_in_flight))
+        with self.cond:
+            self.request = (width, height, max(1, max_fps), max(1, frames_in_flight))
+            self.in_flight.clear()
+            self.cond.notify()
+
+    def stop(self):
+        with self.cond:
+            if self.request is not None:
+                print("  preview stopped after %d frames, %d bytes" % (self.sent, self.bytes))
+            self.request = None
+            self.cond.notify()
+
+    def ack(self, payload):
+        if len(payload) >= 2:
+            with self.cond:
+                self.in_flight.discard(struct.unpack_from("<H", payload)[0])
+                self.cond.notify()
+
+    def loop(self):
+        while True:
+            with self.cond:
+                while self.request is None or len(self.in_flight) >= self.request[3]:
+                    # Frames whose ACK got lost would stall the stream forever
+                    if not self.cond.wait(timeout=2.0) and self.in_flight:
+                        self.in_flight.clear()
+                width, height, max_fps, _ = self.request
+                self.frame_id = (self.frame_id + 1) & 0xFFFF
+                self.in_flight.add(self.frame_id)
+
+            started = time.monotonic()
+            for payload in stripes_of(self.frame_id, self.source.frame(width, height)):
+                self.link.send(MSG_PREVIEW_STRIPE, payload)
+                self.bytes += len(payload) + 7
+            self.sent += 1
+            time.sleep(max(0.0, 1.0 / max_fps - (time.monotonic() - started)))
+
+
+class Link:
+    def __init__(self, port, baud):
+        self.ser = serial.Serial(port, baud, timeout=0.05)
+        self.tx_lock = threading.Lock()
+        self.seq = 0
+
+    def send(self, msg_type, payload=b""):
+        body = struct.pack("<BBH", msg_type, self.seq & 0xFF, len(payload)) + payload
+        frame = bytes([SYNC]) + body + struct.pack("<H", crc16(body))
+        with self.tx_lock:
+            self.ser.write(frame)
+            self.seq += 1
+
+    def frames(self):
+        """Yield (type, payload) for every valid frame received."""
+        buf = bytearray()
+        while True:
+            buf += self.ser.read(256)
+            while True:
+                start = buf.find(bytes([SYNC]))
+                if start < 0:
+                    buf.clear()
+                    break
+                del buf[:start]
+                if len(buf) < 5:
+                    break
+                msg_type, _seq, length = struct.unpack_from("<BBH", buf, 1)
+                if length > MAX_PAYLOAD:
+                    del buf[:1]
+                    continue
+                if len(buf) < 5 + length + 2:
+                    break
+                body = bytes(buf[1:5 + length])
+                (crc,) = struct.unpack_from("<H", buf, 5 + length)
+                del buf[:5 + length + 2]
+                if crc != crc16(body):
+                    print("! CRC error on 0x%02x" % msg_type)
+                    continue
+                yield msg_type, body[4:]
+
+
+class Coprocessor:
+    def __init__(self, link, args, preview, net_proxy=None, sfx=None):
+        self.link = link
+        self.args = args
+        self.preview = preview
+        self.net_proxy = net_proxy
+        self.sfx = sfx
+        self.state = "BOOTING"
+        self.state_lock = threading.Lock()
+        self.frame_id = 0
+        self.timer = None
+        self._after(args.boot_delay, self._ready)
+
+    def _set(self, state):
+        print("%8.3f  state %s -> %s" % (time.monotonic(), self.state, state))
+        self.state = state
+
+    def _after(self, delay, fn):
+        if self.timer:
+            self.timer.cancel()
+        self.timer = threading.Timer(delay, fn)
+        self.timer.daemon = True
+        self.timer.start()
+
+    def _ready(self):
+        with self.state_lock:
+            if self.state in ("BOOTING", "RESUMING"):
+                self._set("RUNNING")
+                self.link.send(MSG_READY)
+
+    def handle(self, msg_type, payload):
+        with self.state_lock:
+            if msg_type == MSG_PING:
+                self.link.send(MSG_PONG)
+            elif msg_type == MSG_SUSPEND:
+                power_off = bool(payload[0]) if payload else False
+                self.preview.stop()
+                self.link.send(MSG_SUSPEND_ACK)
+                self._set("OFF" if power_off else "SUSPENDED")
+            elif msg_type == MSG_RESUME:
+                if self.state == "SUSPENDED":
+                    self._set("RESUMING")
+                    self._after(self.args.resume_delay, self._ready)
+                elif self.state == "RUNNING":
+                    self.link.send(MSG_READY)
+            elif msg_type == MSG_PREVIEW_START:
+                self.preview.start(payload)
+            elif msg_type == MSG_PREVIEW_STOP:
+                self.preview.stop()
+            elif msg_type == MSG_PREVIEW_ACK:
+                self.preview.ack(payload)
+            elif self.net_proxy is not None and MSG_NET_REQUEST <= msg_type <= MSG_NET_CANCEL:
+                # Unanswered while not RUNNING, so the ESP falls back to Wi-Fi
+                if self.state == "RUNNING":
+                    self.net_proxy.handle(msg_type, payload)
+            elif self.sfx is not None and msg_type == MSG_SFX_PLAY:
+                self.sfx.handle(payload, playing=self.state == "RUNNING")
+            else:
+                print("  unhandled message 0x%02x (%d bytes)" % (msg_type, len(payload)))
+
+    def power_cycle(self):
+        """Model the ESP closing the power switch after an OFF."""
+        with self.state_lock:
+            if self.state == "OFF":
+                self._set("BOOTING")
+                self._after(self.args.boot_delay, self._ready)
+
+    def results_loop(self):
+        while True:
+            time.sleep(self.args.result_interval)
+            with self.state_lock:
+                if self.state != "RUNNING":
+                    continue
+                self.frame_id += 1
+                action = random.randrange(len(ACTIONS))
+                self.link.send(MSG_ACTION_RESULT,
+                               struct.pack("<BBI", action, random.randint(60, 99), self.frame_id))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", required=True, help="serial port wired to the ESP link UART")
+    parser.add_argument("--baud", type=int, default=921600)
+    parser.add_argument("--boot-delay", type=float, default=25.0, help="cold boot to READY (s)")
+    parser.add_argument("--resume-delay", type=float, default=1.5, help="RESUME to READY (s)")
+    parser.add_argument("--result-interval", type=float, default=1.0, help="seconds between results")
+    parser.add_argument("--preview-source", help="video file or camera index for the preview (default: test pattern)")
+    parser.add_argument("--net-proxy", action="store_true", help="serve offloaded HTTP(S) requests")
+    parser.add_argument("--ca", help="CA file the proxy verifies upstream servers with")
+    parser.add_argument("--sfx", action="store_true", help="play UI sound effects")
+    parser.add_argument("--sfx-dir", help="directory with tap.wav, shake.wav, press.wav (default: synthesized)")
+    parser.add_argument("--alsa", help="ALSA device for the sound effects (default: simulated DAC)")
+    args = parser.parse_args()
+
+    link = Link(args.port, args.baud)
+    preview = Preview(link, PreviewSource(args.preview_source))
+    net_proxy = None
+    if args.net_proxy:
+        from net_proxy import NetProxy
+        net_proxy = NetProxy(link.send, ca=args.ca)
+    sfx = None
+    if args.sfx:
+        from sfx_mixer import SfxPlayer
+        sfx = SfxPlayer(link.send, effects=args.sfx_dir, alsa=args.alsa)
+    coproc = Coprocessor(link, args, preview, net_proxy, sfx)
+    threading.Thread(target=coproc.results_loop, daemon=True).start()
+    threading.Thread(target=preview.loop, daemon=True).start()
+
+    print("Simulating co-processor on %s (type 'p' + Enter to restore power after OFF)" % args.port)
+    threading.Thread(target=lambda: [coproc.power_cycle() for line in iter(input, None) if line.strip() == "p"],
+                     daemon=True).start()
+
+    for msg_type, payload in link.frames():
+        coproc.handle(msg_type, payload)
+
+
+if __name__ == "__main__":
+    main()
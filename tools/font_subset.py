@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+"""Keep the UI font glyph set equal to the characters the UI draws.
+
+Runs as a build step from main/CMakeLists.txt:
+
+    check     extract the codepoints of the string literals in main/ui_strings.c,
+              and of the modules given with --sources that format status and
+              diagnostics text, and fail if the font lacks any of them; report
+              glyphs the font carries that no string uses and the flash bytes
+              of the exact subset against the current font and against full
+              Unicode blocks.
+    generate  rerun lv_font_conv with the options recorded in the font header,
+              replacing --symbols/--range with exactly the codepoints in use,
+              then check. Needs lv_font_conv (npm i -g lv_font_conv) and the
+              TTF named in the header under --font-dir.
+
+    python tools/font_subset.py check --strings main/ui_strings.c --font main/fonts/chinese_font_16.c \
+        --sources main/coproc_module.c main/energy_module.c
+    python tools/font_subset.py generate --strings main/ui_strings.c --font main/fonts/chinese_font_16.c --font-dir ~/fonts
+"""
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+from collections import defaultdict
+
+TABLE_RE = re.compile(r"ui_strings\[[^\]]*\]\s*=\s*\{(.*?)\n\};", re.S)
+LITERAL_RE = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+CONVERSION_RE = re.compile(r"%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z|j|t)?([diouxXfFeEgGcsp%])")
+COMMENT_RE = re.compile(r'"(?:[^"\\\n]|\\.)*"|//[^\n]*|/\*.*?\*/', re.S)
+NOT_DRAWN_RE = re.compile(r'#\s*include[^\n]*|\bESP_(?:LOG|EARLY_LOG|DRAM_LOG)\w*\s*\((?:[^;"]|"(?:[^"\\]|\\.)*")*;'
+                          r'|\bTAG\s*=\s*"[^"]*"', re.S)
+
+OPTS_RE = re.compile(r"Opts:(.*?)\n\s*\*{5,}", re.S)
+BITMAP_RE = re.compile(r"glyph_bitmap\[\]\s*=\s*\{(.*?)\};", re.S)
+GLYPH_DSC_RE = re.compile(r"\{\.bitmap_index = (\d+),")
+CMAP_RE = re.compile(r"\.range_start = (\d+), \.range_length = (\d+), \.glyph_id_start = (\d+),\s*"
+                     r"\.unicode_list = (\w+), \.glyph_id_ofs_list = (\w+), \.list_length = (\d+), \.type = (\w+)")
+ARRAY_RE = r"static const \w+ %s\[\]\s*=\s*\{(.*?)\};"
+
+GLYPH_DSC_BYTES = 8     # lv_font_fmt_txt_glyph_dsc_t without LV_FONT_FMT_TXT_LARGE
+CMAP_BYTES = 16
+
+# Blocks a font would otherwise be generated from with --range
+BLOCKS = [
+    (0x0020, 0x007E, "Basic Latin"),
+    (0x00A0, 0x00FF, "Latin-1 Supplement"),
+    (0x2000, 0x206F, "General Punctuation"),
+    (0x3000, 0x303F, "CJK Symbols and Punctuation"),
+    (0x4E00, 0x9FFF, "CJK Unified Ideographs"),
+    (0xFF00, 0xFFEF, "Halfwidth and Fullwidth Forms"),
+]
+
+# Options of lv_font_conv that take a value
+VALUE_OPTIONS = {"--bpp", "--size", "--font", "--range", "--symbols", "--format", "-o", "--output",
+                 "--stride", "--align", "--lv-include", "--lv-font-name", "--lv-fallback"}
+
+
+def unescape(literal):
+    """Decode a C string literal body; the file is UTF-8."""
+    out = bytearray()
+    raw = literal.encode("utf-8")
+    i = 0
+    while i < len(raw):
+        c = raw[i]
+        if c != 0x5C:
+            out.append(c)
+            i += 1
+            continue
+        esc = chr(raw[i + 1])
+        if esc == "x":
+            match = re.match(rb"[0-9a-fA-F]+", raw[i + 2:])
+            out.append(int(match.group(0), 16) & 0xFF)
+            i += 2 + len(match.group(0))
+            continue
+        out += {"n": b"\n", "t": b"\t", "r": b"\r", "0": b"\0"}.get(esc, esc.encode())
+        i += 2
+    return out.decode("utf-8")
+
+
+def add_text(used, text, origin):
+    """Add the codepoints a text draws; conversions count by the characters they print."""
+    chars = []
+    for conv in CONVERSION_RE.finditer(text):
+        kind = conv.group(1)
+        if kind in "diouxX":
+            chars += "0123456789-" if kind in "di" else "0123456789"
+            if kind in "xX":
+                chars += "abcdef" if kind == "x" else "ABCDEF"
+        elif kind in "fFeEgG":
+            chars += "0123456789-.e"
+        elif kind == "%":
+            chars.append("%")
+    chars += CONVERSION_RE.sub("", text)
+    for ch in chars:
+        if ord(ch) >= 0x20:
+            used.setdefault(ord(ch), origin)
+
+
+def string_codepoints(path):
+    """Return ({codepoint: first text using it}, number of texts) for the string table."""
+    with open(path, encoding="utf-8") as f:
+        source = f.read()
+    table = TABLE_RE.search(source)
+    if not table:
+        sys.exit("error: %s: ui_strings table not found" % path)
+
+    used = {}
+    texts = [unescape(m.group(1)) for m in LITERAL_RE.finditer(table.group(1))]
+    for text in texts:
+        add_text(used, text, text)
+    return used, len(texts)
+
+
+def source_codepoints(paths, used):
+    """Add the string literals of modules that format screen text (status, diagnostics, names).
+
+    Every literal outside comments, includes, log calls and TAG names counts, so the set is a
+    superset of what these modules can draw.
+    """
+    count = 0
+    for path in paths:
+        with open(path, encoding="utf-8") as f:
+            source = f.read()
+        source = COMMENT_RE.sub(lambda m: m.group(0) if m.group(0).startswith('"') else " ", source)
+        source = NOT_DRAWN_RE.sub(" ", source)
+        for match in LITERAL_RE.finditer(source):
+            text = unescape(match.group(1))
+            add_text(used, text, "%s: %s" % (os.path.basename(path), text))
+            count += 1
+    return count
+
+
+class Font:
+    def __init__(self, path):
+        with open(path, encoding="utf-8") as f:
+            source = f.read()
+        self.path = path
+        opts = OPTS_RE.search(source)
+        self.opts = " ".join(opts.group(1).split()) if opts else ""
+
+        bitmap = BITMAP_RE.search(source)
+        self.bitmap_bytes = bitmap.group(1).count("0x") if bitmap else 0
+        self.bitmap_index = [int(x) for x in GLYPH_DSC_RE.findall(source)]
+
+        self.glyphs = {}        # codepoint -> glyph id
+        self.list_entries = 0
+        cmaps = CMAP_RE.findall(source)
+        self.cmap_count = len(cmaps)
+        for start, length, glyph_start, unicode_list, ofs_list, list_length, kind in cmaps:
+            start, length, glyph_start, list_length = int(start), int(length), int(glyph_start), int(list_length)
+            ofs = self._array(source, ofs_list)
+            if kind.startswith("LV_FONT_FMT_TXT_CMAP_FORMAT0"):
+                for i in range(length):
+                    if ofs is None:
+                        self.glyphs[start + i] = glyph_start + i
+                    elif ofs[i] or i == 0:
+                        self.glyphs[start + i] = glyph_start + ofs[i]
+            else:
+                codes = self._array(source, unicode_list) or []
+                self.list_entries += list_length
+                for i, delta in enumerate(codes):
+                    self.glyphs[start + delta] = glyph_start + (ofs[i] if ofs is not None else i)
+
+    @staticmethod
+    def _array(source, name):
+        if name == "NULL":
+            return None
+        match = re.search(ARRAY_RE % re.escape(name), source, re.S)
+        return [int(x, 0) for x in re.findall(r"0x[0-9a-fA-F]+|\d+", match.group(1))] if match else None
+
+    def glyph_bytes(self, glyph_id):
+        """Bitmap plus descriptor bytes of one glyph."""
+        index = self.bitmap_index[glyph_id]
+        following = [i for i in self.bitmap_index if i > index]
+        end = min(following) if following else self.bitmap_bytes
+        return end - index + GLYPH_DSC_BYTES
+
+    def total_bytes(self):
+        return (self.bitmap_bytes + GLYPH_DSC_BYTES * len(self.bitmap_index)
+                + 2 * self.list_entries + CMAP_BYTES * self.cmap_count)
+
+
+def block_of(codepoint):
+    for start, end, name in BLOCKS:
+        if start <= codepoint <= end:
+            return (start, end, name)
+    return (codepoint, codepoint, "U+%04X" % codepoint)
+
+
+def report(used, text_count, font):
+    present = {cp for cp in used if cp in font.glyphs}
+    missing = sorted(cp for cp in used if cp not in font.glyphs)
+    unused = sorted(cp for cp in font.glyphs if cp not in used and cp >= 0x20)
+
+    name = os.path.basename(font.path)
+    print("UI strings: %d texts, %d codepoints" % (text_count, len(used)))
+    print("%s: %d glyphs, %d not used by any string%s" % (
+        name, len(font.glyphs), len(unused),
+        (": " + "".join(chr(cp) for cp in unused)) if unused and len(unused) <= 64 else ""))
+
+    if not missing:
+        # Average glyph cost per block, measured on the glyphs the font has
+        per_block = defaultdict(list)
+        for cp, glyph in font.glyphs.items():
+            per_block[block_of(cp)].append(font.glyph_bytes(glyph))
+        overall = [b for sizes in per_block.values() for b in sizes]
+        overall_avg = sum(overall) / len(overall) if overall else 0
+
+        subset = sum(font.glyph_bytes(font.glyphs[cp]) for cp in present)
+        blocks = {block_of(cp) for cp in used}
+        full = 0
+        for start, end, _name in blocks:
+            sizes = per_block.get((start, end, _name))
+            avg = sum(sizes) / len(sizes) if sizes else overall_avg
+            full += avg * (end - start + 1)
+        print("Glyph data: exact subset %d B, current font %d B, full blocks ~%d B (%s)" % (
+            subset, font.total_bytes(), full, ", ".join(b[2] for b in sorted(blocks))))
+        print("Saved: %d B against the current font, ~%d B against full blocks" % (
+            max(font.total_bytes() - subset, 0), max(full - subset, 0)))
+
+    return missing
+
+
+def used_codepoints(args):
+    used, text_count = string_codepoints(args.strings)
+    text_count += source_codepoints(args.sources, used)
+    return used, text_count
+
+
+def cmd_check(args):
+    used, text_count = used_codepoints(args)
+    font = Font(args.font)
+    missing = report(used, text_count, font)
+    if missing:
+        for cp in missing:
+            print("error: %s has no glyph for '%s' U+%04X, used in \"%s\"" % (
+                os.path.basename(args.font), chr(cp), cp, used[cp]), file=sys.stderr)
+        print("error: regenerate the font with tools/font_subset.py generate", file=sys.stderr)
+        sys.exit(1)
+
+
+def conv_arguments(opts, symbols, font_dir, out_path):
+    """Rebuild the lv_font_conv command line from the recorded options."""
+    opts = re.sub(r"--symbols .*?(?=\s--|\s-o\s|$)", "", opts)
+    tokens = opts.split()
+    args, i = [], 0
+    while i < len(tokens):
+        token = tokens[i]
+        value = tokens[i + 1] if token in VALUE_OPTIONS and i + 1 < len(tokens) else None
+        i += 2 if value is not None else 1
+        if token in ("--range", "-o", "--output"):
+            continue
+        if token == "--font":
+            path = os.path.join(font_dir, os.path.basename(value))
+            if not os.path.isfile(path):
+                sys.exit("error: %s not found" % path)
+            value = path
+        args.append(token)
+        if value is not None:
+            args.append(value)
+    return args + ["--symbols", symbols, "-o", out_path]
+
+
+def cmd_generate(args):
+    used, _text_count = used_codepoints(args)
+    font = Font(args.font)
+    if "--font" not in font.opts:
+        sys.exit("error: %s has no lv_font_conv options in its header" % args.font)
+
+    conv = shutil.which(args.lv_font_conv)
+    if conv is None:
+        sys.exit("error: %s not found (npm i -g lv_font_conv)" % args.lv_font_conv)
+
+    symbols = "".join(chr(cp) for cp in sorted(used))
+    out_path = os.path.abspath(args.font)
+    command = [conv] + conv_arguments(font.opts, symbols, args.font_dir, os.path.basename(out_path))
+    # lv_font_conv records -o as given, so run it next to the font
+    subprocess.run(command, check=True, cwd=os.path.dirname(out_path))
+    cmd_check(args)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+    for name, func, help_text in (("check", cmd_check, "fail on glyphs missing from the font"),
+                                  ("generate", cmd_generate, "regenerate the font from the string table")):
+        cmd = sub.add_parser(name, help=help_text)
+        cmd.add_argument("--strings", required=True, help="C file holding the ui_strings table")
+        cmd.add_argument("--font", required=True, help="lv_font_conv C output")
+        cmd.add_argument("--sources", nargs="*", default=[],
+                         help="C files that format screen text outside the table")
+        if name == "generate":
+            cmd.add_argument("--font-dir", required=True, help="directory containing the source TTF")
+            cmd.add_argument("--lv-font-conv", default="lv_font_conv")
+        cmd.set_defaults(func=func)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,320 @@
+#!/usr/bin/env python3
+"""Turn a hot_profile capture into a linker fragment placing hot code in IRAM.
+
+Build with CONFIG_HOT_PROFILE_ENABLE 1, flash, let the device run a
+representative workload and capture the monitor output until the
+"HOTPROF end" line. Then:
+
+    python tools/hot_placement.py generate --log profile.log --map build/<project>.map
+
+maps the sampled PCs to functions through the linker map, picks the hottest
+flash-resident functions within CONFIG_HOT_PLACEMENT_IRAM_BUDGET and the read-only
+tables of the hottest code and of the fonts on screen within
+CONFIG_HOT_PLACEMENT_DRAM_BUDGET, and writes main/hot_placement.lf, which
+main/CMakeLists.txt picks up on the next build. Profile the new build the same
+way and compare the render time statistics:
+
+    python tools/hot_placement.py compare before.log after.log
+"""
+
+import argparse
+import bisect
+import os
+import re
+import sys
+from collections import defaultdict
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PROJECT_CONFIG = os.path.join(REPO_ROOT, "main", "project_config.h")
+DEFAULT_OUT = os.path.join(REPO_ROOT, "main", "hot_placement.lf")
+
+# ESP32-S3 cached flash windows
+IROM = (0x42000000, 0x44000000)
+DROM = (0x3C000000, 0x3E000000)
+
+# Code that reads glyph tables; its samples are shared out between the fonts on screen
+FONT_CODE_RE = re.compile(r"font|glyph|letter|^_?lv_txt_|^lv_draw_label")
+# Merged strings and constant pools have no symbol to map
+UNNAMED_RODATA_RE = re.compile(r"^(str\d|cst\d)")
+
+SECTION_RE = re.compile(r"^ (\.(literal|text|rodata)\.(\S+))(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$")
+ADDRESS_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+ORIGIN_RE = re.compile(r"([^/\\(]+\.a)\(([^)]+)\)")
+
+PROF_BEGIN_RE = re.compile(r"HOTPROF begin duration_ms=(\d+) sample_hz=(\d+) block=(\d+) samples=(\d+) flash=(\d+)")
+HOTPC_RE = re.compile(r"HOTPC 0x([0-9a-fA-F]+) (\d+)")
+HOTFONT_RE = re.compile(r"HOTFONT 0x([0-9a-fA-F]+) (\d+)")
+HOTFRAME_RE = re.compile(r"HOTFRAME frames=(\d+) mean_us=(\d+) stddev_us=(\d+) max_us=(\d+)")
+
+
+def config_value(name, default):
+    """Read a numeric #define from main/project_config.h."""
+    try:
+        with open(PROJECT_CONFIG, encoding="utf-8") as f:
+            match = re.search(r"^#define\s+%s\s+(\d+)" % name, f.read(), re.M)
+        return int(match.group(1)) if match else default
+    except OSError:
+        return default
+
+
+def object_name(filename):
+    """display_module.c.obj -> display_module, as ldgen entries expect."""
+    name = filename
+    for _ in range(2):
+        name, ext = os.path.splitext(name)
+        if not ext:
+            break
+    return name
+
+
+class Section:
+    def __init__(self, kind, symbol, address, size, archive, obj):
+        self.kind = kind
+        self.symbol = symbol
+        self.address = address
+        self.size = size
+        self.archive = archive
+        self.obj = obj
+
+    @property
+    def key(self):
+        return (self.archive, self.obj, self.symbol)
+
+
+def parse_map(path):
+    """Return the flash-resident text/literal/rodata input sections of a GNU ld map."""
+    sections = []
+    in_memory_map = False
+    pending = None
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not in_memory_map:
+                in_memory_map = line.startswith("Linker script and memory map")
+                continue
+            if pending is not None:
+                match = ADDRESS_RE.match(line)
+                if match:
+                    sections.append(_section(pending, *match.groups()))
+                pending = None
+                continue
+            match = SECTION_RE.match(line)
+            if not match:
+                continue
+            _full, kind, symbol, address, size, origin = match.groups()
+            if address is None:
+                pending = (kind, symbol)
+            else:
+                sections.append(_section((kind, symbol), address, size, origin))
+    return [s for s in sections if s is not None]
+
+
+def _section(name, address, size, origin):
+    kind, symbol = name
+    origin_match = ORIGIN_RE.search(origin)
+    if not origin_match:
+        return None
+    address = int(address, 16)
+    size = int(size, 16)
+    window = DROM if kind == "rodata" else IROM
+    if size == 0 or not window[0] <= address < window[1]:
+        return None
+    if kind == "rodata" and UNNAMED_RODATA_RE.match(symbol):
+        return None
+    return Section(kind, symbol, address, size, origin_match.group(1), object_name(origin_match.group(2)))
+
+
+def parse_profile(path):
+    profile = {"pcs": [], "fonts": [], "frame": None, "header": None}
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            match = PROF_BEGIN_RE.search(line)
+            if match:
+                # Keep only the last capture in the log
+                profile = {"pcs": [], "fonts": [], "frame": None,
+                           "header": dict(zip(("duration_ms", "sample_hz", "block", "samples", "flash"),
+                                              map(int, match.groups())))}
+                continue
+            match = HOTPC_RE.search(line)
+            if match:
+                profile["pcs"].append((int(match.group(1), 16), int(match.group(2))))
+                continue
+            match = HOTFONT_RE.search(line)
+            if match:
+                profile["fonts"].append((int(match.group(1), 16), int(match.group(2))))
+                continue
+            match = HOTFRAME_RE.search(line)
+            if match:
+                profile["frame"] = dict(zip(("frames", "mean_us", "stddev_us", "max_us"),
+                                            map(int, match.groups())))
+    if profile["header"] is None:
+        sys.exit("%s: no HOTPROF capture found" % path)
+    return profile
+
+
+class AddressIndex:
+    def __init__(self, sections):
+        self.sections = sorted(sections, key=lambda s: s.address)
+        self.starts = [s.address for s in self.sections]
+
+    def find(self, address):
+        i = bisect.bisect_right(self.starts, address) - 1
+        if i >= 0 and address < self.sections[i].address + self.sections[i].size:
+            return self.sections[i]
+        return None
+
+
+def select_code(profile, sections, budget, min_samples):
+    text = [s for s in sections if s.kind == "text"]
+    literal_size = {s.key: s.size for s in sections if s.kind == "literal"}
+    index = AddressIndex(text)
+    block = profile["header"]["block"]
+
+    samples = defaultdict(int)
+    unmapped = 0
+    for address, count in profile["pcs"]:
+        section = index.find(address) or index.find(address + block // 2)
+        if section is None:
+            unmapped += count
+        else:
+            samples[section.key] += count
+
+    by_key = {s.key: s for s in text}
+    ranked = sorted(samples.items(), key=lambda kv: -kv[1])
+    chosen, used = [], 0
+    for key, count in ranked:
+        if count < min_samples:
+            break
+        size = by_key[key].size + literal_size.get(key, 0)
+        if used + size <= budget:
+            chosen.append((key, count, size))
+            used += size
+    return chosen, used, samples, unmapped
+
+
+def select_data(profile, sections, samples, budget, min_weight):
+    rodata = [s for s in sections if s.kind == "rodata"]
+    index = AddressIndex(rodata)
+
+    # Hot code reads the tables of its own object
+    weight = defaultdict(float)
+    for (archive, obj, _symbol), count in samples.items():
+        weight[(archive, obj)] += count
+
+    # Glyph tables are read by LVGL code, so font code samples go to the fonts on screen
+    font_samples = sum(c for (_a, _o, symbol), c in samples.items() if FONT_CODE_RE.search(symbol))
+    font_objects = sum(n for _addr, n in profile["fonts"])
+    for address, objects in profile["fonts"]:
+        font = index.find(address)
+        if font is not None and font_objects > 0:
+            weight[(font.archive, font.obj)] += font_samples * objects / font_objects
+
+    tables = defaultdict(list)
+    for s in rodata:
+        if (s.archive, s.obj) in weight:
+            tables[(s.archive, s.obj)].append(s)
+
+    def density(obj_key):
+        return weight[obj_key] / sum(s.size for s in tables[obj_key])
+
+    chosen, used = [], 0
+    for obj_key in sorted(tables, key=density, reverse=True):
+        if weight[obj_key] < min_weight:
+            continue
+        # Descriptor tables are touched for every glyph or lookup, bulk data last
+        for s in sorted(tables[obj_key], key=lambda s: s.size):
+            if used + s.size <= budget:
+                chosen.append((s.key, weight[obj_key], s.size))
+                used += s.size
+    return chosen, used
+
+
+def write_fragment(path, profile, code, code_used, code_budget, data, data_used, data_budget):
+    header = profile["header"]
+    entries = defaultdict(list)
+    for (archive, obj, symbol), count, size in code:
+        entries[archive].append(("%s:%s (noflash)" % (obj, symbol), "%d samples, %d bytes" % (count, size)))
+    for (archive, obj, symbol), weight, size in data:
+        entries[archive].append(("%s:%s (noflash_data)" % (obj, symbol), "weight %.0f, %d bytes" % (weight, size)))
+
+    with open(path, "w", encoding="utf-8") as f:
+        f.write("# Generated by tools/hot_placement.py from a %d ms profile (%d samples, %d in flash).\n"
+                % (header["duration_ms"], header["samples"], header["flash"]))
+        f.write("# Regenerate after profiling a new build; delete to return to the default placement.\n")
+        f.write("# IRAM %d of %d bytes, DRAM %d of %d bytes\n" % (code_used, code_budget, data_used, data_budget))
+        for archive in sorted(entries):
+            mapping = re.sub(r"[^A-Za-z0-9_]", "_", os.path.splitext(archive)[0])
+            f.write("\n[mapping:hot_placement_%s]\narchive: %s\nentries:\n" % (mapping, archive))
+            for entry, note in entries[archive]:
+                f.write("    # %s\n    %s\n" % (note, entry))
+
+
+def cmd_generate(args):
+    profile = parse_profile(args.log)
+    sections = parse_map(args.map)
+    if not sections:
+        sys.exit("%s: no flash input sections found, is this the linker map of the app?" % args.map)
+
+    flash = max(profile["header"]["flash"], 1)
+    min_samples = max(1, int(flash * args.min_share / 100.0))
+    code, code_used, samples, unmapped = select_code(profile, sections, args.iram_budget, min_samples)
+    data, data_used = select_data(profile, sections, samples, args.dram_budget, min_samples)
+
+    print("%d flash samples, %d not in any function of the map" % (profile["header"]["flash"], unmapped))
+    print("\nIRAM  %6d / %d bytes" % (code_used, args.iram_budget))
+    for (archive, obj, symbol), count, size in code:
+        print("  %5.1f%%  %6d B  %s:%s (%s)" % (count * 100.0 / flash, size, obj, symbol, archive))
+    print("\nDRAM  %6d / %d bytes" % (data_used, args.dram_budget))
+    for (archive, obj, symbol), _weight, size in data:
+        print("          %6d B  %s:%s (%s)" % (size, obj, symbol, archive))
+
+    write_fragment(args.out, profile, code, code_used, args.iram_budget, data, data_used, args.dram_budget)
+    print("\nWrote %s" % args.out)
+
+
+def cmd_compare(args):
+    before = parse_profile(args.before)["frame"]
+    after = parse_profile(args.after)["frame"]
+    if before is None or after is None:
+        sys.exit("HOTFRAME line missing from a capture")
+
+    def change(old, new):
+        return "%+.1f%%" % ((new - old) * 100.0 / old) if old else "n/a"
+
+    rows = [
+        ("frames", before["frames"], after["frames"]),
+        ("mean us", before["mean_us"], after["mean_us"]),
+        ("stddev us", before["stddev_us"], after["stddev_us"]),
+        ("variance us^2", before["stddev_us"] ** 2, after["stddev_us"] ** 2),
+        ("max us", before["max_us"], after["max_us"]),
+    ]
+    print("%-14s %12s %12s %9s" % ("", "before", "after", "change"))
+    for name, old, new in rows:
+        print("%-14s %12d %12d %9s" % (name, old, new, change(old, new)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    gen = sub.add_parser("generate", help="write the linker fragment from a profile capture")
+    gen.add_argument("--log", required=True, help="monitor output containing a HOTPROF capture")
+    gen.add_argument("--map", required=True, help="linker map of the profiled build")
+    gen.add_argument("--out", default=DEFAULT_OUT)
+    gen.add_argument("--iram-budget", type=int, default=config_value("CONFIG_HOT_PLACEMENT_IRAM_BUDGET", 24576))
+    gen.add_argument("--dram-budget", type=int, default=config_value("CONFIG_HOT_PLACEMENT_DRAM_BUDGET", 16384))
+    gen.add_argument("--min-share", type=float, default=0.2,
+                     help="ignore functions below this percentage of the flash samples")
+    gen.set_defaults(func=cmd_generate)
+
+    cmp = sub.add_parser("compare", help="compare render time statistics of two captures")
+    cmp.add_argument("before")
+    cmp.add_argument("after")
+    cmp.set_defaults(func=cmd_compare)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""Motion-gated inference scheduling for the action-recognition pipeline.
+
+The Orange Pi classifier only has to run when the scene changes. MotionGate
+scores every camera frame with a cheap difference of 32x24 grayscale
+thumbnails and decides per frame whether to run full inference:
+
+    spike     score far above the noise floor (or an ESP motion hint):
+              infer on this frame, no rate limit
+    motion    score above the noise floor: infer at most every --motion-interval
+    settle    scene quiet again after motion: infer once on the still frame
+    refresh   nothing happened for --max-interval: infer anyway
+
+The noise floor tracks the quiet-scene score so sensor noise and slow light
+changes do not count as motion. The pipeline on the board imports MotionGate;
+the replay command measures it on recorded clips on a Linux host:
+
+    replay  decode each clip, gate every frame and run the classifier on the
+            frames the gate picks, then report inferences per minute, CPU
+            utilization (one core, decoding excluded) and classification
+            latency against running the classifier on every frame.
+            --model takes an ONNX classifier for cv2.dnn; without it a busy
+            loop of --classify-ms stands in for the classifier. --verify also
+            classifies every frame and reports how often the gated label held
+            on screen matches it.
+
+    python tools/inference_gate.py replay clips/*.mp4 --model action.onnx
+    python tools/inference_gate.py replay clips/reading.mp4 --classify-ms 180 --verify
+
+Needs OpenCV and numpy (pip install opencv-python-headless numpy).
+"""
+
+import argparse
+import os
+import sys
+import time
+
+import cv2
+import numpy as np
+
+THUMB_SIZE = (32, 24)
+
+
+class MotionGate:
+    """Decide per frame whether to run the classifier."""
+
+    def __init__(self, min_threshold=0.012, floor_gain=3.0, spike_gain=4.0, floor_alpha=0.02,
+                 motion_interval=0.5, max_interval=10.0, settle_frames=3):
+        self.min_threshold = min_threshold      # Mean absolute difference, 0..1
+        self.floor_gain = floor_gain            # Motion threshold = floor_gain * noise floor
+        self.spike_gain = spike_gain            # Spike threshold = spike_gain * motion threshold
+        self.floor_alpha = floor_alpha
+        self.motion_interval = motion_interval
+        self.max_interval = max_interval
+        self.settle_frames = settle_frames
+        self.reset()
+
+    def reset(self):
+        self.prev = None
+        self.floor = self.min_threshold / self.floor_gain
+        self.last_infer = None
+        self.quiet_frames = 0
+        self.pending_settle = False
+        self.hinted = False
+        self.moving = False
+        self.motion_since = None                # Onset of motion not yet classified
+        self.onset = None                       # Onset the last inference answered, if any
+        self.score = 0.0
+
+    @staticmethod
+    def thumbnail(frame):
+        gray = cv2.cvtColor(frame, cv2.COLOR_BGR2GRAY) if frame.ndim == 3 else frame
+        return cv2.resize(gray, THUMB_SIZE, interpolation=cv2.INTER_AREA).astype(np.float32) / 255.0
+
+    def hint(self):
+        """External motion (PIR or IMU activity from the ESP) makes the next frame a spike."""
+        self.hinted = True
+
+    def threshold(self):
+        return max(self.min_threshold, self.floor * self.floor_gain)
+
+    def update(self, frame, t):
+        """Score the frame taken at time t (seconds); return the reason to infer or None."""
+        thumb = self.thumbnail(frame)
+        score = float(np.mean(np.abs(thumb - self.prev))) if self.prev is not None else 0.0
+        self.prev = thumb
+
+        threshold = self.threshold()
+        moving = score > threshold
+        if moving:
+            if not self.moving and self.motion_since is None:
+                self.motion_since = t
+            self.quiet_frames = 0
+            self.pending_settle = True
+        else:
+            self.quiet_frames += 1
+            self.floor += self.floor_alpha * (score - self.floor)
+
+        since = t - self.last_infer if self.last_infer is not None else None
+        reason = None
+        if self.last_infer is None:
+            reason = "refresh"
+        elif self.hinted or score > threshold * self.spike_gain:
+            reason = "spike"
+        elif moving and since >= self.motion_interval:
+            reason = "motion"
+        elif self.pending_settle and self.quiet_frames >= self.settle_frames:
+            reason = "settle"
+        elif since >= self.max_interval:
+            reason = "refresh"
+
+        self.score = score
+        self.moving = moving
+        if reason is not None:
+            self.hinted = False
+            self.last_infer = t
+            self.onset, self.motion_since = self.motion_since, None
+            if not moving:
+                self.pending_settle = False
+        return reason
+
+
+class Classifier:
+    """ONNX model through cv2.dnn, or a fixed-cost stand-in."""
+
+    def __init__(self, model, input_size, classify_ms):
+        self.net = cv2.dnn.readNet(model) if model else None
+        self.input_size = input_size
+        self.classify_ms = classify_ms
+
+    def __call__(self, frame):
+        if self.net is not None:
+            blob = cv2.dnn.blobFromImage(frame, 1.0 / 255, (self.input_size, self.input_size), swapRB=True)
+            self.net.setInput(blob)
+            return int(np.argmax(self.net.forward()))
+        end = time.process_time() + self.classify_ms / 1000.0
+        while time.process_time() < end:
+            pass
+        return 0
+
+
+def percentile(values, p):
+    return float(np.percentile(values, p)) if values else 0.0
+
+
+def replay_clip(path, gate, classify, args):
+    cap = cv2.VideoCapture(path)
+    if not cap.isOpened():
+        sys.exit("error: cannot open %s" % path)
+    fps = args.fps or cap.get(cv2.CAP_PROP_FPS) or 15.0
+
+    gate.reset()
+    frames = 0
+    reasons = {}
+    gate_cpu = classify_cpu = 0.0
+    latencies = []          # Classifier run time per inference (ms)
+    onset_delays = []       # Motion onset to result (ms, clip time plus classifier time)
+    label = None
+    agree = 0
+
+    while True:
+        ok, frame = cap.read()
+        if not ok:
+            break
+        t = frames / fps
+        frames += 1
+
+        c0 = time.process_time()
+        reason = gate.update(frame, t)
+        gate_cpu += time.process_time() - c0
+
+        if reason is not None:
+            w0 = time.perf_counter()
+            c0 = time.process_time()
+            label = classify(frame)
+            classify_cpu += time.process_time() - c0
+            run_ms = (time.perf_counter() - w0) * 1000.0
+            latencies.append(run_ms)
+            reasons[reason] = reasons.get(reason, 0) + 1
+            if gate.onset is not None:
+                onset_delays.append((t - gate.onset) * 1000.0 + run_ms)
+
+        if args.verify:
+            agree += classify(frame) == label
+
+    cap.release()
+    duration = frames / fps if frames else 0.0
+    return {
+        "name": os.path.basename(path),
+        "frames": frames,
+        "fps": fps,
+        "duration": duration,
+        "inferences": sum(reasons.values()),
+        "reasons": reasons,
+        "gate_cpu": gate_cpu,
+        "classify_cpu": classify_cpu,
+        "latencies": latencies,
+        "onset_delays": onset_delays,
+        "agree": agree,
+    }
+
+
+def print_result(r, args):
+    minutes = r["duration"] / 60.0 if r["duration"] else 1.0
+    per_infer_cpu = r["classify_cpu"] / r["inferences"] if r["inferences"] else 0.0
+    gated_util = (r["gate_cpu"] + r["classify_cpu"]) / r["duration"] if r["duration"] else 0.0
+    # Every frame classified, at the measured per-inference cost
+    full_util = r["frames"] * per_infer_cpu / r["duration"] if r["duration"] else 0.0
+
+    print("%s: %d frames, %.1f s at %.1f fps" % (r["name"], r["frames"], r["duration"], r["fps"]))
+    print("  inferences/min  gated %7.1f   every frame %7.1f   (%s)" % (
+        r["inferences"] / minutes, r["frames"] / minutes,
+        ", ".join("%s %d" % kv for kv in sorted(r["reasons"].items()))))
+    print("  CPU             gated %6.1f%%   every frame %6.1f%%   (gate alone %.2f%%, one core)" % (
+        100.0 * gated_util, 100.0 * full_util, 100.0 * r["gate_cpu"] / max(r["duration"], 1e-9)))
+    print("  classify ms     mean %.1f  p95 %.1f  max %.1f" % (
+        float(np.mean(r["latencies"])) if r["latencies"] else 0.0,
+        percentile(r["latencies"], 95), max(r["latencies"], default=0.0)))
+    if r["onset_delays"]:
+        print("  motion->result  mean %.0f ms  p95 %.0f ms  max %.0f ms" % (
+            float(np.mean(r["onset_delays"])), percentile(r["onset_delays"], 95), max(r["onset_delays"])))
+    if args.verify and r["frames"]:
+        print("  label agreement with every-frame inference %.1f%%" % (100.0 * r["agree"] / r["frames"]))
+
+
+def cmd_replay(args):
+    gate = MotionGate(min_threshold=args.min_threshold, motion_interval=args.motion_interval,
+                      max_interval=args.max_interval)
+    classify = Classifier(args.model, args.input_size, args.classify_ms)
+    if args.model is None:
+        print("No --model: classifier replaced by a %.0f ms busy loop" % args.classify_ms)
+
+    total = {"frames": 0, "duration": 0.0, "inferences": 0, "cpu": 0.0, "full_cpu": 0.0}
+    for path in args.clips:
+        r = replay_clip(path, gate, classify, args)
+        print_result(r, args)
+        per_infer_cpu = r["classify_cpu"] / r["inferences"] if r["inferences"] else 0.0
+        total["frames"] += r["frames"]
+        total["duration"] += r["duration"]
+        total["inferences"] += r["inferences"]
+        total["cpu"] += r["gate_cpu"] + r["classify_cpu"]
+        total["full_cpu"] += r["frames"] * per_infer_cpu
+
+    if len(args.clips) > 1 and total["duration"] > 0:
+        minutes = total["duration"] / 60.0
+        print("All clips: %.1f min, inferences/min gated %.1f every frame %.1f, CPU gated %.1f%% every frame %.1f%%" % (
+            minutes, total["inferences"] / minutes, total["frames"] / minutes,
+            100.0 * total["cpu"] / total["duration"], 100.0 * total["full_cpu"] / total["duration"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    replay = sub.add_parser("replay", help="measure the gate on recorded clips")
+    replay.add_argument("clips", nargs="+", help="video files")
+    replay.add_argument("--model", help="ONNX action classifier (cv2.dnn)")
+    replay.add_argument("--input-size", type=int, default=224, help="classifier input width and height")
+    replay.add_argument("--classify-ms", type=float, default=150.0, help="stand-in classifier cost without --model")
+    replay.add_argument("--fps", type=float, help="override the clip frame rate")
+    replay.add_argument("--min-threshold", type=float, default=0.012, help="lowest motion score threshold (0..1)")
+    replay.add_argument("--motion-interval", type=float, default=0.5, help="seconds between inferences while moving")
+    replay.add_argument("--max-interval", type=float, default=10.0, help="guaranteed refresh interval (s)")
+    replay.add_argument("--verify", action="store_true", help="also classify every frame and compare labels")
+    replay.set_defaults(func=cmd_replay)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,356 @@
+#!/usr/bin/env python3
+"""HTTP(S) proxy for the ESP32-S3, reached over the co-processor link.
+
+The ESP sends NET_REQUEST messages (main/coproc_link.h, main/net_client.c);
+the proxy makes the request over the Orange Pi's own network and streams
+the response back as NET_RESPONSE_BODY chunks, never more than the window
+the ESP asked for ahead of its NET_CREDIT messages. Every request is
+answered with NET_ACCEPT at once, so the ESP can fall back to Wi-Fi quickly
+when the proxy is not there.
+
+    serve   run the proxy alone on a serial port (the link simulator runs it
+            too with --net-proxy)
+    mock    local mock of the weather and dialogue APIs to benchmark against
+            (CONFIG_NET_BENCHMARK on the ESP): GET /weather returns a JSON
+            document, GET /stream and POST /chat stream tokens with chunked
+            encoding. Every closed connection is logged with its request
+            count and whether TLS was resumed from a session ticket, to check
+            keep-alive and resumption (main/conn_manager.c). With --cert/--key
+            it serves HTTPS; a certificate for the host IP can be made with
+              openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:P-256 -nodes -days 365 \\
+                -keyout key.pem -out cert.pem -subj /CN=192.168.1.20 -addext subjectAltName=IP:192.168.1.20
+            and given to the ESP as CONFIG_NET_CA_PEM and to the proxy as --ca.
+
+    python tools/net_proxy.py mock --port 8443 --cert cert.pem --key key.pem
+    python tools/net_proxy.py serve --port /dev/ttyUSB0 --ca cert.pem
+"""
+
+import argparse
+import http.client
+import http.server
+import json
+import socket
+import ssl
+import struct
+import sys
+import threading
+import time
+import urllib.parse
+
+MAX_PAYLOAD = 512
+
+MSG_NET_REQUEST = 0x40
+MSG_NET_REQUEST_BODY = 0x41
+MSG_NET_ACCEPT = 0x42
+MSG_NET_RESPONSE = 0x43
+MSG_NET_RESPONSE_BODY = 0x44
+MSG_NET_CREDIT = 0x45
+MSG_NET_CANCEL = 0x46
+NET_MESSAGES = range(MSG_NET_REQUEST, MSG_NET_CANCEL + 1)
+
+REQUEST_HEADER = struct.Struct("<BBBBII")
+RESPONSE_HEADER = struct.Struct("<BBHI")
+CHUNK_HEADER = struct.Struct("<BB")
+CHUNK_MAX = MAX_PAYLOAD - CHUNK_HEADER.size
+
+ERR_NONE = 0
+ERR_BUSY = 1
+ERR_NO_UPLINK = 2
+ERR_UPSTREAM = 3
+ERR_TIMEOUT = 4
+ERR_BAD_REQUEST = 5
+
+CHUNK_LAST = 0x01
+CHUNK_ERROR = 0x02
+LENGTH_UNKNOWN = 0xFFFFFFFF
+
+MAX_OPEN_REQUESTS = 4
+CREDIT_POLL_S = 0.5
+
+
+class ProxyRequest:
+    def __init__(self, req_id, method, window, body_len, timeout_ms, url, content_type):
+        self.id = req_id
+        self.method = "POST" if method == 1 else "GET"
+        self.credits = threading.Semaphore(max(1, window))
+        self.body_len = body_len
+        self.body = bytearray()
+        self.timeout = max(1.0, timeout_ms / 1000.0)
+        self.url = url
+        self.content_type = content_type
+        self.cancelled = threading.Event()
+
+
+class NetProxy:
+    """Serves NET_* messages; send(msg_type, payload) writes one link frame."""
+
+    def __init__(self, send, ca=None, insecure=False, verbose=True):
+        self.send = send
+        self.verbose = verbose
+        self.requests = {}
+        self.lock = threading.Lock()
+        if insecure:
+            self.context = ssl._create_unverified_context()
+        else:
+            self.context = ssl.create_default_context(cafile=ca)
+
+    def log(self, text):
+        if self.verbose:
+            print("%8.3f  net %s" % (time.monotonic(), text))
+
+    def handle(self, msg_type, payload):
+        """Return True when the message belonged to the proxy."""
+        if msg_type not in NET_MESSAGES or not payload:
+            return False
+        req_id = payload[0]
+        if msg_type == MSG_NET_REQUEST:
+            self._open(payload)
+        elif msg_type == MSG_NET_REQUEST_BODY:
+            with self.lock:
+                request = self.requests.get(req_id)
+            if request is not None:
+                request.body += payload[CHUNK_HEADER.size:]
+                if payload[1] & CHUNK_LAST:
+                    self._start(request)
+        elif msg_type == MSG_NET_CREDIT and len(payload) >= 2:
+            with self.lock:
+                request = self.requests.get(req_id)
+            for _ in range(payload[1] if request is not None else 0):
+                request.credits.release()
+        elif msg_type == MSG_NET_CANCEL:
+            with self.lock:
+                request = self.requests.pop(req_id, None)
+            if request is not None:
+                request.cancelled.set()
+                request.credits.release()
+                self.log("request %d cancelled" % req_id)
+        return True
+
+    def _open(self, payload):
+        if len(payload) < REQUEST_HEADER.size:
+            return
+        req_id, method, window, _flags, body_len, timeout_ms = REQUEST_HEADER.unpack_from(payload)
+        strings = payload[REQUEST_HEADER.size:].split(b"\0")
+        if len(strings) < 2 or not strings[0]:
+            self.send(MSG_NET_ACCEPT, bytes([req_id, ERR_BAD_REQUEST]))
+            return
+        url, content_type = strings[0].decode(), strings[1].decode()
+
+        with self.lock:
+            busy = len(self.requests) >= MAX_OPEN_REQUESTS
+            if not busy:
+                request = ProxyRequest(req_id, method, window, body_len, timeout_ms, url, content_type)
+                self.requests[req_id] = request
+        self.send(MSG_NET_ACCEPT, bytes([req_id, ERR_BUSY if busy else ERR_NONE]))
+        if busy:
+            self.log("request %d refused, %d open" % (req_id, MAX_OPEN_REQUESTS))
+            return
+        self.log("request %d %s %s (%d body bytes, window %d)" % (req_id, request.method, url, body_len, window))
+        if body_len == 0:
+            self._start(request)
+
+    def _start(self, request):
+        threading.Thread(target=self._run, args=(request,), daemon=True).start()
+
+    def _send_chunk(self, request, data, flags):
+        # Every chunk, the last one included, takes a credit
+        while not request.credits.acquire(timeout=CREDIT_POLL_S):
+            if request.cancelled.is_set():
+                return False
+        if request.cancelled.is_set():
+            return False
+        self.send(MSG_NET_RESPONSE_BODY, CHUNK_HEADER.pack(request.id, flags) + data)
+        return True
+
+    def _run(self, request):
+        started = time.monotonic()
+        parts = urllib.parse.urlsplit(request.url)
+        connection = None
+        sent = 0
+        try:
+            if parts.scheme == "https":
+                connection = http.client.HTTPSConnection(parts.hostname, parts.port or 443,
+                                                         timeout=request.timeout, context=self.context)
+            else:
+                connection = http.client.HTTPConnection(parts.hostname, parts.port or 80, timeout=request.timeout)
+            path = parts.path or "/"
+            if parts.query:
+                path += "?" + parts.query
+            headers = {"Content-Type": request.content_type} if request.content_type else {}
+            connection.request(request.method, path, body=bytes(request.body) or None, headers=headers)
+            response = connection.getresponse()
+        except (OSError, http.client.HTTPException) as e:
+            error = ERR_TIMEOUT if isinstance(e, socket.timeout) else ERR_UPSTREAM
+            self.log("request %d failed: %s" % (request.id, e))
+            self.send(MSG_NET_RESPONSE, RESPONSE_HEADER.pack(request.id, error, 0, 0))
+            self._close(request, connection)
+            return
+
+        length = response.getheader("Content-Length")
+        self.send(MSG_NET_RESPONSE, RESPONSE_HEADER.pack(
+            request.id, ERR_NONE, response.status, int(length) if length is not None else LENGTH_UNKNOWN))
+        ttfb = time.monotonic() - started
+
+        try:
+            while not request.cancelled.is_set():
+                data = response.read1(CHUNK_MAX)
+                if not data:
+                    self._send_chunk(request, b"", CHUNK_LAST)
+                    break
+                if not self._send_chunk(request, data, 0):
+                    break
+                sent += len(data)
+        except (OSError, http.client.HTTPException) as e:
+            self.log("request %d body failed: %s" % (request.id, e))
+            self._send_chunk(request, b"", CHUNK_LAST | CHUNK_ERROR)
+
+        self.log("request %d: %d, %d bytes, upstream ttfb %.0f ms, total %.0f ms" % (
+            request.id, response.status, sent, ttfb * 1000, (time.monotonic() - started) * 1000))
+        self._close(request, connection)
+
+    def _close(self, request, connection):
+        if connection is not None:
+            connection.close()
+        with self.lock:
+            if self.requests.get(request.id) is request:
+                del self.requests[request.id]
+
+
+# -----------------------------------------------------------------------------
+# Mock cloud APIs
+# -----------------------------------------------------------------------------
+
+WEATHER = {
+    "location": "Desk",
+    "current": {"temp_c": 21.5, "condition": "Rainy", "humidity": 78, "wind_kph": 12.2},
+    "forecast": [{"hour": h, "temp_c": 20 + (h % 5) * 0.5, "condition": "Cloudy", "rain_mm": 0.2 * (h % 3)}
+                 for h in range(24)],
+}
+
+
+class MockHandler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    token_delay = 0.05
+    tokens = 40
+    timeout = 60                # Idle keep-alive connections are closed after this
+    counts_lock = threading.Lock()
+    counts = {"connections": 0, "resumed": 0, "requests": 0}
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def setup(self):
+        super().setup()
+        resumed = getattr(self.connection, "session_reused", False)
+        with self.counts_lock:
+            self.counts["connections"] += 1
+            self.counts["resumed"] += resumed
+        self.conn_requests = 0
+
+    def handle_one_request(self):
+        self.command = None     # Stays None when the client closed instead of sending a request
+        super().handle_one_request()
+        if self.command:
+            self.conn_requests += 1
+            with self.counts_lock:
+                self.counts["requests"] += 1
+
+    def finish(self):
+        super().finish()
+        with self.counts_lock:
+            c = dict(self.counts)
+        tls = ""
+        if isinstance(self.connection, ssl.SSLSocket):
+            tls = ", TLS resumed" if self.connection.session_reused else ", TLS full handshake"
+        print("%s: %d requests on connection%s (total %d connections, %d resumed, %d requests)"
+              % (self.client_address[0], self.conn_requests, tls, c["connections"], c["resumed"], c["requests"]))
+
+    def _stream(self, prefix):
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+        for i in range(self.tokens):
+            time.sleep(self.token_delay)
+            data = ("data: {\"token\": \"%s%d \"}\n\n" % (prefix, i)).encode()
+            self.wfile.write(b"%x\r\n%s\r\n" % (len(data), data))
+            self.wfile.flush()
+        self.wfile.write(b"0\r\n\r\n")
+
+    def do_GET(self):
+        if self.path.startswith("/weather"):
+            body = json.dumps(WEATHER).encode()
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+        elif self.path.startswith("/stream"):
+            self._stream("tok")
+        else:
+            self.send_error(404)
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        self.rfile.read(length)
+        if self.path.startswith("/chat"):
+            self._stream("reply")
+        else:
+            self.send_error(404)
+
+
+def cmd_mock(args):
+    MockHandler.token_delay = args.token_ms / 1000.0
+    MockHandler.tokens = args.tokens
+    MockHandler.timeout = args.idle_s
+    server = http.server.ThreadingHTTPServer((args.bind, args.port), MockHandler)
+    scheme = "http"
+    if args.cert:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.cert, args.key)
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+        scheme = "https"
+    print("Mock APIs on %s://%s:%d (/weather, /stream, POST /chat)" % (scheme, args.bind, args.port))
+    server.serve_forever()
+
+
+def cmd_serve(args):
+    from coproc_link_sim import Link     # Needs pyserial
+
+    link = Link(args.port, args.baud)
+    proxy = NetProxy(link.send, ca=args.ca, insecure=args.insecure)
+    print("Proxy serving on %s" % args.port)
+    for msg_type, payload in link.frames():
+        proxy.handle(msg_type, payload)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    serve = sub.add_parser("serve", help="run the proxy on a serial port")
+    serve.add_argument("--port", required=True, help="serial port wired to the ESP link UART")
+    serve.add_argument("--baud", type=int, default=921600)
+    serve.add_argument("--ca", help="CA file to verify upstream servers with (default: system store)")
+    serve.add_argument("--insecure", action="store_true", help="do not verify upstream certificates")
+    serve.set_defaults(func=cmd_serve)
+
+    mock = sub.add_parser("mock", help="serve mock weather and dialogue APIs")
+    mock.add_argument("--bind", default="0.0.0.0")
+    mock.add_argument("--port", type=int, default=8443)
+    mock.add_argument("--cert", help="certificate for HTTPS")
+    mock.add_argument("--key", help="private key for HTTPS")
+    mock.add_argument("--tokens", type=int, default=40, help="tokens per streamed reply")
+    mock.add_argument("--token-ms", type=float, default=50.0, help="delay between streamed tokens")
+    mock.add_argument("--idle-s", type=float, default=60.0,
+                      help="close idle keep-alive connections after this many seconds")
+    mock.set_defaults(func=cmd_mock)
+
+    args = parser.parse_args()
+    if getattr(args, "cert", None) and not args.key:
+        sys.exit("error: --cert needs --key")
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
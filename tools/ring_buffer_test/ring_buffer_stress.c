@@ -0,0 +1,281 @@
+/**
+ * @file ring_buffer_stress.c
+ * @brief Host stress test of main/ring_buffer.h, built with ThreadSanitizer
+ *
+ * Producers and a consumer run as pthreads on small rings so the full and
+ * empty cases and the wrap point are hit constantly. Elements span three
+ * words with a check value, so a torn or stale read shows up as a payload
+ * error, and every producer's sequence must arrive complete and in order.
+ * ThreadSanitizer reports any access the ring's acquire/release ordering
+ * does not cover.
+ */
+
+#include "ring_buffer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_PRODUCERS       4
+#define MAX_BATCH           37      // Not a divisor of the capacities, so batches straddle the wrap
+
+typedef struct {
+    uint32_t producer;
+    uint32_t seq;
+    uint32_t check;
+} element_t;
+
+typedef enum {
+    MODE_SPSC_COPY,                 // ring_spsc_push/pop
+    MODE_SPSC_BATCH,                // ring_spsc_reserve/commit, peek/release with varying sizes
+    MODE_MPSC,                      // ring_mpsc_push/pop
+    MODE_MPSC_INPLACE,              // ring_mpsc_reserve/commit, peek/release
+} stress_mode_t;
+
+typedef struct test test_t;
+
+typedef struct {
+    test_t *test;
+    uint32_t id;
+} producer_arg_t;
+
+struct test {
+    const char *name;
+    stress_mode_t mode;
+    int producers;
+    uint32_t items;                 // Per producer
+    ring_spsc_t spsc;
+    ring_mpsc_t mpsc;
+    uint32_t payload_errors;
+    uint32_t order_errors;
+    producer_arg_t args[MAX_PRODUCERS];
+};
+
+static uint32_t check_value(uint32_t producer, uint32_t seq)
+{
+    uint32_t x = (producer + 1) * 0x9E3779B9U ^ seq * 0x85EBCA6BU;
+    return x ^ (x >> 15);
+}
+
+static void make_element(element_t *e, uint32_t producer, uint32_t seq)
+{
+    e->producer = producer;
+    e->seq = seq;
+    e->check = check_value(producer, seq);
+}
+
+// Small xorshift so batch sizes vary without sharing state between threads
+static uint32_t next_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void *producer_thread(void *arg)
+{
+    producer_arg_t *producer = (producer_arg_t *)arg;
+    test_t *test = producer->test;
+    uint32_t random = 0x1234567U + producer->id;
+
+    uint32_t seq = 0;
+    while (seq < test->items) {
+        bool progress = false;
+        switch (test->mode) {
+            case MODE_SPSC_COPY: {
+                element_t e;
+                make_element(&e, producer->id, seq);
+                if (ring_spsc_push(&test->spsc, &e)) {
+                    seq++;
+                    progress = true;
+                }
+                break;
+            }
+            case MODE_SPSC_BATCH: {
+                uint32_t n = 1 + next_random(&random) % MAX_BATCH;
+                if (n > test->items - seq) {
+                    n = test->items - seq;
+                }
+                element_t *slots = ring_spsc_reserve(&test->spsc, &n);
+                if (slots != NULL) {
+                    // Commit fewer than reserved now and then
+                    uint32_t used = (n > 1 && (next_random(&random) & 3) == 0) ? n - 1 : n;
+                    for (uint32_t i = 0; i < used; i++) {
+                        make_element(&slots[i], producer->id, seq + i);
+                    }
+                    ring_spsc_commit(&test->spsc, used);
+                    seq += used;
+                    progress = true;
+                }
+                break;
+            }
+            case MODE_MPSC: {
+                element_t e;
+                make_element(&e, producer->id, seq);
+                if (ring_mpsc_push(&test->mpsc, &e)) {
+                    seq++;
+                    progress = true;
+                }
+                break;
+            }
+            case MODE_MPSC_INPLACE: {
+                element_t *slot = ring_mpsc_reserve(&test->mpsc);
+                if (slot != NULL) {
+                    make_element(slot, producer->id, seq);
+                    ring_mpsc_commit(&test->mpsc, slot);
+                    seq++;
+                    progress = true;
+                }
+                break;
+            }
+        }
+        if (!progress) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void check_element(test_t *test, const element_t *e, uint32_t *expected)
+{
+    if (e->producer >= (uint32_t)test->producers || e->check != check_value(e->producer, e->seq)) {
+        test->payload_errors++;
+        return;
+    }
+    if (e->seq != expected[e->producer]) {
+        test->order_errors++;
+    }
+    expected[e->producer] = e->seq + 1;
+}
+
+static void consume(test_t *test)
+{
+    uint32_t expected[MAX_PRODUCERS] = {0};
+    uint32_t total = test->items * (uint32_t)test->producers;
+    uint32_t received = 0;
+    uint32_t random = 0x89ABCDEU;
+
+    while (received < total) {
+        uint32_t n = 0;
+        switch (test->mode) {
+            case MODE_SPSC_COPY: {
+                element_t e;
+                if (ring_spsc_pop(&test->spsc, &e)) {
+                    check_element(test, &e, expected);
+                    n = 1;
+                }
+                break;
+            }
+            case MODE_SPSC_BATCH: {
+                const element_t *slots = ring_spsc_peek(&test->spsc, &n);
+                if (slots != NULL) {
+                    uint32_t limit = 1 + next_random(&random) % MAX_BATCH;
+                    if (n > limit) {
+                        n = limit;
+                    }
+                    for (uint32_t i = 0; i < n; i++) {
+                        check_element(test, &slots[i], expected);
+                    }
+                    ring_spsc_release(&test->spsc, n);
+                }
+                break;
+            }
+            case MODE_MPSC: {
+                element_t e;
+                if (ring_mpsc_pop(&test->mpsc, &e)) {
+                    check_element(test, &e, expected);
+                    n = 1;
+                }
+                break;
+            }
+            case MODE_MPSC_INPLACE: {
+                const element_t *slot = ring_mpsc_peek(&test->mpsc);
+                if (slot != NULL) {
+                    check_element(test, slot, expected);
+                    ring_mpsc_release(&test->mpsc);
+                    n = 1;
+                }
+                break;
+            }
+        }
+        if (n == 0) {
+            sched_yield();
+        }
+        received += n;
+    }
+
+    // Nothing may be left over or duplicated
+    if (ring_spsc_count(&test->spsc) != 0 || ring_mpsc_peek(&test->mpsc) != NULL) {
+        test->order_errors++;
+    }
+    for (int p = 0; p < test->producers; p++) {
+        if (expected[p] != test->items) {
+            test->order_errors++;
+        }
+    }
+}
+
+static bool run_test(test_t *test, uint32_t capacity)
+{
+    static element_t storage[64];
+    static _Atomic uint32_t seq[64];
+    pthread_t threads[MAX_PRODUCERS];
+
+    if (capacity > 64 ||
+        ring_spsc_init(&test->spsc, storage, sizeof(element_t), capacity) != ESP_OK ||
+        ring_mpsc_init(&test->mpsc, storage, seq, sizeof(element_t), capacity) != ESP_OK) {
+        printf("%-16s bad capacity %u\n", test->name, (unsigned)capacity);
+        return false;
+    }
+
+    for (int p = 0; p < test->producers; p++) {
+        test->args[p].test = test;
+        test->args[p].id = (uint32_t)p;
+        if (pthread_create(&threads[p], NULL, producer_thread, &test->args[p]) != 0) {
+            perror("pthread_create");
+            exit(2);
+        }
+    }
+    consume(test);
+    for (int p = 0; p < test->producers; p++) {
+        pthread_join(threads[p], NULL);
+    }
+
+    bool ok = test->payload_errors == 0 && test->order_errors == 0;
+    printf("%-16s %d producer(s), capacity %2u, %u elements: %u payload errors, %u order errors %s\n",
+           test->name, test->producers, (unsigned)capacity, (unsigned)(test->items * test->producers),
+           (unsigned)test->payload_errors, (unsigned)test->order_errors, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t items = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : 1000000;
+    struct {
+        const char *name;
+        stress_mode_t mode;
+        int producers;
+        uint32_t capacity;
+    } runs[] = {
+        { "spsc push/pop",   MODE_SPSC_COPY,    1, 16 },
+        { "spsc batch",      MODE_SPSC_BATCH,   1, 64 },
+        { "mpsc push/pop",   MODE_MPSC,         MAX_PRODUCERS, 8 },
+        { "mpsc in place",   MODE_MPSC_INPLACE, MAX_PRODUCERS, 16 },
+        { "mpsc 2 prod",     MODE_MPSC,         2, 2 },
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        test_t test = {
+            .name = runs[i].name,
+            .mode = runs[i].mode,
+            .producers = runs[i].producers,
+            .items = items / (uint32_t)runs[i].producers,
+        };
+        ok &= run_test(&test, runs[i].capacity);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,5 @@
+/* Host stand-in for ESP-IDF's esp_attr.h, enough for main/ring_buffer.h */
+#pragma once
+
+#define FORCE_INLINE_ATTR   static inline __attribute__((always_inline))
+#define IRAM_ATTR
@@ -0,0 +1,313 @@
+#!/usr/bin/env python3
+"""Two-stage ROI-crop action recognition for the Orange Pi co-processor.
+
+Instead of classifying whole GC2035 frames, a small detector finds the
+person/desk region on a low-resolution copy of the frame, and the action
+classifier runs only on that crop at a small input size. The stages are
+threads connected by bounded queues, so decode, detect and classify of
+consecutive frames overlap on separate cores (cv2 releases the GIL):
+
+    decode --> detect (--detect-size) --> crop + classify (--crop-size) --> result
+
+The detector is an SSD-style ONNX model (cv2.dnn detection output,
+[1, 1, N, 7]) given with --detector. Without one, the region comes from
+background subtraction at the detection resolution, then falls back to the
+last region and finally to --desk-roi. Boxes get a margin, are squared and
+smoothed so the crop does not jitter.
+
+The classifier is an ONNX model given with --classifier. Without one, a
+stand-in does cv2 work in proportion to its input pixels, calibrated to
+--classify-ms at 224 px, so the crop-size saving is modelled too.
+
+    bench  run every clip three ways and report end-to-end fps, per-frame
+           latency and per-stage latency: whole-frame classification,
+           two-stage sequential and two-stage pipelined.
+
+    python tools/roi_pipeline.py bench clips/*.mp4 --detector person_ssd.onnx --classifier action.onnx
+    python tools/roi_pipeline.py bench clips/desk.mp4 --classify-ms 150
+
+Needs OpenCV and numpy (pip install opencv-python-headless numpy).
+"""
+
+import argparse
+import os
+import queue
+import sys
+import threading
+import time
+
+import cv2
+import numpy as np
+
+QUEUE_DEPTH = 2
+ROI_MARGIN = 0.15
+ROI_SMOOTHING = 0.5
+MIN_FOREGROUND_AREA = 0.01      # Of the detection frame
+STAND_IN_REFERENCE = 224
+
+
+class Classifier:
+    """ONNX action classifier, or a stand-in costing classify_ms at STAND_IN_REFERENCE."""
+
+    def __init__(self, model, classify_ms):
+        self.net = cv2.dnn.readNet(model) if model else None
+        self.rounds = 0
+        if self.net is None:
+            self._calibrate(classify_ms)
+
+    def _calibrate(self, classify_ms):
+        probe = np.random.rand(STAND_IN_REFERENCE, STAND_IN_REFERENCE).astype(np.float32)
+        start = time.perf_counter()
+        for _ in range(20):
+            cv2.dct(probe)
+        per_round = (time.perf_counter() - start) / 20
+        self.rounds = max(1, int(classify_ms / 1000.0 / per_round))
+
+    def __call__(self, image, size):
+        if self.net is not None:
+            blob = cv2.dnn.blobFromImage(image, 1.0 / 255, (size, size), swapRB=True)
+            self.net.setInput(blob)
+            return int(np.argmax(self.net.forward()))
+        work = cv2.resize(cv2.cvtColor(image, cv2.COLOR_BGR2GRAY), (size, size)).astype(np.float32)
+        for _ in range(self.rounds):
+            cv2.dct(work)
+        return 0
+
+
+class RegionDetector:
+    """Person/desk region on a low-resolution frame, as fractions of the frame."""
+
+    def __init__(self, model, size, person_class, min_confidence, desk_roi):
+        self.net = cv2.dnn.readNet(model) if model else None
+        self.size = size
+        self.person_class = person_class
+        self.min_confidence = min_confidence
+        self.desk_roi = desk_roi
+        self.reset()
+
+    def reset(self):
+        self.background = cv2.createBackgroundSubtractorMOG2(history=200, detectShadows=False)
+        self.last_detection = None
+        self.last = None
+
+    def _detect(self, small):
+        if self.net is not None:
+            blob = cv2.dnn.blobFromImage(small, 1.0 / 127.5, (self.size, self.size), (127.5, 127.5, 127.5),
+                                         swapRB=True)
+            self.net.setInput(blob)
+            best = None
+            for det in self.net.forward().reshape(-1, 7):
+                if int(det[1]) == self.person_class and det[2] >= self.min_confidence:
+                    if best is None or det[2] > best[2]:
+                        best = det
+            if best is None:
+                return None
+            x0, y0, x1, y1 = np.clip(best[3:7], 0.0, 1.0)
+            return (x0, y0, x1 - x0, y1 - y0)
+
+        mask = self.background.apply(small)
+        mask = cv2.morphologyEx(mask, cv2.MORPH_OPEN, np.ones((3, 3), np.uint8))
+        points = cv2.findNonZero(mask)
+        if points is None or len(points) < MIN_FOREGROUND_AREA * mask.size:
+            return None
+        x, y, w, h = cv2.boundingRect(points)
+        height, width = mask.shape
+        return (x / width, y / height, w / width, h / height)
+
+    def __call__(self, frame):
+        height, width = frame.shape[:2]
+        scale = self.size / max(width, height)
+        small = cv2.resize(frame, (max(1, int(width * scale)), max(1, int(height * scale))),
+                           interpolation=cv2.INTER_AREA)
+        box = self._detect(small)
+        if box is None:
+            box = self.last_detection or self.desk_roi
+        else:
+            self.last_detection = box
+
+        # Margin, square in pixels, smooth against the previous region
+        x, y, w, h = box
+        cx, cy = x + w / 2, y + h / 2
+        side = max(w * width, h * height) * (1 + 2 * ROI_MARGIN)
+        w, h = min(1.0, side / width), min(1.0, side / height)
+        box = (min(max(cx - w / 2, 0.0), 1.0 - w), min(max(cy - h / 2, 0.0), 1.0 - h), w, h)
+        if self.last is not None:
+            box = tuple(ROI_SMOOTHING * a + (1 - ROI_SMOOTHING) * b for a, b in zip(self.last, box))
+        self.last = box
+        return box
+
+
+def crop(frame, box):
+    height, width = frame.shape[:2]
+    x, y, w, h = box
+    x0, y0 = int(x * width), int(y * height)
+    x1, y1 = max(x0 + 1, int((x + w) * width)), max(y0 + 1, int((y + h) * height))
+    return frame[y0:y1, x0:x1]
+
+
+class Timing:
+    def __init__(self):
+        self.stages = {}
+        self.latencies = []
+        self.frames = 0
+        self.wall = 0.0
+
+    def add(self, stage, seconds):
+        self.stages.setdefault(stage, []).append(seconds * 1000.0)
+
+
+def frames_of(path):
+    cap = cv2.VideoCapture(path)
+    if not cap.isOpened():
+        sys.exit("error: cannot open %s" % path)
+    while True:
+        t0 = time.perf_counter()
+        ok, frame = cap.read()
+        if not ok:
+            break
+        yield frame, t0, time.perf_counter() - t0
+    cap.release()
+
+
+def run_whole_frame(path, classify, args):
+    timing = Timing()
+    start = time.perf_counter()
+    for frame, t0, decode_s in frames_of(path):
+        timing.add("decode", decode_s)
+        c0 = time.perf_counter()
+        classify(frame, args.full_size)
+        done = time.perf_counter()
+        timing.add("classify", done - c0)
+        timing.latencies.append((done - t0) * 1000.0)
+        timing.frames += 1
+    timing.wall = time.perf_counter() - start
+    return timing
+
+
+def run_two_stage_sequential(path, detect, classify, args):
+    timing = Timing()
+    detect.reset()
+    start = time.perf_counter()
+    for frame, t0, decode_s in frames_of(path):
+        timing.add("decode", decode_s)
+        d0 = time.perf_counter()
+        box = detect(frame)
+        d1 = time.perf_counter()
+        classify(crop(frame, box), args.crop_size)
+        done = time.perf_counter()
+        timing.add("detect", d1 - d0)
+        timing.add("classify", done - d1)
+        timing.latencies.append((done - t0) * 1000.0)
+        timing.frames += 1
+    timing.wall = time.perf_counter() - start
+    return timing
+
+
+def run_two_stage_pipelined(path, detect, classify, args):
+    timing = Timing()
+    detect.reset()
+    to_detect = queue.Queue(QUEUE_DEPTH)
+    to_classify = queue.Queue(QUEUE_DEPTH)
+
+    def decode_stage():
+        for frame, t0, decode_s in frames_of(path):
+            timing.add("decode", decode_s)
+            to_detect.put((frame, t0))
+        to_detect.put(None)
+
+    def detect_stage():
+        while True:
+            item = to_detect.get()
+            if item is None:
+                break
+            frame, t0 = item
+            d0 = time.perf_counter()
+            box = detect(frame)
+            timing.add("detect", time.perf_counter() - d0)
+            to_classify.put((frame, box, t0))
+        to_classify.put(None)
+
+    start = time.perf_counter()
+    threads = [threading.Thread(target=decode_stage, daemon=True),
+               threading.Thread(target=detect_stage, daemon=True)]
+    for thread in threads:
+        thread.start()
+
+    # Classify on the calling thread
+    while True:
+        item = to_classify.get()
+        if item is None:
+            break
+        frame, box, t0 = item
+        c0 = time.perf_counter()
+        classify(crop(frame, box), args.crop_size)
+        done = time.perf_counter()
+        timing.add("classify", done - c0)
+        timing.latencies.append((done - t0) * 1000.0)
+        timing.frames += 1
+
+    for thread in threads:
+        thread.join()
+    timing.wall = time.perf_counter() - start
+    return timing
+
+
+def print_timing(name, timing):
+    fps = timing.frames / timing.wall if timing.wall else 0.0
+    stages = "  ".join("%s %.1f" % (stage, float(np.mean(ms))) for stage, ms in timing.stages.items())
+    print("  %-22s %6.1f fps  latency mean %6.1f ms p95 %6.1f ms   stage mean ms: %s" % (
+        name, fps, float(np.mean(timing.latencies)) if timing.latencies else 0.0,
+        float(np.percentile(timing.latencies, 95)) if timing.latencies else 0.0, stages))
+    return fps
+
+
+def parse_roi(text):
+    values = tuple(float(v) for v in text.split(","))
+    if len(values) != 4 or not all(0.0 <= v <= 1.0 for v in values):
+        raise argparse.ArgumentTypeError("expected x,y,w,h as fractions of the frame")
+    return values
+
+
+def cmd_bench(args):
+    cv2.setNumThreads(1)    # One core per stage, as on the board
+    classify = Classifier(args.classifier, args.classify_ms)
+    detect = RegionDetector(args.detector, args.detect_size, args.person_class, args.min_confidence, args.desk_roi)
+    if args.classifier is None:
+        print("No --classifier: stand-in costing %.0f ms at %d px" % (args.classify_ms, STAND_IN_REFERENCE))
+    if args.detector is None:
+        print("No --detector: background subtraction at %d px" % args.detect_size)
+
+    for path in args.clips:
+        print("%s:" % os.path.basename(path))
+        whole = print_timing("whole frame %d px" % args.full_size, run_whole_frame(path, classify, args))
+        print_timing("two-stage sequential", run_two_stage_sequential(path, detect, classify, args))
+        piped = print_timing("two-stage pipelined", run_two_stage_pipelined(path, detect, classify, args))
+        if whole > 0:
+            print("  pipelined ROI crop at %d px: %.2fx whole-frame fps" % (args.crop_size, piped / whole))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    bench = sub.add_parser("bench", help="compare whole-frame and two-stage recognition on clips")
+    bench.add_argument("clips", nargs="+", help="video files")
+    bench.add_argument("--classifier", help="ONNX action classifier (cv2.dnn)")
+    bench.add_argument("--detector", help="ONNX SSD person detector (cv2.dnn)")
+    bench.add_argument("--classify-ms", type=float, default=150.0,
+                       help="stand-in classifier cost at %d px without --classifier" % STAND_IN_REFERENCE)
+    bench.add_argument("--full-size", type=int, default=224, help="whole-frame classifier input")
+    bench.add_argument("--crop-size", type=int, default=112, help="ROI classifier input")
+    bench.add_argument("--detect-size", type=int, default=160, help="detector input (long side)")
+    bench.add_argument("--person-class", type=int, default=15, help="person class id of the detector (VOC: 15)")
+    bench.add_argument("--min-confidence", type=float, default=0.4)
+    bench.add_argument("--desk-roi", type=parse_roi, default=(0.2, 0.3, 0.6, 0.7),
+                       help="fallback region x,y,w,h as fractions of the frame")
+    bench.set_defaults(func=cmd_bench)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
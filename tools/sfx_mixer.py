@@ -0,0 +1,472 @@
+#!/usr/bin/env python3
+"""UI sound effects mixed over speech on the Orange Pi.
+
+Taps, shakes and presses on the ESP32-S3 go out as SFX_PLAY messages
+(main/coproc_link.h, main/sound_fx.c). The effect has to sound together with
+the expression animation, so nothing is decoded per event. EffectBank loads
+every effect once at startup into int16 arrays padded to whole periods, and
+Mixer adds the voices into the speech stream one PERIOD at a time:
+
+  - at most --voices effects play at once; a new one cuts the oldest
+  - each voice is scaled by its gain, then everything is summed in int32
+    and saturated to int16 once, with one vectorized clip per period.
+    numpy runs these multiply-accumulates and the narrowing with NEON on
+    the Cortex-A7
+  - speech is ducked by --duck-db while any effect plays, with a short
+    attack and a slower release so the ducking does not click or pump
+
+A trigger starts in the next period rendered. With a 4 ms period and two
+periods queued in the I2S DMA, the first sample reaches the DAC at most
+about 12 ms after SFX_PLAY arrives. The mixer answers SFX_STARTED once the
+effect is queued. The answer carries the time from receipt to sound and the
+mixer's CPU load, and the ESP adds its own part to get the whole
+trigger-to-sound latency.
+
+When the user talks over a reply, Player.cut() stops it at the next period:
+the reply still queued in SpeechSource and the periods already in the DMA are
+dropped, effects keep playing, and the callback then starts the new capture.
+BargeInDetector in echo_canceller.py decides when.
+
+    bench   run the mixer in real time against a simulated DAC or an ALSA
+            device while effects fire at random, over looping speech.
+            Reports trigger-to-sound latency against --max-latency-ms and
+            mixer CPU per second of audio; exits with 1 when the p99
+            latency is over the limit
+    render  mix effects at given times over a speech file into a WAV file,
+            to listen to the ducking
+
+Effects are tap.wav, shake.wav and press.wav in --effects (16 kHz mono
+16-bit, like the dialogue audio). Effects missing from the directory are
+synthesized. The link simulator plays them with --sfx.
+
+    python tools/sfx_mixer.py bench --seconds 20 --rate 4
+    python tools/sfx_mixer.py bench --alsa default --effects sounds/
+    python tools/sfx_mixer.py render mix.wav --speech reply.wav --at tap@0.5 shake@1.2
+
+Needs numpy (and pyalsaaudio for --alsa).
+"""
+
+import argparse
+import os
+import struct
+import sys
+import threading
+import time
+
+import numpy as np
+
+from echo_canceller import RATE, read_wav, speech_like, write_wav
+
+PERIOD = 64                     # 4 ms, one I2S DMA period
+BUFFER_PERIODS = 2              # Queued in the DMA ahead of the DAC
+PERIOD_S = PERIOD / RATE
+
+EFFECT_NAMES = ["tap", "shake", "press"]   # coproc_sfx_t order
+
+MSG_SFX_PLAY = 0x50
+MSG_SFX_STARTED = 0x51
+PLAY = struct.Struct("<BBBBI")
+STARTED = struct.Struct("<BBBBII")
+FLAG_STOLEN = 0x01
+FLAG_DROPPED = 0x02
+
+
+def percentile(values, p):
+    return float(np.percentile(values, p)) if values else 0.0
+
+
+def synth_effect(name):
+    """Short placeholder effects, as float samples."""
+    t = np.arange(int(0.25 * RATE)) / RATE
+    if name == "tap":
+        t = t[: int(0.06 * RATE)]
+        return 0.5 * np.sin(2 * np.pi * 1800.0 * t) * np.exp(-t / 0.012)
+    if name == "shake":
+        rng = np.random.default_rng(7)
+        bursts = (np.sin(2 * np.pi * 14.0 * t) > 0.3).astype(np.float64) * np.exp(-t / 0.12)
+        return 0.4 * rng.standard_normal(len(t)) * bursts
+    t = t[: int(0.12 * RATE)]
+    tone = np.where(t < 0.05, np.sin(2 * np.pi * 880.0 * t), np.sin(2 * np.pi * 1320.0 * t))
+    return 0.45 * tone * np.hanning(len(t))
+
+
+class EffectBank:
+    """Effects decoded once and kept resident as int16, padded to whole periods."""
+
+    def __init__(self, directory=None):
+        self.effects = []
+        self.load_ms = []               # Read and convert time of each file, None if synthesized
+        for name in EFFECT_NAMES:
+            path = os.path.join(directory, name + ".wav") if directory else None
+            started = time.perf_counter()
+            from_file = path is not None and os.path.exists(path)
+            samples = read_wav(path) if from_file else synth_effect(name)
+            data = np.clip(np.round(samples * 32768.0), -32768, 32767).astype(np.int16)
+            padded = np.zeros(-(-len(data) // PERIOD) * PERIOD, dtype=np.int16)
+            padded[: len(data)] = data
+            padded.setflags(write=False)
+            self.load_ms.append(1000.0 * (time.perf_counter() - started) if from_file else None)
+            self.effects.append(padded)
+
+    @property
+    def resident_bytes(self):
+        return sum(e.nbytes for e in self.effects)
+
+
+class Mixer:
+    """Mixes up to `voices` effects over speech, one PERIOD per render()."""
+
+    def __init__(self, bank, voices=4, duck_db=-10.0, attack_ms=4.0, release_ms=120.0):
+        self.bank = bank
+        self.voices = voices
+        self.lock = threading.Lock()
+        self.pending = []               # (effect, gain_q8, on_start) since the last render
+        self.active = []                # [effect, position, gain_q8], oldest first
+        self.duck_q15 = int(32767 * 10.0 ** (duck_db / 20.0))
+        self.attack_step = (32767 - self.duck_q15) / max(1.0, attack_ms * RATE / 1000.0)
+        self.release_step = (32767 - self.duck_q15) / max(1.0, release_ms * RATE / 1000.0)
+        self.gain = 32767.0
+        self.ramp = np.arange(1, PERIOD + 1, dtype=np.float64)
+        self.stolen = 0
+
+    def trigger(self, effect, gain=255, on_start=None):
+        """Queue an effect for the next period; on_start(flags, voices) runs once it is mixed."""
+        if not 0 <= effect < len(self.bank.effects):
+            if on_start:
+                on_start(FLAG_DROPPED, 0)
+            return False
+        with self.lock:
+            self.pending.append((effect, gain + 1, on_start))      # 256 = unity
+        return True
+
+    def render(self, speech):
+        """Mix one period of int16 speech with the playing effects; returns int16."""
+        with self.lock:
+            pending, self.pending = self.pending, []
+        started = []
+        for effect, gain, on_start in pending:
+            flags = 0
+            if len(self.active) >= self.voices:
+                self.active.pop(0)
+                self.stolen += 1
+                flags |= FLAG_STOLEN
+            self.active.append([effect, 0, gain])
+            started.append((on_start, flags))
+
+        # Most periods have no effect and no ramp: speech goes out untouched
+        if not self.active and self.gain >= 32767.0:
+            return speech
+
+        # Duck gain ramps per sample toward its target, in Q15; a settled duck is one scalar
+        if self.active and self.gain <= self.duck_q15:
+            acc = (speech.astype(np.int32) * self.duck_q15) >> 15
+        else:
+            if self.active:
+                gains = np.maximum(self.gain - self.attack_step * self.ramp, self.duck_q15)
+            else:
+                gains = np.minimum(self.gain + self.release_step * self.ramp, 32767.0)
+            self.gain = float(gains[-1])
+            acc = (speech.astype(np.int32) * gains.astype(np.int32)) >> 15
+        for voice in self.active:
+            data = self.bank.effects[voice[0]]
+            acc += (data[voice[1]:voice[1] + PERIOD].astype(np.int32) * voice[2]) >> 8
+            voice[1] += PERIOD
+        self.active = [v for v in self.active if v[1] < len(self.bank.effects[v[0]])]
+        out = np.clip(acc, -32768, 32767).astype(np.int16)
+
+        for on_start, flags in started:
+            if on_start:
+                on_start(flags, len(self.active))
+        return out
+
+
+class SpeechSource:
+    """Reply PCM queued by the dialogue pipeline; silence when none is queued."""
+
+    def __init__(self, loop=None):
+        self.loop = loop
+        self.pos = 0
+        self.lock = threading.Lock()
+        self.queue = []
+
+    def push(self, samples):
+        with self.lock:
+            self.queue.append(np.asarray(samples, dtype=np.int16))
+
+    def flush(self):
+        """Drop the queued reply; returns the frames dropped."""
+        with self.lock:
+            dropped = sum(len(chunk) for chunk in self.queue)
+            self.queue = []
+        return dropped
+
+    def read(self, count):
+        if self.loop is not None:
+            idx = (self.pos + np.arange(count)) % len(self.loop)
+            self.pos = (self.pos + count) % len(self.loop)
+            return self.loop[idx]
+        out = np.zeros(count, dtype=np.int16)
+        filled = 0
+        with self.lock:
+            while filled < count and self.queue:
+                head = self.queue[0]
+                take = min(count - filled, len(head))
+                out[filled:filled + take] = head[:take]
+                filled += take
+                if take == len(head):
+                    self.queue.pop(0)
+                else:
+                    self.queue[0] = head[take:]
+        return out
+
+
+class ClockSink:
+    """Models the DAC draining the DMA queue at RATE; ALSA output on top with `device`."""
+
+    def __init__(self, device=None):
+        self.pcm = None
+        if device is not None:
+            import alsaaudio   # Only needed on the board
+            self.pcm = alsaaudio.PCM(alsaaudio.PCM_PLAYBACK, device=device, channels=1, rate=RATE,
+                                     format=alsaaudio.PCM_FORMAT_S16_LE, periodsize=PERIOD,
+                                     periods=BUFFER_PERIODS)
+        self.start = None
+        self.written = 0
+
+    def queued(self):
+        """Frames written but not yet played."""
+        if self.start is None:
+            return 0
+        played = int((time.monotonic() - self.start) * RATE)
+        if played > self.written:
+            # Underrun: the DAC played silence meanwhile, restart the clock
+            self.start = time.monotonic() - self.written / RATE
+            return 0
+        return self.written - played
+
+    def drop(self):
+        """Discard what is queued ahead of the DAC; returns the frames dropped."""
+        dropped = self.queued()
+        if self.pcm is not None:
+            self.pcm.drop()
+        self.written -= dropped
+        return dropped
+
+    def wait_room(self):
+        while self.queued() > (BUFFER_PERIODS - 1) * PERIOD:
+            time.sleep((self.queued() - (BUFFER_PERIODS - 1) * PERIOD) / RATE)
+
+    def write(self, block):
+        if self.start is None:
+            self.start = time.monotonic()
+        if self.pcm is not None:
+            self.pcm.write(block.tobytes())
+        self.written += len(block)
+
+
+class Player:
+    """Real-time render loop: speech + effects -> sink, with latency and CPU accounting."""
+
+    def __init__(self, mixer, speech, sink, record=False):
+        self.mixer = mixer
+        self.speech = speech
+        self.sink = sink
+        self.running = False
+        self.latencies_ms = []
+        self.render_s = 0.0
+        self.periods = 0
+        self.window = []                # Render seconds of the last second of audio
+        self.recorded = [] if record else None
+        self.lock = threading.Lock()
+        self.cuts = []                  # on_cut callbacks for the next period
+
+    @property
+    def load_permille(self):
+        return int(round(1000.0 * sum(self.window) / (len(self.window) * PERIOD_S))) if self.window else 0
+
+    def play(self, effect, gain=255, on_started=None):
+        """Start an effect now; on_started(flags, voices, held_s, until_sound_s) once it is queued."""
+        received = time.monotonic()
+
+        def on_start(flags, voices):
+            # The render that mixed it is about to be written behind what is queued
+            now = time.monotonic()
+            until_sound = (now - received) + self.sink.queued() / RATE
+            if not flags & FLAG_DROPPED:
+                self.latencies_ms.append(1000.0 * until_sound)
+            if on_started:
+                on_started(flags, voices, now - received, until_sound)
+
+        if not self.running:
+            on_start(FLAG_DROPPED, 0)
+            return
+        self.mixer.trigger(effect, gain, on_start)
+
+    def cut(self, on_cut=None):
+        """Barge-in: stop the reply at the next period; on_cut(dropped_frames) then starts the capture."""
+        with self.lock:
+            self.cuts.append(on_cut)
+        if not self.running:
+            self.flush_cuts()
+
+    def flush_cuts(self):
+        with self.lock:
+            cuts, self.cuts = self.cuts, []
+        if not cuts:
+            return
+        # Between two writes, so no period of the reply is written after the drop
+        dropped = self.speech.flush() + self.sink.drop()
+        for on_cut in cuts:
+            if on_cut:
+                on_cut(dropped)
+
+    def loop(self, seconds=None):
+        self.running = True
+        end = None if seconds is None else time.monotonic() + seconds
+        while self.running and (end is None or time.monotonic() < end):
+            self.sink.wait_room()
+            self.flush_cuts()
+            speech = self.speech.read(PERIOD)
+            started = time.perf_counter()
+            block = self.mixer.render(speech)
+            spent = time.perf_counter() - started
+            self.sink.write(block)
+            self.render_s += spent
+            self.periods += 1
+            self.window.append(spent)
+            if len(self.window) > int(1.0 / PERIOD_S):
+                self.window.pop(0)
+            if self.recorded is not None:
+                self.recorded.append(block)
+        self.running = False
+
+
+class SfxPlayer:
+    """SFX_PLAY handling for the link simulator: plays effects and answers SFX_STARTED."""
+
+    def __init__(self, send, effects=None, alsa=None, voices=4, duck_db=-10.0):
+        self.send = send
+        self.bank = EffectBank(effects)
+        self.player = Player(Mixer(self.bank, voices, duck_db), SpeechSource(), ClockSink(alsa))
+        threading.Thread(target=self.player.loop, daemon=True).start()
+        print("  sound effects: %d KiB resident, %d voices, %.0f ms periods"
+              % (self.bank.resident_bytes // 1024, voices, 1000.0 * PERIOD_S))
+
+    def handle(self, payload, playing=True):
+        """Play one SFX_PLAY; playing=False answers it as dropped (audio suspended)."""
+        if len(payload) < PLAY.size:
+            return
+        seq, effect, gain, _flags, event_age_us = PLAY.unpack_from(payload)
+
+        def on_started(flags, voices, held_s, until_sound_s):
+            load = min(255, self.player.load_permille)
+            self.send(MSG_SFX_STARTED, STARTED.pack(seq, flags, voices, load,
+                                                    int(held_s * 1e6), int(until_sound_s * 1e6)))
+            if not flags & FLAG_DROPPED:
+                print("  sfx %s: %.1f ms after receipt (%d us on the ESP), %d voices%s"
+                      % (EFFECT_NAMES[effect], 1000.0 * until_sound_s, event_age_us, voices,
+                         ", stole oldest" if flags & FLAG_STOLEN else ""))
+
+        if playing:
+            self.player.play(effect, gain, on_started)
+        else:
+            on_started(FLAG_DROPPED, 0, 0.0, 0.0)
+
+
+def cmd_bench(args):
+    bank = EffectBank(args.effects)
+    rng = np.random.default_rng(args.seed)
+    loop = np.clip(np.round(speech_like(rng, 8.0, 180.0, -18.0) * 32768.0), -32768, 32767).astype(np.int16)
+    mixer = Mixer(bank, args.voices, args.duck_db)
+    player = Player(mixer, SpeechSource(loop), ClockSink(args.alsa), record=args.out is not None)
+
+    thread = threading.Thread(target=player.loop, args=(args.seconds,), daemon=True)
+    thread.start()
+    while not player.running:
+        time.sleep(0.001)
+    triggers = 0
+    end = time.monotonic() + args.seconds - 0.5
+    while time.monotonic() < end:
+        time.sleep(rng.exponential(1.0 / args.rate))
+        player.play(int(rng.integers(len(EFFECT_NAMES))), 255)
+        triggers += 1
+    thread.join()
+
+    audio_s = player.periods * PERIOD_S
+    lat = player.latencies_ms
+    loads = ", ".join("%s %s" % (name, "synthesized" if ms is None else "%.2f ms" % ms)
+                      for name, ms in zip(EFFECT_NAMES, bank.load_ms))
+    print("effects       %d KiB resident; loading per event would cost: %s" % (bank.resident_bytes // 1024, loads))
+    print("mixer         %d voices, %.0f ms periods, %d queued, duck %.0f dB"
+          % (args.voices, 1000.0 * PERIOD_S, BUFFER_PERIODS, args.duck_db))
+    print("triggers      %d fired, %d started, %d cut the oldest voice" % (triggers, len(lat), mixer.stolen))
+    print("latency       receipt -> first sample at the DAC: mean %.1f ms, p99 %.1f ms, max %.1f ms (limit %.0f ms)"
+          % (float(np.mean(lat)) if lat else 0.0, percentile(lat, 99), max(lat, default=0.0), args.max_latency_ms))
+    print("CPU           %.2f ms per second of audio (%.2f%% of one core), %.1f us per period"
+          % (1000.0 * player.render_s / max(audio_s, 1e-9), 100.0 * player.render_s / max(audio_s, 1e-9),
+             1e6 * player.render_s / max(player.periods, 1)))
+    if args.out:
+        write_wav(args.out, np.concatenate(player.recorded).astype(np.float32) / 32768.0)
+        print("wrote %s" % args.out)
+    if percentile(lat, 99) > args.max_latency_ms:
+        sys.exit(1)
+
+
+def cmd_render(args):
+    bank = EffectBank(args.effects)
+    if args.speech:
+        speech = read_wav(args.speech)
+    else:
+        speech = speech_like(np.random.default_rng(1), 3.0, 180.0, -18.0)
+    speech = np.clip(np.round(speech * 32768.0), -32768, 32767).astype(np.int16)
+    speech = np.concatenate([speech, np.zeros(-len(speech) % PERIOD, dtype=np.int16)])
+
+    events = []
+    for item in args.at:
+        name, _, at = item.partition("@")
+        if name not in EFFECT_NAMES or not at:
+            sys.exit("error: effect times are name@seconds with name one of %s" % ", ".join(EFFECT_NAMES))
+        events.append((int(float(at) / PERIOD_S), EFFECT_NAMES.index(name)))
+
+    mixer = Mixer(bank, args.voices, args.duck_db)
+    out = []
+    for period in range(len(speech) // PERIOD):
+        for _, effect in [e for e in events if e[0] == period]:
+            mixer.trigger(effect)
+        out.append(mixer.render(speech[period * PERIOD:(period + 1) * PERIOD]))
+    write_wav(args.out, np.concatenate(out).astype(np.float32) / 32768.0)
+    print("wrote %s (%.1f s, %d effects)" % (args.out, len(speech) / RATE, len(events)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    def mixer_args(p):
+        p.add_argument("--effects", help="directory with tap.wav, shake.wav, press.wav")
+        p.add_argument("--voices", type=int, default=4, help="effects playing at once")
+        p.add_argument("--duck-db", type=float, default=-10.0, help="speech level under effects")
+
+    p = sub.add_parser("bench", help="real-time latency and CPU report")
+    mixer_args(p)
+    p.add_argument("--seconds", type=float, default=10.0)
+    p.add_argument("--rate", type=float, default=3.0, help="mean triggers per second")
+    p.add_argument("--alsa", help="ALSA device to play on (default: simulated DAC)")
+    p.add_argument("--max-latency-ms", type=float, default=15.0)
+    p.add_argument("--out", help="also write the mixed output to this WAV file")
+    p.add_argument("--seed", type=int, default=1)
+    p.set_defaults(func=cmd_bench)
+
+    p = sub.add_parser("render", help="mix effects over speech offline")
+    mixer_args(p)
+    p.add_argument("out", help="output WAV")
+    p.add_argument("--speech", help="16 kHz mono speech WAV (default: synthesized)")
+    p.add_argument("--at", nargs="+", default=["tap@0.5", "shake@1.2", "press@2.0"], help="name@seconds")
+    p.set_defaults(func=cmd_render)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
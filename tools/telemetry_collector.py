@@ -0,0 +1,518 @@
+#!/usr/bin/env python3
+"""Collects and summarizes the telemetry batches of a fleet of desk units.
+
+Every unit aggregates its metrics over a window and publishes one CBOR
+batch per window, with QoS 1, to <prefix>/<mac>/telemetry
+(main/telemetry.c; the batch layout is documented in main/telemetry.h).
+Batches are sent in bursts on a short-lived connection. This tool decodes
+them and prints one line per batch and a per-unit summary:
+
+  - frame and flush time percentiles, from the log2 histograms
+  - I2C transactions and error rates per device
+  - presence time split, internal heap low-water mark, render stalls
+  - Wi-Fi disconnects and RSSI
+  - batches lost: gaps in the sequence numbers that were not reported as
+    dropped from the unit's ring
+
+    broker    a minimal MQTT 3.1.1 broker (QoS 0/1, no retain, no auth) that
+              decodes the telemetry it receives itself. Enough to test the
+              uplink of a unit on the bench without installing one. Each
+              connection is logged with its duration, which is roughly how
+              long the unit kept its radio busy per flush
+    collect   subscribe to an existing broker (for example mosquitto)
+    selftest  run the broker on a local port and publish batches to it the
+              way a unit does: windows while offline, a ring overflow,
+              then a flush. Checks that every batch arrives and decodes
+
+    python tools/telemetry_collector.py broker --port 1883
+    python tools/telemetry_collector.py collect --host 192.168.1.20 --topic 'desk/+/telemetry'
+    python tools/telemetry_collector.py selftest
+
+Standard library only.
+"""
+
+import argparse
+import random
+import socket
+import socketserver
+import struct
+import sys
+import threading
+import time
+
+HIST_BUCKETS = 16
+HIST_MIN_SHIFT = 8
+DEVICES = ["DS3231", "MPU6050"]        # i2c_device_id_t order
+PRESENCE = ["present", "idle", "away"]
+
+CONNECT, CONNACK, PUBLISH, PUBACK = 1, 2, 3, 4
+SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 8, 9, 12, 13, 14
+
+
+# -----------------------------------------------------------------------------
+# CBOR (definite-length integers, arrays and maps: all main/telemetry.c writes)
+# -----------------------------------------------------------------------------
+
+def cbor_decode(data, pos=0):
+    """Decode one item at pos; returns (value, next position)."""
+    initial = data[pos]
+    major, info = initial >> 5, initial & 0x1F
+    pos += 1
+    if info < 24:
+        value = info
+    elif info in (24, 25, 26, 27):
+        size = 1 << (info - 24)
+        value = int.from_bytes(data[pos:pos + size], "big")
+        pos += size
+    else:
+        raise ValueError("unsupported CBOR item 0x%02x" % initial)
+
+    if major == 0:
+        return value, pos
+    if major == 1:
+        return -1 - value, pos
+    if major == 4:
+        items = []
+        for _ in range(value):
+            item, pos = cbor_decode(data, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        pairs = {}
+        for _ in range(value):
+            key, pos = cbor_decode(data, pos)
+            pairs[key], pos = cbor_decode(data, pos)
+        return pairs, pos
+    raise ValueError("unsupported CBOR major type %d" % major)
+
+
+def cbor_encode(value):
+    """Inverse of cbor_decode, for the self test."""
+    def head(major, n):
+        if n < 24:
+            return bytes([(major << 5) | n])
+        for info, size in ((24, 1), (25, 2), (26, 4), (27, 8)):
+            if n < 1 << (8 * size):
+                return bytes([(major << 5) | info]) + n.to_bytes(size, "big")
+        raise ValueError("integer too large")
+
+    if isinstance(value, int):
+        return head(0, value) if value >= 0 else head(1, -1 - value)
+    if isinstance(value, list):
+        return head(4, len(value)) + b"".join(cbor_encode(v) for v in value)
+    if isinstance(value, dict):
+        return head(5, len(value)) + b"".join(cbor_encode(k) + cbor_encode(v) for k, v in value.items())
+    raise TypeError(type(value))
+
+
+def hist_percentile(buckets, p):
+    """Upper bound of the bucket holding percentile p, in us (None when empty)."""
+    total = sum(buckets)
+    if total == 0:
+        return None
+    rank = p / 100.0 * total
+    seen = 0
+    for i, n in enumerate(buckets):
+        seen += n
+        if seen >= rank:
+            return 1 << (i + HIST_MIN_SHIFT)
+    return 1 << (len(buckets) - 1 + HIST_MIN_SHIFT)
+
+
+# -----------------------------------------------------------------------------
+# Fleet summary
+# -----------------------------------------------------------------------------
+
+class Unit:
+    def __init__(self, unit_id):
+        self.unit_id = unit_id
+        self.seqs = set()
+        self.dropped = 0
+        self.seconds = 0
+        self.hists = {4: [0] * HIST_BUCKETS, 5: [0] * HIST_BUCKETS}
+        self.hist_max = {4: 0, 5: 0}
+        self.i2c = [[0, 0, 0] for _ in DEVICES]
+        self.presence = [0, 0, 0]
+        self.heap_min = None
+        self.stalls = [0, 0]
+        self.disconnects = 0
+        self.rssi = []
+
+    def add(self, batch):
+        self.seqs.add(batch[1])
+        self.seconds += batch[3]
+        for key in (4, 5):
+            _count, _sum, max_us, buckets = batch[key]
+            self.hists[key] = [a + b for a, b in zip(self.hists[key], buckets)]
+            self.hist_max[key] = max(self.hist_max[key], max_us)
+        for device, counts in enumerate(batch[6][:len(DEVICES)]):
+            self.i2c[device] = [a + b for a, b in zip(self.i2c[device], counts)]
+        self.presence = [a + b for a, b in zip(self.presence, batch[7])]
+        self.heap_min = batch[8][0] if self.heap_min is None else min(self.heap_min, batch[8][0])
+        self.stalls = [a + b for a, b in zip(self.stalls, batch[9])]
+        self.disconnects += batch[10][0]
+        if batch[10][1] != 0:
+            self.rssi.append(batch[10][1])
+        self.dropped += batch[11]
+
+    @property
+    def lost(self):
+        if not self.seqs:
+            return 0
+        expected = max(self.seqs) - min(self.seqs) + 1
+        return max(0, expected - len(self.seqs) - self.dropped)
+
+    def summary(self):
+        lines = ["%s: %d batches (%d dropped on the unit, %d lost in transit), %.1f h"
+                 % (self.unit_id, len(self.seqs), self.dropped, self.lost, self.seconds / 3600.0)]
+        for key, name in ((4, "frame"), (5, "flush")):
+            p = [hist_percentile(self.hists[key], q) for q in (50, 95, 99)]
+            if p[0] is None:
+                lines.append("  %-8s no samples" % name)
+            else:
+                lines.append("  %-8s p50 <%.1f ms  p95 <%.1f ms  p99 <%.1f ms  max %.1f ms  (%d samples)"
+                             % (name, p[0] / 1000.0, p[1] / 1000.0, p[2] / 1000.0,
+                                self.hist_max[key] / 1000.0, sum(self.hists[key])))
+        for device, (tx, errors, timeouts) in zip(DEVICES, self.i2c):
+            rate = 100.0 * errors / tx if tx else 0.0
+            lines.append("  %-8s %d transactions, %d errors (%.3f%%), %d timeouts" % (device, tx, errors, rate, timeouts))
+        total = sum(self.presence) or 1
+        lines.append("  presence " + ", ".join("%s %.0f%%" % (n, 100.0 * s / total) for n, s in zip(PRESENCE, self.presence)))
+        lines.append("  heap     %s bytes minimum free" % self.heap_min)
+        lines.append("  stalls   %d, %d ms in total" % tuple(self.stalls))
+        rssi = "%.0f dBm mean" % (sum(self.rssi) / len(self.rssi)) if self.rssi else "no RSSI"
+        lines.append("  wifi     %d disconnects, %s" % (self.disconnects, rssi))
+        return "\n".join(lines)
+
+
+class Fleet:
+    def __init__(self, quiet=False):
+        self.units = {}
+        self.lock = threading.Lock()
+        self.quiet = quiet
+        self.errors = 0
+
+    def on_publish(self, topic, payload):
+        parts = topic.split("/")
+        if len(parts) < 3 or parts[-1] != "telemetry":
+            return
+        try:
+            batch, _ = cbor_decode(payload)
+            if batch.get(0) != 1:
+                raise ValueError("format version %s" % batch.get(0))
+        except (ValueError, IndexError, AttributeError) as exc:
+            self.errors += 1
+            print("! %s: undecodable batch (%s)" % (topic, exc))
+            return
+        with self.lock:
+            unit = self.units.setdefault(parts[-2], Unit(parts[-2]))
+            unit.add(batch)
+        if not self.quiet:
+            frame = hist_percentile(batch[4][3], 99)
+            print("%s #%d: %d s window, %d bytes, frame p99 <%s ms, %d stalls, heap min %d"
+                  % (parts[-2], batch[1], batch[3], len(payload),
+                     "-" if frame is None else "%.1f" % (frame / 1000.0), batch[9][0], batch[8][0]))
+
+    def report(self):
+        with self.lock:
+            for unit in self.units.values():
+                print(unit.summary())
+
+
+# -----------------------------------------------------------------------------
+# MQTT 3.1.1 framing
+# -----------------------------------------------------------------------------
+
+def read_exact(sock, n):
+    data = b""
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError("closed")
+        data += chunk
+    return data
+
+
+def read_packet(sock):
+    first = read_exact(sock, 1)[0]
+    length, shift = 0, 0
+    while True:
+        byte = read_exact(sock, 1)[0]
+        length |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            break
+    return first >> 4, first & 0x0F, read_exact(sock, length)
+
+
+def packet(ptype, flags, body):
+    out = bytearray([(ptype << 4) | flags])
+    length = len(body)
+    while True:
+        byte = length & 0x7F
+        length >>= 7
+        out.append(byte | (0x80 if length else 0))
+        if not length:
+            break
+    return bytes(out) + body
+
+
+def mqtt_string(text):
+    data = text.encode()
+    return struct.pack(">H", len(data)) + data
+
+
+def parse_publish(flags, body):
+    """Returns (topic, packet id or None, payload)."""
+    (topic_len,) = struct.unpack_from(">H", body)
+    topic = body[2:2 + topic_len].decode()
+    pos = 2 + topic_len
+    packet_id = None
+    if (flags >> 1) & 0x03:
+        (packet_id,) = struct.unpack_from(">H", body, pos)
+        pos += 2
+    return topic, packet_id, body[pos:]
+
+
+def topic_matches(pattern, topic):
+    p, t = pattern.split("/"), topic.split("/")
+    for i, level in enumerate(p):
+        if level == "#":
+            return True
+        if i >= len(t) or (level != "+" and level != t[i]):
+            return False
+    return len(p) == len(t)
+
+
+class Broker(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+    def __init__(self, address, fleet):
+        super().__init__(address, BrokerHandler)
+        self.fleet = fleet
+        self.subscribers = []           # (pattern, handler)
+        self.sub_lock = threading.Lock()
+        self.connections = 0
+
+    def route(self, topic, payload):
+        self.fleet.on_publish(topic, payload)
+        with self.sub_lock:
+            targets = [h for pattern, h in self.subscribers if topic_matches(pattern, topic)]
+        for handler in targets:
+            handler.forward(topic, payload)
+
+
+class BrokerHandler(socketserver.BaseRequestHandler):
+    def forward(self, topic, payload):
+        try:
+            with self.tx_lock:
+                self.request.sendall(packet(PUBLISH, 0, mqtt_string(topic) + payload))
+        except OSError:
+            pass
+
+    def handle(self):
+        self.tx_lock = threading.Lock()
+        started = time.monotonic()
+        client_id = "?"
+        publishes = 0
+        try:
+            ptype, _flags, body = read_packet(self.request)
+            if ptype != CONNECT:
+                return
+            (name_len,) = struct.unpack_from(">H", body)
+            pos = 2 + name_len + 4      # Protocol name, level, flags, keepalive
+            (id_len,) = struct.unpack_from(">H", body, pos)
+            client_id = body[pos + 2:pos + 2 + id_len].decode(errors="replace")
+            self.request.sendall(packet(CONNACK, 0, b"\x00\x00"))
+            self.server.connections += 1
+
+            while True:
+                ptype, flags, body = read_packet(self.request)
+                if ptype == PUBLISH:
+                    topic, packet_id, payload = parse_publish(flags, body)
+                    publishes += 1
+                    self.server.route(topic, payload)
+                    if packet_id is not None:
+                        with self.tx_lock:
+                            self.request.sendall(packet(PUBACK, 0, struct.pack(">H", packet_id)))
+                elif ptype == SUBSCRIBE:
+                    (packet_id,) = struct.unpack_from(">H", body)
+                    pos, granted = 2, b""
+                    while pos < len(body):
+                        (n,) = struct.unpack_from(">H", body, pos)
+                        pattern = body[pos + 2:pos + 2 + n].decode()
+                        pos += 2 + n + 1
+                        with self.server.sub_lock:
+                            self.server.subscribers.append((pattern, self))
+                        granted += b"\x00"
+                    with self.tx_lock:
+                        self.request.sendall(packet(SUBACK, 0, struct.pack(">H", packet_id) + granted))
+                elif ptype == PINGREQ:
+                    with self.tx_lock:
+                        self.request.sendall(packet(PINGRESP, 0, b""))
+                elif ptype == DISCONNECT:
+                    break
+        except (ConnectionError, OSError, struct.error):
+            pass
+        finally:
+            with self.server.sub_lock:
+                self.server.subscribers = [(p, h) for p, h in self.server.subscribers if h is not self]
+            if not self.server.fleet.quiet:
+                print("  %s connected %.0f ms, %d publishes" % (client_id, 1000.0 * (time.monotonic() - started), publishes))
+
+
+class Client:
+    """Just enough MQTT client for collect and selftest."""
+
+    def __init__(self, host, port, client_id, keepalive=60):
+        self.sock = socket.create_connection((host, port), timeout=10)
+        self.next_id = 1
+        body = mqtt_string("MQTT") + bytes([4, 0x02]) + struct.pack(">H", keepalive) + mqtt_string(client_id)
+        self.sock.sendall(packet(CONNECT, 0, body))
+        ptype, _, body = read_packet(self.sock)
+        if ptype != CONNACK or body[1] != 0:
+            raise ConnectionError("connection refused")
+
+    def publish(self, topic, payload, qos=1):
+        packet_id = self.next_id
+        self.next_id = self.next_id % 0xFFFF + 1
+        body = mqtt_string(topic) + (struct.pack(">H", packet_id) if qos else b"") + payload
+        self.sock.sendall(packet(PUBLISH, qos << 1, body))
+        if qos:
+            ptype, _, body = read_packet(self.sock)
+            if ptype != PUBACK or struct.unpack(">H", body)[0] != packet_id:
+                raise ConnectionError("no PUBACK for %d" % packet_id)
+
+    def subscribe(self, pattern):
+        self.sock.sendall(packet(SUBSCRIBE, 0x02, struct.pack(">H", 1) + mqtt_string(pattern) + b"\x00"))
+        ptype, _, _ = read_packet(self.sock)
+        if ptype != SUBACK:
+            raise ConnectionError("subscription refused")
+
+    def close(self):
+        self.sock.sendall(packet(DISCONNECT, 0, b""))
+        self.sock.close()
+
+
+# -----------------------------------------------------------------------------
+# Commands
+# -----------------------------------------------------------------------------
+
+def cmd_broker(args):
+    fleet = Fleet(quiet=args.quiet)
+    broker = Broker(("0.0.0.0", args.port), fleet)
+    print("MQTT broker on port %d, Ctrl-C for the fleet summary" % args.port)
+    try:
+        broker.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    fleet.report()
+
+
+def cmd_collect(args):
+    fleet = Fleet(quiet=args.quiet)
+    client = Client(args.host, args.port, "telemetry-collector")
+    client.sock.settimeout(None)
+    client.subscribe(args.topic)
+    print("Subscribed to %s on %s:%d, Ctrl-C for the fleet summary" % (args.topic, args.host, args.port))
+    try:
+        while True:
+            ptype, flags, body = read_packet(client.sock)
+            if ptype == PUBLISH:
+                topic, _, payload = parse_publish(flags, body)
+                fleet.on_publish(topic, payload)
+    except (KeyboardInterrupt, ConnectionError):
+        pass
+    fleet.report()
+
+
+def fake_batch(rng, seq, dropped):
+    """A batch shaped like the ones main/telemetry.c builds."""
+    frame = [0] * HIST_BUCKETS
+    for _ in range(3000):
+        frame[min(HIST_BUCKETS - 1, max(0, int(rng.gauss(5.0, 1.0))))] += 1
+    flush = [0] * HIST_BUCKETS
+    flush[6] = 2900
+    flush[7] = 100
+    return {
+        0: 1, 1: seq, 2: 1760000000 + 300 * seq, 3: 300,
+        4: [sum(frame), 2000 * sum(frame), 70000, frame],
+        5: [sum(flush), 12000 * sum(flush), 31000, flush],
+        6: [[300, rng.randrange(2), 0], [60000, rng.randrange(5), rng.randrange(2)]],
+        7: [200, 80, 20], 8: [61234, 80000, 40000], 9: [rng.randrange(2), 0],
+        10: [0, -58], 11: dropped,
+    }
+
+
+def cmd_selftest(args):
+    fleet = Fleet(quiet=True)
+    broker = Broker(("127.0.0.1", 0), fleet)
+    port = broker.server_address[1]
+    threading.Thread(target=broker.serve_forever, daemon=True).start()
+    rng = random.Random(args.seed)
+
+    # Offline for longer than the ring holds: the oldest windows are dropped on the unit
+    ring, seq, dropped_total, pending_drop = [], 0, 0, 0
+    for _ in range(args.ring + 5):
+        if len(ring) == args.ring:
+            ring.pop(0)
+            dropped_total += 1
+            pending_drop += 1
+        ring.append(cbor_encode(fake_batch(rng, seq, pending_drop)))
+        pending_drop = 0
+        seq += 1
+
+    # Back online: one connection per flush, each batch acknowledged before it leaves the ring
+    started = time.monotonic()
+    client = Client("127.0.0.1", port, "desk-selftest")
+    for payload in ring:
+        client.publish("desk/0011223344aa/telemetry", payload)
+    client.close()
+    flush_ms = 1000.0 * (time.monotonic() - started)
+
+    deadline = time.monotonic() + 2.0
+    while time.monotonic() < deadline and sum(len(u.seqs) for u in fleet.units.values()) < len(ring):
+        time.sleep(0.01)
+    broker.shutdown()
+    fleet.report()
+
+    unit = fleet.units.get("0011223344aa")
+    received = len(unit.seqs) if unit else 0
+    largest = max(len(p) for p in ring)
+    print("selftest: %d/%d batches received, %d dropped on the unit (%d reported), %d lost, "
+          "%d decode errors, largest batch %d bytes, flush %.0f ms"
+          % (received, len(ring), dropped_total, unit.dropped if unit else 0,
+             unit.lost if unit else 0, fleet.errors, largest, flush_ms))
+    if received != len(ring) or fleet.errors or unit.lost or unit.dropped != dropped_total or largest > args.max_bytes:
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("broker", help="minimal MQTT broker that decodes telemetry")
+    p.add_argument("--port", type=int, default=1883)
+    p.add_argument("--quiet", action="store_true", help="summary only")
+    p.set_defaults(func=cmd_broker)
+
+    p = sub.add_parser("collect", help="subscribe to an existing broker")
+    p.add_argument("--host", default="127.0.0.1")
+    p.add_argument("--port", type=int, default=1883)
+    p.add_argument("--topic", default="desk/+/telemetry")
+    p.add_argument("--quiet", action="store_true", help="summary only")
+    p.set_defaults(func=cmd_collect)
+
+    p = sub.add_parser("selftest", help="publish unit-shaped batches through the local broker")
+    p.add_argument("--ring", type=int, default=48, help="CONFIG_TELEMETRY_QUEUE_BATCHES")
+    p.add_argument("--max-bytes", type=int, default=384, help="CONFIG_TELEMETRY_BATCH_MAX_BYTES")
+    p.add_argument("--seed", type=int, default=1)
+    p.set_defaults(func=cmd_selftest)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()